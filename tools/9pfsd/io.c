@@ -7,8 +7,8 @@
  *
  * I/O thread handling.
  *
- * Only handle one request at a time, pushing out the complete response
- * before looking for the next request.
+ * Each ring has an I/O thread receiving requests and sending responses, while
+ * the requests are executed by a pool of worker threads shared by all rings.
  */
 
 #include <assert.h>
@@ -22,6 +22,7 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <dirent.h>
 #include <fcntl.h>
 #include <xen-barrier.h>
@@ -56,6 +57,11 @@
 #define P9_CREATE_PERM_FILE_MASK  0666
 
 #define P9_MIN_MSIZE      2048
+#define P9_IOHDRSZ        24    /* Max. header size of read/write messages. */
+#define P9_READ_HDRSZ     (sizeof(struct p9_header) + sizeof(uint32_t))
+#define P9_WRITE_HDRSZ    (sizeof(struct p9_header) + 2 * sizeof(uint32_t) + \
+                           sizeof(uint64_t))
+#define P9_ZC_MIN         4096  /* Min. size of zero-copy reads/writes. */
 #define P9_VERSION        "9P2000.u"
 #define P9_WALK_MAXELEM   16
 
@@ -102,6 +108,12 @@ static unsigned int ring_in_free(struct ring *ring)
     return ring->ring_size - queued;
 }
 
+/* Free space in the "in" ring not yet reserved for zero-copy reads. */
+static unsigned int ring_in_unreserved(struct ring *ring)
+{
+    return ring_in_free(ring) - (ring->prod_rsv_in - ring->prod_pvt_in);
+}
+
 static unsigned int ring_out_data(struct ring *ring)
 {
     unsigned int queued;
@@ -113,8 +125,8 @@ static unsigned int ring_out_data(struct ring *ring)
     return queued;
 }
 
-static unsigned int get_request_bytes(struct ring *ring, unsigned int off,
-                                      unsigned int total_len)
+static unsigned int get_request_bytes(struct ring *ring, void *buffer,
+                                      unsigned int off, unsigned int total_len)
 {
     unsigned int size;
     unsigned int out_data = ring_out_data(ring);
@@ -123,7 +135,7 @@ static unsigned int get_request_bytes(struct ring *ring, unsigned int off,
     size = min(total_len - off, out_data);
     prod = xen_9pfs_mask(ring->intf->out_prod, ring->ring_size);
     cons = xen_9pfs_mask(ring->cons_pvt_out, ring->ring_size);
-    xen_9pfs_read_packet(ring->buffer + off, ring->data.out, size,
+    xen_9pfs_read_packet(buffer + off, ring->data.out, size,
                          prod, &cons, ring->ring_size);
 
     xen_rmb();           /* Read data out before setting visible consumer. */
@@ -136,8 +148,8 @@ static unsigned int get_request_bytes(struct ring *ring, unsigned int off,
     return size;
 }
 
-static unsigned int put_response_bytes(struct ring *ring, unsigned int off,
-                                       unsigned int total_len)
+static unsigned int put_response_bytes(struct ring *ring, const void *buffer,
+                                       unsigned int off, unsigned int total_len)
 {
     unsigned int size;
     unsigned int in_data = ring_in_free(ring);
@@ -146,7 +158,7 @@ static unsigned int put_response_bytes(struct ring *ring, unsigned int off,
     size = min(total_len - off, in_data);
     prod = xen_9pfs_mask(ring->prod_pvt_in, ring->ring_size);
     cons = xen_9pfs_mask(ring->intf->in_cons, ring->ring_size);
-    xen_9pfs_write_packet(ring->data.in, ring->buffer + off, size,
+    xen_9pfs_write_packet(ring->data.in, buffer + off, size,
                           &prod, cons, ring->ring_size);
 
     xen_wmb();           /* Write data out before setting visible producer. */
@@ -156,13 +168,92 @@ static unsigned int put_response_bytes(struct ring *ring, unsigned int off,
     return size;
 }
 
+/* Set up iovecs for len bytes of a ring half, starting at index idx. */
+static unsigned int ring_iov(struct ring *ring, unsigned char *data,
+                             RING_IDX idx, unsigned int len,
+                             struct iovec iov[2])
+{
+    RING_IDX off = xen_9pfs_mask(idx, ring->ring_size);
+
+    iov[0].iov_base = data + off;
+    iov[0].iov_len = min(len, ring->ring_size - off);
+    iov[1].iov_base = data;
+    iov[1].iov_len = len - iov[0].iov_len;
+
+    return iov[1].iov_len ? 2 : 1;
+}
+
+static bool req_blocked(const struct p9_req *prev, const struct p9_req *req);
+
+static bool req_zc_reserved(const struct p9_req *req)
+{
+    return req->state == REQ_ZC_QUEUED || req->state == REQ_ZC_DONE;
+}
+
+/*
+ * Responses are sent in request order, so ring space can only be reserved
+ * for a zero-copy read if all earlier responses have been sent or are
+ * zero-copy reads with space reserved already. Return the read for which
+ * space can be reserved next, if any. Called with ring->mutex held.
+ */
+static struct p9_req *zc_read_next(struct ring *ring)
+{
+    struct p9_req *req;
+
+    XEN_TAILQ_FOREACH(req, &ring->reqs_busy, list)
+        if ( !req_zc_reserved(req) )
+            break;
+
+    if ( req && req->state == REQ_DONE && req->zc_fid &&
+         ring_in_unreserved(ring) >= P9_READ_HDRSZ + req->zc_count )
+        return req;
+
+    return NULL;
+}
+
+/*
+ * Check whether the response of the first busy request can be sent. The data
+ * of a zero-copy read may have to be moved to close the gap left by an
+ * earlier short read, which can only be done once no other read is writing
+ * into the ring. Called with ring->mutex held.
+ */
+static bool resp_ready(struct ring *ring, const struct p9_req *req)
+{
+    const struct p9_req *other;
+
+    if ( req->state == REQ_DONE )
+        return !req->zc_fid && ring_in_free(ring);
+
+    if ( req->state != REQ_ZC_DONE )
+        return false;
+    if ( req->zc_prod == ring->prod_pvt_in )
+        return true;
+
+    XEN_TAILQ_FOREACH(other, &ring->reqs_busy, list)
+        if ( other->state == REQ_ZC_QUEUED )
+            return false;
+
+    return true;
+}
+
+/* Called with ring->mutex held. */
 static bool io_work_pending(struct ring *ring)
 {
+    struct p9_req *req = XEN_TAILQ_FIRST(&ring->reqs_busy);
+
     if ( ring->stop_thread )
         return true;
     if ( ring->error )
         return false;
-    return ring->handle_response ? ring_in_free(ring) : ring_out_data(ring);
+    if ( req && (resp_ready(ring, req) || zc_read_next(ring)) )
+        return true;
+    if ( ring->zc_blocked )
+        return !req_blocked(XEN_TAILQ_LAST(&ring->reqs_busy, busyhead),
+                            ring->req_in);
+    if ( !ring->req_in && XEN_TAILQ_EMPTY(&ring->reqs_free) &&
+         ring->n_reqs == MAX_RING_REQS )
+        return false;
+    return ring_out_data(ring);
 }
 
 static void fmt_err(const char *fmt)
@@ -323,10 +414,10 @@ static void fill_buffer_at(void **data, const char *fmt, ...)
     va_end(ap);
 }
 
-static void fill_buffer(struct ring *ring, uint8_t cmd, uint16_t tag,
+static void fill_buffer(struct p9_req *req, uint8_t cmd, uint16_t tag,
                         const char *fmt, ...)
 {
-    struct p9_header *hdr = ring->buffer;
+    struct p9_header *hdr = req->buffer;
     void *data = hdr + 1;
     va_list ap;
 
@@ -337,37 +428,37 @@ static void fill_buffer(struct ring *ring, uint8_t cmd, uint16_t tag,
     vfill_buffer_at(&data, fmt, ap);
     va_end(ap);
 
-    hdr->size = data - ring->buffer;
+    hdr->size = data - req->buffer;
 }
 
-static unsigned int add_string(struct ring *ring, const char *str,
+static unsigned int add_string(struct p9_req *req, const char *str,
                                unsigned int len)
 {
     char *tmp;
     unsigned int ret;
 
-    if ( ring->str_used + len + 1 > ring->str_size )
+    if ( req->str_used + len + 1 > req->str_size )
     {
-        tmp = realloc(ring->str, ring->str_used + len + 1);
+        tmp = realloc(req->str, req->str_used + len + 1);
         if ( !tmp )
             return ~0;
-        ring->str = tmp;
-        ring->str_size = ring->str_used + len + 1;
+        req->str = tmp;
+        req->str_size = req->str_used + len + 1;
     }
 
-    ret = ring->str_used;
-    memcpy(ring->str + ret, str, len);
-    ring->str_used += len;
-    ring->str[ring->str_used++] = 0;
+    ret = req->str_used;
+    memcpy(req->str + ret, str, len);
+    req->str_used += len;
+    req->str[req->str_used++] = 0;
 
     return ret;
 }
 
-static bool chk_data(struct ring *ring, void *data, unsigned int len)
+static bool chk_data(struct p9_req *req, void *data, unsigned int len)
 {
-    struct p9_header *hdr = ring->buffer;
+    struct p9_header *hdr = req->buffer;
 
-    if ( data + len <= ring->buffer + hdr->size )
+    if ( data + len <= req->buffer + hdr->size )
         return true;
 
     errno = E2BIG;
@@ -421,9 +512,9 @@ static bool fill_data_elem(void **par, void **array, unsigned int *array_sz,
  * Return value: number of filled variables, errno will be set in case of
  *   error.
  */
-static int fill_data(struct ring *ring, const char *fmt, ...)
+static int fill_data(struct p9_req *req, const char *fmt, ...)
 {
-    struct p9_header *hdr = ring->buffer;
+    struct p9_header *hdr = req->buffer;
     void *data = hdr + 1;
     void *par;
     unsigned int pars = 0;
@@ -447,7 +538,7 @@ static int fill_data(struct ring *ring, const char *fmt, ...)
             f++;
             if ( !*f || array_sz )
                 fmt_err(fmt);
-            if ( !chk_data(ring, data, sizeof(uint16_t)) )
+            if ( !chk_data(req, data, sizeof(uint16_t)) )
                 goto out;
             array_sz = get_unaligned((uint16_t *)data);
             data += sizeof(uint16_t);
@@ -457,7 +548,7 @@ static int fill_data(struct ring *ring, const char *fmt, ...)
             break;
 
         case 'b':
-            if ( !chk_data(ring, data, sizeof(uint8_t)) )
+            if ( !chk_data(req, data, sizeof(uint8_t)) )
                 goto out;
             if ( !fill_data_elem(&par, array, &array_sz, sizeof(uint8_t),
                                  data) )
@@ -468,20 +559,20 @@ static int fill_data(struct ring *ring, const char *fmt, ...)
         case 'D':
             if ( array_sz )
                 fmt_err(fmt);
-            if ( !chk_data(ring, data, sizeof(uint32_t)) )
+            if ( !chk_data(req, data, sizeof(uint32_t)) )
                 goto out;
             len = get_unaligned((uint32_t *)data);
             data += sizeof(uint32_t);
             *(unsigned int *)par = len;
             par = va_arg(ap, void *);
-            if ( !chk_data(ring, data, len) )
+            if ( !chk_data(req, data, len) )
                 goto out;
             memcpy(par, data, len);
             data += len;
             break;
 
         case 'L':
-            if ( !chk_data(ring, data, sizeof(uint64_t)) )
+            if ( !chk_data(req, data, sizeof(uint64_t)) )
                 goto out;
             if ( !fill_data_elem(&par, array, &array_sz, sizeof(uint64_t),
                                  data) )
@@ -490,13 +581,13 @@ static int fill_data(struct ring *ring, const char *fmt, ...)
             break;
 
         case 'S':
-            if ( !chk_data(ring, data, sizeof(uint16_t)) )
+            if ( !chk_data(req, data, sizeof(uint16_t)) )
                 goto out;
             len = get_unaligned((uint16_t *)data);
             data += sizeof(uint16_t);
-            if ( !chk_data(ring, data, len) )
+            if ( !chk_data(req, data, len) )
                 goto out;
-            str_off = add_string(ring, data, len);
+            str_off = add_string(req, data, len);
             if ( str_off == ~0 )
                 goto out;
             if ( !fill_data_elem(&par, array, &array_sz, sizeof(unsigned int),
@@ -506,7 +597,7 @@ static int fill_data(struct ring *ring, const char *fmt, ...)
             break;
 
         case 'U':
-            if ( !chk_data(ring, data, sizeof(uint32_t)) )
+            if ( !chk_data(req, data, sizeof(uint32_t)) )
                 goto out;
             if ( !fill_data_elem(&par, array, &array_sz, sizeof(uint32_t),
                                  data) )
@@ -529,11 +620,17 @@ static int fill_data(struct ring *ring, const char *fmt, ...)
     return pars;
 }
 
+static struct fidhead *fid_bucket(device *device, unsigned int fid)
+{
+    /* Fids are usually allocated sequentially, spread them via Fibonacci. */
+    return &device->fids[(fid * 0x9e3779b1U) >> (32 - FID_HASH_BITS)];
+}
+
 static struct p9_fid *find_fid(device *device, unsigned int fid)
 {
     struct p9_fid *fidp;
 
-    XEN_TAILQ_FOREACH(fidp, &device->fids, list)
+    XEN_LIST_FOREACH(fidp, fid_bucket(device, fid), list)
     {
         if ( fidp->fid == fid )
             return fidp;
@@ -542,6 +639,15 @@ static struct p9_fid *find_fid(device *device, unsigned int fid)
     return NULL;
 }
 
+/* Replace fidp by new_fidp (same fid), called with fid_mutex held. */
+static void replace_fid(device *device, struct p9_fid *fidp,
+                        struct p9_fid *new_fidp)
+{
+    XEN_LIST_REMOVE(fidp, list);
+    XEN_LIST_INSERT_HEAD(fid_bucket(device, new_fidp->fid), new_fidp, list);
+    free(fidp);
+}
+
 static struct p9_fid *get_fid_ref(device *device, unsigned int fid)
 {
     struct p9_fid *fidp;
@@ -596,7 +702,7 @@ static struct p9_fid *alloc_fid(device *device, unsigned int fid,
         goto out;
 
     fidp->ref = 1;
-    XEN_TAILQ_INSERT_HEAD(&device->fids, fidp, list);
+    XEN_LIST_INSERT_HEAD(fid_bucket(device, fid), fidp, list);
     device->n_fids++;
 
  out:
@@ -616,22 +722,36 @@ static void free_fid(device *device, struct p9_fid *fidp)
     if ( !fidp->ref )
     {
         device->n_fids--;
-        XEN_TAILQ_REMOVE(&device->fids, fidp, list);
+        XEN_LIST_REMOVE(fidp, list);
         free(fidp);
     }
 
     pthread_mutex_unlock(&device->fid_mutex);
 }
 
+void init_fids(device *device)
+{
+    unsigned int i;
+
+    for ( i = 0; i < FID_HASH_SIZE; i++ )
+        XEN_LIST_INIT(&device->fids[i]);
+}
+
 void free_fids(device *device)
 {
     struct p9_fid *fidp;
+    unsigned int i;
 
-    while ( (fidp = XEN_TAILQ_FIRST(&device->fids)) != NULL )
+    for ( i = 0; i < FID_HASH_SIZE; i++ )
     {
-        XEN_TAILQ_REMOVE(&device->fids, fidp, list);
-        free(fidp);
+        while ( (fidp = XEN_LIST_FIRST(&device->fids[i])) != NULL )
+        {
+            XEN_LIST_REMOVE(fidp, list);
+            free(fidp);
+        }
     }
+
+    device->n_fids = 0;
 }
 
 static const char *relpath_from_path(const char *path)
@@ -682,7 +802,7 @@ static bool name_ok(const char *str)
 
 /* Including the '\0' */
 #define MAX_ERRSTR_LEN 80
-static void p9_error(struct ring *ring, uint16_t tag, uint32_t err)
+static void p9_error(struct p9_req *req, uint16_t tag, uint32_t err)
 {
     unsigned int erroff;
     static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -698,67 +818,72 @@ static void p9_error(struct ring *ring, uint16_t tag, uint32_t err)
     pthread_mutex_lock(&mutex);
     str = strerror(err);
     len = min(strlen(str), (size_t)(MAX_ERRSTR_LEN - 1));
-    memcpy(ring->buffer, str, len);
-    ((char *)ring->buffer)[len] = '\0';
+    memcpy(req->buffer, str, len);
+    ((char *)req->buffer)[len] = '\0';
     pthread_mutex_unlock(&mutex);
 
-    erroff = add_string(ring, ring->buffer, strlen(ring->buffer));
-    fill_buffer(ring, P9_CMD_ERROR, tag, "SU",
-                erroff != ~0 ? ring->str + erroff : "cannot allocate memory",
+    erroff = add_string(req, req->buffer, strlen(req->buffer));
+    fill_buffer(req, P9_CMD_ERROR, tag, "SU",
+                erroff != ~0 ? req->str + erroff : "cannot allocate memory",
                 &err);
 }
 
-static void p9_version(struct ring *ring, struct p9_header *hdr)
+static void p9_version(struct p9_req *req, struct p9_header *hdr)
 {
+    struct ring *ring = req->ring;
     uint32_t max_size;
     unsigned int off;
     char *version;
     int ret;
 
-    ret = fill_data(ring, "US", &max_size, &off);
+    ret = fill_data(req, "US", &max_size, &off);
     if ( ret != 2 )
     {
-        p9_error(ring, hdr->tag, errno);
+        p9_error(req, hdr->tag, errno);
         return;
     }
 
     if ( max_size < P9_MIN_MSIZE )
     {
-        p9_error(ring, hdr->tag, EMSGSIZE);
+        p9_error(req, hdr->tag, EMSGSIZE);
         return;
     }
 
+    /* The I/O thread checks incoming requests against ring->max_size. */
+    pthread_mutex_lock(&ring->mutex);
     if ( max_size < ring->max_size )
         ring->max_size = max_size;
+    max_size = ring->max_size;
+    pthread_mutex_unlock(&ring->mutex);
 
-    version = ring->str + off;
+    version = req->str + off;
     if ( strcmp(version, P9_VERSION) )
         version = "unknown";
 
-    fill_buffer(ring, hdr->cmd + 1, hdr->tag, "US", &ring->max_size, version);
+    fill_buffer(req, hdr->cmd + 1, hdr->tag, "US", &max_size, version);
 }
 
-static void p9_attach(struct ring *ring, struct p9_header *hdr)
+static void p9_attach(struct p9_req *req, struct p9_header *hdr)
 {
-    device *device = ring->device;
+    device *device = req->ring->device;
     uint32_t fid;
     uint32_t dummy_u32;
     unsigned int dummy_uint;
     struct p9_qid qid;
     int ret;
 
-    ret = fill_data(ring, "UUSSU", &fid, &dummy_u32, &dummy_uint, &dummy_uint,
+    ret = fill_data(req, "UUSSU", &fid, &dummy_u32, &dummy_uint, &dummy_uint,
                     &dummy_u32);
     if ( ret != 5 )
     {
-        p9_error(ring, hdr->tag, errno);
+        p9_error(req, hdr->tag, errno);
         return;
     }
 
     device->root_fid = alloc_fid(device, fid, relpath_from_path("/"));
     if ( !device->root_fid )
     {
-        p9_error(ring, hdr->tag, errno);
+        p9_error(req, hdr->tag, errno);
         return;
     }
 
@@ -767,16 +892,16 @@ static void p9_attach(struct ring *ring, struct p9_header *hdr)
     {
         free_fid(device, device->root_fid);
         device->root_fid = NULL;
-        p9_error(ring, hdr->tag, ret);
+        p9_error(req, hdr->tag, ret);
         return;
     }
 
-    fill_buffer(ring, hdr->cmd + 1, hdr->tag, "Q", &qid);
+    fill_buffer(req, hdr->cmd + 1, hdr->tag, "Q", &qid);
 }
 
-static void p9_walk(struct ring *ring, struct p9_header *hdr)
+static void p9_walk(struct p9_req *req, struct p9_header *hdr)
 {
-    device *device = ring->device;
+    device *device = req->ring->device;
     uint32_t fid;
     uint32_t newfid;
     struct p9_fid *fidp = NULL;
@@ -789,44 +914,44 @@ static void p9_walk(struct ring *ring, struct p9_header *hdr)
     unsigned int path_len;
     int ret;
 
-    ret = fill_data(ring, "UUaS", &fid, &newfid, &n_names, &names);
+    ret = fill_data(req, "UUaS", &fid, &newfid, &n_names, &names);
     if ( n_names > P9_WALK_MAXELEM )
     {
-        p9_error(ring, hdr->tag, EINVAL);
+        p9_error(req, hdr->tag, EINVAL);
         goto out;
     }
     if ( ret != 3 + n_names )
     {
-        p9_error(ring, hdr->tag, errno);
+        p9_error(req, hdr->tag, errno);
         goto out;
     }
 
     fidp = get_fid_ref(device, fid);
     if ( !fidp )
     {
-        p9_error(ring, hdr->tag, ENOENT);
+        p9_error(req, hdr->tag, ENOENT);
         goto out;
     }
     if ( fidp->opened )
     {
-        p9_error(ring, hdr->tag, EINVAL);
+        p9_error(req, hdr->tag, EINVAL);
         goto out;
     }
 
     path_len = strlen(fidp->path) + 1;
     for ( i = 0; i < n_names; i++ )
     {
-        if ( !name_ok(ring->str + names[i]) )
+        if ( !name_ok(req->str + names[i]) )
         {
-            p9_error(ring, hdr->tag, ENOENT);
+            p9_error(req, hdr->tag, ENOENT);
             goto out;
         }
-        path_len += strlen(ring->str + names[i]) + 1;
+        path_len += strlen(req->str + names[i]) + 1;
     }
     path = calloc(path_len + 1, 1);
     if ( !path )
     {
-        p9_error(ring, hdr->tag, ENOMEM);
+        p9_error(req, hdr->tag, ENOMEM);
         goto out;
     }
     strcpy(path, fidp->path);
@@ -836,19 +961,19 @@ static void p9_walk(struct ring *ring, struct p9_header *hdr)
         qids = calloc(n_names, sizeof(*qids));
         if ( !qids )
         {
-            p9_error(ring, hdr->tag, ENOMEM);
+            p9_error(req, hdr->tag, ENOMEM);
             goto out;
         }
         for ( i = 0; i < n_names; i++ )
         {
             strcat(path, "/");
-            strcat(path, ring->str + names[i]);
+            strcat(path, req->str + names[i]);
             ret = fill_qid(device, path, qids + i, NULL);
             if ( ret )
             {
                 if ( !walked )
                 {
-                    p9_error(ring, hdr->tag, errno);
+                    p9_error(req, hdr->tag, errno);
                     goto out;
                 }
                 break;
@@ -877,9 +1002,7 @@ static void p9_walk(struct ring *ring, struct p9_header *hdr)
                 if ( new_fidp )
                 {
                     new_fidp->ref = 2;
-                    XEN_TAILQ_REMOVE(&device->fids, fidp, list);
-                    XEN_TAILQ_INSERT_HEAD(&device->fids, new_fidp, list);
-                    free(fidp);
+                    replace_fid(device, fidp, new_fidp);
                     fidp = new_fidp;
                     ok = true;
                 }
@@ -892,12 +1015,12 @@ static void p9_walk(struct ring *ring, struct p9_header *hdr)
 
         if ( !ok )
         {
-            p9_error(ring, hdr->tag, errno);
+            p9_error(req, hdr->tag, errno);
             goto out;
         }
     }
 
-    fill_buffer(ring, hdr->cmd + 1, hdr->tag, "aQ", &walked, qids);
+    fill_buffer(req, hdr->cmd + 1, hdr->tag, "aQ", &walked, qids);
 
  out:
     free_fid(device, fidp);
@@ -935,14 +1058,18 @@ static int open_flags_from_mode(uint8_t mode)
     return flags;
 }
 
-static unsigned int get_iounit(struct ring *ring, struct stat *st)
+/*
+ * Reads and writes of regular files aren't bounced through a block sized
+ * buffer, so the I/O unit is limited by the negotiated message size only.
+ */
+static unsigned int get_iounit(struct ring *ring)
 {
-    return (ring->max_size - st->st_blksize) & ~(st->st_blksize - 1);
+    return ring->max_size - P9_IOHDRSZ;
 }
 
-static void p9_open(struct ring *ring, struct p9_header *hdr)
+static void p9_open(struct p9_req *req, struct p9_header *hdr)
 {
-    device *device = ring->device;
+    device *device = req->ring->device;
     uint32_t fid;
     uint8_t mode;
     struct p9_fid *fidp;
@@ -952,22 +1079,22 @@ static void p9_open(struct ring *ring, struct p9_header *hdr)
     int flags;
     int ret;
 
-    ret = fill_data(ring, "Ub", &fid, &mode);
+    ret = fill_data(req, "Ub", &fid, &mode);
     if ( ret != 2 )
     {
-        p9_error(ring, hdr->tag, EINVAL);
+        p9_error(req, hdr->tag, EINVAL);
         return;
     }
     if ( mode & ~(P9_OMODEMASK | P9_OTRUNC | P9_OREMOVE) )
     {
-        p9_error(ring, hdr->tag, EINVAL);
+        p9_error(req, hdr->tag, EINVAL);
         return;
     }
 
     fidp = get_fid_ref(device, fid);
     if ( !fidp )
     {
-        p9_error(ring, hdr->tag, ENOENT);
+        p9_error(req, hdr->tag, ENOENT);
         return;
     }
     if ( fidp->opened )
@@ -1016,21 +1143,21 @@ static void p9_open(struct ring *ring, struct p9_header *hdr)
     }
 
     fill_qid(device, fidp->path, &qid, &st);
-    iounit = get_iounit(ring, &st);
+    iounit = get_iounit(req->ring);
     fidp->opened = true;
 
-    fill_buffer(ring, hdr->cmd + 1, hdr->tag, "QU", &qid, &iounit);
+    fill_buffer(req, hdr->cmd + 1, hdr->tag, "QU", &qid, &iounit);
 
     return;
 
  err:
     free_fid(device, fidp);
-    p9_error(ring, hdr->tag, errno);
+    p9_error(req, hdr->tag, errno);
 }
 
-static void p9_create(struct ring *ring, struct p9_header *hdr)
+static void p9_create(struct p9_req *req, struct p9_header *hdr)
 {
-    device *device = ring->device;
+    device *device = req->ring->device;
     uint32_t fid;
     unsigned int name_off;
     uint32_t perm;
@@ -1045,22 +1172,22 @@ static void p9_create(struct ring *ring, struct p9_header *hdr)
     int flags;
     int ret;
 
-    ret = fill_data(ring, "USUbS", &fid, &name_off, &perm, &mode, &ext_off);
+    ret = fill_data(req, "USUbS", &fid, &name_off, &perm, &mode, &ext_off);
     if ( ret != 5 )
     {
-        p9_error(ring, hdr->tag, EINVAL);
+        p9_error(req, hdr->tag, EINVAL);
         return;
     }
 
-    if ( !name_ok(ring->str + name_off) )
+    if ( !name_ok(req->str + name_off) )
     {
-        p9_error(ring, hdr->tag, ENOENT);
+        p9_error(req, hdr->tag, ENOENT);
         return;
     }
 
     if ( perm & P9_CREATE_PERM_NOTSUPP )
     {
-        p9_error(ring, hdr->tag, EINVAL);
+        p9_error(req, hdr->tag, EINVAL);
         return;
     }
 
@@ -1068,30 +1195,30 @@ static void p9_create(struct ring *ring, struct p9_header *hdr)
     if ( !fidp || fidp->opened )
     {
         free_fid(device, fidp);
-        p9_error(ring, hdr->tag, EINVAL);
+        p9_error(req, hdr->tag, EINVAL);
         return;
     }
     if ( fstatat(device->root_fd, fidp->path, &st, 0) < 0 )
     {
         free_fid(device, fidp);
-        p9_error(ring, hdr->tag, errno);
+        p9_error(req, hdr->tag, errno);
         return;
     }
 
-    path = malloc(strlen(fidp->path) + strlen(ring->str + name_off) + 2);
+    path = malloc(strlen(fidp->path) + strlen(req->str + name_off) + 2);
     if ( !path )
     {
         free_fid(device, fidp);
-        p9_error(ring, hdr->tag, ENOMEM);
+        p9_error(req, hdr->tag, ENOMEM);
         return;
     }
-    sprintf(path, "%s/%s", fidp->path, ring->str + name_off);
+    sprintf(path, "%s/%s", fidp->path, req->str + name_off);
     new_fidp = alloc_fid_mem(device, fid, path);
     free(path);
     if ( !new_fidp )
     {
         free_fid(device, fidp);
-        p9_error(ring, hdr->tag, ENOMEM);
+        p9_error(req, hdr->tag, ENOMEM);
         return;
     }
 
@@ -1110,9 +1237,7 @@ static void p9_create(struct ring *ring, struct p9_header *hdr)
         if ( mkdirat(device->root_fd, new_fidp->path, perm) < 0 )
             goto err;
 
-        XEN_TAILQ_REMOVE(&device->fids, fidp, list);
-        XEN_TAILQ_INSERT_HEAD(&device->fids, new_fidp, list);
-        free(fidp);
+        replace_fid(device, fidp, new_fidp);
         fidp = new_fidp;
         new_fidp = NULL;
 
@@ -1133,9 +1258,7 @@ static void p9_create(struct ring *ring, struct p9_header *hdr)
         }
         perm &= P9_CREATE_PERM_FILE_MASK & st.st_mode;
 
-        XEN_TAILQ_REMOVE(&device->fids, fidp, list);
-        XEN_TAILQ_INSERT_HEAD(&device->fids, new_fidp, list);
-        free(fidp);
+        replace_fid(device, fidp, new_fidp);
         fidp = new_fidp;
         new_fidp = NULL;
 
@@ -1149,18 +1272,18 @@ static void p9_create(struct ring *ring, struct p9_header *hdr)
         goto err;
 
     fill_qid(device, fidp->path, &qid, &st);
-    iounit = get_iounit(ring, &st);
+    iounit = get_iounit(req->ring);
     fidp->opened = true;
     fidp->mode = mode;
 
     pthread_mutex_unlock(&device->fid_mutex);
 
-    fill_buffer(ring, hdr->cmd + 1, hdr->tag, "QU", &qid, &iounit);
+    fill_buffer(req, hdr->cmd + 1, hdr->tag, "QU", &qid, &iounit);
 
     return;
 
  err:
-    p9_error(ring, hdr->tag, errno);
+    p9_error(req, hdr->tag, errno);
 
     pthread_mutex_unlock(&device->fid_mutex);
 
@@ -1168,24 +1291,24 @@ static void p9_create(struct ring *ring, struct p9_header *hdr)
     free_fid(device, fidp);
 }
 
-static void p9_clunk(struct ring *ring, struct p9_header *hdr)
+static void p9_clunk(struct p9_req *req, struct p9_header *hdr)
 {
-    device *device = ring->device;
+    device *device = req->ring->device;
     uint32_t fid;
     struct p9_fid *fidp;
     int ret;
 
-    ret = fill_data(ring, "U", &fid);
+    ret = fill_data(req, "U", &fid);
     if ( ret != 1 )
     {
-        p9_error(ring, hdr->tag, EINVAL);
+        p9_error(req, hdr->tag, EINVAL);
         return;
     }
 
     fidp = get_fid_ref(device, fid);
     if ( !fidp )
     {
-        p9_error(ring, hdr->tag, ENOENT);
+        p9_error(req, hdr->tag, ENOENT);
         return;
     }
 
@@ -1203,7 +1326,7 @@ static void p9_clunk(struct ring *ring, struct p9_header *hdr)
     free_fid(device, fidp);
     free_fid(device, fidp);
 
-    fill_buffer(ring, hdr->cmd + 1, hdr->tag, "");
+    fill_buffer(req, hdr->cmd + 1, hdr->tag, "");
 }
 
 static void fill_p9_stat(device *device, struct p9_stat *p9s, struct stat *st,
@@ -1233,45 +1356,45 @@ static void fill_p9_stat(device *device, struct p9_stat *p9s, struct stat *st,
     p9s->size = 71 + strlen(p9s->name);
 }
 
-static void p9_stat(struct ring *ring, struct p9_header *hdr)
+static void p9_stat(struct p9_req *req, struct p9_header *hdr)
 {
-    device *device = ring->device;
+    device *device = req->ring->device;
     uint32_t fid;
     struct p9_fid *fidp;
     struct p9_stat p9s;
     struct stat st;
     int ret;
 
-    ret = fill_data(ring, "U", &fid);
+    ret = fill_data(req, "U", &fid);
     if ( ret != 1 )
     {
-        p9_error(ring, hdr->tag, EINVAL);
+        p9_error(req, hdr->tag, EINVAL);
         return;
     }
 
     fidp = get_fid_ref(device, fid);
     if ( !fidp )
     {
-        p9_error(ring, hdr->tag, ENOENT);
+        p9_error(req, hdr->tag, ENOENT);
         return;
     }
 
     if ( fstatat(device->root_fd, fidp->path, &st, 0) < 0 )
     {
-        p9_error(ring, hdr->tag, errno);
+        p9_error(req, hdr->tag, errno);
         goto out;
     }
     fill_p9_stat(device, &p9s, &st, strrchr(fidp->path, '/') + 1);
 
-    fill_buffer(ring, hdr->cmd + 1, hdr->tag, "s", &p9s);
+    fill_buffer(req, hdr->cmd + 1, hdr->tag, "s", &p9s);
 
  out:
     free_fid(device, fidp);
 }
 
-static void p9_read(struct ring *ring, struct p9_header *hdr)
+static void p9_read(struct p9_req *req, struct p9_header *hdr)
 {
-    device *device = ring->device;
+    device *device = req->ring->device;
     uint32_t fid;
     uint64_t off;
     unsigned int len;
@@ -1280,10 +1403,10 @@ static void p9_read(struct ring *ring, struct p9_header *hdr)
     struct p9_fid *fidp;
     int ret;
 
-    ret = fill_data(ring, "ULU", &fid, &off, &count);
+    ret = fill_data(req, "ULU", &fid, &off, &count);
     if ( ret != 3 )
     {
-        p9_error(ring, hdr->tag, EINVAL);
+        p9_error(req, hdr->tag, EINVAL);
         return;
     }
 
@@ -1294,8 +1417,22 @@ static void p9_read(struct ring *ring, struct p9_header *hdr)
         goto err;
     }
 
+    count = min(count, req->ring->max_size - (uint32_t)P9_READ_HDRSZ);
+
+    if ( !fidp->isdir && count >= P9_ZC_MIN )
+    {
+        /*
+         * The data is read into the ring directly when sending the response,
+         * see put_zc_read(). The fid reference is kept until then.
+         */
+        req->zc_fid = fidp;
+        req->zc_off = off;
+        req->zc_count = count;
+        return;
+    }
+
     len = count;
-    buf = ring->buffer + sizeof(*hdr) + sizeof(uint32_t);
+    buf = req->buffer + sizeof(*hdr) + sizeof(uint32_t);
 
     if ( fidp->isdir )
     {
@@ -1343,9 +1480,9 @@ static void p9_read(struct ring *ring, struct p9_header *hdr)
             goto err;
     }
 
-    buf = ring->buffer + sizeof(*hdr) + sizeof(uint32_t);
+    buf = req->buffer + sizeof(*hdr) + sizeof(uint32_t);
     len = count - len;
-    fill_buffer(ring, hdr->cmd + 1, hdr->tag, "D", &len, buf);
+    fill_buffer(req, hdr->cmd + 1, hdr->tag, "D", &len, buf);
 
  out:
     free_fid(device, fidp);
@@ -1353,13 +1490,13 @@ static void p9_read(struct ring *ring, struct p9_header *hdr)
     return;
 
  err:
-    p9_error(ring, hdr->tag, errno);
+    p9_error(req, hdr->tag, errno);
     goto out;
 }
 
-static void p9_write(struct ring *ring, struct p9_header *hdr)
+static void p9_write(struct p9_req *req, struct p9_header *hdr)
 {
-    device *device = ring->device;
+    device *device = req->ring->device;
     uint32_t fid;
     uint64_t off;
     unsigned int len;
@@ -1368,21 +1505,21 @@ static void p9_write(struct ring *ring, struct p9_header *hdr)
     struct p9_fid *fidp;
     int ret;
 
-    ret = fill_data(ring, "ULD", &fid, &off, &len, ring->buffer);
+    ret = fill_data(req, "ULD", &fid, &off, &len, req->buffer);
     if ( ret != 3 )
     {
-        p9_error(ring, hdr->tag, EINVAL);
+        p9_error(req, hdr->tag, EINVAL);
         return;
     }
 
     fidp = get_fid_ref(device, fid);
     if ( !fidp || !fidp->opened || fidp->isdir )
     {
-        p9_error(ring, hdr->tag, EBADF);
+        p9_error(req, hdr->tag, EBADF);
         goto out;
     }
 
-    buf = ring->buffer;
+    buf = req->buffer;
 
     while ( len != 0 )
     {
@@ -1394,32 +1531,559 @@ static void p9_write(struct ring *ring, struct p9_header *hdr)
         off += ret;
     }
 
-    written = buf - ring->buffer;
+    written = buf - req->buffer;
     if ( written == 0 )
     {
-        p9_error(ring, hdr->tag, errno);
+        p9_error(req, hdr->tag, errno);
         goto out;
     }
-    fill_buffer(ring, hdr->cmd + 1, hdr->tag, "U", &written);
+    fill_buffer(req, hdr->cmd + 1, hdr->tag, "U", &written);
 
  out:
     free_fid(device, fidp);
 }
 
+static void p9_exec(struct p9_req *req)
+{
+    /* Copy the header, as the buffer is reused while handling the request. */
+    struct p9_header hdr_copy = *(struct p9_header *)req->buffer;
+    struct p9_header *hdr = &hdr_copy;
+    struct ring *ring = req->ring;
+
+    req->str_used = 0;
+
+    switch ( hdr->cmd )
+    {
+    case P9_CMD_VERSION:
+        p9_version(req, hdr);
+        break;
+
+    case P9_CMD_ATTACH:
+        p9_attach(req, hdr);
+        break;
+
+    case P9_CMD_WALK:
+        p9_walk(req, hdr);
+        break;
+
+    case P9_CMD_OPEN:
+        p9_open(req, hdr);
+        break;
+
+    case P9_CMD_CREATE:
+        p9_create(req, hdr);
+        break;
+
+    case P9_CMD_READ:
+        p9_read(req, hdr);
+        break;
+
+    case P9_CMD_WRITE:
+        p9_write(req, hdr);
+        break;
+
+    case P9_CMD_CLUNK:
+        p9_clunk(req, hdr);
+        break;
+
+    case P9_CMD_STAT:
+        p9_stat(req, hdr);
+        break;
+
+    default:
+        syslog(LOG_DEBUG, "%u.%u sent unhandled command %u\n",
+               ring->device->domid, ring->device->devid, hdr->cmd);
+        p9_error(req, hdr->tag, EOPNOTSUPP);
+        break;
+    }
+}
+
+/*
+ * Worker pool.
+ *
+ * Requests of all rings are executed by a common pool of worker threads.
+ * A request is queued only when it doesn't depend on any earlier request of
+ * the same ring still being executed (see req_conflict()), while responses
+ * are sent in the order of the requests. With no workers started, requests
+ * are executed by the I/O thread of the ring directly.
+ */
+static pthread_mutex_t work_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+static XEN_TAILQ_HEAD(workhead, struct p9_req) work_queue =
+    XEN_TAILQ_HEAD_INITIALIZER(work_queue);
+static pthread_t *workers;
+static unsigned int n_workers;
+static bool workers_stop;
+
+static void zc_read_fill(struct p9_req *req);
+
+static void req_classify(struct p9_req *req)
+{
+    const struct p9_header *hdr = req->buffer;
+    const uint32_t *par = (const void *)(hdr + 1);
+
+    req->cmd = hdr->cmd;
+    req->barrier = false;
+    req->fid = ~0U;
+    req->newfid = ~0U;
+
+    switch ( hdr->cmd )
+    {
+    case P9_CMD_WALK:
+        if ( hdr->size >= sizeof(*hdr) + 2 * sizeof(uint32_t) )
+        {
+            req->fid = get_unaligned(par);
+            req->newfid = get_unaligned(par + 1);
+            break;
+        }
+        req->barrier = true;
+        break;
+
+    case P9_CMD_OPEN:
+    case P9_CMD_CREATE:
+    case P9_CMD_READ:
+    case P9_CMD_WRITE:
+    case P9_CMD_CLUNK:
+    case P9_CMD_STAT:
+        if ( hdr->size >= sizeof(*hdr) + sizeof(uint32_t) )
+        {
+            req->fid = get_unaligned(par);
+            break;
+        }
+        req->barrier = true;
+        break;
+
+    default:
+        /* Version, attach and anything unknown are run in isolation. */
+        req->barrier = true;
+        break;
+    }
+}
+
+/*
+ * Requests using the same fid must be executed in order, including a walk
+ * creating the fid used by a later request.
+ */
+static bool req_conflict(const struct p9_req *earlier,
+                         const struct p9_req *later)
+{
+    if ( earlier->barrier || later->barrier )
+        return true;
+
+    if ( earlier->fid == later->fid )
+        return true;
+    if ( earlier->newfid != ~0U &&
+         (earlier->newfid == later->fid || earlier->newfid == later->newfid) )
+        return true;
+    if ( later->newfid != ~0U && later->newfid == earlier->fid )
+        return true;
+
+    return false;
+}
+
+/*
+ * Check whether req (not yet executed) must wait for prev or any request
+ * received before prev. A zero-copy read still needs its fid until the
+ * response has been sent. Called with ring->mutex held.
+ */
+static bool req_blocked(const struct p9_req *prev, const struct p9_req *req)
+{
+    for ( ; prev; prev = XEN_TAILQ_PREV(prev, busyhead, list) )
+        if ( (prev->state != REQ_DONE || prev->zc_fid) &&
+             req_conflict(prev, req) )
+            return true;
+
+    return false;
+}
+
+/* Queue all requests which may run now. Called with ring->mutex held. */
+static void ring_kick(struct ring *ring)
+{
+    struct p9_req *req;
+    bool queued = false;
+
+    if ( !n_workers || ring->stop_thread || ring->error )
+        return;
+
+    XEN_TAILQ_FOREACH(req, &ring->reqs_busy, list)
+    {
+        if ( req->state != REQ_WAITING ||
+             req_blocked(XEN_TAILQ_PREV(req, busyhead, list), req) )
+            continue;
+
+        req->state = REQ_QUEUED;
+        pthread_mutex_lock(&work_mutex);
+        XEN_TAILQ_INSERT_TAIL(&work_queue, req, work);
+        pthread_mutex_unlock(&work_mutex);
+        queued = true;
+    }
+
+    if ( queued )
+        pthread_cond_broadcast(&work_cond);
+}
+
+static void *worker_thread(void *arg)
+{
+    struct p9_req *req;
+    struct ring *ring;
+    enum p9_req_state state;
+
+    pthread_mutex_lock(&work_mutex);
+
+    while ( !workers_stop )
+    {
+        req = XEN_TAILQ_FIRST(&work_queue);
+        if ( !req )
+        {
+            pthread_cond_wait(&work_cond, &work_mutex);
+            continue;
+        }
+        XEN_TAILQ_REMOVE(&work_queue, req, work);
+        pthread_mutex_unlock(&work_mutex);
+
+        ring = req->ring;
+        if ( req->state == REQ_ZC_QUEUED )
+        {
+            zc_read_fill(req);
+            state = REQ_ZC_DONE;
+        }
+        else
+        {
+            p9_exec(req);
+            state = REQ_DONE;
+        }
+
+        pthread_mutex_lock(&ring->mutex);
+        req->state = state;
+        ring_kick(ring);
+        pthread_cond_signal(&ring->cond);
+        pthread_mutex_unlock(&ring->mutex);
+
+        pthread_mutex_lock(&work_mutex);
+    }
+
+    pthread_mutex_unlock(&work_mutex);
+
+    return NULL;
+}
+
+int start_workers(unsigned int n)
+{
+    workers = calloc(n, sizeof(*workers));
+    if ( n && !workers )
+        return -1;
+
+    for ( n_workers = 0; n_workers < n; n_workers++ )
+    {
+        if ( pthread_create(workers + n_workers, NULL, worker_thread, NULL) )
+        {
+            stop_workers();
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void stop_workers(void)
+{
+    unsigned int i;
+
+    pthread_mutex_lock(&work_mutex);
+    workers_stop = true;
+    pthread_cond_broadcast(&work_cond);
+    pthread_mutex_unlock(&work_mutex);
+
+    for ( i = 0; i < n_workers; i++ )
+        pthread_join(workers[i], NULL);
+
+    free(workers);
+    workers = NULL;
+    n_workers = 0;
+    workers_stop = false;
+}
+
+/*
+ * Zero-copy reads and writes of regular files.
+ *
+ * Write data is written to the file directly from the ring by the I/O thread
+ * while receiving the request, after all earlier requests for the same fid
+ * have finished. Read data is read from the file directly into the ring by a
+ * worker thread, once the I/O thread has reserved ring space for the
+ * response behind the space reserved for all earlier responses. The I/O
+ * thread then fills in the header and makes the responses visible to the
+ * frontend in request order.
+ */
+static void zc_write_start(struct ring *ring, struct p9_req *req)
+{
+    struct p9_header *hdr = req->buffer;
+    struct p9_fid *fidp;
+    uint32_t fid;
+    uint64_t off;
+    uint32_t len;
+
+    req->str_used = 0;
+    fill_data(req, "ULU", &fid, &off, &len);
+
+    req->zc_started = true;
+    req->zc_off = off;
+    req->zc_count = len;
+    req->zc_done = 0;
+    req->zc_err = 0;
+
+    /* As for the copy path, the data must be contained in the request. */
+    if ( len > hdr->size - P9_WRITE_HDRSZ )
+    {
+        req->zc_err = EINVAL;
+        req->zc_fid = NULL;
+        return;
+    }
+
+    fidp = get_fid_ref(ring->device, fid);
+    if ( fidp && (!fidp->opened || fidp->isdir) )
+    {
+        free_fid(ring->device, fidp);
+        fidp = NULL;
+    }
+    if ( !fidp )
+        req->zc_err = EBADF;
+    req->zc_fid = fidp;
+}
+
+/* Write up to len bytes from the ring, returns the number of bytes consumed. */
+static unsigned int zc_write_data(struct ring *ring, struct p9_req *req,
+                                  unsigned int len)
+{
+    struct iovec iov[2];
+    unsigned int n_iov;
+    ssize_t ret;
+
+    len = min(len, ring_out_data(ring));
+
+    /* Data after an error or beyond the count is just consumed. */
+    if ( !req->zc_err && req->zc_done < req->zc_count )
+    {
+        n_iov = ring_iov(ring, ring->data.out, ring->cons_pvt_out,
+                         min(len, req->zc_count - req->zc_done), iov);
+        ret = pwritev(req->zc_fid->fd, iov, n_iov,
+                      req->zc_off + req->zc_done);
+        if ( ret <= 0 )
+            req->zc_err = ret ? errno : ENOSPC;
+        else
+        {
+            req->zc_done += ret;
+            len = ret;
+        }
+    }
+
+    xen_rmb();           /* Read data out before setting visible consumer. */
+    ring->cons_pvt_out += len;
+    ring->intf->out_cons = ring->cons_pvt_out;
+
+    /* Signal that more space is available now. */
+    xenevtchn_notify(xe, ring->evtchn);
+
+    return len;
+}
+
+static void zc_write_finish(struct ring *ring, struct p9_req *req)
+{
+    struct p9_header *hdr = req->buffer;
+    uint32_t written = req->zc_done;
+
+    if ( written )
+        fill_buffer(req, hdr->cmd + 1, hdr->tag, "U", &written);
+    else
+        p9_error(req, hdr->tag, req->zc_err ?: EINVAL);
+
+    free_fid(ring->device, req->zc_fid);
+    req->zc_fid = NULL;
+}
+
+/* Read the data of a zero-copy read into the ring space reserved for it. */
+static void zc_read_fill(struct p9_req *req)
+{
+    struct ring *ring = req->ring;
+    struct iovec iov[2];
+    unsigned int n_iov;
+    uint32_t len = 0;
+    ssize_t ret = 0;
+
+    while ( len < req->zc_count )
+    {
+        n_iov = ring_iov(ring, ring->data.in,
+                         req->zc_prod + P9_READ_HDRSZ + len,
+                         req->zc_count - len, iov);
+        ret = preadv(req->zc_fid->fd, iov, n_iov, req->zc_off + len);
+        if ( ret <= 0 )
+            break;
+        len += ret;
+    }
+
+    req->zc_done = len;
+    req->zc_err = ret < 0 ? errno : 0;
+}
+
+/*
+ * Reserve ring space for as many zero-copy reads as possible and have their
+ * data read by the workers, or directly without workers.
+ * Called with ring->mutex held.
+ */
+static void zc_read_reserve(struct ring *ring)
+{
+    struct p9_req *req;
+    bool queued = false;
+
+    while ( (req = zc_read_next(ring)) != NULL )
+    {
+        req->zc_prod = ring->prod_rsv_in;
+        ring->prod_rsv_in += P9_READ_HDRSZ + req->zc_count;
+
+        if ( !n_workers )
+        {
+            zc_read_fill(req);
+            req->state = REQ_ZC_DONE;
+            continue;
+        }
+
+        req->state = REQ_ZC_QUEUED;
+        pthread_mutex_lock(&work_mutex);
+        XEN_TAILQ_INSERT_TAIL(&work_queue, req, work);
+        pthread_mutex_unlock(&work_mutex);
+        queued = true;
+    }
+
+    if ( queued )
+        pthread_cond_broadcast(&work_cond);
+}
+
+/*
+ * Send the response of a zero-copy read. The data has been read into the
+ * ring behind the space for the header, which is filled in now, before the
+ * complete response is made visible to the frontend.
+ */
+static void put_zc_read(struct ring *ring, struct p9_req *req)
+{
+    struct p9_header *hdr = req->buffer;
+    struct {
+        struct p9_header hdr;
+        uint32_t count;
+    } __attribute__((packed)) head;
+    RING_IDX prod, cons;
+
+    /*
+     * An earlier read came back short, leaving a gap before the space
+     * reserved for this one. Read the data again right behind the previous
+     * response, which resp_ready() made sure no other read is writing to.
+     */
+    if ( req->zc_prod != ring->prod_pvt_in )
+    {
+        req->zc_prod = ring->prod_pvt_in;
+        zc_read_fill(req);
+    }
+
+    free_fid(ring->device, req->zc_fid);
+    req->zc_fid = NULL;
+
+    if ( req->zc_err && !req->zc_done )
+    {
+        req->str_used = 0;
+        p9_error(req, hdr->tag, req->zc_err);
+        put_response_bytes(ring, req->buffer, 0, hdr->size);
+        return;
+    }
+
+    head.hdr.size = P9_READ_HDRSZ + req->zc_done;
+    head.hdr.cmd = P9_CMD_READ + 1;
+    head.hdr.tag = hdr->tag;
+    head.count = req->zc_done;
+    prod = xen_9pfs_mask(ring->prod_pvt_in, ring->ring_size);
+    cons = xen_9pfs_mask(ring->intf->in_cons, ring->ring_size);
+    xen_9pfs_write_packet(ring->data.in, &head, sizeof(head), &prod, cons,
+                          ring->ring_size);
+
+    xen_wmb();           /* Write data out before setting visible producer. */
+    ring->prod_pvt_in += P9_READ_HDRSZ + req->zc_done;
+    ring->intf->in_prod = ring->prod_pvt_in;
+}
+
+static struct p9_req *get_free_req(struct ring *ring)
+{
+    struct p9_req *req;
+
+    pthread_mutex_lock(&ring->mutex);
+    req = XEN_TAILQ_FIRST(&ring->reqs_free);
+    if ( req )
+        XEN_TAILQ_REMOVE(&ring->reqs_free, req, list);
+    pthread_mutex_unlock(&ring->mutex);
+
+    if ( req || ring->n_reqs == MAX_RING_REQS )
+        return req;
+
+    req = calloc(1, sizeof(*req));
+    if ( !req )
+        return NULL;
+    req->buffer = malloc(ring->ring_size);
+    if ( !req->buffer )
+    {
+        free(req);
+        return NULL;
+    }
+    req->ring = ring;
+    ring->n_reqs++;
+
+    return req;
+}
+
+static void free_reqs(struct ring *ring)
+{
+    struct p9_req *req;
+
+    /* Wait for requests still being executed by workers. */
+    pthread_mutex_lock(&ring->mutex);
+    for ( ; ; )
+    {
+        XEN_TAILQ_FOREACH(req, &ring->reqs_busy, list)
+            if ( req->state == REQ_QUEUED || req->state == REQ_ZC_QUEUED )
+                break;
+        if ( !req )
+            break;
+        pthread_cond_wait(&ring->cond, &ring->mutex);
+    }
+    pthread_mutex_unlock(&ring->mutex);
+
+    if ( ring->req_in )
+        XEN_TAILQ_INSERT_TAIL(&ring->reqs_free, ring->req_in, list);
+    ring->req_in = NULL;
+    XEN_TAILQ_CONCAT(&ring->reqs_free, &ring->reqs_busy, list);
+
+    while ( (req = XEN_TAILQ_FIRST(&ring->reqs_free)) != NULL )
+    {
+        XEN_TAILQ_REMOVE(&ring->reqs_free, req, list);
+        free_fid(ring->device, req->zc_fid);
+        free(req->str);
+        free(req->buffer);
+        free(req);
+    }
+
+    ring->n_reqs = 0;
+}
+
 void *io_thread(void *arg)
 {
     struct ring *ring = arg;
     unsigned int count = 0;
+    unsigned int resp_count = 0;
+    unsigned int resp_size;
+    uint32_t max_size;
     struct p9_header hdr = { .size = 0 };
+    struct p9_req *req;
     bool in_hdr = true;
 
     ring->max_size = ring->ring_size;
-    ring->buffer = malloc(ring->max_size);
-    if ( !ring->buffer )
-    {
-        syslog(LOG_CRIT, "memory allocation failure!");
-        return NULL;
-    }
+    ring->prod_rsv_in = ring->prod_pvt_in;
+    XEN_TAILQ_INIT(&ring->reqs_busy);
+    XEN_TAILQ_INIT(&ring->reqs_free);
 
     while ( !ring->stop_thread )
     {
@@ -1430,103 +2094,145 @@ void *io_thread(void *arg)
                 syslog(LOG_WARNING, "xenevtchn_unmask() failed");
             pthread_cond_wait(&ring->cond, &ring->mutex);
         }
+        /* Updated by Tversion, which is executed by a worker thread. */
+        max_size = ring->max_size;
         pthread_mutex_unlock(&ring->mutex);
 
         if ( ring->stop_thread || ring->error )
             continue;
 
-        if ( !ring->handle_response )
+        /* Receive new requests as long as there are free request slots. */
+        while ( ring_out_data(ring) )
         {
+            if ( !ring->req_in )
+            {
+                ring->req_in = get_free_req(ring);
+                if ( !ring->req_in )
+                {
+                    if ( ring->n_reqs )
+                        break;
+                    syslog(LOG_CRIT, "memory allocation failure!");
+                    ring->error = true;
+                    break;
+                }
+            }
+            req = ring->req_in;
+
             if ( in_hdr )
             {
-                count += get_request_bytes(ring, count, sizeof(hdr));
+                count += get_request_bytes(ring, req->buffer, count,
+                                           sizeof(hdr));
                 if ( count != sizeof(hdr) )
                     continue;
-                hdr = *(struct p9_header *)ring->buffer;
-                if ( hdr.size > ring->max_size || hdr.size < sizeof(hdr) )
+                hdr = *(struct p9_header *)req->buffer;
+                if ( hdr.size > max_size || hdr.size < sizeof(hdr) )
                 {
                     syslog(LOG_ERR, "%u.%u specified illegal request length %u",
                            ring->device->domid, ring->device->devid, hdr.size);
                     ring->error = true;
-                    continue;
+                    break;
                 }
                 in_hdr = false;
+                req->zc_write = hdr.cmd == P9_CMD_WRITE &&
+                                hdr.size >= P9_WRITE_HDRSZ + P9_ZC_MIN;
+                req->zc_started = false;
             }
 
-            count += get_request_bytes(ring, count, hdr.size);
-            if ( count < hdr.size )
-                continue;
-
-            ring->str_used = 0;
-
-            switch ( hdr.cmd )
+            if ( req->zc_write )
             {
-            case P9_CMD_VERSION:
-                p9_version(ring, &hdr);
-                break;
-
-            case P9_CMD_ATTACH:
-                p9_attach(ring, &hdr);
-                break;
-
-            case P9_CMD_WALK:
-                p9_walk(ring, &hdr);
-                break;
-
-            case P9_CMD_OPEN:
-                p9_open(ring, &hdr);
-                break;
-
-            case P9_CMD_CREATE:
-                p9_create(ring, &hdr);
-                break;
-
-            case P9_CMD_READ:
-                p9_read(ring, &hdr);
-                break;
+                if ( count < P9_WRITE_HDRSZ )
+                {
+                    count += get_request_bytes(ring, req->buffer, count,
+                                               P9_WRITE_HDRSZ);
+                    if ( count < P9_WRITE_HDRSZ )
+                        continue;
+                    req_classify(req);
+                }
 
-            case P9_CMD_WRITE:
-                p9_write(ring, &hdr);
-                break;
+                if ( !req->zc_started )
+                {
+                    pthread_mutex_lock(&ring->mutex);
+                    ring->zc_blocked =
+                        req_blocked(XEN_TAILQ_LAST(&ring->reqs_busy, busyhead),
+                                    req);
+                    pthread_mutex_unlock(&ring->mutex);
+                    if ( ring->zc_blocked )
+                        break;
+                    zc_write_start(ring, req);
+                }
 
-            case P9_CMD_CLUNK:
-                p9_clunk(ring, &hdr);
-                break;
+                count += zc_write_data(ring, req, hdr.size - count);
+                if ( count < hdr.size )
+                    continue;
 
-            case P9_CMD_STAT:
-                p9_stat(ring, &hdr);
-                break;
+                zc_write_finish(ring, req);
+            }
+            else
+            {
+                count += get_request_bytes(ring, req->buffer, count, hdr.size);
+                if ( count < hdr.size )
+                    continue;
 
-            default:
-                syslog(LOG_DEBUG, "%u.%u sent unhandled command %u\n",
-                       ring->device->domid, ring->device->devid, hdr.cmd);
-                p9_error(ring, hdr.tag, EOPNOTSUPP);
-                break;
+                req_classify(req);
             }
 
-            ring->handle_response = true;
-            hdr.size = ((struct p9_header *)ring->buffer)->size;
+            req->state = REQ_WAITING;
+            ring->req_in = NULL;
+            in_hdr = true;
             count = 0;
+
+            if ( !req->zc_write && !n_workers )
+                p9_exec(req);
+            if ( req->zc_write || !n_workers )
+                req->state = REQ_DONE;
+
+            pthread_mutex_lock(&ring->mutex);
+            XEN_TAILQ_INSERT_TAIL(&ring->reqs_busy, req, list);
+            ring_kick(ring);
+            pthread_mutex_unlock(&ring->mutex);
         }
 
-        if ( ring->handle_response )
+        /* Send responses in request order. */
+        for ( ; ; )
         {
-            count += put_response_bytes(ring, count, hdr.size);
+            pthread_mutex_lock(&ring->mutex);
+            zc_read_reserve(ring);
+            req = XEN_TAILQ_FIRST(&ring->reqs_busy);
+            if ( req && !resp_ready(ring, req) )
+                req = NULL;
+            pthread_mutex_unlock(&ring->mutex);
+
+            if ( !req )
+                break;
 
-            if ( count == hdr.size )
+            if ( req->state == REQ_ZC_DONE )
+                put_zc_read(ring, req);
+            else
             {
-                /* Signal presence of response. */
-                xenevtchn_notify(xe, ring->evtchn);
-
-                ring->handle_response = false;
-                in_hdr = true;
-                count = 0;
+                resp_size = ((struct p9_header *)req->buffer)->size;
+                resp_count += put_response_bytes(ring, req->buffer, resp_count,
+                                                 resp_size);
+                if ( resp_count != resp_size )
+                    break;
+                resp_count = 0;
             }
+
+            /* Signal presence of response. */
+            xenevtchn_notify(xe, ring->evtchn);
+
+            pthread_mutex_lock(&ring->mutex);
+            XEN_TAILQ_REMOVE(&ring->reqs_busy, req, list);
+            XEN_TAILQ_INSERT_HEAD(&ring->reqs_free, req, list);
+            /* Drop space left reserved by short reads once all are sent. */
+            req = XEN_TAILQ_FIRST(&ring->reqs_busy);
+            if ( !req || !req_zc_reserved(req) )
+                ring->prod_rsv_in = ring->prod_pvt_in;
+            ring_kick(ring);
+            pthread_mutex_unlock(&ring->mutex);
         }
     }
 
-    free(ring->str);
-    free(ring->buffer);
+    free_reqs(ring);
 
     ring->thread_active = false;
 
@@ -20,6 +20,11 @@
  * As an additional security measure the maximum file space used by the guest
  * can be limited by the backend Xenstore node "max-size" specifying the size
  * in MBytes. This size includes the size of the root directory of the guest.
+ *
+ * Requests are executed by a pool of worker threads, the number of workers
+ * defaults to the number of online CPUs (at most 16) and can be set via the
+ * environment variable XEN_9PFSD_WORKERS. Setting it to 0 results in each
+ * ring's requests being handled serially by the ring's I/O thread.
  */
 
 #include <err.h>
@@ -39,6 +44,7 @@
 #include <unistd.h>
 #include <xengnttab.h>
 #include <xenstore.h>
+#include <xen-tools/common-macros.h>
 
 #include "xen-9pfsd.h"
 
@@ -305,7 +311,7 @@ static device *new_device(unsigned int domid, unsigned int devid)
     }
 
     pthread_mutex_init(&device->fid_mutex, NULL);
-    XEN_TAILQ_INIT(&device->fids);
+    init_fids(device);
 
     val = read_backend_node(device, "security_model");
     if ( !val || strcmp(val, "none") )
@@ -656,6 +662,7 @@ static void close_all(void)
 
         remove_all_devices();
     }
+    stop_workers();
     if ( xe )
         xenevtchn_close(xe);
     if ( xg )
@@ -749,6 +756,19 @@ static void xen_connect(void)
     daemon_running = true;
 }
 
+static unsigned int get_n_workers(void)
+{
+    const char *val = getenv("XEN_9PFSD_WORKERS");
+    long n;
+
+    if ( val )
+        return min(strtoul(val, NULL, 0), (unsigned long)MAX_WORKERS);
+
+    n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return n > 0 ? min((unsigned long)n, (unsigned long)MAX_WORKERS) : 1;
+}
+
 int main(int argc, char *argv[])
 {
     struct sigaction act = { .sa_handler = handle_stop, };
@@ -772,6 +792,9 @@ int main(int argc, char *argv[])
 
     xen_connect();
 
+    if ( start_workers(get_n_workers()) )
+        do_err("could not start worker threads");
+
     if ( !xs_watch(xs, "backend/xen_9pfs", "main") )
         do_err("xs_watch() in main thread failed");
     p[0].fd = xs_fileno(xs);
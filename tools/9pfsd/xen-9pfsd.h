@@ -14,6 +14,10 @@
 #define MAX_RINGS                4
 #define MAX_RING_ORDER           9
 #define MAX_OPEN_FILES_DEFAULT   5
+#define MAX_RING_REQS            8    /* Requests in flight per ring. */
+#define MAX_WORKERS              16
+#define FID_HASH_BITS            6
+#define FID_HASH_SIZE            (1U << FID_HASH_BITS)
 
 struct p9_header {
     uint32_t size;
@@ -22,7 +26,7 @@ struct p9_header {
 } __attribute__((packed));
 
 struct p9_fid {
-    XEN_TAILQ_ENTRY(struct p9_fid) list;
+    XEN_LIST_ENTRY(struct p9_fid) list;
     unsigned int fid;
     unsigned int ref;
     int fd;
@@ -35,6 +39,42 @@ struct p9_fid {
 
 typedef struct device device;
 
+enum p9_req_state {
+    REQ_WAITING,            /* Blocked by an earlier request. */
+    REQ_QUEUED,             /* Handed to the worker pool. */
+    REQ_DONE,               /* Response ready to be sent. */
+    REQ_ZC_QUEUED,          /* Zero-copy read data being read into the ring. */
+    REQ_ZC_DONE,            /* Zero-copy read data in the ring. */
+};
+
+struct p9_req {
+    struct ring *ring;
+    XEN_TAILQ_ENTRY(struct p9_req) list;   /* Ring's free or busy list. */
+    XEN_TAILQ_ENTRY(struct p9_req) work;   /* Worker pool queue. */
+    enum p9_req_state state;
+
+    /* Dependency tracking, see req_conflict(). */
+    uint8_t cmd;
+    bool barrier;
+    uint32_t fid;
+    uint32_t newfid;
+
+    /* Zero-copy read or write, data goes directly from/to the ring. */
+    bool zc_write;          /* Write data is being taken from the ring. */
+    bool zc_started;
+    int zc_err;
+    struct p9_fid *zc_fid;  /* Fid reference while data is pending. */
+    uint64_t zc_off;
+    uint32_t zc_count;
+    uint32_t zc_done;
+    RING_IDX zc_prod;       /* Response space reserved for a read. */
+
+    void *buffer;           /* Request/response buffer. */
+    char *str;              /* String work space. */
+    unsigned int str_size;  /* Size of *str. */
+    unsigned int str_used;  /* Currently used size of *str. */
+};
+
 struct ring {
     device *device;
     pthread_t thread;
@@ -51,16 +91,18 @@ struct ring {
     /* Transport layer data. */
     struct xen_9pfs_data data;
     RING_IDX prod_pvt_in;
+    RING_IDX prod_rsv_in;   /* Reserved for zero-copy reads up to here. */
     RING_IDX cons_pvt_out;
 
     /* Request and response handling. */
     uint32_t max_size;
     bool error;             /* Protocol error - stop processing. */
-    bool handle_response;   /* Main loop now handling response. */
-    void *buffer;           /* Request/response buffer. */
-    char *str;              /* String work space. */
-    unsigned int str_size;  /* Size of *str. */
-    unsigned int str_used;  /* Currently used size of *str. */
+    struct p9_req *req_in;  /* Request currently being received. */
+    bool zc_blocked;        /* req_in waiting for earlier requests. */
+    unsigned int n_reqs;    /* Number of allocated requests. */
+    /* Requests in arrival order, responses are sent in this order. */
+    XEN_TAILQ_HEAD(busyhead, struct p9_req) reqs_busy;
+    XEN_TAILQ_HEAD(freehead, struct p9_req) reqs_free;
 };
 
 struct device {
@@ -86,7 +128,7 @@ struct device {
 
     /* File system handling. */
     pthread_mutex_t fid_mutex;
-    XEN_TAILQ_HEAD(fidhead, struct p9_fid) fids;
+    XEN_LIST_HEAD(fidhead, struct p9_fid) fids[FID_HASH_SIZE];
     struct p9_fid *root_fid;
     unsigned int n_fids;
 };
@@ -94,6 +136,9 @@ struct device {
 extern xenevtchn_handle *xe;
 
 void *io_thread(void *arg);
+int start_workers(unsigned int n);
+void stop_workers(void);
+void init_fids(device *device);
 void free_fids(device *device);
 
 #endif /* XEN_9PFSD_H */
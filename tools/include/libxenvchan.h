@@ -42,6 +42,7 @@
  *  compile time, so the macros in ring.h cannot be used to access the rings.
  */
 
+#include <sys/uio.h>
 #include <xen/io/libxenvchan.h>
 #include <xen/xen.h>
 #include <xen/sys/evtchn.h>
@@ -158,6 +159,69 @@ int libxenvchan_send(struct libxenvchan *ctrl, const void *data, size_t size);
  *         the vchan is nonblocking)
  */
 int libxenvchan_write(struct libxenvchan *ctrl, const void *data, size_t size);
+/**
+ * Stream-based scatter receive: like libxenvchan_read(), but fills the
+ * buffers described by iov in order, consuming the data with a single
+ * index update and notification.
+ * @param ctrl The vchan control structure
+ * @param iov Buffers for data that was read
+ * @param iovcnt Number of entries in iov
+ * @return -1 on error, otherwise the amount of data read (which may be zero if
+ *         the vchan is nonblocking)
+ */
+int libxenvchan_readv(struct libxenvchan *ctrl, const struct iovec *iov,
+                      int iovcnt);
+/**
+ * Stream-based gather send: like libxenvchan_write(), but sends the buffers
+ * described by iov in order, publishing the data with a single index update
+ * and notification.
+ * @param ctrl The vchan control structure
+ * @param iov Buffers of data to send
+ * @param iovcnt Number of entries in iov
+ * @return -1 on error, otherwise the amount of data sent (which may be zero if
+ *         the vchan is nonblocking)
+ */
+int libxenvchan_writev(struct libxenvchan *ctrl, const struct iovec *iov,
+                       int iovcnt);
+/**
+ * Zero-copy receive: describe all data ready in the receive ring as at most
+ * two regions of ring memory, without consuming it. The regions remain valid
+ * until the data is consumed with libxenvchan_read_commit().
+ * @param ctrl The vchan control structure
+ * @param iov Filled with the regions holding the data
+ * @param iovcnt Set to the number of regions filled in
+ * @return -1 on error, otherwise the amount of data available (which may be
+ *         zero if the vchan is nonblocking)
+ */
+int libxenvchan_read_peek(struct libxenvchan *ctrl, struct iovec iov[2],
+                          int *iovcnt);
+/**
+ * Consume data previously returned by libxenvchan_read_peek(), notifying
+ * the sender once for the whole amount if it is waiting for space.
+ * @param ctrl The vchan control structure
+ * @param size Amount of data to consume, from the start of the first region
+ * @return -1 on error, otherwise size
+ */
+int libxenvchan_read_commit(struct libxenvchan *ctrl, size_t size);
+/**
+ * Zero-copy send: describe all free space in the send ring as at most two
+ * regions of ring memory which the caller may fill directly.
+ * @param ctrl The vchan control structure
+ * @param iov Filled with the free regions
+ * @param iovcnt Set to the number of regions filled in
+ * @return -1 on error, otherwise the amount of space available (which may be
+ *         zero if the vchan is nonblocking)
+ */
+int libxenvchan_write_peek(struct libxenvchan *ctrl, struct iovec iov[2],
+                           int *iovcnt);
+/**
+ * Send data written into the regions returned by libxenvchan_write_peek(),
+ * notifying the receiver once for the whole amount if it is waiting for data.
+ * @param ctrl The vchan control structure
+ * @param size Amount of data written, from the start of the first region
+ * @return -1 on error, otherwise size
+ */
+int libxenvchan_write_commit(struct libxenvchan *ctrl, size_t size);
 /**
  * Waits for reads or writes to unblock, or for a close
  */
@@ -852,6 +852,12 @@ long long xc_logdirty_control(xc_interface *xch,
                               unsigned long pages,
                               unsigned int mode,
                               xc_shadow_op_stats_t *stats);
+/*
+ * Set up (pages != 0) or tear down (pages == 0) the dirty pfn ring of a
+ * domain, mapped with xenforeignmemory_map_resource() of type
+ * XENMEM_resource_dirty_ring.  See struct xen_domctl_dirty_ring.
+ */
+int xc_logdirty_ring(xc_interface *xch, uint32_t domid, unsigned int pages);
 
 int xc_get_paging_mempool_size(xc_interface *xch, uint32_t domid, uint64_t *size);
 int xc_set_paging_mempool_size(xc_interface *xch, uint32_t domid, uint64_t size);
@@ -1113,6 +1119,35 @@ int xc_evtchn_reset(xc_interface *xch,
 typedef struct evtchn_status xc_evtchn_status_t;
 int xc_evtchn_status(xc_interface *xch, xc_evtchn_status_t *status);
 
+/**
+ * This function sends an event on each of the given local ports, as
+ * xenevtchn_notify() would, but using as few hypercalls as possible and
+ * notifying each target vCPU at most once per hypercall.
+ *
+ * @parm xch a handle to an open hypervisor interface
+ * @parm ports the local ports to send events on
+ * @parm nr_ports the number of entries in @ports
+ * @parm nr_sent if not NULL, set to the number of ports successfully sent
+ * @return 0 on success, -1 on failure
+ */
+int xc_evtchn_send_multi(xc_interface *xch, const evtchn_port_t *ports,
+                         unsigned int nr_ports, unsigned int *nr_sent);
+
+/**
+ * This function configures moderation of the events delivered on one of the
+ * calling domain's ports: events arriving less than @interval_us after the
+ * previous delivery are held back, until the interval elapses or @count
+ * events have been held.
+ *
+ * @parm xch a handle to an open hypervisor interface
+ * @parm port the local port to moderate
+ * @parm interval_us the minimum delivery interval, 0 to disable moderation
+ * @parm count the number of held events forcing a delivery, 0 for no limit
+ * @return 0 on success, -1 on failure
+ */
+int xc_evtchn_set_moderation(xc_interface *xch, evtchn_port_t port,
+                             uint32_t interval_us, uint32_t count);
+
 
 
 int xc_physdev_pci_access_modify(xc_interface *xch,
@@ -1390,6 +1425,18 @@ int xc_lockprof_query(xc_interface *xch,
                       uint64_t *time,
                       xc_hypercall_buffer_t *data);
 
+typedef xen_sysctl_lockprof_site_t xc_lockprof_site_t;
+/* A sample_rate of 0 disables contention sampling. */
+int xc_lockprof_contention_set(xc_interface *xch, uint32_t sample_rate);
+int xc_lockprof_contention_reset(xc_interface *xch);
+/* *n_elems: size of sites on input, number of sites available on output. */
+int xc_lockprof_contention_query(xc_interface *xch,
+                                 uint32_t *n_elems,
+                                 uint32_t *sample_rate,
+                                 uint64_t *time,
+                                 uint64_t *dropped,
+                                 xc_hypercall_buffer_t *sites);
+
 void *xc_memalign(xc_interface *xch, size_t alignment, size_t size);
 
 /**
@@ -2029,6 +2076,27 @@ int xc_mem_paging_prep(xc_interface *xch, uint32_t domain_id, uint64_t gfn);
 int xc_mem_paging_load(xc_interface *xch, uint32_t domain_id,
                        uint64_t gfn, void *buffer);
 
+/*
+ * Fetch and clear the accessed state of nr gfns starting at gfn.  Bit i of
+ * bitmap (which must hold nr bits) is set if gfn + i was accessed since the
+ * previous sample.  Fails with EOPNOTSUPP if the hardware can't track
+ * accesses (e.g. no EPT A/D bits).
+ */
+int xc_mem_paging_sample(xc_interface *xch, uint32_t domain_id,
+                         uint64_t gfn, uint32_t nr, unsigned long *bitmap);
+
+/*
+ * Nominate / evict the nr gfns listed in gfns (at most
+ * XENMEM_paging_batch_max).  Bit i of done is set if gfns[i] was nominated /
+ * evicted, gfns which are busy or can't be paged are skipped.
+ */
+int xc_mem_paging_nominate_batch(xc_interface *xch, uint32_t domain_id,
+                                 const uint64_t *gfns, uint32_t nr,
+                                 unsigned long *done);
+int xc_mem_paging_evict_batch(xc_interface *xch, uint32_t domain_id,
+                              const uint64_t *gfns, uint32_t nr,
+                              unsigned long *done);
+
 /** 
  * Access tracking operations.
  * Supported only on Intel EPT 64 bit processors.
@@ -2297,6 +2365,37 @@ int xc_memshr_range_share(xc_interface *xch,
                           uint64_t first_gfn,
                           uint64_t last_gfn);
 
+/* Share arbitrary pairs of gfns of a source and a client domain, such as
+ * found to be duplicates by hashing the domains' memory.  Both pages of a
+ * pair get nominated, and shared if their contents are identical.  The
+ * domains needn't be paused.  Bit i of shared (nr bits) tells whether the
+ * pages of pair i got shared; other pairs were unsharable or differed.
+ *
+ * May fail with -EINVAL if memory sharing is not enabled on either of the
+ * domains, or with -ENOMEM if there isn't enough memory available to store
+ * the sharing metadata, in which case the pairs past the last one reported
+ * in shared were not attempted.
+ */
+int xc_memshr_share_batch(xc_interface *xch,
+                          uint32_t source_domain,
+                          uint32_t client_domain,
+                          const uint64_t *source_gfns,
+                          const uint64_t *client_gfns,
+                          uint32_t nr,
+                          uint8_t *shared);
+
+/* Report the p2m type of nr gfns of a domain, one XENMEM_SHARING_GFN_* per
+ * gfn in types, without populating, paging in or unsharing them.  Unlike
+ * the other sharing ops this doesn't enable sharing on the domain; enabled
+ * (if not NULL) tells whether it is.  nr may be 0 to only query the latter.
+ */
+int xc_memshr_query_batch(xc_interface *xch,
+                          uint32_t domid,
+                          const uint64_t *gfns,
+                          uint32_t nr,
+                          uint8_t *types,
+                          bool *enabled);
+
 int xc_memshr_fork(xc_interface *xch,
                    uint32_t source_domain,
                    uint32_t client_domain,
@@ -2304,11 +2403,13 @@ int xc_memshr_fork(xc_interface *xch,
                    bool block_interrupts);
 
 /*
- * Note: this function is only intended to be used on short-lived forks that
- * haven't yet aquired a lot of memory. In case the fork has a lot of memory
- * it is likely more performant to create a new fork with xc_memshr_fork.
+ * Resetting the memory of a fork costs in proportion to the number of pages
+ * the fork wrote or populated since it was created or last reset, rather
+ * than to its size, as long as these could all be logged.  Otherwise (eg.
+ * when populating superpages) the whole fork is scanned.
  *
- * With VMs that have a lot of memory this call may block for a long time.
+ * With forks that wrote to a lot of memory this call may block for a long
+ * time.
  */
 int xc_memshr_fork_reset(xc_interface *xch, uint32_t forked_domain,
                          bool reset_state, bool reset_memory);
@@ -365,6 +365,54 @@ int xendevicemodel_pin_memory_cacheattr(
 int xendevicemodel_nr_vcpus(
     xendevicemodel_handle *dmod, domid_t domid, unsigned int *vcpus);
 
+/**
+ * This function allocates the posted write ring of an IOREQ Server.
+ *
+ * The ring is signalled on the buffered ioreq event channel, so the
+ * server must have been created with buffered ioreq handling, and it must
+ * not have been enabled yet.  The ring can then be mapped using
+ * XENMEM_resource_ioreq_server_frame_posted() resource frames.
+ *
+ * @parm dmod a handle to an open devicemodel interface.
+ * @parm domid the domain id to be serviced
+ * @parm id the IOREQ Server id.
+ * @parm nr_frames number of slot pages, a power of two.
+ * @return 0 on success, -1 on failure.
+ */
+int xendevicemodel_set_ioreq_server_posted_ring(
+    xendevicemodel_handle *dmod, domid_t domid, ioservid_t id,
+    unsigned int nr_frames);
+
+/**
+ * This function registers a range of memory for emulation, allowing
+ * writes to it to be queued on the posted write ring.
+ *
+ * @parm dmod a handle to an open devicemodel interface.
+ * @parm domid the domain id to be serviced
+ * @parm id the IOREQ Server id.
+ * @parm start start of range
+ * @parm end end of range (inclusive).
+ * @return 0 on success, -1 on failure.
+ */
+int xendevicemodel_map_posted_range_to_ioreq_server(
+    xendevicemodel_handle *dmod, domid_t domid, ioservid_t id,
+    uint64_t start, uint64_t end);
+
+/**
+ * This function deregisters a range of memory previously registered with
+ * xendevicemodel_map_posted_range_to_ioreq_server().
+ *
+ * @parm dmod a handle to an open devicemodel interface.
+ * @parm domid the domain id to be serviced
+ * @parm id the IOREQ Server id.
+ * @parm start start of range
+ * @parm end end of range (inclusive).
+ * @return 0 on success, -1 on failure.
+ */
+int xendevicemodel_unmap_posted_range_from_ioreq_server(
+    xendevicemodel_handle *dmod, domid_t domid, ioservid_t id,
+    uint64_t start, uint64_t end);
+
 /**
  * This function restricts the use of this handle to the specified
  * domain.
@@ -657,6 +657,20 @@ long long xc_logdirty_control(xc_interface *xch,
     return (rc == 0) ? domctl.u.shadow_op.pages : rc;
 }
 
+int xc_logdirty_ring(xc_interface *xch, uint32_t domid, unsigned int pages)
+{
+    struct xen_domctl domctl = {
+        .cmd         = XEN_DOMCTL_shadow_op,
+        .domain      = domid,
+        .u.shadow_op = {
+            .op    = XEN_DOMCTL_SHADOW_OP_DIRTY_RING,
+            .pages = pages,
+        }
+    };
+
+    return do_domctl(xch, &domctl);
+}
+
 int xc_get_paging_mempool_size(xc_interface *xch, uint32_t domid, uint64_t *size)
 {
     int rc;
@@ -74,6 +74,43 @@ int xc_evtchn_status(xc_interface *xch, xc_evtchn_status_t *status)
                         sizeof(*status), 1);
 }
 
+int xc_evtchn_send_multi(xc_interface *xch, const evtchn_port_t *ports,
+                         unsigned int nr_ports, unsigned int *nr_sent)
+{
+    struct evtchn_send_multi arg;
+    unsigned int done = 0;
+    int rc = 0;
+
+    while ( done < nr_ports )
+    {
+        arg.nr_ports = min(nr_ports - done, (unsigned int)EVTCHN_SEND_MULTI_MAX);
+        arg.nr_sent = 0;
+        memcpy(arg.ports, ports + done, arg.nr_ports * sizeof(*ports));
+
+        rc = do_evtchn_op(xch, EVTCHNOP_send_multi, &arg, sizeof(arg), 0);
+        done += arg.nr_sent;
+        if ( rc < 0 )
+            break;
+    }
+
+    if ( nr_sent )
+        *nr_sent = done;
+
+    return rc < 0 ? -1 : 0;
+}
+
+int xc_evtchn_set_moderation(xc_interface *xch, evtchn_port_t port,
+                             uint32_t interval_us, uint32_t count)
+{
+    struct evtchn_set_moderation arg = {
+        .port        = port,
+        .interval_us = interval_us,
+        .count       = count,
+    };
+
+    return do_evtchn_op(xch, EVTCHNOP_set_moderation, &arg, sizeof(arg), 0);
+}
+
 /*
  * Local variables:
  * mode: C
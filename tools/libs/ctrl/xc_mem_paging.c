@@ -55,6 +55,40 @@ static int xc_mem_paging_memop(xc_interface *xch, uint32_t domain_id,
     return rc;
 }
 
+static int xc_mem_paging_batch(xc_interface *xch, uint32_t domain_id,
+                               unsigned int op, const uint64_t *gfns,
+                               uint32_t nr, unsigned long *done)
+{
+    xen_mem_paging_op_t mpo;
+    DECLARE_HYPERCALL_BOUNCE_IN(gfns, nr * sizeof(*gfns));
+    DECLARE_HYPERCALL_BOUNCE(done, (nr + 7) / 8,
+                             XC_HYPERCALL_BUFFER_BOUNCE_OUT);
+    int rc = -1;
+
+    if ( xc_hypercall_bounce_pre(xch, gfns) ||
+         xc_hypercall_bounce_pre(xch, done) )
+    {
+        PERROR("Could not bounce memory for XENMEM_paging_op %u", op);
+        goto out;
+    }
+
+    memset(&mpo, 0, sizeof(mpo));
+
+    mpo.op      = op;
+    mpo.domain  = domain_id;
+    mpo.nr      = nr;
+    set_xen_guest_handle(mpo.gfns, gfns);
+    set_xen_guest_handle(mpo.bitmap, done);
+
+    rc = xc_memory_op(xch, XENMEM_paging_op, &mpo, sizeof(mpo));
+
+ out:
+    xc_hypercall_bounce_post(xch, gfns);
+    xc_hypercall_bounce_post(xch, done);
+
+    return rc;
+}
+
 int xc_mem_paging_enable(xc_interface *xch, uint32_t domain_id,
                          uint32_t *port)
 {
@@ -119,6 +153,53 @@ int xc_mem_paging_load(xc_interface *xch, uint32_t domain_id,
                                gfn, buffer);
 }
 
+int xc_mem_paging_nominate_batch(xc_interface *xch, uint32_t domain_id,
+                                 const uint64_t *gfns, uint32_t nr,
+                                 unsigned long *done)
+{
+    return xc_mem_paging_batch(xch, domain_id,
+                               XENMEM_paging_op_nominate_batch,
+                               gfns, nr, done);
+}
+
+int xc_mem_paging_evict_batch(xc_interface *xch, uint32_t domain_id,
+                              const uint64_t *gfns, uint32_t nr,
+                              unsigned long *done)
+{
+    return xc_mem_paging_batch(xch, domain_id,
+                               XENMEM_paging_op_evict_batch,
+                               gfns, nr, done);
+}
+
+int xc_mem_paging_sample(xc_interface *xch, uint32_t domain_id,
+                         uint64_t gfn, uint32_t nr, unsigned long *bitmap)
+{
+    xen_mem_paging_op_t mpo;
+    DECLARE_HYPERCALL_BOUNCE(bitmap, (nr + 7) / 8,
+                             XC_HYPERCALL_BUFFER_BOUNCE_OUT);
+    int rc;
+
+    if ( xc_hypercall_bounce_pre(xch, bitmap) )
+    {
+        PERROR("Could not bounce memory for XENMEM_paging_op_sample");
+        return -1;
+    }
+
+    memset(&mpo, 0, sizeof(mpo));
+
+    mpo.op      = XENMEM_paging_op_sample;
+    mpo.domain  = domain_id;
+    mpo.gfn     = gfn;
+    mpo.nr      = nr;
+    set_xen_guest_handle(mpo.bitmap, bitmap);
+
+    rc = xc_memory_op(xch, XENMEM_paging_op, &mpo, sizeof(mpo));
+
+    xc_hypercall_bounce_post(xch, bitmap);
+
+    return rc;
+}
+
 
 /*
  * Local variables:
@@ -202,6 +202,88 @@ int xc_memshr_range_share(xc_interface *xch,
     return xc_memshr_memop(xch, source_domain, &mso);
 }
 
+int xc_memshr_share_batch(xc_interface *xch,
+                          uint32_t source_domain,
+                          uint32_t client_domain,
+                          const uint64_t *source_gfns,
+                          const uint64_t *client_gfns,
+                          uint32_t nr,
+                          uint8_t *shared)
+{
+    xen_mem_sharing_op_t mso;
+    DECLARE_HYPERCALL_BOUNCE_IN(source_gfns, nr * sizeof(*source_gfns));
+    DECLARE_HYPERCALL_BOUNCE_IN(client_gfns, nr * sizeof(*client_gfns));
+    DECLARE_HYPERCALL_BOUNCE(shared, (nr + 7) / 8,
+                             XC_HYPERCALL_BUFFER_BOUNCE_OUT);
+    int rc = -1;
+
+    if ( xc_hypercall_bounce_pre(xch, source_gfns) ||
+         xc_hypercall_bounce_pre(xch, client_gfns) ||
+         xc_hypercall_bounce_pre(xch, shared) )
+    {
+        PERROR("Could not bounce memory for XENMEM_sharing_op_share_batch");
+        goto out;
+    }
+
+    memset(&mso, 0, sizeof(mso));
+
+    mso.op = XENMEM_sharing_op_share_batch;
+
+    mso.u.batch.client_domain = client_domain;
+    mso.u.batch.nr = nr;
+    set_xen_guest_handle(mso.u.batch.source_gfns, source_gfns);
+    set_xen_guest_handle(mso.u.batch.client_gfns, client_gfns);
+    set_xen_guest_handle(mso.u.batch.bitmap, shared);
+
+    rc = xc_memshr_memop(xch, source_domain, &mso);
+
+ out:
+    xc_hypercall_bounce_post(xch, source_gfns);
+    xc_hypercall_bounce_post(xch, client_gfns);
+    xc_hypercall_bounce_post(xch, shared);
+
+    return rc;
+}
+
+int xc_memshr_query_batch(xc_interface *xch,
+                          uint32_t domid,
+                          const uint64_t *gfns,
+                          uint32_t nr,
+                          uint8_t *types,
+                          bool *enabled)
+{
+    xen_mem_sharing_op_t mso;
+    DECLARE_HYPERCALL_BOUNCE_IN(gfns, nr * sizeof(*gfns));
+    DECLARE_HYPERCALL_BOUNCE(types, nr * sizeof(*types),
+                             XC_HYPERCALL_BUFFER_BOUNCE_OUT);
+    int rc = -1;
+
+    if ( xc_hypercall_bounce_pre(xch, gfns) ||
+         xc_hypercall_bounce_pre(xch, types) )
+    {
+        PERROR("Could not bounce memory for XENMEM_sharing_op_query_batch");
+        goto out;
+    }
+
+    memset(&mso, 0, sizeof(mso));
+
+    mso.op = XENMEM_sharing_op_query_batch;
+
+    mso.u.query.nr = nr;
+    set_xen_guest_handle(mso.u.query.gfns, gfns);
+    set_xen_guest_handle(mso.u.query.types, types);
+
+    rc = xc_memshr_memop(xch, domid, &mso);
+    if ( !rc && enabled )
+        *enabled = mso.u.query.enabled;
+
+ out:
+    xc_hypercall_bounce_post(xch, gfns);
+    xc_hypercall_bounce_post(xch, types);
+
+    return rc;
+}
+
 int xc_memshr_domain_resume(xc_interface *xch,
                             uint32_t domid)
 {
@@ -551,6 +551,58 @@ int xc_lockprof_query(xc_interface *xch,
     return rc;
 }
 
+int xc_lockprof_contention_set(xc_interface *xch, uint32_t sample_rate)
+{
+    struct xen_sysctl sysctl = {};
+
+    sysctl.cmd = XEN_SYSCTL_lockprof_op;
+    sysctl.u.lockprof_op.cmd = XEN_SYSCTL_LOCKPROF_contention_set;
+    sysctl.u.lockprof_op.sample_rate = sample_rate;
+    set_xen_guest_handle(sysctl.u.lockprof_op.sites, HYPERCALL_BUFFER_NULL);
+
+    return do_sysctl(xch, &sysctl);
+}
+
+int xc_lockprof_contention_reset(xc_interface *xch)
+{
+    struct xen_sysctl sysctl = {};
+
+    sysctl.cmd = XEN_SYSCTL_lockprof_op;
+    sysctl.u.lockprof_op.cmd = XEN_SYSCTL_LOCKPROF_contention_reset;
+    set_xen_guest_handle(sysctl.u.lockprof_op.sites, HYPERCALL_BUFFER_NULL);
+
+    return do_sysctl(xch, &sysctl);
+}
+
+int xc_lockprof_contention_query(xc_interface *xch,
+                                 uint32_t *n_elems,
+                                 uint32_t *sample_rate,
+                                 uint64_t *time,
+                                 uint64_t *dropped,
+                                 struct xc_hypercall_buffer *sites)
+{
+    int rc;
+    struct xen_sysctl sysctl = {};
+    DECLARE_HYPERCALL_BUFFER_ARGUMENT(sites);
+
+    sysctl.cmd = XEN_SYSCTL_lockprof_op;
+    sysctl.u.lockprof_op.cmd = XEN_SYSCTL_LOCKPROF_contention_query;
+    sysctl.u.lockprof_op.max_elem = *n_elems;
+    set_xen_guest_handle(sysctl.u.lockprof_op.sites, sites);
+
+    rc = do_sysctl(xch, &sysctl);
+
+    *n_elems = sysctl.u.lockprof_op.nr_elem;
+    if ( sample_rate )
+        *sample_rate = sysctl.u.lockprof_op.sample_rate;
+    if ( time )
+        *time = sysctl.u.lockprof_op.time;
+    if ( dropped )
+        *dropped = sysctl.u.lockprof_op.dropped;
+
+    return rc;
+}
+
 int xc_getcpuinfo(xc_interface *xch, int max_cpus,
                   xc_cpuinfo_t *info, int *nr_cpus)
 {
@@ -246,6 +246,14 @@ struct xc_sr_context
             unsigned long *deferred_pages;
             unsigned long nr_deferred_pages;
             xc_hypercall_buffer_t dirty_bitmap_hbuf;
+
+            /* Dirty pfn ring, if Xen provides one. */
+            xenforeignmemory_resource_handle *dirty_ring_res;
+            struct xen_domctl_dirty_ring *dirty_ring;
+            uint64_t *dirty_ring_pfns;
+            uint32_t dirty_ring_mask;
+            /* Pages dirtied in the last round are listed in the ring. */
+            bool dirty_from_ring;
         } save;
 
         struct /* Restore data. */
@@ -414,6 +414,179 @@ static int send_all_pages(struct xc_sr_context *ctx)
     return send_dirty_pages(ctx, ctx->save.p2m_size);
 }
 
+/*
+ * Send the pages dirtied in the last round, as listed in the dirty pfn ring.
+ * Unlike send_dirty_pages(), this costs time proportional to the number of
+ * dirty pages rather than to the size of the guest.
+ */
+static void teardown_dirty_ring(struct xc_sr_context *ctx);
+
+static int send_ring_pages(struct xc_sr_context *ctx,
+                           unsigned long entries)
+{
+    xc_interface *xch = ctx->xch;
+    struct xen_domctl_dirty_ring *ring = ctx->save.dirty_ring;
+    uint32_t cons = ring->cons, end = ring->round_end;
+    unsigned long written = 0;
+    int rc;
+
+    xen_rmb();
+
+    /*
+     * The bitmap for this round is gone, so a ring claiming more entries
+     * than it can hold leaves no choice but to send everything, and to
+     * stop using the ring.
+     */
+    if ( end - cons > ctx->save.dirty_ring_mask + 1 )
+    {
+        ERROR("Dirty pfn ring has %u entries, larger than the ring (%u)",
+              end - cons, ctx->save.dirty_ring_mask + 1);
+        teardown_dirty_ring(ctx);
+        return send_all_pages(ctx);
+    }
+
+    for ( ; cons != end; ++cons )
+    {
+        xen_pfn_t pfn = ctx->save.dirty_ring_pfns[cons &
+                                                  ctx->save.dirty_ring_mask];
+
+        if ( pfn >= ctx->save.p2m_size )
+            continue;
+
+        rc = add_to_batch(ctx, pfn);
+        if ( rc )
+            return rc;
+
+        /* Update progress, and free up ring space, every 4MB sent. */
+        if ( (written & ((1U << (22 - 12)) - 1)) == 0 )
+        {
+            xc_report_progress_step(xch, written, entries);
+            xen_mb();
+            ring->cons = cons + 1;
+        }
+
+        ++written;
+    }
+
+    xen_mb();
+    ring->cons = cons;
+
+    rc = flush_batch(ctx);
+    if ( rc )
+        return rc;
+
+    if ( written > entries )
+        DPRINTF("Ring contained more entries than expected...");
+
+    xc_report_progress_step(xch, entries, entries);
+
+    return ctx->save.ops.check_vm_state(ctx);
+}
+
+/*
+ * Set up the dirty pfn ring.  This is done before enabling log-dirty mode,
+ * so that the ring can be used from the first CLEAN onwards.  The ring is
+ * optional: without it, the bitmap gets retrieved every round.
+ */
+static void setup_dirty_ring(struct xc_sr_context *ctx)
+{
+    xc_interface *xch = ctx->xch;
+    unsigned int pages = 16;
+    void *addr = NULL;
+
+    /* Size for 1/64th of the guest being dirtied per round. */
+    while ( pages < XEN_DOMCTL_DIRTY_RING_MAX_PAGES &&
+            pages * (PAGE_SIZE / sizeof(uint64_t)) < ctx->save.p2m_size / 64 )
+        pages <<= 1;
+
+    if ( xc_logdirty_ring(xch, ctx->domid, pages) )
+    {
+        DPRINTF("No dirty pfn ring (%d), using the bitmap", errno);
+        return;
+    }
+
+    ctx->save.dirty_ring_res = xenforeignmemory_map_resource(
+        xch->fmem, ctx->domid, XENMEM_resource_dirty_ring, 0, 0, pages + 1,
+        &addr, PROT_READ | PROT_WRITE, 0);
+    if ( !ctx->save.dirty_ring_res )
+    {
+        PERROR("Failed to map dirty pfn ring, using the bitmap");
+        xc_logdirty_ring(xch, ctx->domid, 0);
+        return;
+    }
+
+    ctx->save.dirty_ring = addr;
+    ctx->save.dirty_ring_pfns = addr + PAGE_SIZE;
+    ctx->save.dirty_ring_mask = pages * (PAGE_SIZE / sizeof(uint64_t)) - 1;
+
+    DPRINTF("Using a dirty pfn ring of %u entries",
+            ctx->save.dirty_ring_mask + 1);
+}
+
+static void teardown_dirty_ring(struct xc_sr_context *ctx)
+{
+    xc_interface *xch = ctx->xch;
+
+    if ( !ctx->save.dirty_ring_res )
+        return;
+
+    xenforeignmemory_unmap_resource(xch->fmem, ctx->save.dirty_ring_res);
+    ctx->save.dirty_ring_res = NULL;
+    ctx->save.dirty_ring = NULL;
+    ctx->save.dirty_from_ring = false;
+
+    xc_logdirty_ring(xch, ctx->domid, 0);
+}
+
+/*
+ * End a precopy round.  The pages dirtied in the round are taken from the
+ * dirty pfn ring if possible, else from the bitmap.
+ */
+static int clean_logdirty(struct xc_sr_context *ctx,
+                          xc_shadow_op_stats_t *stats)
+{
+    xc_interface *xch = ctx->xch;
+    struct xen_domctl_dirty_ring *ring = ctx->save.dirty_ring;
+
+    ctx->save.dirty_from_ring = false;
+
+    if ( ring )
+    {
+        if ( xc_logdirty_control(
+                 xch, ctx->domid, XEN_DOMCTL_SHADOW_OP_CLEAN,
+                 NULL, ctx->save.p2m_size,
+                 XEN_DOMCTL_SHADOW_LOGDIRTY_RING, stats) ==
+             ctx->save.p2m_size )
+        {
+            ctx->save.dirty_from_ring = true;
+            return 0;
+        }
+
+        if ( errno != ENOBUFS )
+        {
+            PERROR("Failed to clean logdirty ring");
+            return -1;
+        }
+
+        DPRINTF("Dirty pfn ring overflowed, using the bitmap");
+    }
+
+    if ( xc_logdirty_control(
+             xch, ctx->domid, XEN_DOMCTL_SHADOW_OP_CLEAN,
+             &ctx->save.dirty_bitmap_hbuf, ctx->save.p2m_size,
+             0, stats) != ctx->save.p2m_size )
+    {
+        PERROR("Failed to retrieve logdirty bitmap");
+        return -1;
+    }
+
+    /* The bitmap covers everything in the ring up to this CLEAN. */
+    if ( ring )
+        ring->cons = ring->round_end;
+
+    return 0;
+}
+
 static int enable_logdirty(struct xc_sr_context *ctx)
 {
     xc_interface *xch = ctx->xch;
@@ -534,7 +707,10 @@ static int send_memory_live(struct xc_sr_context *ctx)
             if ( rc )
                 goto out;
 
-            rc = send_dirty_pages(ctx, stats.dirty_count);
+            if ( ctx->save.dirty_from_ring )
+                rc = send_ring_pages(ctx, stats.dirty_count);
+            else
+                rc = send_dirty_pages(ctx, stats.dirty_count);
             if ( rc )
                 goto out;
         }
@@ -551,15 +727,9 @@ static int send_memory_live(struct xc_sr_context *ctx)
         if ( policy_decision != XGS_POLICY_CONTINUE_PRECOPY )
             break;
 
-        if ( xc_logdirty_control(
-                 xch, ctx->domid, XEN_DOMCTL_SHADOW_OP_CLEAN,
-                 &ctx->save.dirty_bitmap_hbuf, ctx->save.p2m_size,
-                 0, &stats) != ctx->save.p2m_size )
-        {
-            PERROR("Failed to retrieve logdirty bitmap");
-            rc = -1;
+        rc = clean_logdirty(ctx, &stats);
+        if ( rc )
             goto out;
-        }
 
         policy_stats->dirty_count = stats.dirty_count;
 
@@ -735,6 +905,8 @@ static int send_domain_memory_live(struct xc_sr_context *ctx)
 {
     int rc;
 
+    setup_dirty_ring(ctx);
+
     rc = enable_logdirty(ctx);
     if ( rc )
         goto out;
@@ -743,6 +915,9 @@ static int send_domain_memory_live(struct xc_sr_context *ctx)
     if ( rc )
         goto out;
 
+    /* The final round, with the domain suspended, uses the bitmap. */
+    teardown_dirty_ring(ctx);
+
     rc = suspend_and_send_dirty(ctx);
     if ( rc )
         goto out;
@@ -827,6 +1002,7 @@ static void cleanup(struct xc_sr_context *ctx)
     DECLARE_HYPERCALL_BUFFER_SHADOW(unsigned long, dirty_bitmap,
                                     &ctx->save.dirty_bitmap_hbuf);
 
+    teardown_dirty_ring(ctx);
 
     xc_shadow_control(xch, ctx->domid, XEN_DOMCTL_SHADOW_OP_OFF,
                       NULL, 0);
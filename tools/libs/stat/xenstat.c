@@ -62,6 +62,8 @@ static void xenstat_uninit_vcpus(xenstat_handle * handle);
 static void xenstat_uninit_xen_version(xenstat_handle * handle);
 static char *xenstat_get_domain_name(xenstat_handle * handle, unsigned int domain_id);
 static void xenstat_prune_domain(xenstat_node *node, unsigned int entry);
+static void xenstat_free_dom_cache(struct xenstat_dom_cache *cache,
+				   unsigned int num);
 
 static xenstat_collector collectors[] = {
 	{ XENSTAT_VCPU, xenstat_collect_vcpus,
@@ -124,6 +126,9 @@ void xenstat_uninit(xenstat_handle * handle)
 	if (handle) {
 		for (i = 0; i < NUM_COLLECTORS; i++)
 			collectors[i].uninit(handle);
+		xenstat_free_dom_cache(handle->dom_cache,
+				       handle->num_dom_cache);
+		free(handle->domaininfo);
 		xc_interface_close(handle->xc_handle);
 		xs_close(handle->xshandle);
 		free(handle->priv);
@@ -131,12 +136,105 @@ void xenstat_uninit(xenstat_handle * handle)
 	}
 }
 
+/* Free per-domain state no longer needed */
+static void xenstat_free_dom_cache(struct xenstat_dom_cache *cache,
+				   unsigned int num)
+{
+	unsigned int i;
+
+	for (i = 0; i < num; i++) {
+		free(cache[i].name);
+		free(cache[i].vcpus);
+	}
+	free(cache);
+}
+
+/* Find the state kept for a domain, or NULL */
+struct xenstat_dom_cache *xenstat_get_dom_cache(xenstat_handle * handle,
+						unsigned int domid)
+{
+	unsigned int lo = 0, hi = handle->num_dom_cache;
+
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+
+		if (handle->dom_cache[mid].id == domid)
+			return &handle->dom_cache[mid];
+		if (handle->dom_cache[mid].id < domid)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return NULL;
+}
+
+/*
+ * Rebuild the per-domain state for the domains in handle->domaininfo,
+ * carrying over what is still valid from the previous call. Names of known
+ * domains are re-read from xenstore a few at a time to pick up renames.
+ * Returns 0 on fatal error, 1 for success.
+ */
+static int xenstat_update_dom_cache(xenstat_handle * handle, unsigned int num)
+{
+#define NAME_REFRESH_BUDGET 64
+	struct xenstat_dom_cache *cache, *old = handle->dom_cache;
+	unsigned int i, j = 0, num_old = handle->num_dom_cache;
+	unsigned int refresh_start = handle->name_cursor;
+
+	/* malloc(0) is not portable */
+	cache = calloc(num ? num : 1, sizeof(*cache));
+	if (cache == NULL)
+		return 0;
+
+	if (num && refresh_start >= num)
+		refresh_start = 0;
+
+	for (i = 0; i < num; i++) {
+		xc_domaininfo_t *info = &handle->domaininfo[i];
+		struct xenstat_dom_cache *c = &cache[i];
+
+		/* Both lists are sorted by domain id */
+		while (j < num_old && old[j].id < info->domain)
+			j++;
+		if (j < num_old && old[j].id == info->domain &&
+		    !memcmp(old[j].uuid, info->handle, sizeof(c->uuid))) {
+			*c = old[j];
+			memset(&old[j], 0, sizeof(old[j]));
+			/*
+			 * A domain whose name wasn't there yet is retried
+			 * every time, as it is hidden until it has one.
+			 */
+			if (c->name && num > NAME_REFRESH_BUDGET &&
+			    (i - refresh_start + num) % num >= NAME_REFRESH_BUDGET)
+				continue;
+			free(c->name);
+		} else {
+			c->id = info->domain;
+			memcpy(c->uuid, info->handle, sizeof(c->uuid));
+		}
+
+		c->name = xenstat_get_domain_name(handle, c->id);
+		if (c->name == NULL && errno == ENOMEM) {
+			xenstat_free_dom_cache(cache, i + 1);
+			return 0;
+		}
+	}
+
+	handle->name_cursor = refresh_start + NAME_REFRESH_BUDGET;
+	xenstat_free_dom_cache(old, num_old);
+	handle->dom_cache = cache;
+	handle->num_dom_cache = num;
+
+	return 1;
+}
+
 xenstat_node *xenstat_get_node(xenstat_handle * handle, unsigned int flags)
 {
-#define DOMAIN_CHUNK_SIZE 256
+#define DOMAIN_CHUNK_SIZE 1024
 	xenstat_node *node;
 	xc_physinfo_t physinfo;
-	xc_domaininfo_t domaininfo[DOMAIN_CHUNK_SIZE];
+	xenstat_domain *domain;
+	unsigned int num = 0, next_domid = 0;
 	int new_domains;
 	unsigned int i;
 
@@ -163,78 +261,81 @@ xenstat_node *xenstat_get_node(xenstat_handle * handle, unsigned int flags)
 	    * handle->page_size;
 
 	node->freeable_mb = 0;
-	/* malloc(0) is not portable, so allocate a single domain.  This will
-	 * be resized below. */
-	node->domains = malloc(sizeof(xenstat_domain));
-	if (node->domains == NULL) {
-		free(node);
-		return NULL;
-	}
 
-	node->num_domains = 0;
+	/* Get the list of domains, as many as possible per hypercall */
 	do {
-		xenstat_domain *domain, *tmp;
+		if (num + DOMAIN_CHUNK_SIZE > handle->domaininfo_size) {
+			xc_domaininfo_t *tmp;
+
+			tmp = realloc(handle->domaininfo,
+				      (num + DOMAIN_CHUNK_SIZE)
+				      * sizeof(*tmp));
+			if (tmp == NULL)
+				goto err;
+			handle->domaininfo = tmp;
+			handle->domaininfo_size = num + DOMAIN_CHUNK_SIZE;
+		}
 
 		new_domains = xc_domain_getinfolist(handle->xc_handle,
-						    node->num_domains, 
-						    DOMAIN_CHUNK_SIZE, 
-						    domaininfo);
+						    next_domid,
+						    DOMAIN_CHUNK_SIZE,
+						    handle->domaininfo + num);
 		if (new_domains < 0)
 			goto err;
 
-		tmp = realloc(node->domains,
-			      (node->num_domains + new_domains)
-			      * sizeof(xenstat_domain));
-		if (tmp == NULL)
-			goto err;
-
-		node->domains = tmp;
-
-		domain = node->domains + node->num_domains;
-
-		/* zero out newly allocated memory in case error occurs below */
-		memset(domain, 0, new_domains * sizeof(xenstat_domain));
+		num += new_domains;
+		if (new_domains)
+			next_domid = handle->domaininfo[num - 1].domain + 1;
+	} while (new_domains == DOMAIN_CHUNK_SIZE);
 
-		for (i = 0; i < new_domains; i++) {
-			/* Fill in domain using domaininfo[i] */
-			domain->id = domaininfo[i].domain;
-			domain->name = xenstat_get_domain_name(handle, 
-							       domain->id);
-			if (domain->name == NULL) {
-				if (errno == ENOMEM) {
-					/* fatal error */
-					xenstat_free_node(node);
-					return NULL;
-				}
-				else {
-					/* failed to get name -- this means the
-					   domain is being destroyed so simply
-					   ignore this entry */
-					continue;
-				}
-			}
-			domain->state = domaininfo[i].flags;
-			domain->cpu_ns = domaininfo[i].cpu_time;
-			domain->num_vcpus = (domaininfo[i].max_vcpu_id+1);
-			domain->vcpus = NULL;
-			domain->cur_mem =
-			    ((unsigned long long)domaininfo[i].tot_pages)
-			    * handle->page_size;
-			domain->max_mem =
-			    domaininfo[i].max_pages == UINT_MAX
-			    ? (unsigned long long)-1
-			    : (unsigned long long)(domaininfo[i].max_pages
-						   * handle->page_size);
-			domain->ssid = domaininfo[i].ssidref;
-			domain->num_networks = 0;
-			domain->networks = NULL;
-			domain->num_vbds = 0;
-			domain->vbds = NULL;
-
-			domain++;
-			node->num_domains++;
+	/* Reuse what is known about domains seen before */
+	if (!xenstat_update_dom_cache(handle, num))
+		goto err;
+
+	/* malloc(0) is not portable, so allocate at least one domain. */
+	node->domains = calloc(num ? num : 1, sizeof(xenstat_domain));
+	if (node->domains == NULL)
+		goto err;
+
+	domain = node->domains;
+	for (i = 0; i < num; i++) {
+		xc_domaininfo_t *info = &handle->domaininfo[i];
+
+		/* Failed to get name -- this means the domain is being
+		 * destroyed so simply ignore this entry */
+		if (handle->dom_cache[i].name == NULL)
+			continue;
+
+		/* Fill in domain using domaininfo[i] */
+		domain->id = info->domain;
+		domain->name = strdup(handle->dom_cache[i].name);
+		if (domain->name == NULL) {
+			/* fatal error */
+			xenstat_free_node(node);
+			return NULL;
 		}
-	} while (new_domains == DOMAIN_CHUNK_SIZE);
+		domain->state = info->flags;
+		domain->cpu_ns = info->cpu_time;
+		domain->num_vcpus = (info->max_vcpu_id+1);
+		domain->num_online_vcpus = info->nr_online_vcpus;
+		domain->vcpus = NULL;
+		domain->cur_mem =
+		    ((unsigned long long)info->tot_pages)
+		    * handle->page_size;
+		domain->max_mem =
+		    info->max_pages == UINT_MAX
+		    ? (unsigned long long)-1
+		    : (unsigned long long)(info->max_pages
+					   * handle->page_size);
+		domain->ssid = info->ssidref;
+		domain->num_networks = 0;
+		domain->networks = NULL;
+		domain->num_vbds = 0;
+		domain->vbds = NULL;
+
+		domain++;
+		node->num_domains++;
+	}
 
 
 	/* Run all the extra data collectors requested */
@@ -277,13 +378,18 @@ void xenstat_free_node(xenstat_node * node)
 
 xenstat_domain *xenstat_node_domain(xenstat_node * node, unsigned int domid)
 {
-	unsigned int i;
+	unsigned int lo = 0, hi = node->num_domains;
+
+	/* Domains are sorted by id; find the appropriate entry. */
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
 
-	/* FIXME: binary search */
-	/* Find the appropriate domain entry in the node struct. */
-	for (i = 0; i < node->num_domains; i++) {
-		if (node->domains[i].id == domid)
-			return &(node->domains[i]);
+		if (node->domains[mid].id == domid)
+			return &(node->domains[mid]);
+		if (node->domains[mid].id < domid)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
 	return NULL;
 }
@@ -456,19 +562,35 @@ static int xenstat_collect_vcpus(xenstat_node * node)
 
 	/* Fill in VCPU information */
 	for (i = 0; i < node->num_domains; i+=inc_index) {
+		xenstat_domain *domain = &node->domains[i];
+		struct xenstat_dom_cache *cache;
+		size_t size = domain->num_vcpus * sizeof(xenstat_vcpu);
+
 		inc_index = 1; /* default is to increment to next domain */
 
-		node->domains[i].vcpus = malloc(node->domains[i].num_vcpus
-						* sizeof(xenstat_vcpu));
-		if (node->domains[i].vcpus == NULL)
+		domain->vcpus = malloc(size);
+		if (domain->vcpus == NULL)
 			return 0;
+
+		/*
+		 * No VCPU has run, or gone on- or offline, since the last
+		 * collection: reuse it
+		 */
+		cache = xenstat_get_dom_cache(node->handle, domain->id);
+		if (cache && cache->vcpus &&
+		    cache->num_vcpus == domain->num_vcpus &&
+		    cache->num_online_vcpus == domain->num_online_vcpus &&
+		    cache->cpu_ns == domain->cpu_ns) {
+			memcpy(domain->vcpus, cache->vcpus, size);
+			continue;
+		}
 	
-		for (vcpu = 0; vcpu < node->domains[i].num_vcpus; vcpu++) {
+		for (vcpu = 0; vcpu < domain->num_vcpus; vcpu++) {
 			/* FIXME: need to be using a more efficient mechanism*/
 			xc_vcpuinfo_t info;
 
 			if (xc_vcpu_getinfo(node->handle->xc_handle,
-					    node->domains[i].id, vcpu, &info) != 0) {
+					    domain->id, vcpu, &info) != 0) {
 				if (errno == ENOMEM) {
 					/* fatal error */ 
 					return 0;
@@ -476,6 +598,8 @@ static int xenstat_collect_vcpus(xenstat_node * node)
 				else {
 					/* domain is in transition - remove
 					   from list */
+					free(domain->name);
+					free(domain->vcpus);
 					xenstat_prune_domain(node, i);
 
 					/* remember not to increment index! */
@@ -484,8 +608,22 @@ static int xenstat_collect_vcpus(xenstat_node * node)
 				}
 			}
 			else {
-				node->domains[i].vcpus[vcpu].online = info.online;
-				node->domains[i].vcpus[vcpu].ns = info.cpu_time;
+				domain->vcpus[vcpu].online = info.online;
+				domain->vcpus[vcpu].ns = info.cpu_time;
+			}
+		}
+
+		if (inc_index && cache) {
+			xenstat_vcpu *tmp = realloc(cache->vcpus, size);
+
+			/* Failing to cache is not fatal */
+			if (tmp != NULL) {
+				memcpy(tmp, domain->vcpus, size);
+				cache->vcpus = tmp;
+				cache->num_vcpus = domain->num_vcpus;
+				cache->num_online_vcpus =
+					domain->num_online_vcpus;
+				cache->cpu_ns = domain->cpu_ns;
 			}
 		}
 	}
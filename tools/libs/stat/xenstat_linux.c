@@ -37,9 +37,41 @@
 #define SYSFS_VBD_PATH "/sys/bus/xen-backend/devices"
 #define XENSTAT_VBD_TYPE_VBD3 3
 
+/* Interface seen in /proc/net/dev, kept between collections */
+struct netdev_entry {
+	char name[17];
+	int vif;			/* Is a Xen VIF */
+	unsigned int domid;
+	xenstat_network net;		/* Statistics from the last scan */
+};
+
+#define NUM_VBD_STATS 5
+static const char *const vbd_stats[NUM_VBD_STATS] = {
+	"statistics/oo_req", "statistics/rd_req", "statistics/wr_req",
+	"statistics/rd_sect", "statistics/wr_sect",
+};
+
+/* Backend device seen in sysfs, with its statistics files kept open */
+struct vbd_entry {
+	char name[256];
+	int fd[NUM_VBD_STATS];
+};
+
+/*
+ * Both /proc/net/dev and the sysfs directory list devices in a stable
+ * order, so the caches are kept in that order and looked up at the
+ * position of the previous collection first.
+ */
 struct priv_data {
 	FILE *procnetdev;
 	DIR *sysfsvbd;
+	regex_t netdev_re;
+	int netdev_re_ok;
+	struct netdev_entry *netdevs;
+	unsigned int num_netdevs;
+	char devBridge[16];
+	struct vbd_entry *vbds;
+	unsigned int num_vbds;
 };
 
 static struct priv_data *
@@ -48,13 +80,10 @@ get_priv_data(xenstat_handle *handle)
 	if (handle->priv != NULL)
 		return handle->priv;
 
-	handle->priv = malloc(sizeof(struct priv_data));
+	handle->priv = calloc(1, sizeof(struct priv_data));
 	if (handle->priv == NULL)
 		return (NULL);
 
-	((struct priv_data *)handle->priv)->procnetdev = NULL;
-	((struct priv_data *)handle->priv)->sysfsvbd = NULL;
-
 	return handle->priv;
 }
 
@@ -75,6 +104,8 @@ static void getBridge(const char *excludeName, char *result, size_t resultLen)
 	char tmp[512] = { 0 };
 
 	d = opendir("/sys/class/net");
+	if (d == NULL)
+		return;
 	while ((de = readdir(d)) != NULL) {
 		if ((strlen(de->d_name) > 0) && (de->d_name[0] != '.')
 			&& (strstr(de->d_name, excludeName) == NULL)) {
@@ -98,7 +129,7 @@ static void getBridge(const char *excludeName, char *result, size_t resultLen)
 
 /* parseNetLine provides regular expression based parsing for lines from /proc/net/dev, all the */
 /* information are parsed but not all are used in our case, ie. for xenstat */
-static int parseNetDevLine(char *line, char *iface, unsigned long long *rxBytes, unsigned long long *rxPackets,
+static int parseNetDevLine(regex_t *r, char *line, char *iface, unsigned long long *rxBytes, unsigned long long *rxPackets,
 		unsigned long long *rxErrs, unsigned long long *rxDrops, unsigned long long *rxFifo,
 		unsigned long long *rxFrames, unsigned long long *rxComp, unsigned long long *rxMcast,
 		unsigned long long *txBytes, unsigned long long *txPackets, unsigned long long *txErrs,
@@ -106,18 +137,11 @@ static int parseNetDevLine(char *line, char *iface, unsigned long long *rxBytes,
 		unsigned long long *txCarrier, unsigned long long *txComp)
 {
 	/* Temporary/helper variables */
-	int ret;
 	char *tmp;
 	int i = 0, x = 0, col = 0;
-	regex_t r;
 	regmatch_t matches[19];
 	int num = 19;
 
-	/* Regular exception to parse all the information from /proc/net/dev line */
-	const char *regex = "([^:]*):([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)"
-			"[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*"
-			"([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)";
-
 	/* Initialize all variables called has passed as non-NULL to zeros */
 	if (iface != NULL)
 		memset(iface, 0, sizeof(*iface));
@@ -154,13 +178,8 @@ static int parseNetDevLine(char *line, char *iface, unsigned long long *rxBytes,
 	if (txComp != NULL)
 		*txComp = 0;
 
-	if ((ret = regcomp(&r, regex, REG_EXTENDED))) {
-		regfree(&r);
-		return ret;
-	}
-
 	tmp = (char *)malloc( sizeof(char) );
-	if (regexec (&r, line, num, matches, REG_EXTENDED) == 0){
+	if (regexec (r, line, num, matches, REG_EXTENDED) == 0){
 		for (i = 1; i < num; i++) {
 			/* The expression matches are empty sometimes so we need to check it first */
 			if (matches[i].rm_eo - matches[i].rm_so > 0) {
@@ -237,7 +256,6 @@ static int parseNetDevLine(char *line, char *iface, unsigned long long *rxBytes,
 	}
 
 	free(tmp);
-	regfree(&r);
 
 	return 0;
 }
@@ -265,13 +283,35 @@ static int get_iface_domid_network(const char *iface, unsigned int *domid_p, uns
 	return 0;
 }
 
+/* Regular expression to parse all the information from a /proc/net/dev line */
+static const char NETDEV_REGEX[] =
+	"([^:]*):([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)"
+	"[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*"
+	"([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)[ ]*([^ ]*)";
+
+/* Find what is known about an interface, trying its last position first */
+static struct netdev_entry *find_netdev(struct priv_data *priv,
+					unsigned int hint, const char *iface)
+{
+	unsigned int i;
+
+	if (hint < priv->num_netdevs && !strcmp(priv->netdevs[hint].name, iface))
+		return &priv->netdevs[hint];
+	for (i = 0; i < priv->num_netdevs; i++)
+		if (!strcmp(priv->netdevs[i].name, iface))
+			return &priv->netdevs[i];
+	return NULL;
+}
+
 /* Collect information about networks */
 int xenstat_collect_networks(xenstat_node * node)
 {
 	/* Helper variables for parseNetDevLine() function defined above */
 	int i;
-	char line[512] = { 0 }, iface[16] = { 0 }, devBridge[16] = { 0 }, devNoBridge[17] = { 0 };
+	char line[512] = { 0 }, iface[16] = { 0 }, devNoBridge[17] = { 0 };
 	unsigned long long rxBytes, rxPackets, rxErrs, rxDrops, txBytes, txPackets, txErrs, txDrops;
+	struct netdev_entry *netdevs = NULL, *e;
+	unsigned int num = 0, size = 0, n, changed = 0;
 
 	struct priv_data *priv = get_priv_data(node->handle);
 
@@ -280,6 +320,14 @@ int xenstat_collect_networks(xenstat_node * node)
 		return 0;
 	}
 
+	if (!priv->netdev_re_ok) {
+		if (regcomp(&priv->netdev_re, NETDEV_REGEX, REG_EXTENDED)) {
+			fprintf(stderr, "Error compiling /proc/net/dev regex\n");
+			return 0;
+		}
+		priv->netdev_re_ok = 1;
+	}
+
 	/* Open and validate /proc/net/dev if we haven't already */
 	if (priv->procnetdev == NULL) {
 		char header[sizeof(PROCNETDEV_HEADER)];
@@ -304,61 +352,92 @@ int xenstat_collect_networks(xenstat_node * node)
 	}
 
 	/* Fill in networks */
-	/* FIXME: optimize this */
 	fseek(priv->procnetdev, sizeof(PROCNETDEV_HEADER) - 1,
 	      SEEK_SET);
 
+	/* Read all interfaces; only look up new ones in sysfs */
+	while (fgets(line, 512, priv->procnetdev)) {
+		parseNetDevLine(&priv->netdev_re, line, iface, &rxBytes, &rxPackets, &rxErrs, &rxDrops, NULL, NULL, NULL,
+				NULL, &txBytes, &txPackets, &txErrs, &txDrops, NULL, NULL, NULL, NULL);
+
+		if (num == size) {
+			struct netdev_entry *tmp;
+
+			size = size ? size * 2 : 64;
+			tmp = realloc(netdevs, size * sizeof(*netdevs));
+			if (tmp == NULL) {
+				free(netdevs);
+				return 0;
+			}
+			netdevs = tmp;
+		}
+
+		e = &netdevs[num];
+		if (find_netdev(priv, num, iface) != NULL) {
+			*e = *find_netdev(priv, num, iface);
+		} else {
+			changed = 1;
+			memset(e, 0, sizeof(*e));
+			strcpy(e->name, iface);
+			e->vif = get_iface_domid_network(iface, &e->domid,
+							 &e->net.id);
+		}
+		num++;
+
+		e->net.tbytes = txBytes;
+		e->net.tpackets = txPackets;
+		e->net.terrs = txErrs;
+		e->net.tdrop = txDrops;
+		e->net.rbytes = rxBytes;
+		e->net.rpackets = rxPackets;
+		e->net.rerrs = rxErrs;
+		e->net.rdrop = rxDrops;
+	}
+
+	free(priv->netdevs);
+	priv->netdevs = netdevs;
+	if (num != priv->num_netdevs)
+		changed = 1;
+	priv->num_netdevs = num;
+
 	/* We get the bridge devices for use with bonding interface to get bonding interface stats */
-	getBridge("vir", devBridge, sizeof(devBridge));
-	snprintf(devNoBridge, sizeof(devNoBridge), "p%s", devBridge);
+	if (changed)
+		getBridge("vir", priv->devBridge, sizeof(priv->devBridge));
+	snprintf(devNoBridge, sizeof(devNoBridge), "p%s", priv->devBridge);
 
-	while (fgets(line, 512, priv->procnetdev)) {
+	for (n = 0; n < num; n++) {
 		xenstat_domain *domain;
-		xenstat_network net;
-		unsigned int domid;
 
-		parseNetDevLine(line, iface, &rxBytes, &rxPackets, &rxErrs, &rxDrops, NULL, NULL, NULL,
-				NULL, &txBytes, &txPackets, &txErrs, &txDrops, NULL, NULL, NULL, NULL);
+		e = &netdevs[n];
 
 		/* If the device parsed is network bridge and both tx & rx packets are zero, we are most */
 		/* likely using bonding so we alter the configuration for dom0 to have bridge stats */
-		if ((strstr(iface, devBridge) != NULL) &&
-		    (strstr(iface, devNoBridge) == NULL) &&
+		if ((strstr(e->name, priv->devBridge) != NULL) &&
+		    (strstr(e->name, devNoBridge) == NULL) &&
 		    ((domain = xenstat_node_domain(node, 0)) != NULL)) {
 			for (i = 0; i < domain->num_networks; i++) {
 				if ((domain->networks[i].id != 0) ||
 				    (domain->networks[i].tbytes != 0) ||
 				    (domain->networks[i].rbytes != 0))
 					continue;
-				domain->networks[i].tbytes = txBytes;
-				domain->networks[i].tpackets = txPackets;
-				domain->networks[i].terrs = txErrs;
-				domain->networks[i].tdrop = txDrops;
-				domain->networks[i].rbytes = rxBytes;
-				domain->networks[i].rpackets = rxPackets;
-				domain->networks[i].rerrs = rxErrs;
-				domain->networks[i].rdrop = rxDrops;
+				domain->networks[i].tbytes = e->net.tbytes;
+				domain->networks[i].tpackets = e->net.tpackets;
+				domain->networks[i].terrs = e->net.terrs;
+				domain->networks[i].tdrop = e->net.tdrop;
+				domain->networks[i].rbytes = e->net.rbytes;
+				domain->networks[i].rpackets = e->net.rpackets;
+				domain->networks[i].rerrs = e->net.rerrs;
+				domain->networks[i].rdrop = e->net.rdrop;
 			}
 		}
 		else /* Otherwise we need to preserve old behaviour */
-		if (get_iface_domid_network(iface, &domid, &net.id)) {
-
-			net.tbytes = txBytes;
-			net.tpackets = txPackets;
-			net.terrs = txErrs;
-			net.tdrop = txDrops;
-			net.rbytes = rxBytes;
-			net.rpackets = rxPackets;
-			net.rerrs = rxErrs;
-			net.rdrop = rxDrops;
-
-		/* FIXME: this does a search for the domid */
-		  domain = xenstat_node_domain(node, domid);
+		if (e->vif) {
+		  domain = xenstat_node_domain(node, e->domid);
 		  if (domain == NULL) {
 			fprintf(stderr,
 				"Found interface vif%u.%u but domain %u"
-				" does not exist.\n", domid, net.id,
-				domid);
+				" does not exist.\n", e->domid, e->net.id,
+				e->domid);
 			continue;
 		  }
 		  if (domain->networks == NULL) {
@@ -376,7 +455,7 @@ int xenstat_collect_networks(xenstat_node * node)
 		  }
 		  if (domain->networks == NULL)
 			return 0;
-		  domain->networks[domain->num_networks - 1] = net;
+		  domain->networks[domain->num_networks - 1] = e->net;
           }
         }
 
@@ -387,8 +466,13 @@ int xenstat_collect_networks(xenstat_node * node)
 void xenstat_uninit_networks(xenstat_handle * handle)
 {
 	struct priv_data *priv = get_priv_data(handle);
-	if (priv != NULL && priv->procnetdev != NULL)
+	if (priv == NULL)
+		return;
+	if (priv->procnetdev != NULL)
 		fclose(priv->procnetdev);
+	if (priv->netdev_re_ok)
+		regfree(&priv->netdev_re);
+	free(priv->netdevs);
 }
 
 static int read_attributes_vbd3(const char *vbd3_path, xenstat_vbd *vbd)
@@ -423,27 +507,60 @@ static int read_attributes_vbd3(const char *vbd3_path, xenstat_vbd *vbd)
 	return 0;
 }
 
-static int read_attributes_vbd(const char *vbd_directory, const char *what, char *ret, int cap)
+/* Re-read a statistics file of a VBD, opening it on first use */
+static int read_attributes_vbd(struct vbd_entry *e, unsigned int what, char *ret, int cap)
 {
-	static char file_name[80];
-	int fd, num_read;
-
-	snprintf(file_name, sizeof(file_name), "%s/%s/%s",
-		SYSFS_VBD_PATH, vbd_directory, what);
-	fd = open(file_name, O_RDONLY, 0);
-	if (fd==-1) return -1;
-	num_read = read(fd, ret, cap - 1);
-	close(fd);
-	if (num_read<=0) return -1;
+	char file_name[80];
+	int num_read;
+
+	if (e->fd[what] == -1) {
+		snprintf(file_name, sizeof(file_name), "%s/%s/%s",
+			SYSFS_VBD_PATH, e->name, vbd_stats[what]);
+		e->fd[what] = open(file_name, O_RDONLY | O_CLOEXEC, 0);
+		if (e->fd[what] == -1) return -1;
+	}
+	num_read = pread(e->fd[what], ret, cap - 1, 0);
+	if (num_read<=0) {
+		/* Try again from scratch next time */
+		close(e->fd[what]);
+		e->fd[what] = -1;
+		return -1;
+	}
 	ret[num_read] = '\0';
 	return num_read;
 }
 
+static void close_vbd_entries(struct vbd_entry *vbds, unsigned int num)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < num; i++)
+		for (j = 0; j < NUM_VBD_STATS; j++)
+			if (vbds[i].fd[j] != -1)
+				close(vbds[i].fd[j]);
+}
+
+/* Find what is known about a device, trying its last position first */
+static struct vbd_entry *find_vbd(struct priv_data *priv, unsigned int hint,
+				  const char *name)
+{
+	unsigned int i;
+
+	if (hint < priv->num_vbds && !strcmp(priv->vbds[hint].name, name))
+		return &priv->vbds[hint];
+	for (i = 0; i < priv->num_vbds; i++)
+		if (!strcmp(priv->vbds[i].name, name))
+			return &priv->vbds[i];
+	return NULL;
+}
+
 /* Collect information about VBDs */
 int xenstat_collect_vbds(xenstat_node * node)
 {
 	struct dirent *dp;
 	struct priv_data *priv = get_priv_data(node->handle);
+	struct vbd_entry *vbds = NULL, *e;
+	unsigned int num = 0, size = 0, i;
 
 	if (priv == NULL) {
 		perror("Allocation error");
@@ -497,18 +614,45 @@ int xenstat_collect_vbds(xenstat_node * node)
 
 		if (vbd.back_type == 1 || vbd.back_type == 2)
 		{
+			/* Keep the statistics files open across collections */
+			if (num == size) {
+				struct vbd_entry *tmp;
+
+				size = size ? size * 2 : 64;
+				tmp = realloc(vbds, size * sizeof(*vbds));
+				if (tmp == NULL) {
+					perror("Allocation error");
+					close_vbd_entries(vbds, num);
+					free(vbds);
+					return 0;
+				}
+				vbds = tmp;
+			}
+			e = find_vbd(priv, num, dp->d_name);
+			if (e != NULL) {
+				vbds[num] = *e;
+				/* Now owned by the new list */
+				for (i = 0; i < NUM_VBD_STATS; i++)
+					e->fd[i] = -1;
+			} else {
+				snprintf(vbds[num].name, sizeof(vbds[num].name),
+					 "%s", dp->d_name);
+				for (i = 0; i < NUM_VBD_STATS; i++)
+					vbds[num].fd[i] = -1;
+			}
+			e = &vbds[num++];
 
 			vbd.error = 0;
 
-			if ((read_attributes_vbd(dp->d_name, "statistics/oo_req", buf, 256)<=0) ||
+			if ((read_attributes_vbd(e, 0, buf, 256)<=0) ||
 				((ret = sscanf(buf, "%llu", &vbd.oo_reqs)) != 1) ||
-				(read_attributes_vbd(dp->d_name, "statistics/rd_req", buf, 256)<=0) ||
+				(read_attributes_vbd(e, 1, buf, 256)<=0) ||
 				((ret = sscanf(buf, "%llu", &vbd.rd_reqs)) != 1) ||
-				(read_attributes_vbd(dp->d_name, "statistics/wr_req", buf, 256)<=0) ||
+				(read_attributes_vbd(e, 2, buf, 256)<=0) ||
 				((ret = sscanf(buf, "%llu", &vbd.wr_reqs)) != 1) ||
-				(read_attributes_vbd(dp->d_name, "statistics/rd_sect", buf, 256)<=0) ||
+				(read_attributes_vbd(e, 3, buf, 256)<=0) ||
 				((ret = sscanf(buf, "%llu", &vbd.rd_sects)) != 1) ||
-				(read_attributes_vbd(dp->d_name, "statistics/wr_sect", buf, 256)<=0) ||
+				(read_attributes_vbd(e, 4, buf, 256)<=0) ||
 				((ret = sscanf(buf, "%llu", &vbd.wr_sects)) != 1))
 			{
 				vbd.error = 1;
@@ -548,10 +692,18 @@ int xenstat_collect_vbds(xenstat_node * node)
 		}
 		if ((xenstat_save_vbd(domain, &vbd)) == NULL) {
 			perror("Allocation error");
+			close_vbd_entries(vbds, num);
+			free(vbds);
 			return 0;
 		}
 	}
 
+	/* Devices which went away are not needed anymore */
+	close_vbd_entries(priv->vbds, priv->num_vbds);
+	free(priv->vbds);
+	priv->vbds = vbds;
+	priv->num_vbds = num;
+
 	return 1;	
 }
 
@@ -559,6 +711,10 @@ int xenstat_collect_vbds(xenstat_node * node)
 void xenstat_uninit_vbds(xenstat_handle * handle)
 {
 	struct priv_data *priv = get_priv_data(handle);
-	if (priv != NULL && priv->sysfsvbd != NULL)
+	if (priv == NULL)
+		return;
+	if (priv->sysfsvbd != NULL)
 		closedir(priv->sysfsvbd);
+	close_vbd_entries(priv->vbds, priv->num_vbds);
+	free(priv->vbds);
 }
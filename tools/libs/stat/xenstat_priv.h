@@ -32,12 +32,28 @@
 #define SHORT_ASC_LEN 5                 /* length of 65535 */
 #define VERSION_SIZE (2 * SHORT_ASC_LEN + 1 + sizeof(xen_extraversion_t) + 1)
 
+/* Per-domain state kept between calls to xenstat_get_node() */
+struct xenstat_dom_cache {
+	unsigned int id;
+	xen_domain_handle_t uuid;	/* Tells a new domain reusing the id */
+	char *name;			/* NULL if the domain is going away */
+	unsigned long long cpu_ns;	/* Domain CPU time when vcpus were read */
+	unsigned int num_vcpus;
+	unsigned int num_online_vcpus;	/* Online vcpus when vcpus were read */
+	xenstat_vcpu *vcpus;		/* NULL until first collected */
+};
+
 struct xenstat_handle {
 	xc_interface *xc_handle;
 	struct xs_handle *xshandle; /* xenstore handle */
 	int page_size;
 	void *priv;
 	char xen_version[VERSION_SIZE]; /* xen version running on this node */
+	xc_domaininfo_t *domaininfo;	/* Buffer for the domain list */
+	unsigned int domaininfo_size;
+	struct xenstat_dom_cache *dom_cache;	/* Sorted by domain id */
+	unsigned int num_dom_cache;
+	unsigned int name_cursor;	/* Next cached name to re-read */
 };
 
 struct xenstat_node {
@@ -58,6 +74,7 @@ struct xenstat_domain {
 	unsigned int state;
 	unsigned long long cpu_ns;
 	unsigned int num_vcpus;		/* No. vcpus configured for domain */
+	unsigned int num_online_vcpus;	/* No. vcpus currently online */
 	xenstat_vcpu *vcpus;		/* Array of length num_vcpus */
 	unsigned long long cur_mem;	/* Current memory reservation */
 	unsigned long long max_mem;	/* Total memory allowed */
@@ -121,5 +138,7 @@ extern int xenstat_collect_vbds(xenstat_node * node);
 extern void xenstat_uninit_vbds(xenstat_handle * handle);
 extern void read_attributes_qdisk(xenstat_node * node);
 extern xenstat_vbd *xenstat_save_vbd(xenstat_domain * domain, xenstat_vbd * vbd);
+extern struct xenstat_dom_cache *xenstat_get_dom_cache(xenstat_handle * handle,
+						       unsigned int domid);
 
 #endif /* XENSTAT_PRIV_H */
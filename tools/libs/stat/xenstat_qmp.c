@@ -285,10 +285,29 @@ static size_t qmp_write(int qfd, const char *cmd, size_t cmd_len)
 	return pos;
 }
 
+/*
+ * Return the start of the last complete line in buf if it is the reply to
+ * a command, NULL otherwise.
+ */
+static unsigned char *qmp_reply(unsigned char *buf, int size)
+{
+	unsigned char *line;
+
+	if (size == 0 || buf[size - 1] != '\n')
+		return NULL;
+	buf[size - 1] = 0;
+	line = (unsigned char *)strrchr((char *)buf, '\n');
+	buf[size - 1] = '\n';
+	line = line ? line + 1 : buf;
+	if (strstr((char *)line, "\"return\"") || strstr((char *)line, "\"error\""))
+		return line;
+	return NULL;
+}
+
 /* Read the data sent in response to a QMP execute query. Returns 1 for success */
 static int qmp_read(int qfd, unsigned char **qstats)
 {
-	unsigned char buf[1024], *ptr;
+	unsigned char buf[1024], *ptr, *reply;
 	struct pollfd pfd[1];
 	int n, qsize = 0;
 
@@ -310,6 +329,16 @@ static int qmp_read(int qfd, unsigned char **qstats)
 			qsize += n;
 			ptr[qsize] = 0;
 			*qstats = ptr;
+
+			/*
+			 * Stop at the reply rather than waiting for QEMU to go
+			 * quiet, and drop greetings and events queued before it.
+			 */
+			reply = qmp_reply(ptr, qsize);
+			if (reply) {
+				memmove(ptr, reply, qsize - (reply - ptr) + 1);
+				break;
+			}
 		}
 	}
 	return 1;
@@ -386,18 +415,14 @@ static void read_attributes_qdisk_dom(xenstat_node *node, domid_t domain)
 {
 	const char *cmd_mode = "{ \"execute\": \"qmp_capabilities\" }";
 	const char *query_blockstats_cmd = "{ \"execute\": \"query-blockstats\" }";
-	unsigned char *qmp_stats, *val;
+	unsigned char *qmp_stats;
 	char path[80];
 	int qfd;
 
-	/* Verify that qdisk disks are used with this VM */
-	snprintf(path, sizeof(path),"/local/domain/0/backend/qdisk/%i", domain);
-	val = xs_read(node->handle->xshandle, XBT_NULL, path, NULL);
-	if (val == NULL)
-		return;
-	free(val);
-
-	/* Connect to this VMs QMP socket */
+	/*
+	 * Connect to this VMs QMP socket.  QEMU serves one client at a time
+	 * on it, so don't keep it from other libxenstat users between calls.
+	 */
 	snprintf(path, sizeof(path), XEN_RUN_DIR "/qmp-libxenstat-%i", domain);
 	if ((qfd = qmp_connect(path)) < 0)
 		return;
@@ -417,22 +442,22 @@ static void read_attributes_qdisk_dom(xenstat_node *node, domid_t domain)
 
 void read_attributes_qdisk(xenstat_node * node)
 {
-	xc_domaininfo_t dominfo[1024];
-	int i, num_doms;
-	domid_t next_domid = 0;
+	char **dirs;
+	unsigned int i, num, domid;
 
-	for (;;) {
-		num_doms = xc_domain_getinfolist(node->handle->xc_handle,
-						 next_domid, 1024, dominfo);
-		if (num_doms <= 0)
-			return;
-
-		for (i = 0; i < num_doms; i++)
-			if (dominfo[i].domain > 0)
-				read_attributes_qdisk_dom(node, dominfo[i].domain);
+	/* Domains using qdisk disks, in a single xenstore access */
+	dirs = xs_directory(node->handle->xshandle, XBT_NULL,
+			    "/local/domain/0/backend/qdisk", &num);
+	if (dirs == NULL)
+		return;
 
-		next_domid = dominfo[num_doms - 1].domain + 1;
+	for (i = 0; i < num; i++) {
+		domid = strtoul(dirs[i], NULL, 10);
+		if (domid == 0 || xenstat_node_domain(node, domid) == NULL)
+			continue;
+		read_attributes_qdisk_dom(node, domid);
 	}
+	free(dirs);
 }
 
 #else /* !HAVE_YAJL_V2 */
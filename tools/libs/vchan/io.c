@@ -205,24 +205,31 @@ int libxenvchan_wait(struct libxenvchan *ctrl)
 	return 0;
 }
 
-/**
- * returns -1 on error, or size on success
- *
- * caller must have checked that enough space is available
+/*
+ * Copy data into the write ring, starting offset bytes past the producer
+ * index.  Does not publish the data.
  */
-static int do_send(struct libxenvchan *ctrl, const void *data, size_t size)
+static void ring_write(struct libxenvchan *ctrl, uint32_t offset,
+                       const void *data, size_t size)
 {
-	int real_idx = wr_prod(ctrl) & (wr_ring_size(ctrl) - 1);
+	int real_idx = (wr_prod(ctrl) + offset) & (wr_ring_size(ctrl) - 1);
 	int avail_contig = wr_ring_size(ctrl) - real_idx;
 	if (avail_contig > size)
 		avail_contig = size;
-	xen_mb(); /* read indexes /then/ write data */
 	memcpy(wr_ring(ctrl) + real_idx, data, avail_contig);
 	if (avail_contig < size)
 	{
 		// we rolled across the end of the ring
 		memcpy(wr_ring(ctrl), data + avail_contig, size - avail_contig);
 	}
+}
+
+/*
+ * Publish size bytes written past the producer index, and notify the
+ * reader if it asked for it.
+ */
+static int publish_write(struct libxenvchan *ctrl, size_t size)
+{
 	xen_wmb(); /* write data /then/ notify */
 	wr_prod(ctrl) += size;
 	if (send_notify(ctrl, VCHAN_NOTIFY_WRITE))
@@ -230,6 +237,58 @@ static int do_send(struct libxenvchan *ctrl, const void *data, size_t size)
 	return size;
 }
 
+/**
+ * returns -1 on error, or size on success
+ *
+ * caller must have checked that enough space is available
+ */
+static int do_send(struct libxenvchan *ctrl, const void *data, size_t size)
+{
+	xen_mb(); /* read indexes /then/ write data */
+	ring_write(ctrl, 0, data, size);
+	return publish_write(ctrl, size);
+}
+
+/**
+ * Send size bytes gathered from iov, skipping the first skip bytes, with a
+ * single index update and notification.
+ *
+ * returns -1 on error, or size on success
+ *
+ * caller must have checked that enough space is available
+ */
+static int do_sendv(struct libxenvchan *ctrl, const struct iovec *iov,
+                    int iovcnt, size_t skip, size_t size)
+{
+	size_t pos = 0, len;
+	int i;
+
+	xen_mb(); /* read indexes /then/ write data */
+	for (i = 0; i < iovcnt && pos < size; i++) {
+		if (skip >= iov[i].iov_len) {
+			skip -= iov[i].iov_len;
+			continue;
+		}
+		len = iov[i].iov_len - skip;
+		if (len > size - pos)
+			len = size - pos;
+		ring_write(ctrl, pos, iov[i].iov_base + skip, len);
+		pos += len;
+		skip = 0;
+	}
+	return publish_write(ctrl, size);
+}
+
+static size_t iov_total(const struct iovec *iov, int iovcnt)
+{
+	size_t size = 0;
+	int i;
+
+	for (i = 0; i < iovcnt; i++)
+		size += iov[i].iov_len;
+	return size;
+}
+
 /**
  * returns 0 if no buffer space is available, -1 on error, or size on success
  */
@@ -281,24 +340,63 @@ int libxenvchan_write(struct libxenvchan *ctrl, const void *data, size_t size)
 	}
 }
 
-/**
- * returns -1 on error, or size on success
- *
- * caller must have checked that enough data is available
+int libxenvchan_writev(struct libxenvchan *ctrl, const struct iovec *iov,
+                       int iovcnt)
+{
+	size_t size = iov_total(iov, iovcnt);
+	int avail;
+	if (!libxenvchan_is_open(ctrl))
+		return -1;
+	if (ctrl->blocking) {
+		size_t pos = 0;
+		while (1) {
+			avail = fast_get_buffer_space(ctrl, size - pos);
+			if (pos + avail > size)
+				avail = size - pos;
+			if (avail)
+				pos += do_sendv(ctrl, iov, iovcnt, pos, avail);
+			if (pos == size)
+				return pos;
+			if (libxenvchan_wait(ctrl))
+				return -1;
+			if (!libxenvchan_is_open(ctrl))
+				return -1;
+		}
+	} else {
+		avail = fast_get_buffer_space(ctrl, size);
+		if (size > avail)
+			size = avail;
+		if (size == 0)
+			return 0;
+		return do_sendv(ctrl, iov, iovcnt, 0, size);
+	}
+}
+
+/*
+ * Copy data out of the read ring, starting offset bytes past the consumer
+ * index.  Does not consume the data.
  */
-static int do_recv(struct libxenvchan *ctrl, void *data, size_t size)
+static void ring_read(struct libxenvchan *ctrl, uint32_t offset,
+                      void *data, size_t size)
 {
-	int real_idx = rd_cons(ctrl) & (rd_ring_size(ctrl) - 1);
+	int real_idx = (rd_cons(ctrl) + offset) & (rd_ring_size(ctrl) - 1);
 	int avail_contig = rd_ring_size(ctrl) - real_idx;
 	if (avail_contig > size)
 		avail_contig = size;
-	xen_rmb(); /* data read must happen /after/ rd_cons read */
 	memcpy(data, rd_ring(ctrl) + real_idx, avail_contig);
 	if (avail_contig < size)
 	{
 		// we rolled across the end of the ring
 		memcpy(data + avail_contig, rd_ring(ctrl), size - avail_contig);
 	}
+}
+
+/*
+ * Consume size bytes past the consumer index, and notify the writer if it
+ * asked for it.
+ */
+static int consume_read(struct libxenvchan *ctrl, size_t size)
+{
 	xen_mb(); /* consume /then/ notify */
 	rd_cons(ctrl) += size;
 	if (send_notify(ctrl, VCHAN_NOTIFY_READ))
@@ -306,6 +404,43 @@ static int do_recv(struct libxenvchan *ctrl, void *data, size_t size)
 	return size;
 }
 
+/**
+ * returns -1 on error, or size on success
+ *
+ * caller must have checked that enough data is available
+ */
+static int do_recv(struct libxenvchan *ctrl, void *data, size_t size)
+{
+	xen_rmb(); /* data read must happen /after/ rd_cons read */
+	ring_read(ctrl, 0, data, size);
+	return consume_read(ctrl, size);
+}
+
+/**
+ * Receive size bytes scattered into iov, with a single index update and
+ * notification.
+ *
+ * returns -1 on error, or size on success
+ *
+ * caller must have checked that enough data is available
+ */
+static int do_recvv(struct libxenvchan *ctrl, const struct iovec *iov,
+                    int iovcnt, size_t size)
+{
+	size_t pos = 0, len;
+	int i;
+
+	xen_rmb(); /* data read must happen /after/ rd_cons read */
+	for (i = 0; i < iovcnt && pos < size; i++) {
+		len = iov[i].iov_len;
+		if (len > size - pos)
+			len = size - pos;
+		ring_read(ctrl, pos, iov[i].iov_base, len);
+		pos += len;
+	}
+	return consume_read(ctrl, size);
+}
+
 /**
  * reads exactly size bytes from the vchan.
  * returns 0 if insufficient data is available, -1 on error, or size on success
@@ -344,6 +479,113 @@ int libxenvchan_read(struct libxenvchan *ctrl, void *data, size_t size)
 	}
 }
 
+int libxenvchan_readv(struct libxenvchan *ctrl, const struct iovec *iov,
+                      int iovcnt)
+{
+	size_t size = iov_total(iov, iovcnt);
+	while (1) {
+		int avail = fast_get_data_ready(ctrl, size);
+		if (avail && size > avail)
+			size = avail;
+		if (avail)
+			return do_recvv(ctrl, iov, iovcnt, size);
+		if (!libxenvchan_is_open(ctrl))
+			return -1;
+		if (!ctrl->blocking)
+			return 0;
+		if (libxenvchan_wait(ctrl))
+			return -1;
+	}
+}
+
+/*
+ * Describe size bytes of ring memory starting at idx as at most two
+ * contiguous regions.
+ */
+static int ring_iov(void *ring, uint32_t ring_size, uint32_t idx,
+                    size_t size, struct iovec iov[2])
+{
+	uint32_t real_idx = idx & (ring_size - 1);
+	size_t avail_contig = ring_size - real_idx;
+
+	if (!size)
+		return 0;
+	iov[0].iov_base = ring + real_idx;
+	if (avail_contig >= size) {
+		iov[0].iov_len = size;
+		return 1;
+	}
+	iov[0].iov_len = avail_contig;
+	iov[1].iov_base = ring;
+	iov[1].iov_len = size - avail_contig;
+	return 2;
+}
+
+int libxenvchan_read_peek(struct libxenvchan *ctrl, struct iovec iov[2],
+                          int *iovcnt)
+{
+	while (1) {
+		/* Everything is handed out; ask to hear about more data */
+		int avail = fast_get_data_ready(ctrl, rd_ring_size(ctrl));
+		if (avail) {
+			xen_rmb(); /* data read must happen /after/ rd_prod read */
+			*iovcnt = ring_iov((void *)rd_ring(ctrl), rd_ring_size(ctrl),
+			                   rd_cons(ctrl), avail, iov);
+			return avail;
+		}
+		if (!libxenvchan_is_open(ctrl))
+			return -1;
+		if (!ctrl->blocking) {
+			*iovcnt = 0;
+			return 0;
+		}
+		if (libxenvchan_wait(ctrl))
+			return -1;
+	}
+}
+
+int libxenvchan_read_commit(struct libxenvchan *ctrl, size_t size)
+{
+	if (size > raw_get_data_ready(ctrl))
+		return -1;
+	if (!size)
+		return 0;
+	return consume_read(ctrl, size);
+}
+
+int libxenvchan_write_peek(struct libxenvchan *ctrl, struct iovec iov[2],
+                           int *iovcnt)
+{
+	while (1) {
+		int avail;
+		if (!libxenvchan_is_open(ctrl))
+			return -1;
+		/* The whole ring is handed out; ask to hear about more space */
+		avail = fast_get_buffer_space(ctrl, wr_ring_size(ctrl));
+		if (avail) {
+			xen_mb(); /* read indexes /then/ write data */
+			*iovcnt = ring_iov(wr_ring(ctrl), wr_ring_size(ctrl),
+			                   wr_prod(ctrl), avail, iov);
+			return avail;
+		}
+		if (!ctrl->blocking) {
+			*iovcnt = 0;
+			return 0;
+		}
+		if (libxenvchan_wait(ctrl))
+			return -1;
+	}
+}
+
+int libxenvchan_write_commit(struct libxenvchan *ctrl, size_t size)
+{
+	if (size > raw_get_buffer_space(ctrl))
+		return -1;
+	if (!size)
+		return 0;
+	return publish_write(ctrl, size);
+}
+
 int libxenvchan_is_open(struct libxenvchan* ctrl)
 {
 	if (ctrl->is_server)
@@ -0,0 +1,580 @@
+/*
+ * xen-dedupd: find identical pages across (and within) HVM guests and have
+ * Xen share them.
+ *
+ * Each pass hashes the memory of the domains from read-only foreign
+ * mappings, in a pool of threads, sorts the hashes to find candidate
+ * duplicates, and shares them in batches with XENMEM_sharing_op_share_batch.
+ * Xen compares the pages' contents before sharing them, so hash collisions,
+ * or pages changed since they were hashed, only cost a failed pair.  The
+ * domains keep running throughout.
+ *
+ * Only private RAM gets mapped: the p2m types are queried first, as mapping
+ * would populate PoD entries, page paged out gfns back in, and populate
+ * forks from their parents.
+ *
+ * Usage: xen-dedupd [-1] [-e] [-i interval] [-t threads] [domid...]
+ * With no domid, all HVM guests are scanned.  Only domains with sharing
+ * enabled are scanned, unless -e is given to enable it.
+ */
+
+#include <err.h>
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <xenctrl.h>
+#include <xenforeignmemory.h>
+#include <xen-tools/common-macros.h>
+
+/* Pages mapped and hashed at a time by a thread. */
+#define CHUNK_PAGES 1024
+/* Pairs of pages per sharing hypercall. */
+#define BATCH_PAIRS 1024
+
+#define GFN_BITS    40
+#define GFN_MASK    ((UINT64_C(1) << GFN_BITS) - 1)
+
+static xc_interface *xch;
+
+static unsigned int nr_threads;
+static unsigned int interval = 60;
+static bool once, enable;
+
+struct dom {
+    uint32_t domid;
+    xen_pfn_t max_gfn;
+};
+
+static struct dom *doms;
+static unsigned int nr_doms;
+
+/* A page hashed: its domain (index in doms[]) and gfn packed into loc. */
+struct page_hash {
+    uint64_t hash;
+    uint64_t loc;
+};
+
+struct chunk {
+    unsigned int dom;
+    xen_pfn_t gfn;
+};
+
+static struct chunk *chunks;
+static unsigned int nr_chunks, next_chunk;
+
+struct worker {
+    pthread_t thread;
+    struct page_hash *hashes;
+    size_t nr, max;
+    unsigned long skipped;
+};
+
+/* A candidate pair, source and client as doms[] index and gfn. */
+struct pair {
+    unsigned int sdom, cdom;
+    uint64_t sgfn, cgfn;
+};
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline uint32_t rol32(uint32_t x, unsigned int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+/*
+ * Hash a page over 8 independent 32-bit lanes, xxHash32 style.  The lanes
+ * don't depend on each other, so that the compiler vectorises the inner
+ * loop (SSE/AVX, NEON) without resorting to intrinsics.
+ */
+#define HASH_LANES 8
+#define PRIME32_1  0x9e3779b1U
+#define PRIME32_2  0x85ebca77U
+#define PRIME64_1  UINT64_C(0x9e3779b97f4a7c15)
+
+static uint64_t hash_page(const uint32_t *w)
+{
+    uint32_t lane[HASH_LANES];
+    uint64_t h = 0;
+    unsigned int i, j;
+
+    for ( j = 0; j < HASH_LANES; j++ )
+        lane[j] = PRIME32_1 + j;
+
+    for ( i = 0; i < XC_PAGE_SIZE / sizeof(*w); i += HASH_LANES )
+        for ( j = 0; j < HASH_LANES; j++ )
+            lane[j] = rol32(lane[j] + w[i + j] * PRIME32_2, 13) * PRIME32_1;
+
+    for ( j = 0; j < HASH_LANES; j++ )
+    {
+        h = (h ^ lane[j]) * PRIME64_1;
+        h ^= h >> 31;
+    }
+
+    return h;
+}
+
+static void add_hash(struct worker *w, uint64_t hash, uint64_t loc)
+{
+    if ( w->nr == w->max )
+    {
+        size_t max = w->max ? w->max * 2 : 65536;
+        struct page_hash *h = realloc(w->hashes, max * sizeof(*h));
+
+        if ( !h )
+            err(1, "realloc");
+        w->hashes = h;
+        w->max = max;
+    }
+
+    w->hashes[w->nr].hash = hash;
+    w->hashes[w->nr].loc = loc;
+    w->nr++;
+}
+
+static void *hash_worker(void *arg)
+{
+    struct worker *w = arg;
+    xc_interface *wxch;
+    xenforeignmemory_handle *fmem;
+    uint64_t query[CHUNK_PAGES];
+    uint8_t types[CHUNK_PAGES];
+    xen_pfn_t gfns[CHUNK_PAGES];
+    int errs[CHUNK_PAGES];
+
+    wxch = xc_interface_open(NULL, NULL, 0);
+    if ( !wxch )
+        err(1, "xc_interface_open");
+    fmem = xenforeignmemory_open(NULL, 0);
+    if ( !fmem )
+        err(1, "xenforeignmemory_open");
+
+    for ( ;; )
+    {
+        unsigned int c = __atomic_fetch_add(&next_chunk, 1, __ATOMIC_RELAXED);
+        const struct dom *dom;
+        unsigned int i, nr, n;
+        const uint8_t *va;
+
+        if ( c >= nr_chunks )
+            break;
+
+        dom = &doms[chunks[c].dom];
+        nr = min_t(xen_pfn_t, CHUNK_PAGES,
+                   dom->max_gfn + 1 - chunks[c].gfn);
+        for ( i = 0; i < nr; i++ )
+            query[i] = chunks[c].gfn + i;
+
+        /*
+         * Only map private RAM.  Mapping would populate PoD entries (which
+         * can crash the guest once its PoD cache is exhausted), page paged
+         * out gfns back in, and populate a fork from its parent.  Shared
+         * pages have nothing left to save.
+         */
+        if ( xc_memshr_query_batch(wxch, dom->domid, query, nr, types,
+                                   NULL) )
+        {
+            w->skipped += nr;
+            continue;
+        }
+
+        for ( i = n = 0; i < nr; i++ )
+        {
+            if ( types[i] == XENMEM_SHARING_GFN_RAM )
+                gfns[n++] = query[i];
+            else
+                w->skipped++;
+        }
+        if ( !n )
+            continue;
+
+        /* Pages which can't be mapped get reported in errs[]. */
+        va = xenforeignmemory_map(fmem, dom->domid, PROT_READ, n, gfns,
+                                  errs);
+        if ( !va )
+        {
+            w->skipped += n;
+            continue;
+        }
+
+        for ( i = 0; i < n; i++ )
+        {
+            if ( errs[i] )
+            {
+                w->skipped++;
+                continue;
+            }
+
+            add_hash(w, hash_page((const void *)(va + i * XC_PAGE_SIZE)),
+                     ((uint64_t)chunks[c].dom << GFN_BITS) | gfns[i]);
+        }
+
+        xenforeignmemory_unmap(fmem, (void *)va, n);
+    }
+
+    xenforeignmemory_close(fmem);
+    xc_interface_close(wxch);
+
+    return NULL;
+}
+
+static int cmp_hash(const void *a, const void *b)
+{
+    const struct page_hash *x = a, *y = b;
+
+    if ( x->hash != y->hash )
+        return x->hash < y->hash ? -1 : 1;
+
+    return x->loc < y->loc ? -1 : x->loc > y->loc;
+}
+
+static int cmp_pair(const void *a, const void *b)
+{
+    const struct pair *x = a, *y = b;
+
+    if ( x->sdom != y->sdom )
+        return x->sdom < y->sdom ? -1 : 1;
+    if ( x->cdom != y->cdom )
+        return x->cdom < y->cdom ? -1 : 1;
+
+    return x->cgfn < y->cgfn ? -1 : x->cgfn > y->cgfn;
+}
+
+/* Hash all domains' memory, returning the hashes sorted. */
+static struct page_hash *hash_all(size_t *nr, unsigned long *skipped)
+{
+    struct worker *workers = calloc(nr_threads, sizeof(*workers));
+    struct page_hash *hashes;
+    unsigned int i, d;
+    size_t total = 0;
+
+    if ( !workers )
+        err(1, "calloc");
+
+    nr_chunks = next_chunk = 0;
+    for ( d = 0; d < nr_doms; d++ )
+        nr_chunks += doms[d].max_gfn / CHUNK_PAGES + 1;
+    free(chunks);
+    chunks = calloc(nr_chunks, sizeof(*chunks));
+    if ( !chunks )
+        err(1, "calloc");
+    for ( i = d = 0; d < nr_doms; d++ )
+    {
+        xen_pfn_t gfn;
+
+        for ( gfn = 0; gfn <= doms[d].max_gfn; gfn += CHUNK_PAGES, i++ )
+        {
+            chunks[i].dom = d;
+            chunks[i].gfn = gfn;
+        }
+    }
+
+    for ( i = 0; i < nr_threads; i++ )
+        if ( pthread_create(&workers[i].thread, NULL, hash_worker,
+                            &workers[i]) )
+            errx(1, "pthread_create failed");
+
+    *skipped = 0;
+    for ( i = 0; i < nr_threads; i++ )
+    {
+        pthread_join(workers[i].thread, NULL);
+        total += workers[i].nr;
+        *skipped += workers[i].skipped;
+    }
+
+    hashes = malloc(total * sizeof(*hashes) ?: 1);
+    if ( !hashes )
+        err(1, "malloc");
+    for ( *nr = i = 0; i < nr_threads; i++ )
+    {
+        memcpy(hashes + *nr, workers[i].hashes,
+               workers[i].nr * sizeof(*hashes));
+        *nr += workers[i].nr;
+        free(workers[i].hashes);
+    }
+    free(workers);
+
+    qsort(hashes, *nr, sizeof(*hashes), cmp_hash);
+
+    return hashes;
+}
+
+/*
+ * Pair every page with the first page of the same hash, and sort the pairs
+ * by domains so they can be shared in batches.
+ */
+static struct pair *find_pairs(const struct page_hash *hashes, size_t nr,
+                               size_t *nr_pairs)
+{
+    struct pair *pairs = NULL;
+    size_t i, first = 0, max = 0;
+
+    *nr_pairs = 0;
+    for ( i = 1; i < nr; i++ )
+    {
+        if ( hashes[i].hash != hashes[first].hash )
+        {
+            first = i;
+            continue;
+        }
+
+        if ( *nr_pairs == max )
+        {
+            struct pair *p;
+
+            max = max ? max * 2 : 65536;
+            p = realloc(pairs, max * sizeof(*p));
+            if ( !p )
+                err(1, "realloc");
+            pairs = p;
+        }
+
+        pairs[*nr_pairs].sdom = hashes[first].loc >> GFN_BITS;
+        pairs[*nr_pairs].sgfn = hashes[first].loc & GFN_MASK;
+        pairs[*nr_pairs].cdom = hashes[i].loc >> GFN_BITS;
+        pairs[*nr_pairs].cgfn = hashes[i].loc & GFN_MASK;
+        (*nr_pairs)++;
+    }
+
+    if ( *nr_pairs )
+        qsort(pairs, *nr_pairs, sizeof(*pairs), cmp_pair);
+
+    return pairs;
+}
+
+static unsigned long share_pairs(const struct pair *pairs, size_t nr)
+{
+    static uint64_t sgfns[BATCH_PAIRS], cgfns[BATCH_PAIRS];
+    static uint8_t shared[BATCH_PAIRS / 8];
+    unsigned long nr_shared = 0;
+    size_t i = 0;
+
+    while ( i < nr )
+    {
+        unsigned int sdom = pairs[i].sdom, cdom = pairs[i].cdom;
+        unsigned int n, j;
+        int rc;
+
+        for ( n = 0; n < BATCH_PAIRS && i + n < nr &&
+                     pairs[i + n].sdom == sdom && pairs[i + n].cdom == cdom;
+              n++ )
+        {
+            sgfns[n] = pairs[i + n].sgfn;
+            cgfns[n] = pairs[i + n].cgfn;
+        }
+
+        memset(shared, 0, sizeof(shared));
+        rc = xc_memshr_share_batch(xch, doms[sdom].domid, doms[cdom].domid,
+                                   sgfns, cgfns, n, shared);
+        if ( rc && errno != ENOMEM )
+        {
+            warn("d%u/d%u: sharing %u pairs", doms[sdom].domid,
+                 doms[cdom].domid, n);
+            i += n;
+            continue;
+        }
+
+        /* The pairs reported before running out of memory got shared. */
+        for ( j = 0; j < n; j++ )
+            nr_shared += !!(shared[j / 8] & (1U << (j & 7)));
+
+        /*
+         * Xen is out of memory for the sharing metadata: sharing more now
+         * would only fail again, and press on a host already short of
+         * memory.  Leave the rest to the next pass.
+         */
+        if ( rc )
+        {
+            warnx("out of memory for sharing, %zu pairs left for the next pass",
+                  nr - i);
+            break;
+        }
+
+        i += n;
+    }
+
+    return nr_shared;
+}
+
+/*
+ * Look up the domains to scan: those with sharing enabled, or all of them
+ * with -e, enabling sharing on those which don't have it yet.
+ */
+static void get_domains(int argc, char **argv)
+{
+    unsigned int i;
+
+    free(doms);
+    nr_doms = 0;
+
+    if ( argc )
+    {
+        doms = calloc(argc, sizeof(*doms));
+        if ( !doms )
+            err(1, "calloc");
+        for ( i = 0; i < argc; i++ )
+            doms[nr_doms++].domid = strtoul(argv[i], NULL, 0);
+    }
+    else
+    {
+        xc_domaininfo_t info[256];
+        uint32_t next = 1;
+        int n;
+
+        doms = NULL;
+        while ( (n = xc_domain_getinfolist(xch, next, ARRAY_SIZE(info),
+                                           info)) > 0 )
+        {
+            struct dom *d = realloc(doms, (nr_doms + n) * sizeof(*d));
+
+            if ( !d )
+                err(1, "realloc");
+            doms = d;
+
+            for ( i = 0; i < n; i++ )
+                if ( (info[i].flags & XEN_DOMINF_hvm_guest) &&
+                     !(info[i].flags & XEN_DOMINF_dying) )
+                    doms[nr_doms++].domid = info[i].domain;
+
+            next = info[n - 1].domain + 1;
+        }
+    }
+
+    for ( i = 0; i < nr_doms; )
+    {
+        bool enabled;
+
+        if ( xc_memshr_query_batch(xch, doms[i].domid, NULL, 0, NULL,
+                                   &enabled) ||
+             (!enabled && enable &&
+              xc_memshr_control(xch, doms[i].domid, 1)) ||
+             xc_domain_maximum_gpfn(xch, doms[i].domid, &doms[i].max_gfn) )
+        {
+            warn("d%u: skipping", doms[i].domid);
+            doms[i] = doms[--nr_doms];
+            continue;
+        }
+
+        if ( !enabled && !enable )
+        {
+            /* Only complain about the domains asked for explicitly. */
+            if ( argc )
+                warnx("d%u: sharing not enabled, skipping (see -e)",
+                      doms[i].domid);
+            doms[i] = doms[--nr_doms];
+            continue;
+        }
+        i++;
+    }
+}
+
+static void pass(int argc, char **argv)
+{
+    struct page_hash *hashes;
+    struct pair *pairs;
+    size_t nr_hashes, nr_pairs;
+    unsigned long skipped, nr_shared;
+    long saved_before, saved_after;
+    double t0, t1, t2;
+
+    get_domains(argc, argv);
+    if ( !nr_doms )
+    {
+        printf("No domain to scan\n");
+        return;
+    }
+
+    saved_before = xc_sharing_freed_pages(xch);
+
+    t0 = now();
+    hashes = hash_all(&nr_hashes, &skipped);
+    pairs = find_pairs(hashes, nr_hashes, &nr_pairs);
+    free(hashes);
+    t1 = now();
+    nr_shared = share_pairs(pairs, nr_pairs);
+    free(pairs);
+    t2 = now();
+
+    saved_after = xc_sharing_freed_pages(xch);
+
+    printf("%u domains: hashed %zu pages (%lu skipped) in %.2fs, "
+           "shared %lu/%zu candidates in %.2fs\n",
+           nr_doms, nr_hashes, skipped, t1 - t0, nr_shared, nr_pairs,
+           t2 - t1);
+    if ( saved_before >= 0 && saved_after >= 0 )
+        printf("saved %ld MiB (%+ld MiB this pass)\n",
+               saved_after >> (20 - XC_PAGE_SHIFT),
+               (saved_after - saved_before) >> (20 - XC_PAGE_SHIFT));
+    fflush(stdout);
+}
+
+static void usage(const char *prog)
+{
+    errx(1, "Usage: %s [-1] [-e] [-i interval] [-t threads] [domid...]",
+         prog);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    nr_threads = cpus > 0 ? cpus : 1;
+
+    while ( (opt = getopt(argc, argv, "1ei:t:")) != -1 )
+    {
+        switch ( opt )
+        {
+        case '1':
+            once = true;
+            break;
+        case 'e':
+            enable = true;
+            break;
+        case 'i':
+            interval = strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            nr_threads = strtoul(optarg, NULL, 0);
+            if ( !nr_threads )
+                usage(argv[0]);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    xch = xc_interface_open(NULL, NULL, 0);
+    if ( !xch )
+        err(1, "xc_interface_open");
+
+    for ( ;; )
+    {
+        pass(argc - optind, argv + optind);
+        if ( once )
+            break;
+        sleep(interval);
+    }
+
+    free(chunks);
+    free(doms);
+    xc_interface_close(xch);
+
+    return 0;
+}
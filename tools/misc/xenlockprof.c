@@ -17,6 +17,164 @@
 #include <errno.h>
 #include <string.h>
 #include <inttypes.h>
+#include <unistd.h>
+
+static void usage(const char *name)
+{
+    printf("%s: [-r] | [-C rate] [-R] [-c [-n count]]\n", name);
+    printf("no args: print lock profile data\n");
+    printf("    -r : reset profile data\n");
+    printf("    -C : sample one in <rate> contended lock acquisitions "
+           "(0: off)\n");
+    printf("    -R : reset lock contention data\n");
+    printf("    -c : print lock contention data\n");
+    printf("    -n : print at most <count> call sites per lock "
+           "(default 5)\n");
+}
+
+struct contention_entry {
+    const xc_lockprof_site_t *site;
+    uint64_t lock_wait;             /* wait time summed over the lock */
+};
+
+static int cmp_lock(const void *a, const void *b)
+{
+    const struct contention_entry *ea = a, *eb = b;
+
+    if ( ea->site->lock_addr != eb->site->lock_addr )
+        return ea->site->lock_addr < eb->site->lock_addr ? -1 : 1;
+    return 0;
+}
+
+static int cmp_wait(const void *a, const void *b)
+{
+    const struct contention_entry *ea = a, *eb = b;
+
+    /* Locks by total wait time, then call sites of a lock by wait time. */
+    if ( ea->lock_wait != eb->lock_wait )
+        return ea->lock_wait < eb->lock_wait ? 1 : -1;
+    if ( ea->site->lock_addr != eb->site->lock_addr )
+        return ea->site->lock_addr < eb->site->lock_addr ? -1 : 1;
+    if ( ea->site->wait_time != eb->site->wait_time )
+        return ea->site->wait_time < eb->site->wait_time ? 1 : -1;
+    return 0;
+}
+
+static void print_hist(const xc_lockprof_site_t *site)
+{
+    unsigned int i;
+
+    printf("      wait:");
+    for ( i = 0; i < LOCKPROF_HIST_BUCKETS; i++ )
+    {
+        if ( !site->hist[i] )
+            continue;
+        if ( i == 0 )
+            printf(" <128ns:%"PRIu64, site->hist[i]);
+        else if ( i == LOCKPROF_HIST_BUCKETS - 1 )
+            printf(" >=%uus:%"PRIu64, (64u << i) / 1000, site->hist[i]);
+        else if ( (128u << i) <= 1000 )
+            printf(" <%uns:%"PRIu64, 128u << i, site->hist[i]);
+        else
+            printf(" <%uus:%"PRIu64, (128u << i) / 1000, site->hist[i]);
+    }
+    printf("\n");
+}
+
+static int print_contention(xc_interface *xc_handle, unsigned int max_sites)
+{
+    uint32_t i, j, n, rate;
+    uint64_t time, dropped, lock_samples;
+    struct contention_entry *entries;
+    DECLARE_HYPERCALL_BUFFER(xc_lockprof_site_t, data);
+
+    for ( n = 256; ; n = i + 32 )
+    {
+        data = xc_hypercall_buffer_alloc(xc_handle, data, sizeof(*data) * n);
+        if ( data == NULL )
+        {
+            fprintf(stderr, "Could not allocate buffers: %d (%s)\n",
+                    errno, strerror(errno));
+            return 1;
+        }
+
+        i = n;
+        if ( xc_lockprof_contention_query(xc_handle, &i, &rate, &time,
+                                          &dropped,
+                                          HYPERCALL_BUFFER(data)) != 0 )
+        {
+            fprintf(stderr, "Error getting contention records: %d (%s)\n",
+                    errno, strerror(errno));
+            xc_hypercall_buffer_free(xc_handle, data);
+            return 1;
+        }
+
+        if ( i <= n )
+            break;
+
+        xc_hypercall_buffer_free(xc_handle, data);
+    }
+
+    entries = calloc(i, sizeof(*entries));
+    if ( i && !entries )
+    {
+        fprintf(stderr, "Could not allocate memory\n");
+        xc_hypercall_buffer_free(xc_handle, data);
+        return 1;
+    }
+
+    for ( j = 0; j < i; j++ )
+        entries[j].site = &data[j];
+    qsort(entries, i, sizeof(*entries), cmp_lock);
+    for ( j = 0; j < i; )
+    {
+        uint32_t k;
+        uint64_t sum = 0;
+
+        for ( k = j; k < i &&
+                     entries[k].site->lock_addr == entries[j].site->lock_addr;
+              k++ )
+            sum += entries[k].site->wait_time;
+        for ( ; j < k; j++ )
+            entries[j].lock_wait = sum;
+    }
+    qsort(entries, i, sizeof(*entries), cmp_wait);
+
+    printf("sample rate: %s%u, sampling time: %.9fs, dropped samples: %"
+           PRIu64"\n", rate ? "1/" : "off, last 1/", rate,
+           (double)time / 1E+09, dropped);
+
+    for ( j = 0; j < i; )
+    {
+        uint64_t lock = entries[j].site->lock_addr;
+        uint32_t k, shown = 0;
+
+        lock_samples = 0;
+        for ( k = j; k < i && entries[k].site->lock_addr == lock; k++ )
+            lock_samples += entries[k].site->samples;
+
+        printf("lock %#"PRIx64": samples:%12"PRIu64", wait:%20.9fs\n",
+               lock, lock_samples, (double)entries[j].lock_wait / 1E+09);
+
+        for ( ; j < k; j++ )
+        {
+            const xc_lockprof_site_t *site = entries[j].site;
+
+            if ( shown++ >= max_sites )
+                continue;
+            printf("    %-48s: samples:%12"PRIu64", wait:%20.9fs, "
+                   "max:%12"PRIu64"ns\n",
+                   site->caller[0] ? site->caller : "?", site->samples,
+                   (double)site->wait_time / 1E+09, site->max_wait);
+            print_hist(site);
+        }
+    }
+
+    free(entries);
+    xc_hypercall_buffer_free(xc_handle, data);
+
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
@@ -25,13 +183,50 @@ int main(int argc, char *argv[])
     uint64_t           time;
     double             l, b, sl, sb;
     char               name[100];
+    int                opt, reset = 0, creset = 0, cprint = 0;
+    long               rate = -1;
+    unsigned int       max_sites = 5;
+    char              *end;
     DECLARE_HYPERCALL_BUFFER(xc_lockprof_data_t, data);
 
-    if ( (argc > 2) || ((argc == 2) && (strcmp(argv[1], "-r") != 0)) )
+    while ( (opt = getopt(argc, argv, "rC:Rcn:")) != -1 )
+    {
+        switch ( opt )
+        {
+        case 'r':
+            reset = 1;
+            break;
+        case 'C':
+            rate = strtol(optarg, &end, 0);
+            if ( *end || rate < 0 || rate > UINT32_MAX )
+            {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'R':
+            creset = 1;
+            break;
+        case 'c':
+            cprint = 1;
+            break;
+        case 'n':
+            max_sites = strtoul(optarg, &end, 0);
+            if ( *end )
+            {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if ( optind < argc || (reset && (rate >= 0 || creset || cprint)) )
     {
-        printf("%s: [-r]\n", argv[0]);
-        printf("no args: print lock profile data\n");
-        printf("    -r : reset profile data\n");
+        usage(argv[0]);
         return 1;
     }
 
@@ -42,7 +237,24 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    if ( argc > 1 )
+    if ( rate >= 0 || creset || cprint )
+    {
+        if ( rate >= 0 && xc_lockprof_contention_set(xc_handle, rate) != 0 )
+        {
+            fprintf(stderr, "Error setting contention sampling: %d (%s)\n",
+                    errno, strerror(errno));
+            return 1;
+        }
+        if ( creset && xc_lockprof_contention_reset(xc_handle) != 0 )
+        {
+            fprintf(stderr, "Error resetting contention data: %d (%s)\n",
+                    errno, strerror(errno));
+            return 1;
+        }
+        return cprint ? print_contention(xc_handle, max_sites) : 0;
+    }
+
+    if ( reset )
     {
         if ( xc_lockprof_reset(xc_handle) != 0 )
         {
@@ -0,0 +1,481 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+/*
+ * Throughput benchmark for the xen-9pfsd request handling.
+ *
+ * The I/O thread and worker pool of xen-9pfsd are run against a ring living
+ * in local memory, with the frontend emulated by the main thread. A number of
+ * clients, each with one request in flight, repeatedly walk to, open, read
+ * (or write with -W) and clunk a file of their own in the given local
+ * directory.
+ *
+ * Usage: bench-9pfsd [-W] [-w workers] [-c clients] [-s file_kb]
+ *                    [-o ring_order] [-t seconds] <dir>
+ */
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <xen-barrier.h>
+#include <xen-tools/common-macros.h>
+
+#include "xen-9pfsd.h"
+
+#define P9_CMD_VERSION    100
+#define P9_CMD_ATTACH     104
+#define P9_CMD_ERROR      107
+#define P9_CMD_WALK       110
+#define P9_CMD_OPEN       112
+#define P9_CMD_READ       116
+#define P9_CMD_WRITE      118
+#define P9_CMD_CLUNK      120
+
+#define ROOT_FID          0
+#define FILE_PREFIX       "bench-9pfsd."
+
+xenevtchn_handle *xe;
+
+static struct ring *ring;
+
+/* Frontend side event channel emulation. */
+static pthread_mutex_t fe_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t fe_cond = PTHREAD_COND_INITIALIZER;
+static bool fe_event;
+
+int xenevtchn_notify(xenevtchn_handle *xce, evtchn_port_t port)
+{
+    pthread_mutex_lock(&fe_mutex);
+    fe_event = true;
+    pthread_cond_signal(&fe_cond);
+    pthread_mutex_unlock(&fe_mutex);
+
+    return 0;
+}
+
+int xenevtchn_unmask(xenevtchn_handle *xce, evtchn_port_t port)
+{
+    return 0;
+}
+
+static void kick_backend(void)
+{
+    pthread_mutex_lock(&ring->mutex);
+    pthread_cond_signal(&ring->cond);
+    pthread_mutex_unlock(&ring->mutex);
+}
+
+static void wait_backend(void)
+{
+    pthread_mutex_lock(&fe_mutex);
+    while ( !fe_event )
+        pthread_cond_wait(&fe_cond, &fe_mutex);
+    fe_event = false;
+    pthread_mutex_unlock(&fe_mutex);
+}
+
+struct msg {
+    unsigned char buf[256];
+    unsigned int len;
+};
+
+static void msg_init(struct msg *m, uint8_t cmd, uint16_t tag)
+{
+    struct p9_header *hdr = (void *)m->buf;
+
+    hdr->cmd = cmd;
+    hdr->tag = tag;
+    m->len = sizeof(*hdr);
+}
+
+static void put_u8(struct msg *m, uint8_t val)
+{
+    m->buf[m->len++] = val;
+}
+
+static void put_u16(struct msg *m, uint16_t val)
+{
+    put_unaligned(val, (uint16_t *)(m->buf + m->len));
+    m->len += sizeof(val);
+}
+
+static void put_u32(struct msg *m, uint32_t val)
+{
+    put_unaligned(val, (uint32_t *)(m->buf + m->len));
+    m->len += sizeof(val);
+}
+
+static void put_u64(struct msg *m, uint64_t val)
+{
+    put_unaligned(val, (uint64_t *)(m->buf + m->len));
+    m->len += sizeof(val);
+}
+
+static void put_str(struct msg *m, const char *str)
+{
+    unsigned int len = strlen(str);
+
+    put_u16(m, len);
+    memcpy(m->buf + m->len, str, len);
+    m->len += len;
+}
+
+/* Send a message, optionally followed by data_len bytes of payload. */
+static void send_msg(struct msg *m, const void *data, unsigned int data_len)
+{
+    struct xen_9pfs_data_intf *intf = ring->intf;
+    unsigned int size = m->len + data_len;
+    RING_IDX prod, cons;
+
+    ((struct p9_header *)m->buf)->size = size;
+
+    while ( ring->ring_size - xen_9pfs_queued(intf->out_prod, intf->out_cons,
+                                              ring->ring_size) < size )
+        wait_backend();
+
+    prod = xen_9pfs_mask(intf->out_prod, ring->ring_size);
+    cons = xen_9pfs_mask(intf->out_cons, ring->ring_size);
+    xen_9pfs_write_packet(ring->data.out, m->buf, m->len, &prod, cons,
+                          ring->ring_size);
+    if ( data_len )
+        xen_9pfs_write_packet(ring->data.out, data, data_len, &prod, cons,
+                              ring->ring_size);
+    xen_wmb();
+    intf->out_prod += size;
+
+    kick_backend();
+}
+
+/* Get the next complete response, returns false if there is none. */
+static bool recv_msg(void *buf)
+{
+    struct xen_9pfs_data_intf *intf = ring->intf;
+    struct p9_header hdr;
+    RING_IDX in_prod = intf->in_prod;
+    RING_IDX prod, cons;
+    RING_IDX queued = xen_9pfs_queued(in_prod, intf->in_cons, ring->ring_size);
+
+    xen_rmb();
+    if ( queued < sizeof(hdr) )
+        return false;
+
+    prod = xen_9pfs_mask(in_prod, ring->ring_size);
+    cons = xen_9pfs_mask(intf->in_cons, ring->ring_size);
+    xen_9pfs_read_packet(&hdr, ring->data.in, sizeof(hdr), prod, &cons,
+                         ring->ring_size);
+    if ( queued < hdr.size )
+        return false;
+
+    cons = xen_9pfs_mask(intf->in_cons, ring->ring_size);
+    xen_9pfs_read_packet(buf, ring->data.in, hdr.size, prod, &cons,
+                         ring->ring_size);
+    xen_mb();
+    intf->in_cons += hdr.size;
+
+    kick_backend();
+
+    return true;
+}
+
+static void recv_wait(void *buf)
+{
+    while ( !recv_msg(buf) )
+        wait_backend();
+}
+
+static void check_resp(const void *buf, uint8_t cmd)
+{
+    const struct p9_header *hdr = buf;
+
+    if ( hdr->cmd == P9_CMD_ERROR )
+        errx(1, "request %u (tag %u) failed: %.*s", cmd, hdr->tag,
+             get_unaligned((const uint16_t *)(hdr + 1)),
+             (const char *)(hdr + 1) + sizeof(uint16_t));
+    if ( hdr->cmd != cmd + 1 )
+        errx(1, "unexpected response %u to request %u", hdr->cmd, cmd);
+}
+
+enum client_state {
+    CL_WALK,
+    CL_OPEN,
+    CL_IO,
+    CL_CLUNK,
+};
+
+struct client {
+    enum client_state state;
+    uint64_t off;
+    uint32_t iounit;
+};
+
+static unsigned int n_clients = 8;
+static unsigned int n_workers = 4;
+static unsigned int file_size = 256 * 1024;
+static unsigned int ring_order = 6;
+static unsigned int seconds = 5;
+static bool do_write;
+static void *write_data;
+
+static void client_send(unsigned int idx, struct client *cl)
+{
+    struct msg m;
+    char name[32];
+    uint32_t len;
+
+    switch ( cl->state )
+    {
+    case CL_WALK:
+        msg_init(&m, P9_CMD_WALK, idx);
+        put_u32(&m, ROOT_FID);
+        put_u32(&m, idx);
+        put_u16(&m, 1);
+        snprintf(name, sizeof(name), FILE_PREFIX "%u", idx);
+        put_str(&m, name);
+        break;
+
+    case CL_OPEN:
+        msg_init(&m, P9_CMD_OPEN, idx);
+        put_u32(&m, idx);
+        put_u8(&m, do_write ? 1 : 0);
+        break;
+
+    case CL_IO:
+        len = min(cl->iounit, (uint32_t)(file_size - cl->off));
+        msg_init(&m, do_write ? P9_CMD_WRITE : P9_CMD_READ, idx);
+        put_u32(&m, idx);
+        put_u64(&m, cl->off);
+        put_u32(&m, len);
+        if ( do_write )
+        {
+            send_msg(&m, write_data, len);
+            return;
+        }
+        break;
+
+    case CL_CLUNK:
+        msg_init(&m, P9_CMD_CLUNK, idx);
+        put_u32(&m, idx);
+        break;
+    }
+
+    send_msg(&m, NULL, 0);
+}
+
+/* Handle a response, returns number of file bytes read or written. */
+static unsigned int client_recv(struct client *cl, const void *buf)
+{
+    const struct p9_header *hdr = buf;
+    unsigned int len = 0;
+
+    switch ( cl->state )
+    {
+    case CL_WALK:
+        check_resp(buf, P9_CMD_WALK);
+        cl->state = CL_OPEN;
+        break;
+
+    case CL_OPEN:
+        check_resp(buf, P9_CMD_OPEN);
+        /* Qid is 13 bytes, followed by iounit. */
+        cl->iounit = get_unaligned((const uint32_t *)((void *)(hdr + 1) + 13));
+        if ( !cl->iounit )
+            cl->iounit = ring->max_size - 24;
+        cl->off = 0;
+        cl->state = CL_IO;
+        break;
+
+    case CL_IO:
+        check_resp(buf, do_write ? P9_CMD_WRITE : P9_CMD_READ);
+        len = get_unaligned((const uint32_t *)(hdr + 1));
+        cl->off += len;
+        if ( !len || cl->off >= file_size )
+            cl->state = CL_CLUNK;
+        break;
+
+    case CL_CLUNK:
+        check_resp(buf, P9_CMD_CLUNK);
+        cl->state = CL_WALK;
+        break;
+    }
+
+    return len;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void create_files(int dir_fd)
+{
+    char name[32];
+    char *data;
+    unsigned int i;
+    int fd;
+
+    data = malloc(file_size);
+    if ( !data )
+        err(1, "malloc");
+    memset(data, 0x5a, file_size);
+
+    for ( i = 1; i <= n_clients; i++ )
+    {
+        snprintf(name, sizeof(name), FILE_PREFIX "%u", i);
+        fd = openat(dir_fd, name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if ( fd < 0 || write(fd, data, file_size) != file_size )
+            err(1, "creating %s", name);
+        close(fd);
+    }
+
+    free(data);
+}
+
+static void remove_files(int dir_fd)
+{
+    char name[32];
+    unsigned int i;
+
+    for ( i = 1; i <= n_clients; i++ )
+    {
+        snprintf(name, sizeof(name), FILE_PREFIX "%u", i);
+        unlinkat(dir_fd, name, 0);
+    }
+}
+
+static void usage(const char *prog)
+{
+    errx(1, "usage: %s [-W] [-w workers] [-c clients] [-s file_kb] "
+         "[-o ring_order] [-t seconds] <dir>", prog);
+}
+
+int main(int argc, char *argv[])
+{
+    device dev = { .domid = 0 };
+    struct client *clients;
+    struct msg m;
+    void *buf;
+    unsigned int i, in_flight, ops = 0;
+    uint64_t bytes = 0;
+    double start, end;
+    int c;
+
+    while ( (c = getopt(argc, argv, "Ww:c:s:o:t:")) != -1 )
+    {
+        switch ( c )
+        {
+        case 'W': do_write = true; break;
+        case 'w': n_workers = strtoul(optarg, NULL, 0); break;
+        case 'c': n_clients = strtoul(optarg, NULL, 0); break;
+        case 's': file_size = strtoul(optarg, NULL, 0) * 1024; break;
+        case 'o': ring_order = strtoul(optarg, NULL, 0); break;
+        case 't': seconds = strtoul(optarg, NULL, 0); break;
+        default: usage(argv[0]);
+        }
+    }
+    if ( optind != argc - 1 || !n_clients || n_clients > 0xfffe ||
+         !file_size || ring_order < 1 || ring_order > MAX_RING_ORDER )
+        usage(argv[0]);
+
+    dev.root_fd = open(argv[optind], O_RDONLY | O_DIRECTORY);
+    if ( dev.root_fd < 0 )
+        err(1, "opening %s", argv[optind]);
+    dev.max_open_files = n_clients + 1;
+    pthread_mutex_init(&dev.fid_mutex, NULL);
+    init_fids(&dev);
+
+    create_files(dev.root_fd);
+
+    ring = calloc(1, sizeof(*ring));
+    clients = calloc(n_clients + 1, sizeof(*clients));
+    if ( !ring || !clients )
+        err(1, "calloc");
+    ring->device = &dev;
+    ring->evtchn = 1;
+    pthread_cond_init(&ring->cond, NULL);
+    pthread_mutex_init(&ring->mutex, NULL);
+    ring->ring_order = ring_order;
+    ring->ring_size = XEN_FLEX_RING_SIZE(ring_order);
+    ring->intf = calloc(1, sizeof(*ring->intf));
+    ring->data.in = calloc(2, ring->ring_size);
+    buf = malloc(ring->ring_size);
+    write_data = calloc(1, ring->ring_size);
+    if ( !ring->intf || !ring->data.in || !buf || !write_data )
+        err(1, "ring allocation");
+    ring->data.out = ring->data.in + ring->ring_size;
+
+    if ( start_workers(n_workers) )
+        err(1, "starting workers");
+    if ( pthread_create(&ring->thread, NULL, io_thread, ring) )
+        err(1, "starting I/O thread");
+    ring->thread_active = true;
+
+    msg_init(&m, P9_CMD_VERSION, 0xffff);
+    put_u32(&m, ring->ring_size);
+    put_str(&m, "9P2000.u");
+    send_msg(&m, NULL, 0);
+    recv_wait(buf);
+    check_resp(buf, P9_CMD_VERSION);
+
+    msg_init(&m, P9_CMD_ATTACH, 0);
+    put_u32(&m, ROOT_FID);
+    put_u32(&m, ~0U);
+    put_str(&m, "");
+    put_str(&m, "");
+    put_u32(&m, ~0U);
+    send_msg(&m, NULL, 0);
+    recv_wait(buf);
+    check_resp(buf, P9_CMD_ATTACH);
+
+    start = now();
+    end = start + seconds;
+
+    for ( i = 1; i <= n_clients; i++ )
+        client_send(i, clients + i);
+    in_flight = n_clients;
+
+    while ( in_flight )
+    {
+        const struct p9_header *hdr = buf;
+        struct client *cl;
+
+        recv_wait(buf);
+        if ( !hdr->tag || hdr->tag > n_clients )
+            errx(1, "response with unknown tag %u", hdr->tag);
+        cl = clients + hdr->tag;
+
+        bytes += client_recv(cl, buf);
+        ops++;
+
+        /* Finish the current file before stopping. */
+        if ( cl->state == CL_WALK && now() >= end )
+            in_flight--;
+        else
+            client_send(hdr->tag, cl);
+    }
+
+    end = now();
+
+    printf("%s: %u workers, %u clients, %u kB files, ring order %u:\n",
+           do_write ? "write" : "read", n_workers, n_clients,
+           file_size / 1024, ring_order);
+    printf("  %.0f requests/s, %.1f MB/s\n", ops / (end - start),
+           bytes / (end - start) / (1024 * 1024));
+
+    ring->stop_thread = true;
+    kick_backend();
+    pthread_join(ring->thread, NULL);
+    stop_workers();
+
+    remove_files(dev.root_fd);
+    free_fids(&dev);
+
+    return 0;
+}
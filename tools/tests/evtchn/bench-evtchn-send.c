@@ -0,0 +1,140 @@
+/*
+ * Measure the rate at which events can be sent on a set of loopback event
+ * channels, either one port per hypercall (EVTCHNOP_send) or a vector of
+ * ports per hypercall (EVTCHNOP_send_multi).
+ *
+ * Usage: bench-evtchn-send [nr_ports [nr_rounds]]
+ */
+#include <err.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <xenctrl.h>
+#include <xenevtchn.h>
+#include <xen-tools/common-macros.h>
+
+static xc_interface *xch;
+static xenevtchn_handle *xce;
+
+static unsigned int nr_ports = 16;
+static unsigned int nr_rounds = 100000;
+
+/* Ports the events are sent on, and the ports they get delivered to. */
+static evtchn_port_t *send_ports, *recv_ports;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Wait for the events of one round to be delivered, and re-arm the ports. */
+static void drain(void)
+{
+    unsigned int i;
+
+    for ( i = 0; i < nr_ports; i++ )
+    {
+        xenevtchn_port_or_error_t port = xenevtchn_pending(xce);
+
+        if ( port < 0 )
+            err(1, "xenevtchn_pending");
+        if ( xenevtchn_unmask(xce, port) )
+            err(1, "xenevtchn_unmask(%d)", port);
+    }
+}
+
+static void send_single(void)
+{
+    unsigned int i;
+
+    for ( i = 0; i < nr_ports; i++ )
+        if ( xenevtchn_notify(xce, send_ports[i]) )
+            err(1, "xenevtchn_notify(%u)", send_ports[i]);
+}
+
+static void send_multi(void)
+{
+    if ( xc_evtchn_send_multi(xch, send_ports, nr_ports, NULL) )
+        err(1, "xc_evtchn_send_multi");
+}
+
+static void run(const char *name, void (*send)(void))
+{
+    unsigned int i;
+    double start, elapsed;
+
+    start = now();
+    for ( i = 0; i < nr_rounds; i++ )
+    {
+        send();
+        drain();
+    }
+    elapsed = now() - start;
+
+    printf("%-12s %10.0f notifications/s (%u ports, %u rounds, %.3fs)\n",
+           name, (double)nr_ports * nr_rounds / elapsed, nr_ports, nr_rounds,
+           elapsed);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int i;
+
+    if ( argc > 1 )
+        nr_ports = strtoul(argv[1], NULL, 0);
+    if ( argc > 2 )
+        nr_rounds = strtoul(argv[2], NULL, 0);
+    if ( !nr_ports || !nr_rounds )
+        errx(1, "Usage: %s [nr_ports [nr_rounds]]", argv[0]);
+
+    xch = xc_interface_open(NULL, NULL, 0);
+    if ( !xch )
+        err(1, "xc_interface_open");
+
+    xce = xenevtchn_open(NULL, 0);
+    if ( !xce )
+        err(1, "xenevtchn_open");
+
+    send_ports = calloc(nr_ports, sizeof(*send_ports));
+    recv_ports = calloc(nr_ports, sizeof(*recv_ports));
+    if ( !send_ports || !recv_ports )
+        err(1, "calloc");
+
+    for ( i = 0; i < nr_ports; i++ )
+    {
+        xenevtchn_port_or_error_t port;
+
+        port = xenevtchn_bind_unbound_port(xce, DOMID_SELF);
+        if ( port < 0 )
+            err(1, "xenevtchn_bind_unbound_port");
+        recv_ports[i] = port;
+
+        port = xenevtchn_bind_interdomain(xce, DOMID_SELF, recv_ports[i]);
+        if ( port < 0 )
+            err(1, "xenevtchn_bind_interdomain");
+        send_ports[i] = port;
+    }
+
+    run("send", send_single);
+    run("send_multi", send_multi);
+
+    for ( i = 0; i < nr_ports; i++ )
+    {
+        xenevtchn_unbind(xce, send_ports[i]);
+        xenevtchn_unbind(xce, recv_ports[i]);
+    }
+
+    free(send_ports);
+    free(recv_ports);
+    xenevtchn_close(xce);
+    xc_interface_close(xch);
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * Measure the latency of resetting a VM fork, against the number of pages
+ * the fork wrote since it was last reset.
+ *
+ * A fork of the given (HVM, HAP) parent domain is created, and for each
+ * size the fork gets that many pages written through a foreign mapping,
+ * giving it a private copy of each, before its memory is reset.  The cost
+ * of resetting the vCPU and device state alone is reported separately.
+ *
+ * Usage: bench-fork-reset parent_domid [max_pages [nr_rounds]]
+ */
+#include <err.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include <xenctrl.h>
+#include <xenforeignmemory.h>
+#include <xen-tools/common-macros.h>
+
+/* Leave the first MB alone, it is full of firmware tables and holes. */
+#define FIRST_GFN 0x100
+
+static xc_interface *xch;
+static xenforeignmemory_handle *fmem;
+
+static uint32_t parent, fork_domid;
+static unsigned int max_pages = 65536;
+static unsigned int nr_rounds = 20;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void create_fork(void)
+{
+    xc_domaininfo_t info;
+    struct xen_domctl_createdomain create = {
+        .flags = XEN_DOMCTL_CDF_hvm | XEN_DOMCTL_CDF_hap,
+        .max_evtchn_port = -1,
+        .max_grant_frames = 64,
+        .max_maptrack_frames = 1024,
+        .grant_opts = XEN_DOMCTL_GRANT_version(1),
+    };
+
+    if ( xc_domain_getinfo_single(xch, parent, &info) )
+        err(1, "xc_domain_getinfo_single(%u)", parent);
+    if ( !(info.flags & XEN_DOMINF_hvm_guest) ||
+         !(info.flags & XEN_DOMINF_hap) )
+        errx(1, "d%u is not an HVM guest using HAP", parent);
+
+    create.max_vcpus = info.max_vcpu_id + 1;
+    create.arch = info.arch_config;
+
+    if ( xc_domain_create(xch, &fork_domid, &create) )
+        err(1, "xc_domain_create");
+
+    if ( xc_memshr_fork(xch, parent, fork_domid, false, true) )
+    {
+        int saved_errno = errno;
+
+        xc_domain_destroy(xch, fork_domid);
+        errno = saved_errno;
+        err(1, "xc_memshr_fork(%u, %u)", parent, fork_domid);
+    }
+}
+
+/* Give the fork a private copy of nr pages, by writing to them. */
+static void dirty(xen_pfn_t *gfns, int *errs, unsigned int nr)
+{
+    unsigned int i;
+    uint8_t *va;
+
+    va = xenforeignmemory_map(fmem, fork_domid, PROT_READ | PROT_WRITE, nr,
+                              gfns, errs);
+    if ( !va )
+        err(1, "xenforeignmemory_map(%u pages)", nr);
+
+    for ( i = 0; i < nr; i++ )
+    {
+        if ( errs[i] )
+            errx(1, "gfn %#lx: %s", (unsigned long)gfns[i],
+                 strerror(-errs[i]));
+        va[(size_t)i * XC_PAGE_SIZE] ^= 1;
+    }
+
+    xenforeignmemory_unmap(fmem, va, nr);
+}
+
+static void reset(bool state, bool memory)
+{
+    if ( xc_memshr_fork_reset(xch, fork_domid, state, memory) )
+        err(1, "xc_memshr_fork_reset(%u)", fork_domid);
+}
+
+int main(int argc, char **argv)
+{
+    xen_pfn_t *gfns;
+    int *errs;
+    unsigned int i, nr, round;
+    double start, elapsed;
+
+    if ( argc < 2 )
+        errx(1, "Usage: %s parent_domid [max_pages [nr_rounds]]", argv[0]);
+    parent = strtoul(argv[1], NULL, 0);
+    if ( argc > 2 )
+        max_pages = strtoul(argv[2], NULL, 0);
+    if ( argc > 3 )
+        nr_rounds = strtoul(argv[3], NULL, 0);
+    if ( !max_pages || !nr_rounds )
+        errx(1, "Usage: %s parent_domid [max_pages [nr_rounds]]", argv[0]);
+
+    xch = xc_interface_open(NULL, NULL, 0);
+    if ( !xch )
+        err(1, "xc_interface_open");
+
+    fmem = xenforeignmemory_open(NULL, 0);
+    if ( !fmem )
+        err(1, "xenforeignmemory_open");
+
+    gfns = calloc(max_pages, sizeof(*gfns));
+    errs = calloc(max_pages, sizeof(*errs));
+    if ( !gfns || !errs )
+        err(1, "calloc");
+    for ( i = 0; i < max_pages; i++ )
+        gfns[i] = FIRST_GFN + i;
+
+    create_fork();
+    printf("Forked d%u from d%u\n", fork_domid, parent);
+
+    start = now();
+    for ( round = 0; round < nr_rounds; round++ )
+        reset(true, false);
+    elapsed = now() - start;
+    printf("%-14s %10.1f us/reset\n", "state", elapsed * 1e6 / nr_rounds);
+
+    for ( nr = 1; nr <= max_pages; nr *= 4 )
+    {
+        double total = 0;
+
+        for ( round = 0; round < nr_rounds; round++ )
+        {
+            dirty(gfns, errs, nr);
+
+            start = now();
+            reset(false, true);
+            total += now() - start;
+        }
+
+        printf("memory %7u pages %10.1f us/reset %8.3f us/page\n",
+               nr, total * 1e6 / nr_rounds, total * 1e6 / nr_rounds / nr);
+    }
+
+    if ( xc_domain_destroy(xch, fork_domid) )
+        err(1, "xc_domain_destroy(%u)", fork_domid);
+
+    free(gfns);
+    free(errs);
+    xenforeignmemory_close(fmem);
+    xc_interface_close(xch);
+
+    return 0;
+}
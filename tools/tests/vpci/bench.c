@@ -0,0 +1,142 @@
+/*
+ * Micro-benchmark for the generic vPCI config space dispatch.
+ *
+ * Populates a device with a register layout resembling what the header,
+ * MSI, MSI-X and extended capability handlers install, and times guest
+ * sized accesses spread over the whole config space, including the gaps
+ * that are forwarded to (dummy) hardware.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms and conditions of the GNU General Public
+ * License, version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <time.h>
+
+#include "emul.h"
+
+static struct vpci vpci;
+
+static struct domain d;
+
+const struct pci_dev test_pdev = {
+    .vpci = &vpci,
+};
+
+const static struct vcpu v = {
+    .domain = &d
+};
+
+const struct vcpu *current = &v;
+
+static uint32_t regs[PCI_CFG_SPACE_EXP_SIZE / 4];
+
+static uint32_t bench_read(const struct pci_dev *pdev, unsigned int reg,
+                           void *data)
+{
+    return *(uint32_t *)data;
+}
+
+static void bench_write(const struct pci_dev *pdev, unsigned int reg,
+                        uint32_t val, void *data)
+{
+    *(uint32_t *)data = val;
+}
+
+static void add_reg(unsigned int offset, unsigned int size)
+{
+    int rc = vpci_add_register(&vpci, bench_read, bench_write, offset, size,
+                               &regs[offset / 4]);
+
+    assert(!rc);
+}
+
+static void populate(void)
+{
+    unsigned int i;
+
+    /* Type 0 header: command, status, BARs, ROM BAR, interrupt line. */
+    add_reg(0x04, 2);
+    add_reg(0x06, 2);
+    for ( i = 0x10; i <= 0x24; i += 4 )
+        add_reg(i, 4);
+    add_reg(0x30, 4);
+    add_reg(0x34, 1);
+    add_reg(0x3c, 1);
+
+    /* Capability list headers and MSI / MSI-X bodies. */
+    for ( i = 0x40; i < 0x100; i += 0x10 )
+    {
+        add_reg(i, 2);
+        add_reg(i + 2, 2);
+        add_reg(i + 4, 4);
+        add_reg(i + 8, 4);
+    }
+
+    /* Extended capability headers, one every 0x40 bytes. */
+    for ( i = 0x100; i < PCI_CFG_SPACE_EXP_SIZE; i += 0x40 )
+        add_reg(i, 4);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int
+main(int argc, char **argv)
+{
+    unsigned int iters = argc > 1 ? strtoul(argv[1], NULL, 0) : 2000;
+    static const unsigned int sizes[] = { 1, 2, 4 };
+    unsigned int i, j, s;
+    volatile uint32_t sink = 0;
+
+    spin_lock_init(&vpci.lock);
+    populate();
+    printf("%u registers, %u iterations over %u bytes of config space\n",
+           vpci.nr_regs, iters, PCI_CFG_SPACE_EXP_SIZE);
+
+    for ( s = 0; s < ARRAY_SIZE(sizes); s++ )
+    {
+        unsigned int size = sizes[s];
+        uint64_t start, rd, wr, nr = 0;
+
+        start = now_ns();
+        for ( i = 0; i < iters; i++ )
+            for ( j = 0; j < PCI_CFG_SPACE_EXP_SIZE; j += size, nr++ )
+                sink += vpci_read((pci_sbdf_t){ .sbdf = 0 }, j, size);
+        rd = now_ns() - start;
+
+        start = now_ns();
+        for ( i = 0; i < iters; i++ )
+            for ( j = 0; j < PCI_CFG_SPACE_EXP_SIZE; j += size )
+                vpci_write((pci_sbdf_t){ .sbdf = 0 }, j, size, i);
+        wr = now_ns() - start;
+
+        printf("size %u: read %6.1f ns/access, write %6.1f ns/access\n",
+               size, (double)rd / nr, (double)wr / nr);
+    }
+
+    return 0;
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
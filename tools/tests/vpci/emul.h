@@ -26,6 +26,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <xen-tools/common-macros.h>
 
@@ -95,7 +96,9 @@ typedef union {
 
 #define xzalloc(type) ((type *)calloc(1, sizeof(type)))
 #define xmalloc(type) ((type *)malloc(sizeof(type)))
+#define xrealloc_array(p, n) ((typeof(p))realloc(p, sizeof(*(p)) * (n)))
 #define xfree(p) free(p)
+#define XFREE(p) do { free(p); (p) = NULL; } while ( 0 )
 
 #define pci_get_pdev(...) (&test_pdev)
 #define pci_get_ro_map(...) NULL
@@ -192,7 +192,6 @@ main(int argc, char **argv)
     unsigned int i;
     int rc;
 
-    INIT_LIST_HEAD(&vpci.handlers);
     spin_lock_init(&vpci.lock);
 
     VPCI_ADD_REG(vpci_read32, vpci_write32, 0, 4, r0);
@@ -407,6 +406,17 @@ main(int argc, char **argv)
     VPCI_REMOVE_INVALID_REG(16, 2);
     VPCI_REMOVE_INVALID_REG(30, 2);
 
+    /* Removed registers must be backed by hardware again. */
+    VPCI_READ_CHECK(24, 4, 0xffffffff);
+    VPCI_READ_CHECK(28, 4, 0xffacffff);
+    VPCI_READ_CHECK(12, 4, 0xffffffff);
+
+    /* Re-add a register in the middle of the sorted set. */
+    r12 = 0x8696;
+    VPCI_ADD_REG(vpci_read16, vpci_write16, 12, 2, r12);
+    VPCI_READ_CHECK(12, 4, 0xffff8696);
+    VPCI_READ_CHECK(13, 2, 0xff86);
+
     return 0;
 }
 
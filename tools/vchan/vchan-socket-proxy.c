@@ -29,6 +29,8 @@
  * This is a vchan to unix socket proxy. Vchan server is set, and on client
  * connection, local socket connection is established. Communication is bidirectional.
  * One client is served at a time, clients needs to coordinate this themselves.
+ * With --multi, many such channels are served by one process from a single
+ * epoll loop, each still carrying one client at a time.
  */
 
 #include <stdlib.h>
@@ -37,7 +39,12 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <getopt.h>
 
@@ -49,12 +56,18 @@ static void usage(char** argv)
 {
     fprintf(stderr, "usage:\n"
         "\t%s [options] domainid nodepath [socket-path|file-no|-]\n"
+        "\t%s [options] --multi domainid nodepath socket-path\n"
+        "\t\t[domainid nodepath socket-path ...]\n"
         "\n"
         "options:\n"
         "\t-m, --mode=client|server - vchan connection mode (client by default)\n"
         "\t-s, --state-path=path - xenstore path where write \"running\" to \n"
         "\t                        at startup\n"
         "\t-v, --verbose - verbose logging\n"
+        "\t-r, --ring-size=bytes - minimum size of each vchan ring (server);\n"
+        "\t                        the same for all channels with --multi\n"
+        "\t-M, --multi - serve all given channels from a single process;\n"
+        "\t              statistics are printed on SIGUSR1 and on exit\n"
         "\n"
         "client: client of a vchan connection, fourth parameter can be:\n"
         "\tsocket-path: listen on a UNIX socket at this path and connect to vchan\n"
@@ -77,54 +90,99 @@ static void usage(char** argv)
         "\t             is closed\n"
         "\n"
         "\t-:           pass data to/from stdin/stdout; terminate when vchan\n"
-        "\t             connection is closed\n",
-        argv[0]);
+        "\t             connection is closed\n"
+        "\n"
+        "multi: each channel behaves like a socket-path channel of the\n"
+        "\tgiven mode, with one connection at a time per channel\n",
+        argv[0], argv[0]);
     exit(1);
 }
 
-#define BUFSIZE 8192
-char inbuf[BUFSIZE];
-char outbuf[BUFSIZE];
-int insiz = 0;
-int outsiz = 0;
 int verbose = 0;
 
 struct vchan_proxy_state {
     struct libxenvchan *ctrl;
     int output_fd;
     int input_fd;
+    /* bytes passed in each direction */
+    uint64_t to_vchan;
+    uint64_t to_socket;
 };
 
-static void vchan_wr(struct libxenvchan *ctrl) {
-    int ret;
+/*
+ * Data is passed without intermediate buffers: reads from the socket land
+ * directly in the vchan send ring, and writes to the socket are taken
+ * directly from the vchan receive ring.
+ */
 
-    if (!insiz)
-        return;
-    ret = libxenvchan_write(ctrl, inbuf, insiz);
+/*
+ * Returns the amount of data passed, 0 on EOF on the socket, or -1 with
+ * errno set to EAGAIN if the socket has no data, ENOSPC if the vchan has no
+ * space, or the error.
+ */
+static int socket_to_vchan(struct vchan_proxy_state *state) {
+    struct iovec iov[2];
+    int ret, iovcnt;
+
+    ret = libxenvchan_write_peek(state->ctrl, iov, &iovcnt);
     if (ret < 0) {
         fprintf(stderr, "vchan write failed\n");
-        exit(1);
+        errno = EPIPE;
+        return -1;
+    }
+    if (!ret) {
+        errno = ENOSPC;
+        return -1;
+    }
+    ret = readv(state->input_fd, iov, iovcnt);
+    if (ret <= 0)
+        return ret;
+    if (verbose)
+        fprintf(stderr, "from-unix: %.*s%.*s\n",
+                (int)(ret < iov[0].iov_len ? ret : iov[0].iov_len),
+                (char *)iov[0].iov_base,
+                (int)(ret > iov[0].iov_len ? ret - iov[0].iov_len : 0),
+                iovcnt > 1 ? (char *)iov[1].iov_base : "");
+    if (libxenvchan_write_commit(state->ctrl, ret) < 0) {
+        fprintf(stderr, "vchan write failed\n");
+        errno = EPIPE;
+        return -1;
     }
     if (verbose)
         fprintf(stderr, "wrote %d bytes to vchan\n", ret);
-    if (ret > 0) {
-        insiz -= ret;
-        memmove(inbuf, inbuf + ret, insiz);
-    }
+    state->to_vchan += ret;
+    return ret;
 }
 
-static void socket_wr(int output_fd) {
-    int ret;
+/* Returns the amount of data left in the vchan, or -1 on error */
+static int vchan_to_socket(struct vchan_proxy_state *state) {
+    struct iovec iov[2];
+    int ret, avail, iovcnt;
 
-    if (!outsiz)
-        return;
-    ret = write(output_fd, outbuf, outsiz);
-    if (ret < 0 && errno != EAGAIN)
-        exit(1);
-    if (ret > 0) {
-        outsiz -= ret;
-        memmove(outbuf, outbuf + ret, outsiz);
+    while (libxenvchan_data_ready(state->ctrl)) {
+        avail = libxenvchan_read_peek(state->ctrl, iov, &iovcnt);
+        if (avail < 0)
+            return -1;
+        if (!avail)
+            break;
+        ret = writev(state->output_fd, iov, iovcnt);
+        if (ret < 0 && errno != EAGAIN)
+            return -1;
+        if (ret <= 0)
+            return avail;
+        if (verbose)
+            fprintf(stderr, "from-vchan: %.*s%.*s\n",
+                    (int)(ret < iov[0].iov_len ? ret : iov[0].iov_len),
+                    (char *)iov[0].iov_base,
+                    (int)(ret > iov[0].iov_len ? ret - iov[0].iov_len : 0),
+                    iovcnt > 1 ? (char *)iov[1].iov_base : "");
+        if (libxenvchan_read_commit(state->ctrl, ret) < 0)
+            return -1;
+        state->to_socket += ret;
+        if (ret < avail)
+            return avail - ret;
     }
+    return 0;
 }
 
 static int set_nonblocking(int fd, int nonblocking) {
@@ -218,6 +276,24 @@ static int listen_socket(const char *path_or_fd) {
     return fd;
 }
 
+static int write_state(const char *state_path)
+{
+    struct xs_handle *xs;
+
+    xs = xs_open(0);
+    if (!xs) {
+        perror("xs_open");
+        return -1;
+    }
+    if (!xs_write(xs, XBT_NULL, state_path, "running", strlen("running"))) {
+        perror("xs_write");
+        xs_close(xs);
+        return -1;
+    }
+    xs_close(xs);
+    return 0;
+}
+
 static struct libxenvchan *connect_vchan(int domid, const char *path) {
     struct libxenvchan *ctrl = NULL;
     struct xs_handle *xs = NULL;
@@ -273,13 +349,13 @@ out:
 
 
 static void discard_buffers(struct libxenvchan *ctrl) {
-    /* discard local buffers */
-    insiz = 0;
-    outsiz = 0;
+    struct iovec iov[2];
+    int ret, iovcnt;
 
     /* discard remaining incoming data */
     while (libxenvchan_data_ready(ctrl)) {
-        if (libxenvchan_read(ctrl, inbuf, BUFSIZE) == -1) {
+        ret = libxenvchan_read_peek(ctrl, iov, &iovcnt);
+        if (ret == -1 || libxenvchan_read_commit(ctrl, ret) == -1) {
             perror("vchan read");
             exit(1);
         }
@@ -300,12 +376,12 @@ int data_loop(struct vchan_proxy_state *state)
         FD_ZERO(&wfds);
 
         max_fd = -1;
-        if (state->input_fd != -1 && insiz != BUFSIZE) {
+        if (state->input_fd != -1 && libxenvchan_buffer_space(state->ctrl)) {
             FD_SET(state->input_fd, &rfds);
             if (state->input_fd > max_fd)
                 max_fd = state->input_fd;
         }
-        if (state->output_fd != -1 && outsiz) {
+        if (state->output_fd != -1 && libxenvchan_data_ready(state->ctrl)) {
             FD_SET(state->output_fd, &wfds);
             if (state->output_fd > max_fd)
                 max_fd = state->output_fd;
@@ -323,8 +399,11 @@ int data_loop(struct vchan_proxy_state *state)
             if (!libxenvchan_is_open(state->ctrl)) {
                 if (verbose)
                     fprintf(stderr, "vchan client disconnected\n");
-                while (outsiz)
-                    socket_wr(state->output_fd);
+                do {
+                    ret = vchan_to_socket(state);
+                    if (ret < 0)
+                        exit(1);
+                } while (ret);
                 close(state->output_fd);
                 state->output_fd = -1;
                 close(state->input_fd);
@@ -332,22 +411,16 @@ int data_loop(struct vchan_proxy_state *state)
                 discard_buffers(state->ctrl);
                 break;
             }
-            vchan_wr(state->ctrl);
         }
 
         if (FD_ISSET(state->input_fd, &rfds)) {
-            ret = read(state->input_fd, inbuf + insiz, BUFSIZE - insiz);
-            if (ret < 0 && errno != EAGAIN)
+            ret = socket_to_vchan(state);
+            if (ret < 0 && errno != EAGAIN && errno != ENOSPC)
                 exit(1);
-            if (verbose)
-                fprintf(stderr, "from-unix: %.*s\n", ret, inbuf + insiz);
-            if (ret == 0) {
-                /* EOF on socket, write everything in the buffer and close the
-                 * state->input_fd socket */
-                while (insiz) {
-                    vchan_wr(state->ctrl);
-                    libxenvchan_wait(state->ctrl);
-                }
+            if (!ret) {
+                /* EOF on socket; data already passed on stays in the vchan
+                 * for the other end to read, close the state->input_fd
+                 * socket */
                 close(state->input_fd);
                 if (state->input_fd == state->output_fd)
                     state->output_fd = -1;
@@ -355,26 +428,516 @@ int data_loop(struct vchan_proxy_state *state)
                 /* TODO: maybe signal the vchan client somehow? */
                 break;
             }
-            if (ret)
-                insiz += ret;
-            vchan_wr(state->ctrl);
-        }
-        if (FD_ISSET(state->output_fd, &wfds))
-            socket_wr(state->output_fd);
-        while (libxenvchan_data_ready(state->ctrl) && outsiz < BUFSIZE) {
-            ret = libxenvchan_read(state->ctrl, outbuf + outsiz,
-                                   BUFSIZE - outsiz);
-            if (ret < 0)
-                exit(1);
-            if (verbose)
-                fprintf(stderr, "from-vchan: %.*s\n", ret, outbuf + outsiz);
-            outsiz += ret;
-            socket_wr(state->output_fd);
         }
+        if (vchan_to_socket(state) < 0)
+            exit(1);
     }
     return 0;
 }
 
+/*
+ * Multi-channel mode: any number of domid/nodepath/socket-path channels are
+ * served by a single process, with all vchan event channels, sockets and
+ * (client mode) listening sockets and the xenstore connection polled by one
+ * epoll instance. Each channel carries at most one connection at a time,
+ * like the single-channel mode does.
+ */
+
+enum ep_type {
+    EP_LISTEN,
+    EP_SOCKET,
+    EP_VCHAN,
+    EP_XS,
+};
+
+struct channel;
+
+struct ep_ref {
+    struct channel *ch;
+    enum ep_type type;
+};
+
+struct channel {
+    int domid;
+    const char *vchan_path;
+    const char *socket_path;
+    struct vchan_proxy_state state;
+    int listen_fd;
+    int vchan_fd;
+    /* socket accepted, vchan server not there yet (client mode) */
+    int pending;
+    /* socket->vchan stopped for lack of ring space */
+    int in_blocked;
+    /*
+     * socket hung up with data left to pass to the vchan; it is no longer
+     * polled, and drained as ring space becomes available
+     */
+    int hangup;
+    /* events currently polled for on the socket */
+    uint32_t socket_events;
+    /*
+     * bumped on disconnect, so that events already returned by epoll_wait()
+     * for the connection which went away are dropped
+     */
+    unsigned int gen, event_gen;
+    struct ep_ref ref_listen, ref_socket, ref_vchan;
+
+    /* statistics */
+    unsigned long connections;
+    uint64_t in_since, out_since;
+    unsigned long lat_nr;
+    uint64_t lat_ns, lat_max_ns;
+};
+
+static int epfd = -1;
+static int is_server;
+static size_t ring_size;
+static volatile sig_atomic_t stats_requested, quit_requested;
+
+static void stats_handler(int sig)
+{
+    stats_requested = 1;
+}
+
+static void quit_handler(int sig)
+{
+    quit_requested = 1;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int ep_ctl(int op, int fd, uint32_t events, struct ep_ref *ref)
+{
+    struct epoll_event ev = { .events = events, .data.ptr = ref };
+
+    if (epoll_ctl(epfd, op, fd, &ev) == -1) {
+        perror("epoll_ctl");
+        return -1;
+    }
+    return 0;
+}
+
+static void account_latency(struct channel *ch, uint64_t *since, uint64_t now)
+{
+    uint64_t ns;
+
+    if (!*since)
+        return;
+    ns = now - *since;
+    *since = 0;
+    ch->lat_nr++;
+    ch->lat_ns += ns;
+    if (ns > ch->lat_max_ns)
+        ch->lat_max_ns = ns;
+}
+
+static void report_stats(struct channel *chans, unsigned int nr,
+                         uint64_t start)
+{
+    double secs = (now_ns() - start) / 1e9;
+    unsigned int i;
+
+    for (i = 0; i < nr; i++) {
+        struct channel *ch = &chans[i];
+
+        fprintf(stderr, "%d %s %s: %lu connections, "
+                "to vchan %"PRIu64" bytes (%.1f KiB/s), "
+                "from vchan %"PRIu64" bytes (%.1f KiB/s), "
+                "latency avg %"PRIu64"us max %"PRIu64"us\n",
+                ch->domid, ch->vchan_path, ch->socket_path, ch->connections,
+                ch->state.to_vchan, ch->state.to_vchan / 1024.0 / secs,
+                ch->state.to_socket, ch->state.to_socket / 1024.0 / secs,
+                ch->lat_nr ? ch->lat_ns / ch->lat_nr / 1000 : 0,
+                ch->lat_max_ns / 1000);
+    }
+}
+
+/* Poll the socket for what the rings allow to be passed */
+static int channel_update_events(struct channel *ch)
+{
+    uint32_t events = 0;
+
+    if (ch->hangup)
+        return 0;
+    if (libxenvchan_buffer_space(ch->state.ctrl))
+        events |= EPOLLIN;
+    if (libxenvchan_data_ready(ch->state.ctrl))
+        events |= EPOLLOUT;
+    if (events == ch->socket_events)
+        return 0;
+    ch->socket_events = events;
+    return ep_ctl(EPOLL_CTL_MOD, ch->state.input_fd, events, &ch->ref_socket);
+}
+
+static int channel_connect_vchan(struct channel *ch)
+{
+    ch->state.ctrl = libxenvchan_client_init(NULL, ch->domid, ch->vchan_path);
+    if (!ch->state.ctrl)
+        return -1;
+    ch->vchan_fd = libxenvchan_fd_for_select(ch->state.ctrl);
+    return ep_ctl(EPOLL_CTL_ADD, ch->vchan_fd, EPOLLIN, &ch->ref_vchan);
+}
+
+static int channel_add_socket(struct channel *ch, int fd)
+{
+    ch->state.input_fd = ch->state.output_fd = fd;
+    ch->socket_events = 0;
+    ch->in_blocked = 0;
+    ch->hangup = 0;
+    ch->in_since = ch->out_since = 0;
+    ch->connections++;
+    if (ep_ctl(EPOLL_CTL_ADD, fd, 0, &ch->ref_socket))
+        return -1;
+    return channel_update_events(ch);
+}
+
+/* Tear down the connection; the channel waits for the next one */
+static void channel_disconnect(struct channel *ch)
+{
+    if (verbose)
+        fprintf(stderr, "%s: disconnected\n", ch->vchan_path);
+
+    ch->gen++;
+
+    if (ch->state.input_fd != -1) {
+        /* Pass on what the socket takes without blocking other channels */
+        if (ch->state.ctrl && !ch->pending)
+            vchan_to_socket(&ch->state);
+        epoll_ctl(epfd, EPOLL_CTL_DEL, ch->state.input_fd, NULL);
+        close(ch->state.input_fd);
+        ch->state.input_fd = ch->state.output_fd = -1;
+    }
+    ch->pending = 0;
+
+    if (is_server) {
+        /* Data from a client that went away is not for the next one */
+        if (libxenvchan_is_open(ch->state.ctrl) != 1)
+            discard_buffers(ch->state.ctrl);
+        return;
+    }
+
+    if (ch->state.ctrl) {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, ch->vchan_fd, NULL);
+        libxenvchan_close(ch->state.ctrl);
+        ch->state.ctrl = NULL;
+    }
+    /* Accept the next connection */
+    ep_ctl(EPOLL_CTL_MOD, ch->listen_fd, EPOLLIN, &ch->ref_listen);
+}
+
+/*
+ * Pass data in both directions as far as the socket and the rings allow.
+ * Returns 0 on EOF on the socket, -1 on error, 1 otherwise.
+ */
+static int channel_pump(struct channel *ch, int readable)
+{
+    uint64_t now = now_ns();
+    int ret;
+
+    /* Nothing can be passed to a socket which hung up */
+    if (!ch->hangup) {
+        ret = vchan_to_socket(&ch->state);
+        if (ret < 0)
+            return -1;
+        if (!ret)
+            account_latency(ch, &ch->out_since, now);
+    }
+
+    if (readable || ch->in_blocked) {
+        if (readable && !ch->in_since)
+            ch->in_since = now;
+        for (;;) {
+            ret = socket_to_vchan(&ch->state);
+            if (ret > 0)
+                continue;
+            if (!ret)
+                return 0;
+            if (errno == EAGAIN) {
+                ch->in_blocked = 0;
+                account_latency(ch, &ch->in_since, now_ns());
+                break;
+            }
+            if (errno == ENOSPC) {
+                ch->in_blocked = 1;
+                break;
+            }
+            return -1;
+        }
+    }
+
+    return channel_update_events(ch) ? -1 : 1;
+}
+
+static void channel_vchan_connected(struct channel *ch)
+{
+    int fd = connect_socket(ch->socket_path);
+
+    if (fd == -1) {
+        fprintf(stderr, "%s: connect_socket failed\n", ch->socket_path);
+        return;
+    }
+    if (channel_add_socket(ch, fd))
+        channel_disconnect(ch);
+}
+
+/* Act on the result of channel_pump() */
+static void channel_pumped(struct channel *ch, int ret)
+{
+    if (ret > 0)
+        return;
+    /*
+     * On EOF, data already passed on stays in the vchan for the other end
+     * to read.
+     */
+    channel_disconnect(ch);
+    if (!ret && is_server && libxenvchan_is_open(ch->state.ctrl) == 1)
+        channel_vchan_connected(ch);
+}
+
+static void channel_socket_event(struct channel *ch, uint32_t events)
+{
+    int ret = channel_pump(ch, events & (EPOLLIN | EPOLLHUP | EPOLLERR));
+
+    /*
+     * EPOLLHUP and EPOLLERR are reported whatever the events polled for, so
+     * a socket which hung up while the ring is full would keep waking us.
+     * Stop polling it; vchan events drain it once the ring has space.
+     */
+    if (ret > 0 && (events & (EPOLLHUP | EPOLLERR)) && ch->in_blocked) {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, ch->state.input_fd, NULL);
+        ch->hangup = 1;
+        return;
+    }
+
+    channel_pumped(ch, ret);
+}
+
+static void channel_vchan_event(struct channel *ch)
+{
+    libxenvchan_wait(ch->state.ctrl);
+
+    if (ch->state.input_fd == -1) {
+        /* Server waiting for a client */
+        if (is_server && libxenvchan_is_open(ch->state.ctrl) == 1)
+            channel_vchan_connected(ch);
+        return;
+    }
+
+    if (!libxenvchan_is_open(ch->state.ctrl)) {
+        channel_disconnect(ch);
+        return;
+    }
+
+    if (!ch->out_since && libxenvchan_data_ready(ch->state.ctrl))
+        ch->out_since = now_ns();
+    channel_pumped(ch, channel_pump(ch, 0));
+}
+
+static void channel_accept(struct channel *ch)
+{
+    int fd = accept(ch->listen_fd, NULL, NULL);
+
+    if (fd == -1) {
+        if (errno != EAGAIN)
+            perror("accept");
+        return;
+    }
+    set_nonblocking(fd, 1);
+
+    /* One connection per channel; leave further ones in the backlog */
+    ep_ctl(EPOLL_CTL_MOD, ch->listen_fd, 0, &ch->ref_listen);
+
+    if (channel_connect_vchan(ch)) {
+        /* Retried when the server shows up in xenstore */
+        ch->state.input_fd = ch->state.output_fd = fd;
+        ch->pending = 1;
+        return;
+    }
+    if (channel_add_socket(ch, fd))
+        channel_disconnect(ch);
+}
+
+/* Retry pending client connections after a xenstore change */
+static void channels_retry(struct channel *chans, unsigned int nr,
+                           struct xs_handle *xs, xc_interface *xc)
+{
+    xc_domaininfo_t dominfo;
+    char **watch_ret;
+    unsigned int i;
+    int ret, fd;
+
+    while ((watch_ret = xs_check_watch(xs)))
+        free(watch_ret);
+
+    for (i = 0; i < nr; i++) {
+        struct channel *ch = &chans[i];
+
+        if (!ch->pending)
+            continue;
+        if (!channel_connect_vchan(ch)) {
+            fd = ch->state.input_fd;
+            ch->pending = 0;
+            if (channel_add_socket(ch, fd))
+                channel_disconnect(ch);
+            continue;
+        }
+
+        /* Give up if the domain is definitely not there anymore */
+        ret = xc_domain_getinfo_single(xc, ch->domid, &dominfo);
+        if ((ret == -1 && errno == ESRCH) ||
+            (ret == 0 && (dominfo.flags & XEN_DOMINF_dying)))
+            channel_disconnect(ch);
+    }
+}
+
+static int multi_loop(struct channel *chans, unsigned int nr,
+                      const char *state_path)
+{
+    struct epoll_event events[64];
+    struct ep_ref xs_ref = { .type = EP_XS };
+    struct xs_handle *xs = NULL;
+    xc_interface *xc = NULL;
+    uint64_t start = now_ns();
+    unsigned int i;
+    int n, ret = 1;
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd == -1) {
+        perror("epoll_create1");
+        return 1;
+    }
+
+    if (!is_server) {
+        xs = xs_open(XS_OPEN_READONLY);
+        if (!xs) {
+            perror("xs_open");
+            goto out;
+        }
+        xc = xc_interface_open(NULL, NULL, XC_OPENFLAG_NON_REENTRANT);
+        if (!xc) {
+            perror("xc_interface_open");
+            goto out;
+        }
+        if (!xs_watch(xs, "@releaseDomain", "release")) {
+            fprintf(stderr, "xs_watch(@releaseDomain) failed.\n");
+            goto out;
+        }
+        if (ep_ctl(EPOLL_CTL_ADD, xs_fileno(xs), EPOLLIN, &xs_ref))
+            goto out;
+    }
+
+    for (i = 0; i < nr; i++) {
+        struct channel *ch = &chans[i];
+
+        ch->ref_listen = (struct ep_ref){ ch, EP_LISTEN };
+        ch->ref_socket = (struct ep_ref){ ch, EP_SOCKET };
+        ch->ref_vchan = (struct ep_ref){ ch, EP_VCHAN };
+
+        if (is_server) {
+            ch->state.ctrl = libxenvchan_server_init(NULL, ch->domid,
+                                                     ch->vchan_path,
+                                                     ring_size, ring_size);
+            if (!ch->state.ctrl) {
+                perror("libxenvchan_server_init");
+                goto out;
+            }
+            ch->vchan_fd = libxenvchan_fd_for_select(ch->state.ctrl);
+            if (ep_ctl(EPOLL_CTL_ADD, ch->vchan_fd, EPOLLIN, &ch->ref_vchan))
+                goto out;
+        } else {
+            ch->listen_fd = listen_socket(ch->socket_path);
+            if (ch->listen_fd == -1) {
+                fprintf(stderr, "listen socket failed\n");
+                goto out;
+            }
+            set_nonblocking(ch->listen_fd, 1);
+            if (!xs_watch(xs, ch->vchan_path, "path")) {
+                fprintf(stderr, "xs_watch(%s) failed.\n", ch->vchan_path);
+                goto out;
+            }
+            if (ep_ctl(EPOLL_CTL_ADD, ch->listen_fd, EPOLLIN, &ch->ref_listen))
+                goto out;
+        }
+    }
+
+    if (state_path && write_state(state_path))
+        goto out;
+
+    while (!quit_requested) {
+        n = epoll_wait(epfd, events, sizeof(events) / sizeof(events[0]), -1);
+        if (n == -1) {
+            if (errno != EINTR) {
+                perror("epoll_wait");
+                goto out;
+            }
+            n = 0;
+        }
+
+        /* Note which connection each event was reported for */
+        for (i = 0; i < n; i++) {
+            struct ep_ref *ref = events[i].data.ptr;
+
+            if (ref->ch)
+                ref->ch->event_gen = ref->ch->gen;
+        }
+
+        for (i = 0; i < n; i++) {
+            struct ep_ref *ref = events[i].data.ptr;
+
+            switch (ref->type) {
+            case EP_LISTEN:
+                channel_accept(ref->ch);
+                break;
+            case EP_SOCKET:
+                /* The socket may have gone with an earlier event */
+                if (ref->ch->gen == ref->ch->event_gen)
+                    channel_socket_event(ref->ch, events[i].events);
+                break;
+            case EP_VCHAN:
+                if (ref->ch->gen == ref->ch->event_gen)
+                    channel_vchan_event(ref->ch);
+                break;
+            case EP_XS:
+                channels_retry(chans, nr, xs, xc);
+                break;
+            }
+        }
+
+        if (stats_requested) {
+            stats_requested = 0;
+            report_stats(chans, nr, start);
+        }
+    }
+
+    ret = 0;
+    report_stats(chans, nr, start);
+
+ out:
+    for (i = 0; i < nr; i++) {
+        struct channel *ch = &chans[i];
+
+        if (ch->state.input_fd >= 0)
+            close(ch->state.input_fd);
+        if (ch->state.ctrl)
+            libxenvchan_close(ch->state.ctrl);
+        if (!is_server && ch->listen_fd >= 0)
+            close(ch->listen_fd);
+    }
+    if (xc)
+        xc_interface_close(xc);
+    if (xs)
+        xs_close(xs);
+    close(epfd);
+    return ret;
+}
+
 /**
     Simple libxenvchan application, both client and server.
     Both sides may write and read, both from the libxenvchan and from
@@ -385,12 +948,14 @@ static struct option options[] = {
     { "mode",       required_argument, NULL, 'm' },
     { "verbose",          no_argument, NULL, 'v' },
     { "state-path", required_argument, NULL, 's' },
+    { "multi",            no_argument, NULL, 'M' },
+    { "ring-size",  required_argument, NULL, 'r' },
     { }
 };
 
 int main(int argc, char **argv)
 {
-    int is_server = 0;
+    int multi = 0;
     int socket_fd = -1;
     struct vchan_proxy_state state = { .ctrl = NULL,
                                        .input_fd = -1,
@@ -402,7 +967,7 @@ int main(int argc, char **argv)
     int opt;
     int ret;
 
-    while ((opt = getopt_long(argc, argv, "m:vs:", options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "m:vs:Mr:", options, NULL)) != -1) {
         switch (opt) {
             case 'm':
                 if (strcmp(optarg, "server") == 0)
@@ -421,11 +986,53 @@ int main(int argc, char **argv)
             case 's':
                 state_path = optarg;
                 break;
+            case 'M':
+                multi = 1;
+                break;
+            case 'r':
+                ring_size = strtoul(optarg, NULL, 0);
+                break;
             case '?':
                 usage(argv);
         }
     }
 
+    if (multi) {
+        struct sigaction sa = { .sa_handler = stats_handler };
+        struct channel *chans;
+        unsigned int i, nr = (argc - optind) / 3;
+
+        if (!nr || (argc - optind) % 3)
+            usage(argv);
+        chans = calloc(nr, sizeof(*chans));
+        if (!chans) {
+            perror("calloc");
+            return 1;
+        }
+        for (i = 0; i < nr; i++) {
+            chans[i].domid = atoi(argv[optind + i * 3]);
+            chans[i].vchan_path = argv[optind + i * 3 + 1];
+            chans[i].socket_path = argv[optind + i * 3 + 2];
+            chans[i].state.input_fd = chans[i].state.output_fd = -1;
+            chans[i].listen_fd = -1;
+            if (chans[i].socket_path[0] != '/') {
+                fprintf(stderr, "--multi needs socket paths\n");
+                usage(argv);
+            }
+        }
+
+        /* Interrupt epoll_wait() rather than restarting it */
+        sigaction(SIGUSR1, &sa, NULL);
+        sa.sa_handler = quit_handler;
+        sigaction(SIGTERM, &sa, NULL);
+        sigaction(SIGINT, &sa, NULL);
+        signal(SIGPIPE, SIG_IGN);
+
+        ret = multi_loop(chans, nr, state_path);
+        free(chans);
+        return ret;
+    }
+
     if (argc-optind != 3)
         usage(argv);
 
@@ -434,7 +1041,8 @@ int main(int argc, char **argv)
     socket_path = argv[optind+2];
 
     if (is_server) {
-        state.ctrl = libxenvchan_server_init(NULL, domid, vchan_path, 0, 0);
+        state.ctrl = libxenvchan_server_init(NULL, domid, vchan_path,
+                                             ring_size, ring_size);
         if (!state.ctrl) {
             perror("libxenvchan_server_init");
             exit(1);
@@ -452,20 +1060,8 @@ int main(int argc, char **argv)
         }
     }
 
-    if (state_path) {
-        struct xs_handle *xs;
-
-        xs = xs_open(0);
-        if (!xs) {
-            perror("xs_open");
-            return 1;
-        }
-        if (!xs_write(xs, XBT_NULL, state_path, "running", strlen("running"))) {
-            perror("xs_write");
-            return 1;
-        }
-        xs_close(xs);
-    }
+    if (state_path && write_state(state_path))
+        return 1;
 
     ret = 0;
 
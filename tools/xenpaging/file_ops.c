@@ -19,9 +19,18 @@
  */
 
 
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <xenctrl.h>
 
+#include "file_ops.h"
+
+/* Maximum number of adjacent slots transferred in one system call */
+#define PAGE_IO_MERGE 32
+
 static int file_op(int fd, void *page, int i,
                    ssize_t (*fn)(int, void *, size_t))
 {
@@ -60,6 +69,220 @@ int write_page(int fd, void *page, int i)
     return file_op(fd, page, i, &my_write);
 }
 
+/*
+ * Asynchronous page I/O: a batch of page transfers is handed to a pool of
+ * threads, each keeping one system call in flight, so the depth of the pool
+ * is the queue depth seen by the storage.  Transfers to adjacent slots are
+ * merged into a single vectored system call.
+ */
+static int io_fd = -1;
+static pthread_t *io_threads;
+static unsigned int io_nr_threads;
+static pthread_mutex_t io_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t io_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t io_done_cond = PTHREAD_COND_INITIALIZER;
+static struct page_io *io_queue;
+static unsigned int io_next, io_count, io_pending, io_failed;
+static int io_stop;
+
+static int page_io_cmp(const void *a, const void *b)
+{
+    const struct page_io *x = a, *y = b;
+
+    return x->slot - y->slot;
+}
+
+static int page_io_rw(int write, struct iovec *iov, int cnt, off_t offset)
+{
+    ssize_t bytes;
+
+    while ( cnt )
+    {
+        if ( write )
+            bytes = pwritev(io_fd, iov, cnt, offset);
+        else
+            bytes = preadv(io_fd, iov, cnt, offset);
+        if ( bytes < 0 && errno == EINTR )
+            continue;
+        if ( bytes <= 0 )
+            return -1;
+
+        offset += bytes;
+        while ( cnt && bytes >= iov->iov_len )
+        {
+            bytes -= iov->iov_len;
+            iov++;
+            cnt--;
+        }
+        if ( cnt )
+        {
+            iov->iov_base += bytes;
+            iov->iov_len -= bytes;
+        }
+    }
+
+    return 0;
+}
+
+/* Transfer io[0 .. nr - 1], which are for adjacent slots */
+static int page_io_run(struct page_io *io, unsigned int nr)
+{
+    struct iovec iov[PAGE_IO_MERGE];
+    unsigned int i;
+
+    for ( i = 0; i < nr; i++ )
+    {
+        iov[i].iov_base = io[i].page;
+        iov[i].iov_len = XC_PAGE_SIZE;
+    }
+
+    return page_io_rw(io->write, iov, nr, (off_t)io->slot << XC_PAGE_SHIFT);
+}
+
+/* Take the next run of adjacent transfers off the queue, io_mutex held */
+static unsigned int page_io_take(struct page_io **io)
+{
+    unsigned int first = io_next;
+
+    *io = &io_queue[first];
+    do {
+        io_next++;
+    } while ( io_next < io_count && io_next - first < PAGE_IO_MERGE &&
+              io_queue[io_next].write == io_queue[first].write &&
+              io_queue[io_next].slot == io_queue[io_next - 1].slot + 1 );
+
+    return io_next - first;
+}
+
+static void page_io_complete(struct page_io *io, unsigned int nr, int rc)
+{
+    unsigned int i;
+
+    for ( i = 0; i < nr; i++ )
+        io[i].rc = rc;
+    if ( rc )
+        io_failed += nr;
+    io_pending -= nr;
+}
+
+static void *page_io_thread(void *arg)
+{
+    struct page_io *io;
+    unsigned int nr;
+    int rc;
+
+    pthread_mutex_lock(&io_mutex);
+
+    for ( ; ; )
+    {
+        while ( !io_stop && io_next == io_count )
+            pthread_cond_wait(&io_cond, &io_mutex);
+        if ( io_stop )
+            break;
+
+        nr = page_io_take(&io);
+
+        pthread_mutex_unlock(&io_mutex);
+        rc = page_io_run(io, nr);
+        pthread_mutex_lock(&io_mutex);
+
+        page_io_complete(io, nr, rc);
+        if ( !io_pending )
+            pthread_cond_signal(&io_done_cond);
+    }
+
+    pthread_mutex_unlock(&io_mutex);
+
+    return NULL;
+}
+
+int page_io_init(int fd, unsigned int depth)
+{
+    io_fd = fd;
+
+    if ( !depth )
+        return 0;
+
+    io_threads = calloc(depth, sizeof(*io_threads));
+    if ( !io_threads )
+        return -1;
+
+    for ( io_nr_threads = 0; io_nr_threads < depth; io_nr_threads++ )
+    {
+        errno = pthread_create(&io_threads[io_nr_threads], NULL,
+                               page_io_thread, NULL);
+        if ( errno )
+        {
+            page_io_teardown();
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void page_io_teardown(void)
+{
+    unsigned int i;
+
+    pthread_mutex_lock(&io_mutex);
+    io_stop = 1;
+    pthread_cond_broadcast(&io_cond);
+    pthread_mutex_unlock(&io_mutex);
+
+    for ( i = 0; i < io_nr_threads; i++ )
+        pthread_join(io_threads[i], NULL);
+
+    free(io_threads);
+    io_threads = NULL;
+    io_nr_threads = 0;
+}
+
+void page_io_submit(struct page_io *io, unsigned int nr)
+{
+    /* Sort by slot, so that adjacent slots get merged */
+    qsort(io, nr, sizeof(*io), page_io_cmp);
+
+    pthread_mutex_lock(&io_mutex);
+
+    io_queue = io;
+    io_next = 0;
+    io_count = nr;
+    io_pending = nr;
+    io_failed = 0;
+
+    if ( io_nr_threads )
+        pthread_cond_broadcast(&io_cond);
+
+    pthread_mutex_unlock(&io_mutex);
+}
+
+int page_io_wait(void)
+{
+    struct page_io *io;
+    unsigned int nr;
+    int rc;
+
+    pthread_mutex_lock(&io_mutex);
+
+    /* Without threads, do the transfers synchronously */
+    while ( !io_nr_threads && io_next < io_count )
+    {
+        nr = page_io_take(&io);
+        rc = page_io_run(io, nr);
+        page_io_complete(io, nr, rc);
+    }
+
+    while ( io_pending )
+        pthread_cond_wait(&io_done_cond, &io_mutex);
+
+    rc = io_failed;
+
+    pthread_mutex_unlock(&io_mutex);
+
+    return rc;
+}
+
 
 /*
  * Local variables:
@@ -27,6 +27,25 @@
 int read_page(int fd, void *page, int i);
 int write_page(int fd, void *page, int i);
 
+/* A page transfer between memory and a slot of the paging file */
+struct page_io {
+    void *page;
+    int slot;
+    int write;
+    /* Result, 0 or -1 */
+    int rc;
+    /* For the submitter's use */
+    unsigned long gfn;
+};
+
+/* Start depth I/O threads on fd, 0 does I/O synchronously in page_io_wait() */
+int page_io_init(int fd, unsigned int depth);
+void page_io_teardown(void);
+/* Queue a batch of transfers, which get reordered by slot */
+void page_io_submit(struct page_io *io, unsigned int nr);
+/* Wait for all transfers of the batch, returns the number of failures */
+int page_io_wait(void);
+
 
 #endif
 
@@ -28,11 +28,13 @@
 
 
 int policy_init(struct xenpaging *paging);
-unsigned long policy_choose_victim(struct xenpaging *paging);
+unsigned int policy_choose_victims(struct xenpaging *paging,
+                                   unsigned long *victims, unsigned int nr);
 void policy_notify_paged_out(unsigned long gfn);
 void policy_notify_paged_in(unsigned long gfn);
 void policy_notify_paged_in_nomru(unsigned long gfn);
 void policy_notify_dropped(unsigned long gfn);
+void policy_notify_prefetched(unsigned long gfn);
 
 #endif // __XEN_PAGING_POLICY_H__
 
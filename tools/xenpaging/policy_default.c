@@ -25,6 +25,27 @@
 
 #define DEFAULT_MRU_SIZE (1024 * 16)
 
+/*
+ * Victims are picked with a simplified CLOCK-Pro: resident pages are either
+ * hot (part of the working set) or cold, and only cold pages are evicted.
+ * A cold page gets a test period when it is found referenced; a second
+ * reference during the test period, or a refault after it was evicted,
+ * promotes it to hot.  The cold hand looks for victims, the hot hand demotes
+ * hot pages which were not referenced during its last revolution and ends
+ * test periods.  Refaults during a test period grow the share of cold pages,
+ * expired test periods shrink it.
+ *
+ * References are taken from the accessed bits kept by the hardware,
+ * harvested one chunk at a time when a hand enters it.  Without hardware
+ * support no page is ever referenced, and the cold hand degrades to a plain
+ * round-robin scan.
+ */
+#define PG_TEST  0x1 /* Cold page in its test period */
+#define PG_REF   0x2 /* Accessed since a hand last passed */
+
+/* gfns sampled at once, a multiple of BITS_PER_LONG */
+#define SAMPLE_CHUNK 4096
+
 
 static unsigned long *mru;
 static unsigned int i_mru;
@@ -35,6 +56,15 @@ static unsigned int unconsumed_cleared;
 static unsigned long current_gfn;
 static unsigned long max_pages;
 
+static unsigned long *hot;
+static unsigned char *state;
+static unsigned long *sample;
+static int sampling;
+static unsigned long cold_chunk, hot_chunk;
+static unsigned long hot_gfn;
+static unsigned long nr_hot;
+static unsigned long cold_target, cold_min, cold_max;
+
 
 int policy_init(struct xenpaging *paging)
 {
@@ -65,24 +95,130 @@ int policy_init(struct xenpaging *paging)
     for ( i = 0; i < mru_size; i++ )
         mru[i] = INVALID_MFN;
 
+    /* Allocate hot/cold state and the access sample buffer */
+    hot = bitmap_alloc(max_pages);
+    if ( !hot )
+        goto out;
+    state = calloc(max_pages, sizeof(*state));
+    if ( !state )
+        goto out;
+    sample = bitmap_alloc(SAMPLE_CHUNK);
+    if ( !sample )
+        goto out;
+
+    sampling = 1;
+    cold_min = max_pages / 32 ?: 1;
+    cold_max = max_pages / 2 ?: 1;
+    cold_target = max_pages / 16 ?: 1;
+    cold_chunk = hot_chunk = ~0UL;
+
     /* Don't page out page 0 */
     set_bit(0, bitmap);
 
     /* Start in the middle to avoid paging during BIOS startup */
     current_gfn = max_pages / 2;
+    hot_gfn = current_gfn;
 
     rc = 0;
  out:
     return rc;
 }
 
-unsigned long policy_choose_victim(struct xenpaging *paging)
+/* Fold the accessed bits of the chunk containing gfn into the page state */
+static void sample_chunk(struct xenpaging *paging, unsigned long gfn)
+{
+    xc_interface *xch = paging->xc_handle;
+    unsigned long first = gfn & ~(SAMPLE_CHUNK - 1UL);
+    unsigned int nr = SAMPLE_CHUNK, i;
+    const unsigned char *bytes = (const unsigned char *)sample;
+
+    if ( !sampling )
+        return;
+
+    if ( first + nr > max_pages )
+        nr = max_pages - first;
+
+    if ( xc_mem_paging_sample(xch, paging->vm_event.domain_id,
+                              first, nr, sample) < 0 )
+    {
+        if ( errno == EOPNOTSUPP || errno == ENOSYS )
+        {
+            DPRINTF("access sampling not available, using round-robin");
+            sampling = 0;
+        }
+        else
+            PERROR("Error sampling gfns %lx-%lx", first, first + nr - 1);
+        return;
+    }
+
+    for ( i = 0; i < nr; i += 8 )
+    {
+        unsigned int j, b = bytes[i / 8];
+
+        for ( j = 0; b; j++, b >>= 1 )
+            if ( b & 1 )
+                state[first + i + j] |= PG_REF;
+    }
+}
+
+static unsigned long hot_target(struct xenpaging *paging)
+{
+    unsigned long resident = max_pages - paging->num_paged_out;
+
+    /* Make room for cold pages within the target, not the current size */
+    if ( paging->target_tot_pages > 0 && paging->target_tot_pages < resident )
+        resident = paging->target_tot_pages;
+
+    return resident > cold_target ? resident - cold_target : 0;
+}
+
+/* Demote hot pages until the number of hot pages is back within target */
+static void run_hot_hand(struct xenpaging *paging)
+{
+    unsigned long i;
+
+    for ( i = 0; i < 2 * max_pages && nr_hot > hot_target(paging); i++ )
+    {
+        if ( ++hot_gfn >= max_pages )
+            hot_gfn = 0;
+
+        if ( hot_gfn / SAMPLE_CHUNK != hot_chunk )
+        {
+            hot_chunk = hot_gfn / SAMPLE_CHUNK;
+            sample_chunk(paging, hot_gfn);
+        }
+
+        if ( test_bit(hot_gfn, hot) )
+        {
+            if ( state[hot_gfn] & PG_REF )
+                state[hot_gfn] &= ~PG_REF;
+            else
+            {
+                clear_bit(hot_gfn, hot);
+                nr_hot--;
+            }
+        }
+        else if ( state[hot_gfn] & PG_TEST )
+        {
+            /* Test period expired without reuse */
+            state[hot_gfn] &= ~PG_TEST;
+            if ( cold_target > cold_min )
+                cold_target--;
+        }
+    }
+}
+
+unsigned int policy_choose_victims(struct xenpaging *paging,
+                                   unsigned long *victims, unsigned int nr)
 {
     xc_interface *xch = paging->xc_handle;
     unsigned long i;
+    unsigned int n = 0;
+
+    run_hot_hand(paging);
 
     /* One iteration over all possible gfns */
-    for ( i = 0; i < max_pages; i++ )
+    for ( i = 0; i < max_pages && n < nr; i++ )
     {
         /* Try next gfn */
         current_gfn++;
@@ -91,13 +227,22 @@ unsigned long policy_choose_victim(struct xenpaging *paging)
         if ( current_gfn >= max_pages )
             current_gfn = 0;
 
-        if ( (current_gfn & (BITS_PER_LONG - 1)) == 0 )
+        if ( current_gfn / SAMPLE_CHUNK != cold_chunk )
         {
-            /* All gfns busy */
-            if ( ~bitmap[current_gfn >> ORDER_LONG] == 0 || ~unconsumed[current_gfn >> ORDER_LONG] == 0 )
+            cold_chunk = current_gfn / SAMPLE_CHUNK;
+            sample_chunk(paging, current_gfn);
+        }
+
+        if ( (current_gfn & (BITS_PER_LONG - 1)) == 0 &&
+             current_gfn + BITS_PER_LONG <= max_pages )
+        {
+            /* All gfns busy or hot */
+            if ( ~(bitmap[current_gfn >> ORDER_LONG] |
+                   unconsumed[current_gfn >> ORDER_LONG] |
+                   hot[current_gfn >> ORDER_LONG]) == 0 )
             {
-                current_gfn += BITS_PER_LONG;
-                i += BITS_PER_LONG;
+                current_gfn += BITS_PER_LONG - 1;
+                i += BITS_PER_LONG - 1;
                 continue;
             }
         }
@@ -110,12 +255,33 @@ unsigned long policy_choose_victim(struct xenpaging *paging)
         if ( test_bit(current_gfn, unconsumed) )
             continue;
 
+        /* Hot pages are left to the hot hand */
+        if ( test_bit(current_gfn, hot) )
+            continue;
+
+        if ( state[current_gfn] & PG_REF )
+        {
+            state[current_gfn] &= ~PG_REF;
+            if ( state[current_gfn] & PG_TEST )
+            {
+                /* Reused during its test period */
+                state[current_gfn] = 0;
+                set_bit(current_gfn, hot);
+                nr_hot++;
+                run_hot_hand(paging);
+            }
+            else
+                state[current_gfn] |= PG_TEST;
+            continue;
+        }
+
         /* gfn found */
-        break;
+        set_bit(current_gfn, unconsumed);
+        victims[n++] = current_gfn;
     }
 
     /* Could not nominate any gfn */
-    if ( i >= max_pages )
+    if ( !n )
     {
         /* No more pages, wait in poll */
         paging->use_poll_timeout = 1;
@@ -129,17 +295,17 @@ unsigned long policy_choose_victim(struct xenpaging *paging)
             unconsumed_cleared = 0;
             DPRINTF("clearing unconsumed, current_gfn %lx", current_gfn);
         }
-        return INVALID_MFN;
     }
 
-    set_bit(current_gfn, unconsumed);
-    return current_gfn;
+    return n;
 }
 
 void policy_notify_paged_out(unsigned long gfn)
 {
     set_bit(gfn, bitmap);
     clear_bit(gfn, unconsumed);
+    /* A page in its test period stays tracked as non-resident */
+    state[gfn] &= PG_TEST;
 }
 
 static void policy_handle_paged_in(unsigned long gfn, int do_mru)
@@ -157,6 +323,18 @@ static void policy_handle_paged_in(unsigned long gfn, int do_mru)
     }
 
     i_mru++;
+
+    if ( state[gfn] & PG_TEST )
+    {
+        /* Refault during the test period: evicted too early */
+        state[gfn] = 0;
+        set_bit(gfn, hot);
+        nr_hot++;
+        if ( cold_target < cold_max )
+            cold_target++;
+    }
+    else
+        state[gfn] = PG_TEST;
 }
 
 void policy_notify_paged_in(unsigned long gfn)
@@ -172,6 +350,18 @@ void policy_notify_paged_in_nomru(unsigned long gfn)
 void policy_notify_dropped(unsigned long gfn)
 {
     clear_bit(gfn, bitmap);
+    state[gfn] = 0;
+    if ( test_bit(gfn, hot) )
+    {
+        clear_bit(gfn, hot);
+        nr_hot--;
+    }
+}
+
+void policy_notify_prefetched(unsigned long gfn)
+{
+    /* Not accessed yet, so it is neither recent nor a refault */
+    clear_bit(gfn, bitmap);
 }
 
 
@@ -42,6 +42,7 @@ static char *dom_path;
 static char watch_token[16];
 static char *filename;
 static int interrupted;
+static int report_requested;
 
 static void unlink_pagefile(void)
 {
@@ -58,6 +59,20 @@ static void close_handler(int sig)
     unlink_pagefile();
 }
 
+static void report_handler(int sig)
+{
+    report_requested = 1;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
 static void xenpaging_mem_paging_flush_ioemu_cache(struct xenpaging *paging)
 {
     struct xs_handle *xsh = paging->xs_handle;
@@ -178,17 +193,17 @@ static int xenpaging_get_tot_pages(struct xenpaging *paging)
     return domain_info.tot_pages;
 }
 
-static void *init_page(void)
+static void *init_pages(unsigned int nr)
 {
     void *buffer;
 
     /* Allocated page memory */
-    errno = posix_memalign(&buffer, XC_PAGE_SIZE, XC_PAGE_SIZE);
+    errno = posix_memalign(&buffer, XC_PAGE_SIZE, nr * XC_PAGE_SIZE);
     if ( errno != 0 )
         return NULL;
 
     /* Lock buffer in memory so it can't be paged out */
-    if ( mlock(buffer, XC_PAGE_SIZE) < 0 )
+    if ( mlock(buffer, nr * XC_PAGE_SIZE) < 0 )
     {
         free(buffer);
         buffer = NULL;
@@ -208,20 +223,27 @@ static void usage(void)
     printf(" -f <file>      --pagefile=<file>        pagefile to use. This option is required.\n");
     printf(" -m <max_memkb> --max_memkb=<max_memkb>  maximum amount of memory to handle.\n");
     printf(" -r <num>       --mru_size=<num>         number of paged-in pages to keep in memory.\n");
+    printf(" -q <num>       --io_depth=<num>         number of paging file I/Os in flight (default %d).\n",
+           XENPAGING_IO_DEPTH);
+    printf(" -p <num>       --prefetch=<num>         number of following pages to page in on a fault (default %d).\n",
+           XENPAGING_PREFETCH);
     printf(" -v             --verbose                enable debug output.\n");
     printf(" -h             --help                   this output.\n");
+    printf("\nSend SIGUSR1 to report paging statistics.\n");
 }
 
 static int xenpaging_getopts(struct xenpaging *paging, int argc, char *argv[])
 {
     int ch;
-    static const char sopts[] = "hvd:f:m:r:";
+    static const char sopts[] = "hvd:f:m:r:q:p:";
     static const struct option lopts[] = {
         {"help", 0, NULL, 'h'},
         {"verbose", 0, NULL, 'v'},
         {"domain", 1, NULL, 'd'},
         {"pagefile", 1, NULL, 'f'},
         {"mru_size", 1, NULL, 'm'},
+        {"io_depth", 1, NULL, 'q'},
+        {"prefetch", 1, NULL, 'p'},
         { }
     };
 
@@ -242,6 +264,12 @@ static int xenpaging_getopts(struct xenpaging *paging, int argc, char *argv[])
         case 'r':
             paging->policy_mru_size = atoi(optarg);
             break;
+        case 'q':
+            paging->io_depth = atoi(optarg);
+            break;
+        case 'p':
+            paging->prefetch = atoi(optarg);
+            break;
         case 'v':
             paging->debug = 1;
             break;
@@ -286,6 +314,9 @@ static struct xenpaging *xenpaging_init(int argc, char *argv[])
     if ( !paging )
         goto err;
 
+    paging->io_depth = XENPAGING_IO_DEPTH;
+    paging->prefetch = XENPAGING_PREFETCH;
+
     /* Get cmdline options and domain_id */
     if ( xenpaging_getopts(paging, argc, argv) )
         goto err;
@@ -464,13 +495,20 @@ static struct xenpaging *xenpaging_init(int argc, char *argv[])
         goto err;
     }
 
-    paging->paging_buffer = init_page();
+    paging->paging_buffer = init_pages(1);
     if ( !paging->paging_buffer )
     {
         PERROR("Creating page aligned load buffer");
         goto err;
     }
 
+    paging->io_buffer = init_pages(XENPAGING_IO_BATCH);
+    if ( !paging->io_buffer )
+    {
+        PERROR("Creating page aligned I/O buffer");
+        goto err;
+    }
+
     /* Open file */
     paging->fd = open(filename, O_CREAT | O_TRUNC | O_RDWR, S_IRUSR | S_IWUSR);
     if ( paging->fd < 0 )
@@ -479,6 +517,15 @@ static struct xenpaging *xenpaging_init(int argc, char *argv[])
         goto err;
     }
 
+    /* Start I/O threads */
+    if ( page_io_init(paging->fd, paging->io_depth < 0 ? 0 : paging->io_depth) )
+    {
+        PERROR("Error starting I/O threads");
+        goto err;
+    }
+
+    paging->stats.start_ns = now_ns();
+
     return paging;
 
  err:
@@ -495,6 +542,13 @@ static struct xenpaging *xenpaging_init(int argc, char *argv[])
             munlock(paging->paging_buffer, XC_PAGE_SIZE);
             free(paging->paging_buffer);
         }
+        if ( paging->io_buffer )
+        {
+            munlock(paging->io_buffer, XENPAGING_IO_BATCH * XC_PAGE_SIZE);
+            free(paging->io_buffer);
+        }
+        if ( paging->fd > 0 )
+            close(paging->fd);
 
         if ( paging->vm_event.ring_page )
         {
@@ -589,85 +643,160 @@ static void put_response(struct vm_event *vm_event, vm_event_response_t *rsp)
     RING_PUSH_RESPONSES(back_ring);
 }
 
-/* Evict a given gfn
+/* Take a free slot in the paging file
+ * Returns < 0 if the paging file is full
+ */
+static int get_free_slot(struct xenpaging *paging, int *scan)
+{
+    /* Reuse known free slots */
+    if ( paging->stack_count > 0 )
+        return paging->free_slot_stack[--paging->stack_count];
+
+    /* Scan all slots for remainders */
+    for ( ; *scan < paging->max_pages; (*scan)++ )
+        if ( !paging->slot_to_gfn[*scan] )
+            return (*scan)++;
+
+    return -1;
+}
+
+static void put_free_slot(struct xenpaging *paging, int slot)
+{
+    paging->slot_to_gfn[slot] = 0;
+    paging->free_slot_stack[paging->stack_count++] = slot;
+}
+
+/* Evict a batch of gfns and write them to free slots in the paging file
  * Returns < 0 on fatal error
- * Returns 0 on successful evict
- * Returns > 0 if gfn can not be evicted
+ * Returns the number of evicted gfns otherwise, busy gfns are skipped
  */
-static int xenpaging_evict_page(struct xenpaging *paging, unsigned long gfn, int slot)
+static int evict_batch(struct xenpaging *paging, const unsigned long *victims,
+                       unsigned int nr, int *scan)
 {
     xc_interface *xch = paging->xc_handle;
-    void *page;
-    xen_pfn_t victim = gfn;
-    int ret;
-    struct xen_domctl domctl;
+    domid_t domain_id = paging->vm_event.domain_id;
+    uint64_t gfns[XENPAGING_EVICT_BATCH];
+    xen_pfn_t pfns[XENPAGING_EVICT_BATCH];
+    int err[XENPAGING_EVICT_BATCH];
+    unsigned long done[XENPAGING_EVICT_BATCH / BITS_PER_LONG];
+    struct page_io io[XENPAGING_EVICT_BATCH];
+    uint64_t start = now_ns();
+    unsigned int i, n = 0, num = 0;
+    unsigned long gfn;
+    char *pages;
+    int slot, ret = -1;
 
-    /* Nominate page */
-    ret = xc_mem_paging_nominate(xch, paging->vm_event.domain_id, gfn);
-    if ( ret < 0 )
+    for ( i = 0; i < nr; i++ )
+        gfns[i] = victims[i];
+
+    /* Nominate pages, unpageable gfns are skipped */
+    if ( xc_mem_paging_nominate_batch(xch, domain_id, gfns, nr, done) < 0 )
     {
-        /* unpageable gfn is indicated by EBUSY */
-        if ( errno == EBUSY )
-            ret = 1;
-        else
-            PERROR("Error nominating page %lx", gfn);
-        goto out;
+        PERROR("Error nominating %u pages", nr);
+        return -1;
     }
 
-    /* Map page */
-    page = xc_map_foreign_pages(xch, paging->vm_event.domain_id, PROT_READ, &victim, 1);
-    if ( page == NULL )
+    for ( i = 0; i < nr; i++ )
+        if ( test_bit(i, done) )
+            pfns[n++] = gfns[i];
+    if ( !n )
+        return 0;
+
+    /* Map pages */
+    pages = xc_map_foreign_bulk(xch, domain_id, PROT_READ, pfns, err, n);
+    if ( pages == NULL )
     {
-        PERROR("Error mapping page %lx", gfn);
-        ret = -1;
-        goto out;
+        PERROR("Error mapping %u pages", n);
+        return -1;
     }
 
-    /* Copy page */
-    ret = write_page(paging->fd, page, slot);
-    if ( ret < 0 )
+    /* Copy pages, in parallel */
+    for ( i = 0; i < n; i++ )
     {
-        PERROR("Error copying page %lx", gfn);
-        munmap(page, XC_PAGE_SIZE);
-        ret = -1;
-        goto out;
+        if ( err[i] )
+        {
+            errno = -err[i];
+            PERROR("Error mapping page %"PRI_xen_pfn, pfns[i]);
+            goto out;
+        }
+
+        slot = get_free_slot(paging, scan);
+        if ( slot < 0 )
+            break;
+
+        /* Reserve the slot so a later scan does not hand it out again */
+        paging->slot_to_gfn[slot] = pfns[i];
+
+        io[num].page = pages + i * XC_PAGE_SIZE;
+        io[num].slot = slot;
+        io[num].write = 1;
+        io[num].gfn = pfns[i];
+        num++;
     }
 
-    /* Release page */
-    munmap(page, XC_PAGE_SIZE);
+    page_io_submit(io, num);
+    if ( page_io_wait() )
+    {
+        for ( i = 0; i < num; i++ )
+            if ( io[i].rc )
+                PERROR("Error copying page %lx", io[i].gfn);
+        goto out;
+    }
 
-    /* Tell Xen to evict page */
-    ret = xc_mem_paging_evict(xch, paging->vm_event.domain_id, gfn);
-    if ( ret < 0 )
+    /* Tell Xen to evict pages, gfns in use are skipped */
+    for ( i = 0; i < num; i++ )
+        gfns[i] = io[i].gfn;
+    if ( num &&
+         xc_mem_paging_evict_batch(xch, domain_id, gfns, num, done) < 0 )
     {
-        /* A gfn in use is indicated by EBUSY */
-        if ( errno == EBUSY )
-        {
-                ret = 1;
-                DPRINTF("Nominated page %lx busy", gfn);
-        } else
-            PERROR("Error evicting page %lx", gfn);
+        PERROR("Error evicting %u pages", num);
         goto out;
     }
 
-    DPRINTF("evict_page > gfn %lx pageslot %d\n", gfn, slot);
-    /* Notify policy of page being paged out */
-    policy_notify_paged_out(gfn);
+    ret = 0;
+    for ( i = 0; i < num; i++ )
+    {
+        gfn = io[i].gfn;
+        slot = io[i].slot;
 
-    /* Update index */
-    paging->slot_to_gfn[slot] = gfn;
-    paging->gfn_to_slot[gfn] = slot;
+        if ( !test_bit(i, done) )
+        {
+            DPRINTF("Nominated page %lx busy", gfn);
+            put_free_slot(paging, slot);
+            continue;
+        }
 
-    /* Record number of evicted pages */
-    paging->num_paged_out++;
+        DPRINTF("evict_page > gfn %lx pageslot %d\n", gfn, slot);
+        /* Notify policy of page being paged out */
+        policy_notify_paged_out(gfn);
 
-    ret = 0;
+        /* Update index */
+        paging->gfn_to_slot[gfn] = slot;
+
+        /* Record number of evicted pages */
+        paging->num_paged_out++;
+
+        if ( test_and_set_bit(gfn, paging->bitmap) )
+            ERROR("Page %lx has been evicted before", gfn);
+
+        ret++;
+    }
+
+    paging->stats.paged_out += ret;
 
  out:
+    /* On error, give back the slots reserved for the batch */
+    if ( ret < 0 )
+        for ( i = 0; i < num; i++ )
+            put_free_slot(paging, io[i].slot);
+
+    munmap(pages, n * XC_PAGE_SIZE);
+    paging->stats.out_ns += now_ns() - start;
+
     return ret;
 }
 
-static int xenpaging_resume_page(struct xenpaging *paging, vm_event_response_t *rsp, int notify_policy)
+static void xenpaging_resume_page(struct xenpaging *paging, vm_event_response_t *rsp, int notify_policy)
 {
     /* Put the page info on the ring */
     put_response(&paging->vm_event, rsp);
@@ -687,33 +816,28 @@ static int xenpaging_resume_page(struct xenpaging *paging, vm_event_response_t *
        /* Record number of resumed pages */
        paging->num_paged_out--;
     }
-
-    /* Tell Xen page is ready */
-    return xenevtchn_notify(paging->vm_event.xce_handle, paging->vm_event.port);
 }
 
-static int xenpaging_populate_page(struct xenpaging *paging, unsigned long gfn, int i)
+/* Tell Xen to allocate a page for the domain and fill it from buffer
+ * A prefetch gives up instead of waiting for memory to become available.
+ */
+static int load_page(struct xenpaging *paging, unsigned long gfn, void *buffer,
+                     int prefetch)
 {
     xc_interface *xch = paging->xc_handle;
     int ret;
     unsigned char oom = 0;
 
-    DPRINTF("populate_page < gfn %lx pageslot %d\n", gfn, i);
-
-    /* Read page */
-    ret = read_page(paging->fd, paging->paging_buffer, i);
-    if ( ret != 0 )
-    {
-        PERROR("Error reading page");
-        goto out;
-    }
-
     do
     {
-        /* Tell Xen to allocate a page for the domain */
-        ret = xc_mem_paging_load(xch, paging->vm_event.domain_id, gfn, paging->paging_buffer);
+        ret = xc_mem_paging_load(xch, paging->vm_event.domain_id, gfn, buffer);
         if ( ret < 0 )
         {
+            if ( prefetch )
+            {
+                DPRINTF("Not prefetching %lx (%d)\n", gfn, errno);
+                break;
+            }
             if ( errno == ENOMEM )
             {
                 if ( oom++ == 0 )
@@ -728,11 +852,310 @@ static int xenpaging_populate_page(struct xenpaging *paging, unsigned long gfn,
     }
     while ( ret && !interrupted );
 
-
- out:
     return ret;
 }
 
+static int xenpaging_populate_page(struct xenpaging *paging, unsigned long gfn, int i)
+{
+    xc_interface *xch = paging->xc_handle;
+    int ret;
+
+    DPRINTF("populate_page < gfn %lx pageslot %d\n", gfn, i);
+
+    /* Read page */
+    ret = read_page(paging->fd, paging->paging_buffer, i);
+    if ( ret != 0 )
+    {
+        PERROR("Error reading page");
+        return ret;
+    }
+
+    return load_page(paging, gfn, paging->paging_buffer, 0);
+}
+
+static int find_request(const vm_event_request_t *reqs, unsigned int nr,
+                        unsigned long gfn, unsigned int flags)
+{
+    unsigned int i;
+
+    for ( i = 0; i < nr; i++ )
+        if ( reqs[i].u.mem_paging.gfn == gfn &&
+             (reqs[i].u.mem_paging.flags & MEM_PAGING_DROP_PAGE) == flags )
+            return 1;
+
+    return 0;
+}
+
+static int find_io(const struct page_io *io, unsigned int nr, unsigned long gfn)
+{
+    unsigned int i;
+
+    for ( i = 0; i < nr; i++ )
+        if ( io[i].gfn == gfn )
+            return 1;
+
+    return 0;
+}
+
+/* Queue the read of a paged-out gfn
+ * Returns < 0 if the paging file index is inconsistent
+ */
+static int queue_read(struct xenpaging *paging, struct page_io *io,
+                      unsigned int *nr, unsigned long gfn)
+{
+    int slot = paging->gfn_to_slot[gfn];
+
+    /* Sanity check */
+    if ( paging->slot_to_gfn[slot] != gfn )
+    {
+        ERROR("Expected gfn %lx in slot %d, but found gfn %lx\n",
+              gfn, slot, paging->slot_to_gfn[slot]);
+        return -1;
+    }
+
+    io[*nr].page = paging->io_buffer + *nr * XC_PAGE_SIZE;
+    io[*nr].slot = slot;
+    io[*nr].write = 0;
+    io[*nr].gfn = gfn;
+    (*nr)++;
+
+    return 0;
+}
+
+static void account_fault(struct xenpaging *paging, uint64_t ns)
+{
+    struct xenpaging_stats *st = &paging->stats;
+    uint64_t us = ns / 1000;
+    unsigned int b = 0;
+
+    while ( us > 1 && b < XENPAGING_LAT_BUCKETS - 1 )
+    {
+        us >>= 1;
+        b++;
+    }
+
+    st->faults++;
+    st->fault_ns += ns;
+    if ( ns > st->fault_max_ns )
+        st->fault_max_ns = ns;
+    st->fault_hist[b]++;
+}
+
+/* Handle a batch of requests from the ring
+ * Returns < 0 on fatal error
+ */
+static int page_in_requests(struct xenpaging *paging)
+{
+    vm_event_request_t reqs[XENPAGING_PAGEIN_BATCH], *req;
+    vm_event_response_t rsp;
+    struct page_io io[XENPAGING_IO_BATCH];
+    uint64_t start = now_ns();
+    unsigned int nr_reqs = 0, nr_io = 0, nr_faults, i, j;
+    unsigned long gfn;
+    int slot;
+
+    /* Gather requests */
+    while ( nr_reqs < XENPAGING_PAGEIN_BATCH &&
+            RING_HAS_UNCONSUMED_REQUESTS(&paging->vm_event.back_ring) )
+    {
+        req = &reqs[nr_reqs];
+        get_request(&paging->vm_event, req);
+
+        if ( req->u.mem_paging.gfn > paging->max_pages )
+        {
+            ERROR("Requested gfn %"PRIx64" higher than max_pages %x\n",
+                  req->u.mem_paging.gfn, paging->max_pages);
+            return -1;
+        }
+
+        nr_reqs++;
+    }
+
+    /*
+     * Read the faulting pages and the pages following them, in parallel.
+     * Pages the guest is dropping are left to the drop request.
+     */
+    for ( i = 0; i < nr_reqs; i++ )
+    {
+        gfn = reqs[i].u.mem_paging.gfn;
+        if ( (reqs[i].u.mem_paging.flags & MEM_PAGING_DROP_PAGE) ||
+             !test_bit(gfn, paging->bitmap) ||
+             find_request(reqs, nr_reqs, gfn, MEM_PAGING_DROP_PAGE) ||
+             find_io(io, nr_io, gfn) )
+            continue;
+
+        if ( queue_read(paging, io, &nr_io, gfn) )
+            return -1;
+    }
+
+    nr_faults = nr_io;
+    for ( i = 0; i < nr_faults; i++ )
+        for ( j = 1; j <= paging->prefetch && nr_io < XENPAGING_IO_BATCH; j++ )
+        {
+            gfn = io[i].gfn + j;
+            if ( gfn >= paging->max_pages ||
+                 !test_bit(gfn, paging->bitmap) ||
+                 find_request(reqs, nr_reqs, gfn, MEM_PAGING_DROP_PAGE) ||
+                 find_io(io, nr_io, gfn) )
+                continue;
+
+            if ( queue_read(paging, io, &nr_io, gfn) )
+                return -1;
+        }
+
+    page_io_submit(io, nr_io);
+    if ( page_io_wait() )
+    {
+        for ( i = 0; i < nr_io; i++ )
+            if ( io[i].rc )
+                PERROR("Error reading page %lx", io[i].gfn);
+        return -1;
+    }
+
+    /* Load pages into the guest, prefetched ones are done with right away */
+    for ( i = 0; i < nr_io; i++ )
+    {
+        int prefetch = !find_request(reqs, nr_reqs, io[i].gfn, 0);
+
+        gfn = io[i].gfn;
+        DPRINTF("populate_page < gfn %lx pageslot %d%s\n", gfn, io[i].slot,
+                prefetch ? " (prefetch)" : "");
+
+        if ( load_page(paging, gfn, io[i].page, prefetch) )
+        {
+            if ( prefetch )
+                continue;
+            ERROR("Error populating page %lx", gfn);
+            return -1;
+        }
+
+        paging->stats.paged_in++;
+
+        if ( prefetch )
+        {
+            clear_bit(gfn, paging->bitmap);
+            put_free_slot(paging, io[i].slot);
+            policy_notify_prefetched(gfn);
+            paging->num_paged_out--;
+            paging->stats.prefetched++;
+        }
+    }
+
+    /* Respond in order */
+    for ( i = 0; i < nr_reqs; i++ )
+    {
+        req = &reqs[i];
+        gfn = req->u.mem_paging.gfn;
+
+        /* Check if the page has already been paged in */
+        if ( test_and_clear_bit(gfn, paging->bitmap) )
+        {
+            /* Find where in the paging file to read from */
+            slot = paging->gfn_to_slot[gfn];
+
+            /* Sanity check */
+            if ( paging->slot_to_gfn[slot] != gfn )
+            {
+                ERROR("Expected gfn %lx in slot %d, but found gfn %lx\n",
+                      gfn, slot, paging->slot_to_gfn[slot]);
+                return -1;
+            }
+
+            if ( req->u.mem_paging.flags & MEM_PAGING_DROP_PAGE )
+            {
+                DPRINTF("drop_page ^ gfn %lx pageslot %d\n", gfn, slot);
+                /* Notify policy of page being dropped */
+                policy_notify_dropped(gfn);
+            }
+            /* A fault followed by a drop of the gfn within the batch */
+            else if ( !find_io(io, nr_io, gfn) )
+            {
+                /* Populate the page */
+                if ( xenpaging_populate_page(paging, gfn, slot) < 0 )
+                {
+                    ERROR("Error populating page %lx", gfn);
+                    return -1;
+                }
+                paging->stats.paged_in++;
+            }
+
+            /* Prepare the response */
+            rsp.u.mem_paging.gfn = gfn;
+            rsp.vcpu_id = req->vcpu_id;
+            rsp.flags = req->flags;
+
+            xenpaging_resume_page(paging, &rsp, 1);
+
+            if ( !(req->u.mem_paging.flags & MEM_PAGING_DROP_PAGE) )
+                account_fault(paging, now_ns() - start);
+
+            /* Clear this pagefile slot */
+            put_free_slot(paging, slot);
+        }
+        else
+        {
+            DPRINTF("page %s populated (domain = %d; vcpu = %d;"
+                    " gfn = %lx; paused = %d; evict_fail = %d)\n",
+                    req->u.mem_paging.flags & MEM_PAGING_EVICT_FAIL ? "not" : "already",
+                    paging->vm_event.domain_id, req->vcpu_id, gfn,
+                    !!(req->flags & VM_EVENT_FLAG_VCPU_PAUSED) ,
+                    !!(req->u.mem_paging.flags & MEM_PAGING_EVICT_FAIL) );
+
+            /* Tell Xen to resume the vcpu */
+            if (( req->flags & VM_EVENT_FLAG_VCPU_PAUSED ) ||
+                ( req->u.mem_paging.flags & MEM_PAGING_EVICT_FAIL ))
+            {
+                /* Prepare the response */
+                rsp.u.mem_paging.gfn = gfn;
+                rsp.vcpu_id = req->vcpu_id;
+                rsp.flags = req->flags;
+
+                xenpaging_resume_page(paging, &rsp, 0);
+            }
+        }
+    }
+
+    paging->stats.in_ns += now_ns() - start;
+
+    /* Tell Xen pages are ready */
+    if ( xenevtchn_notify(paging->vm_event.xce_handle,
+                          paging->vm_event.port) < 0 )
+    {
+        PERROR("Error notifying event channel");
+        return -1;
+    }
+
+    return 0;
+}
+
+static void report_stats(struct xenpaging *paging)
+{
+    const struct xenpaging_stats *st = &paging->stats;
+    char hist[XENPAGING_LAT_BUCKETS * 40], *p = hist;
+    unsigned int i;
+
+    IPRINTF("%.1fs: %d pages paged out\n",
+            (now_ns() - st->start_ns) / 1e9, paging->num_paged_out);
+    IPRINTF("page-out: %lu pages, %.0f pages/s\n", st->paged_out,
+            st->out_ns ? st->paged_out * 1e9 / st->out_ns : 0.0);
+    IPRINTF("page-in: %lu pages (%lu prefetched), %.0f pages/s\n",
+            st->paged_in, st->prefetched,
+            st->in_ns ? st->paged_in * 1e9 / st->in_ns : 0.0);
+
+    if ( !st->faults )
+        return;
+
+    IPRINTF("fault resolution: %lu faults, avg %"PRIu64"us, max %"PRIu64"us\n",
+            st->faults, st->fault_ns / st->faults / 1000,
+            st->fault_max_ns / 1000);
+
+    hist[0] = '\0';
+    for ( i = 0; i < XENPAGING_LAT_BUCKETS; i++ )
+        if ( st->fault_hist[i] )
+            p += sprintf(p, " <%luus:%lu", 2UL << i, st->fault_hist[i]);
+    IPRINTF("fault resolution histogram:%s\n", hist);
+}
+
 /* Trigger a page-in for a batch of pages */
 static void resume_pages(struct xenpaging *paging, int num_pages)
 {
@@ -754,22 +1177,28 @@ static void resume_pages(struct xenpaging *paging, int num_pages)
         page_in_trigger();
 }
 
-/* Evict one gfn and write it to the given slot
+/* Evict a batch of pages and write them to a free slot in the paging file
  * Returns < 0 on fatal error
- * Returns 0 on successful evict
- * Returns > 0 if no gfn can be evicted
+ * Returns 0 if no gfn can be evicted
+ * Returns > 0 on successful evict
  */
-static int evict_victim(struct xenpaging *paging, int slot)
+static int evict_pages(struct xenpaging *paging, int num_pages)
 {
     xc_interface *xch = paging->xc_handle;
-    unsigned long gfn;
+    unsigned long victims[XENPAGING_EVICT_BATCH];
     static int num_paged_out;
-    int ret;
+    unsigned int nr;
+    int rc, scan = 0, num = 0;
 
-    do
+    while ( num < num_pages && !interrupted )
     {
-        gfn = policy_choose_victim(paging);
-        if ( gfn == INVALID_MFN )
+        nr = num_pages - num;
+        if ( nr > XENPAGING_EVICT_BATCH )
+            nr = XENPAGING_EVICT_BATCH;
+
+        /* Let the policy pick a batch of victims in one scan */
+        nr = policy_choose_victims(paging, victims, nr);
+        if ( !nr )
         {
             /* If the number did not change after last flush command then
              * the command did not reach qemu yet, or qemu still processes
@@ -782,70 +1211,16 @@ static int evict_victim(struct xenpaging *paging, int slot)
                 xenpaging_mem_paging_flush_ioemu_cache(paging);
                 num_paged_out = paging->num_paged_out;
             }
-            ret = ENOSPC;
-            goto out;
-        }
-
-        if ( interrupted )
-        {
-            ret = EINTR;
-            goto out;
+            break;
         }
 
-        ret = xenpaging_evict_page(paging, gfn, slot);
-        if ( ret < 0 )
-            goto out;
-    }
-    while ( ret );
-
-    if ( test_and_set_bit(gfn, paging->bitmap) )
-        ERROR("Page %lx has been evicted before", gfn);
-
-    ret = 0;
-
- out:
-    return ret;
-}
-
-/* Evict a batch of pages and write them to a free slot in the paging file
- * Returns < 0 on fatal error
- * Returns 0 if no gfn can be evicted
- * Returns > 0 on successful evict
- */
-static int evict_pages(struct xenpaging *paging, int num_pages)
-{
-    xc_interface *xch = paging->xc_handle;
-    int rc, slot, num = 0;
+        rc = evict_batch(paging, victims, nr, &scan);
+        if ( rc < 0 )
+            return -1;
 
-    /* Reuse known free slots */
-    while ( paging->stack_count > 0 && num < num_pages )
-    {
-        slot = paging->free_slot_stack[--paging->stack_count];
-        rc = evict_victim(paging, slot);
-        if ( rc )
-        {
-            num = rc < 0 ? -1 : num;
-            return num;
-        }
-        num++;
+        num += rc;
     }
 
-    /* Scan all slots slots for remainders */
-    for ( slot = 0; slot < paging->max_pages && num < num_pages; slot++ )
-    {
-        /* Slot is allocated */
-        if ( paging->slot_to_gfn[slot] )
-            continue;
-
-        rc = evict_victim(paging, slot);
-        if ( rc )
-        {
-            num = rc < 0 ? -1 : num;
-            break;
-        }
-
-        num++;
-    }
     return num;
 }
 
@@ -853,10 +1228,7 @@ int main(int argc, char *argv[])
 {
     struct sigaction act;
     struct xenpaging *paging;
-    vm_event_request_t req;
-    vm_event_response_t rsp;
     int num, prev_num = 0;
-    int slot;
     int tot_pages;
     int rc;
     xc_interface *xch;
@@ -881,6 +1253,8 @@ int main(int argc, char *argv[])
     sigaction(SIGTERM, &act, NULL);
     sigaction(SIGINT,  &act, NULL);
     sigaction(SIGALRM, &act, NULL);
+    act.sa_handler = report_handler;
+    sigaction(SIGUSR1, &act, NULL);
 
     /* listen for page-in events to stop pager */
     create_page_in_thread(paging);
@@ -905,88 +1279,14 @@ int main(int argc, char *argv[])
             /* Indicate possible error */
             rc = 1;
 
-            get_request(&paging->vm_event, &req);
-
-            if ( req.u.mem_paging.gfn > paging->max_pages )
-            {
-                ERROR("Requested gfn %"PRIx64" higher than max_pages %x\n",
-                      req.u.mem_paging.gfn, paging->max_pages);
+            if ( page_in_requests(paging) < 0 )
                 goto out;
-            }
-
-            /* Check if the page has already been paged in */
-            if ( test_and_clear_bit(req.u.mem_paging.gfn, paging->bitmap) )
-            {
-                /* Find where in the paging file to read from */
-                slot = paging->gfn_to_slot[req.u.mem_paging.gfn];
-
-                /* Sanity check */
-                if ( paging->slot_to_gfn[slot] != req.u.mem_paging.gfn )
-                {
-                    ERROR("Expected gfn %"PRIx64" in slot %d, but found gfn %lx\n",
-                          req.u.mem_paging.gfn, slot, paging->slot_to_gfn[slot]);
-                    goto out;
-                }
-
-                if ( req.u.mem_paging.flags & MEM_PAGING_DROP_PAGE )
-                {
-                    DPRINTF("drop_page ^ gfn %"PRIx64" pageslot %d\n",
-                            req.u.mem_paging.gfn, slot);
-                    /* Notify policy of page being dropped */
-                    policy_notify_dropped(req.u.mem_paging.gfn);
-                }
-                else
-                {
-                    /* Populate the page */
-                    if ( xenpaging_populate_page(paging, req.u.mem_paging.gfn, slot) < 0 )
-                    {
-                        ERROR("Error populating page %"PRIx64"", req.u.mem_paging.gfn);
-                        goto out;
-                    }
-                }
-
-                /* Prepare the response */
-                rsp.u.mem_paging.gfn = req.u.mem_paging.gfn;
-                rsp.vcpu_id = req.vcpu_id;
-                rsp.flags = req.flags;
-
-                if ( xenpaging_resume_page(paging, &rsp, 1) < 0 )
-                {
-                    PERROR("Error resuming page %"PRIx64"", req.u.mem_paging.gfn);
-                    goto out;
-                }
-
-                /* Clear this pagefile slot */
-                paging->slot_to_gfn[slot] = 0;
-
-                /* Record this free slot */
-                paging->free_slot_stack[paging->stack_count++] = slot;
-            }
-            else
-            {
-                DPRINTF("page %s populated (domain = %d; vcpu = %d;"
-                        " gfn = %"PRIx64"; paused = %d; evict_fail = %d)\n",
-                        req.u.mem_paging.flags & MEM_PAGING_EVICT_FAIL ? "not" : "already",
-                        paging->vm_event.domain_id, req.vcpu_id, req.u.mem_paging.gfn,
-                        !!(req.flags & VM_EVENT_FLAG_VCPU_PAUSED) ,
-                        !!(req.u.mem_paging.flags & MEM_PAGING_EVICT_FAIL) );
-
-                /* Tell Xen to resume the vcpu */
-                if (( req.flags & VM_EVENT_FLAG_VCPU_PAUSED ) ||
-                    ( req.u.mem_paging.flags & MEM_PAGING_EVICT_FAIL ))
-                {
-                    /* Prepare the response */
-                    rsp.u.mem_paging.gfn = req.u.mem_paging.gfn;
-                    rsp.vcpu_id = req.vcpu_id;
-                    rsp.flags = req.flags;
+        }
 
-                    if ( xenpaging_resume_page(paging, &rsp, 0) < 0 )
-                    {
-                        PERROR("Error resuming page %"PRIx64"", req.u.mem_paging.gfn);
-                        goto out;
-                    }
-                }
-            }
+        if ( report_requested )
+        {
+            report_requested = 0;
+            report_stats(paging);
         }
 
         /* If interrupted, write all pages back into the guest */
@@ -1031,10 +1331,10 @@ int main(int argc, char *argv[])
                 prev_num = num;
             }
             /* Limit the number of evicts to be able to process page-in requests */
-            if ( num > 42 )
+            if ( num > XENPAGING_EVICT_BATCH )
             {
                 paging->use_poll_timeout = 0;
-                num = 42;
+                num = XENPAGING_EVICT_BATCH;
             }
             if ( evict_pages(paging, num) < 0 )
                 goto out;
@@ -1064,6 +1364,9 @@ int main(int argc, char *argv[])
     DPRINTF("xenpaging got signal %d\n", interrupted);
 
  out:
+    report_stats(paging);
+
+    page_io_teardown();
     close(paging->fd);
     unlink_pagefile();
 
@@ -38,6 +38,14 @@
 #include <xen/vm_event.h>
 
 #define XENPAGING_PAGEIN_QUEUE_SIZE 64
+#define XENPAGING_EVICT_BATCH 64
+/* Page-in requests handled at once, and pages read at once */
+#define XENPAGING_PAGEIN_BATCH 32
+#define XENPAGING_IO_BATCH 128
+#define XENPAGING_IO_DEPTH 4
+#define XENPAGING_PREFETCH 7
+/* Fault resolution latency histogram, power of 2 microseconds */
+#define XENPAGING_LAT_BUCKETS 20
 
 struct vm_event {
     domid_t domain_id;
@@ -48,6 +56,19 @@ struct vm_event {
     void *ring_page;
 };
 
+struct xenpaging_stats {
+    uint64_t start_ns;
+    unsigned long paged_out;
+    uint64_t out_ns;
+    unsigned long paged_in;
+    unsigned long prefetched;
+    uint64_t in_ns;
+    unsigned long faults;
+    uint64_t fault_ns;
+    uint64_t fault_max_ns;
+    unsigned long fault_hist[XENPAGING_LAT_BUCKETS];
+};
+
 struct xenpaging {
     xc_interface *xc_handle;
     xentoollog_logger *logger;
@@ -59,6 +80,8 @@ struct xenpaging {
     int *gfn_to_slot;
 
     void *paging_buffer;
+    /* XENPAGING_IO_BATCH pages to read into */
+    void *io_buffer;
 
     struct vm_event vm_event;
     int fd;
@@ -72,10 +95,17 @@ struct xenpaging {
     int stack_count;
     int *free_slot_stack;
     unsigned long pagein_queue[XENPAGING_PAGEIN_QUEUE_SIZE];
+    /* number of I/O threads */
+    int io_depth;
+    /* number of following gfns to page in along with a faulting gfn */
+    int prefetch;
+    struct xenpaging_stats stats;
 };
 
 #define DPRINTF(msg, args...) xtl_log(paging->logger, XTL_DETAIL, 0,      \
                                       "paging", msg, ## args)
+#define IPRINTF(msg, args...) xtl_log(paging->logger, XTL_INFO, -1,       \
+                                      "paging", msg, ## args)
 #define ERROR(msg, args...)   xtl_log(paging->logger, XTL_ERROR, -1,      \
                                       "paging", msg, ## args)
 #define PERROR(msg, args...)  xtl_log(paging->logger, XTL_ERROR, -1,      \
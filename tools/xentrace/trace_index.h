@@ -0,0 +1,40 @@
+/*
+ * Trace index file, written by xentrace alongside the trace and used by
+ * xenalyze to start processing at a point in time.
+ *
+ * The file is a header followed by one entry per window written to the
+ * trace, in file order.  An entry gives the offset of the window's
+ * cpu_change record and the tsc of the first record in the window which
+ * has one.  Windows without any tsc are not indexed.
+ */
+#ifndef __XENTRACE_TRACE_INDEX_H__
+#define __XENTRACE_TRACE_INDEX_H__
+
+#include <stdint.h>
+
+#define TRACE_INDEX_MAGIC   0x78746978 /* "xitx" */
+#define TRACE_INDEX_VERSION 1
+
+struct trace_index_header {
+    uint32_t magic;
+    uint32_t version;
+};
+
+struct trace_index_entry {
+    uint64_t tsc;
+    uint64_t offset;
+    uint32_t cpu;
+    uint32_t size;      /* window size, excluding the cpu_change record */
+};
+
+#endif /* __XENTRACE_TRACE_INDEX_H__ */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
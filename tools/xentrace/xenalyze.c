@@ -34,6 +34,7 @@
 #include "analyze.h"
 #include "mread.h"
 #include "pv.h"
+#include "trace_index.h"
 #include <errno.h>
 #include <strings.h>
 #include <string.h>
@@ -71,8 +72,10 @@ struct {
     struct symbol_struct * symbols;
     char * symbol_file;
     char * trace_file;
+    char * index_file;
     int output_defined;
     off_t file_size;
+    off_t start_offset;
     struct {
         off_t update_offset;
         int pipe[2];
@@ -182,6 +185,9 @@ struct {
         report_pcpu:1,
         tsc_loop_fatal:1,
         summary_info;
+    /* Time range to process, in seconds from the start of the trace */
+    double range_start, range_end;
+    tsc_t range_start_tsc, range_end_tsc;
     long long cpu_qhz, cpu_hz;
     int scatterplot_interrupt_vector;
     int scatterplot_extint_cycles_vector;
@@ -9937,6 +9943,20 @@ void process_records(void) {
         if(!(p=choose_next_record()))
             return;
 
+        if(opt.range_end_tsc && p->order_tsc > opt.range_end_tsc)
+            return;
+
+        /* Processing starts at the earliest window containing the start
+         * of --time-range; skip the records before it.  cpu_change
+         * records still have to be followed, and a skipped lost record
+         * is skipped on both passes. */
+        if(p->order_tsc < opt.range_start_tsc
+           && p->ri.event != TRC_TRACE_CPU_CHANGE) {
+            p->file_offset += p->ri.size;
+            read_record(p);
+            goto next;
+        }
+
         process_record(p);
 
         /* Lost records gets processed twice. */
@@ -9953,6 +9973,7 @@ void process_records(void) {
         else
             read_record(p);
 
+    next:
         /* Update this pcpu in the processing order */
         if ( p->active )
             record_order_bubble(p);
@@ -10060,9 +10081,67 @@ void report_pcpu(void) {
 
 }
 
+/*
+ * Use the index written by xentrace --index to find where to start
+ * processing for --time-range: the earliest of, for each pcpu, the last
+ * window which starts at or before the start of the range.
+ */
+void seek_time_range(void) {
+    struct trace_index_header hdr;
+    struct trace_index_entry e;
+    off_t start[MAX_CPUS];
+    tsc_t base = 0, start_tsc;
+    FILE *f;
+    int i;
+
+    if ( !(f = fopen(G.index_file, "r")) )
+    {
+        perror("open index");
+        error(ERR_SYSTEM, NULL);
+    }
+
+    if ( fread(&hdr, sizeof(hdr), 1, f) != 1
+         || hdr.magic != TRACE_INDEX_MAGIC
+         || hdr.version != TRACE_INDEX_VERSION )
+    {
+        fprintf(stderr, "%s: %s is not a trace index\n",
+                __func__, G.index_file);
+        error(ERR_SYSTEM, NULL);
+    }
+
+    /* The trace starts at the lowest tsc of any window. */
+    while ( fread(&e, sizeof(e), 1, f) == 1 )
+        if ( !base || e.tsc < base )
+            base = e.tsc;
+
+    start_tsc = opt.range_start_tsc = base + opt.range_start * opt.cpu_hz;
+    if ( opt.range_end )
+        opt.range_end_tsc = base + opt.range_end * opt.cpu_hz;
+
+    for ( i = 0; i < MAX_CPUS; i++ )
+        start[i] = -1;
+
+    fseek(f, sizeof(hdr), SEEK_SET);
+    while ( fread(&e, sizeof(e), 1, f) == 1 )
+        if ( e.cpu < MAX_CPUS && e.tsc <= start_tsc )
+            start[e.cpu] = e.offset;
+
+    fclose(f);
+
+    G.start_offset = G.file_size;
+    for ( i = 0; i < MAX_CPUS; i++ )
+        if ( start[i] >= 0 && start[i] < G.start_offset )
+            G.start_offset = start[i];
+    if ( G.start_offset == G.file_size )
+        G.start_offset = 0;
+
+    fprintf(warn, "%s: starting at offset %llx\n",
+            __func__, (unsigned long long)G.start_offset);
+}
+
 void init_pcpus(void) {
     int i=0;
-    off_t offset = 0;
+    off_t offset = G.start_offset;
 
     for(i=0; i<MAX_CPUS; i++)
     {
@@ -10140,6 +10219,8 @@ enum {
     OPT_PROGRESS,
     OPT_TOLERANCE,
     OPT_TSC_LOOP_FATAL,
+    OPT_INDEX_FILE,
+    OPT_TIME_RANGE,
     /* Specific letters */
     OPT_DUMP_ALL='a',
     OPT_INTERVAL_LENGTH='i',
@@ -10620,6 +10701,24 @@ error_t cmd_parser(int key, char *arg, struct argp_state *state)
         opt.tsc_loop_fatal = 1;
         break;
 
+    case OPT_INDEX_FILE:
+        G.index_file = arg;
+        break;
+
+    case OPT_TIME_RANGE:
+    {
+        char * inval;
+
+        opt.range_start = strtod(arg, &inval);
+        if ( *inval == ':' )
+            opt.range_end = strtod(inval + 1, &inval);
+
+        if ( *inval || opt.range_start < 0
+             || (opt.range_end && opt.range_end <= opt.range_start) )
+            argp_usage(state);
+    }
+    break;
+
     case ARGP_KEY_ARG:
     {
         /* FIXME - strcpy */
@@ -10909,6 +11008,16 @@ const struct argp_option cmd_opts[] =  {
       .arg = "errlevel",
       .doc = "Sets tolerance for errors found in the file.  Default is 3; max is 6.", },
 
+    { .name = "index",
+      .key = OPT_INDEX_FILE,
+      .arg = "filename",
+      .doc = "Index written by xentrace --index, used by --time-range.", },
+
+    { .name = "time-range",
+      .key = OPT_TIME_RANGE,
+      .arg = "START[:END]",
+      .doc = "Only process records from START to END seconds after the start of the trace.  Requires --index.", },
+
 
     { 0 },
 };
@@ -10944,6 +11053,14 @@ int main(int argc, char *argv[]) {
     if (G.symbol_file != NULL)
         parse_symbol_file(G.symbol_file);
 
+    if (opt.range_start || opt.range_end) {
+        if (G.index_file == NULL) {
+            fprintf(stderr, "--time-range requires --index\n");
+            exit(1);
+        }
+        seek_time_range();
+    }
+
     if(opt.dump_all)
         warn = stdout;
 
@@ -19,12 +19,14 @@
 #include <unistd.h>
 #include <errno.h>
 #include <signal.h>
+#include <stdbool.h>
 #include <inttypes.h>
 #include <string.h>
 #include <getopt.h>
 #include <assert.h>
 #include <ctype.h>
 #include <poll.h>
+#include <pthread.h>
 #include <sys/statvfs.h>
 
 #include <xen/xen.h>
@@ -34,6 +36,8 @@
 #include <xenevtchn.h>
 #include <xenctrl.h>
 
+#include "trace_index.h"
+
 #define PERROR(_m, _a...)                                       \
 do {                                                            \
     int __saved_errno = errno;                                  \
@@ -60,9 +64,11 @@ typedef struct settings_st {
     unsigned long disk_rsvd;
     unsigned long timeout;
     unsigned long memory_buffer;
+    char *index_file;
     uint8_t discard:1,
         disable_tracing:1,
-        start_disabled:1;
+        start_disabled:1,
+        node_threads:1;
 } settings_t;
 
 struct t_struct {
@@ -79,6 +85,8 @@ static xc_interface *xc_handle;
 static xenevtchn_handle *xce_handle = NULL;
 static int virq_port = -1;
 static int outfd = 1;
+static uint64_t out_offset;     /* bytes written to outfd */
+static FILE *index_out;
 
 static void close_handler(int signal)
 {
@@ -332,6 +340,51 @@ fail:
     return;
 }
 
+/**
+ * index_window - add the window about to be written to the index file
+ * @cpu        - source buffer CPU ID
+ * @start      - start of the window's data
+ * @size       - size of the data available at @start
+ * @total_size - total size of the window
+ *
+ * The window is indexed by the tsc of its first record which has one.
+ */
+static void index_window(unsigned int cpu, const unsigned char *start,
+                         int size, int total_size)
+{
+    struct trace_index_entry e = {
+        .offset = out_offset,
+        .cpu = cpu,
+        .size = total_size,
+    };
+    const unsigned char *p = start;
+
+    while ( p + sizeof(uint32_t) <= start + size )
+    {
+        const struct t_rec *rec = (const struct t_rec *)p;
+
+        if ( rec->cycles_included )
+        {
+            if ( p + sizeof(uint32_t) + sizeof(uint64_t) > start + size )
+                return;
+            e.tsc = ((uint64_t)rec->u.cycles.cycles_hi << 32) |
+                    rec->u.cycles.cycles_lo;
+            break;
+        }
+
+        p += sizeof(uint32_t) + rec->extra_u32 * sizeof(uint32_t);
+    }
+
+    if ( !e.tsc )
+        return;
+
+    if ( fwrite(&e, sizeof(e), 1, index_out) != 1 )
+    {
+        PERROR("Failed to write index");
+        exit(EXIT_FAILURE);
+    }
+}
+
 /**
  * write_buffer - write a section of the trace buffer
  * @cpu      - source buffer CPU ID
@@ -389,6 +442,9 @@ static void write_buffer(unsigned int cpu, unsigned char *start, int size,
         {
             struct cpu_change_record rec;
 
+            if ( index_out )
+                index_window(cpu, start, size, total_size);
+
             rec.header = CPU_CHANGE_HEADER;
             rec.data.cpu = cpu;
             rec.data.window_size = total_size;
@@ -400,6 +456,7 @@ static void write_buffer(unsigned int cpu, unsigned char *start, int size,
                         written);
                 goto fail;
             }
+            out_offset += written;
         }
     }
 
@@ -416,6 +473,7 @@ static void write_buffer(unsigned int cpu, unsigned char *start, int size,
                     size, written);
             goto fail;
         }
+        out_offset += written;
     }
 
     return;
@@ -664,6 +722,250 @@ static void wait_for_event_or_timeout(unsigned long milliseconds)
 }
 
 
+/**
+ * drain_cpu - write out the new records of a trace buffer
+ * @cpu:       CPU ID of the buffer
+ * @meta:      the buffer's metadata
+ * @data:      the buffer's data area
+ * @data_size: size of the data area
+ * @stage:     NULL, or a buffer of @data_size bytes to copy the records to
+ *
+ * With a staging buffer, the records are copied out and handed back to Xen
+ * before being written, which is done holding out_lock.
+ */
+static pthread_mutex_t out_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void drain_cpu(unsigned int cpu, struct t_buf *meta,
+                      unsigned char *data, unsigned long data_size,
+                      unsigned char *stage)
+{
+    unsigned long start_offset, end_offset, window_size, cons, prod;
+
+    /* Read window information only once. */
+    cons = meta->cons;
+    prod = meta->prod;
+    xen_rmb(); /* read prod, then read item. */
+
+    if ( cons == prod )
+        return;
+
+    assert(cons < 2*data_size);
+    assert(prod < 2*data_size);
+
+    // NB: if (prod<cons), then (prod-cons)%data_size will not yield
+    // the correct answer because data_size is not a power of 2.
+    if ( prod < cons )
+        window_size = (prod + 2*data_size) - cons;
+    else
+        window_size = prod - cons;
+    assert(window_size > 0);
+    assert(window_size <= data_size);
+
+    start_offset = cons % data_size;
+    end_offset = prod % data_size;
+
+    if ( stage )
+    {
+        if ( end_offset > start_offset )
+            memcpy(stage, data + start_offset, window_size);
+        else
+        {
+            memcpy(stage, data + start_offset, data_size - start_offset);
+            memcpy(stage + data_size - start_offset, data, end_offset);
+        }
+
+        xen_mb(); /* read buffer, then update cons. */
+        meta->cons = prod;
+
+        pthread_mutex_lock(&out_lock);
+        write_buffer(cpu, stage, window_size, window_size);
+        pthread_mutex_unlock(&out_lock);
+
+        return;
+    }
+
+    if ( end_offset > start_offset )
+    {
+        /* If window does not wrap, write in one big chunk */
+        write_buffer(cpu, data+start_offset,
+                     window_size,
+                     window_size);
+    }
+    else
+    {
+        /* If wrapped, write in two chunks:
+         * - first, start to the end of the buffer
+         * - second, start of buffer to end of window
+         */
+        write_buffer(cpu, data + start_offset,
+                     data_size - start_offset,
+                     window_size);
+        write_buffer(cpu, data,
+                     end_offset,
+                     0);
+    }
+
+    xen_mb(); /* read buffer, then update cons. */
+    meta->cons = prod;
+}
+
+/*
+ * With --node-threads, the buffers are drained by one thread per NUMA
+ * node, each handling the buffers of that node's CPUs.  The main thread
+ * waits for VIRQ_TBUF or the poll timeout and kicks all of them.
+ */
+struct drain_thread {
+    pthread_t thread;
+    unsigned int nr_cpus;
+    unsigned int *cpus;
+    unsigned char *stage;
+};
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned long gen;      /* Bumped to kick the threads */
+    bool stop;              /* Drain once more, then exit */
+    struct t_struct *tbufs;
+    unsigned long data_size;
+} drain = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static void *drain_thread_fn(void *arg)
+{
+    struct drain_thread *t = arg;
+    unsigned long gen = 0;
+    bool stop;
+    unsigned int i;
+
+    do {
+        pthread_mutex_lock(&drain.lock);
+        while ( drain.gen == gen && !drain.stop )
+            pthread_cond_wait(&drain.cond, &drain.lock);
+        gen = drain.gen;
+        stop = drain.stop;
+        pthread_mutex_unlock(&drain.lock);
+
+        for ( i = 0; i < t->nr_cpus; i++ )
+            drain_cpu(t->cpus[i], drain.tbufs->meta[t->cpus[i]],
+                      drain.tbufs->data[t->cpus[i]], drain.data_size,
+                      t->stage);
+    } while ( !stop );
+
+    return NULL;
+}
+
+static void drain_kick(bool stop)
+{
+    pthread_mutex_lock(&drain.lock);
+    drain.gen++;
+    drain.stop = stop;
+    pthread_cond_broadcast(&drain.cond);
+    pthread_mutex_unlock(&drain.lock);
+}
+
+/**
+ * start_drain_threads - start one thread per NUMA node with trace buffers
+ * @num: number of trace buffers / logical CPUs
+ *
+ * Returns the number of threads started, 0 if the host topology could not
+ * be obtained.
+ */
+static unsigned int start_drain_threads(struct drain_thread **threadsp,
+                                        unsigned int num)
+{
+    struct drain_thread *threads;
+    xc_cputopo_t *topo;
+    unsigned int nr_topo = num, nr_nodes = 0, i, n;
+    sigset_t mask, old;
+
+    topo = calloc(num, sizeof(*topo));
+    if ( !topo || xc_cputopoinfo(xc_handle, &nr_topo, topo) )
+    {
+        PERROR("Failed to get CPU topology");
+        free(topo);
+        return 0;
+    }
+
+    /* CPUs without a node (or with buffers beyond the reported ones) go
+     * with node 0. */
+    for ( i = 0; i < num; i++ )
+    {
+        if ( i >= nr_topo || topo[i].node == XEN_INVALID_NODE_ID )
+            topo[i].node = 0;
+        if ( drain.tbufs->meta[i] && topo[i].node >= nr_nodes )
+            nr_nodes = topo[i].node + 1;
+    }
+
+    threads = calloc(nr_nodes, sizeof(*threads));
+    if ( !threads )
+    {
+        PERROR("Failed to allocate drain threads");
+        exit(EXIT_FAILURE);
+    }
+
+    for ( i = 0; i < num; i++ )
+    {
+        struct drain_thread *t = &threads[topo[i].node];
+
+        if ( !drain.tbufs->meta[i] )
+            continue;
+
+        if ( !t->cpus && !(t->cpus = calloc(num, sizeof(*t->cpus))) )
+        {
+            PERROR("Failed to allocate drain threads");
+            exit(EXIT_FAILURE);
+        }
+        t->cpus[t->nr_cpus++] = i;
+    }
+
+    /* Leave signal handling to the main thread. */
+    sigfillset(&mask);
+    pthread_sigmask(SIG_BLOCK, &mask, &old);
+
+    for ( n = 0; n < nr_nodes; n++ )
+    {
+        struct drain_thread *t = &threads[n];
+
+        if ( !t->nr_cpus )
+            continue;
+
+        if ( !(t->stage = malloc(drain.data_size)) ||
+             pthread_create(&t->thread, NULL, drain_thread_fn, t) )
+        {
+            PERROR("Failed to start drain thread for node %u", n);
+            exit(EXIT_FAILURE);
+        }
+        fprintf(stderr, "node %u: draining %u CPU buffers\n", n, t->nr_cpus);
+    }
+
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    free(topo);
+    *threadsp = threads;
+
+    return nr_nodes;
+}
+
+static void stop_drain_threads(struct drain_thread *threads,
+                               unsigned int nr_threads)
+{
+    unsigned int n;
+
+    drain_kick(true);
+
+    for ( n = 0; n < nr_threads; n++ )
+    {
+        if ( !threads[n].nr_cpus )
+            continue;
+        pthread_join(threads[n].thread, NULL);
+        free(threads[n].stage);
+        free(threads[n].cpus);
+    }
+    free(threads);
+}
+
 /**
  * monitor_tbufs - monitor the contents of tbufs and output to a file
  * @logfile:       the FILE * representing the file to log to
@@ -685,6 +987,9 @@ static void monitor_tbufs(void)
 
     int last_read = 1;
 
+    struct drain_thread *threads = NULL;
+    unsigned int nr_threads = 0;
+
     /* prepare to listen for VIRQ_TBUF */
     event_init();
 
@@ -711,64 +1016,22 @@ static void monitor_tbufs(void)
             if ( meta[i] )
                 meta[i]->cons = meta[i]->prod;
 
+    if ( opts.node_threads )
+    {
+        drain.tbufs = tbufs;
+        drain.data_size = data_size;
+        nr_threads = start_drain_threads(&threads, num);
+    }
+
     /* now, scan buffers for events */
     while ( 1 )
     {
-        for ( i = 0; i < num; i++ )
-        {
-            unsigned long start_offset, end_offset, window_size, cons, prod;
-
-            if ( !meta[i] )
-                continue;
-
-            /* Read window information only once. */
-            cons = meta[i]->cons;
-            prod = meta[i]->prod;
-            xen_rmb(); /* read prod, then read item. */
-
-            if ( cons == prod )
-                continue;
-           
-            assert(cons < 2*data_size);
-            assert(prod < 2*data_size);
-
-            // NB: if (prod<cons), then (prod-cons)%data_size will not yield
-            // the correct answer because data_size is not a power of 2.
-            if ( prod < cons )
-                window_size = (prod + 2*data_size) - cons;
-            else
-                window_size = prod - cons;
-            assert(window_size > 0);
-            assert(window_size <= data_size);
-
-            start_offset = cons % data_size;
-            end_offset = prod % data_size;
-
-            if ( end_offset > start_offset )
-            {
-                /* If window does not wrap, write in one big chunk */
-                write_buffer(i, data[i]+start_offset,
-                             window_size,
-                             window_size);
-            }
-            else
-            {
-                /* If wrapped, write in two chunks:
-                 * - first, start to the end of the buffer
-                 * - second, start of buffer to end of window
-                 */
-                write_buffer(i, data[i] + start_offset,
-                             data_size - start_offset,
-                             window_size);
-                write_buffer(i, data[i],
-                             end_offset,
-                             0);
-            }
-
-            xen_mb(); /* read buffer, then update cons. */
-            meta[i]->cons = prod;
-
-        }
+        if ( nr_threads )
+            drain_kick(false);
+        else
+            for ( i = 0; i < num; i++ )
+                if ( meta[i] )
+                    drain_cpu(i, meta[i], data[i], data_size, NULL);
 
         if ( interrupted )
         {
@@ -787,6 +1050,9 @@ static void monitor_tbufs(void)
         wait_for_event_or_timeout(opts.poll_sleep);
     }
 
+    if ( nr_threads )
+        stop_drain_threads(threads, nr_threads);
+
     if ( opts.memory_buffer )
         membuf_dump();
 
@@ -842,6 +1108,11 @@ static void usage(int status)
 "  -r  --reserve-disk-space=n Before writing trace records to disk, check to see\n" \
 "                          that after the write there will be at least n space\n" \
 "                          left on the disk.\n" \
+"  -N  --node-threads      Drain the trace buffers with one thread per NUMA\n" \
+"                          node, copying records out of the buffers before\n" \
+"                          writing them.\n" \
+"  -I  --index=file        Write an index of the trace to file, allowing\n" \
+"                          xenalyze to start at a given time.\n" \
 "\n" \
 "This tool is used to capture trace buffer data from Xen. The\n" \
 "data is output in a binary format, in the following order:\n" \
@@ -1090,12 +1361,14 @@ static void parse_args(int argc, char **argv)
         { "discard-buffers", no_argument,      0, 'D' },
         { "dont-disable-tracing", no_argument, 0, 'x' },
         { "start-disabled", no_argument,       0, 'X' },
+        { "node-threads",   no_argument,       0, 'N' },
+        { "index",          required_argument, 0, 'I' },
         { "help",           no_argument,       0, 'h' },
         { "version",        no_argument,       0, 'V' },
         { 0, 0, 0, 0 }
     };
 
-    while ( (option = getopt_long(argc, argv, "t:s:c:e:S:r:T:M:DxX?V",
+    while ( (option = getopt_long(argc, argv, "t:s:c:e:S:r:T:M:I:DxXN?V",
                     long_options, NULL)) != -1) 
     {
         switch ( option )
@@ -1146,6 +1419,14 @@ static void parse_args(int argc, char **argv)
             opts.memory_buffer = sargtol(optarg, 0);
             break;
 
+        case 'N':
+            opts.node_threads = 1;
+            break;
+
+        case 'I':
+            opts.index_file = optarg;
+            break;
+
         case 'h':
             usage(EXIT_SUCCESS);
             break;
@@ -1219,6 +1500,28 @@ int main(int argc, char **argv)
     if ( opts.memory_buffer > 0 )
         membuf_alloc(opts.memory_buffer);
 
+    if ( opts.index_file )
+    {
+        struct trace_index_header hdr = {
+            .magic = TRACE_INDEX_MAGIC,
+            .version = TRACE_INDEX_VERSION,
+        };
+
+        /* The memory buffer drops and reorders windows when dumped. */
+        if ( opts.memory_buffer )
+        {
+            fprintf(stderr, "Cannot index a memory buffer trace.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        index_out = fopen(opts.index_file, "w");
+        if ( !index_out || fwrite(&hdr, sizeof(hdr), 1, index_out) != 1 )
+        {
+            perror("Could not open index file");
+            exit(EXIT_FAILURE);
+        }
+    }
+
     /* ensure that if we get a signal, we'll do cleanup, then exit */
     act.sa_handler = close_handler;
     act.sa_flags = 0;
@@ -1230,6 +1533,9 @@ int main(int argc, char **argv)
 
     monitor_tbufs();
 
+    if ( index_out && fclose(index_out) )
+        PERROR("Failed to write index");
+
     close(outfd);
     return 0;
 }
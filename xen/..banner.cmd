@@ -0,0 +1 @@
+cmd_.banner :=     if command -v figlet >/dev/null 2>&1 ; then echo " Xen 4.21-unstable" | figlet -w 100 -f tools/xen.flf > .banner.tmp; else echo "Xen 4.21-unstable" > .banner.tmp; fi; mv -f .banner.tmp .banner
@@ -0,0 +1 @@
+cmd_prelink.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o prelink.o common/built_in.o drivers/built_in.o lib/built_in.o xsm/built_in.o arch/x86/built_in.o crypto/built_in.o --start-group lib/lib.a --end-group
@@ -0,0 +1 @@
+cmd_arch/x86/acpi/built_in.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o arch/x86/acpi/built_in.o arch/x86/acpi/cpufreq/built_in.o arch/x86/acpi/lib.o arch/x86/acpi/power.o arch/x86/acpi/cpu_idle.o arch/x86/acpi/cpuidle_menu.o arch/x86/acpi/boot.init.o arch/x86/acpi/wakeup_prot.o
@@ -0,0 +1 @@
+cmd_arch/x86/boot/built-in-32.S := /root/.pyenv/shims/python3 ./tools/combine_two_binaries.py --gap       0x010200 --text-diff 0x408020 --script    arch/x86/boot/build32.base.lds --bin1      arch/x86/boot/built-in-32.base.bin --bin2      arch/x86/boot/built-in-32.offset.bin --map       arch/x86/boot/built-in-32.base.map --exports   cmdline_parse_early,reloc,reloc_trampoline32 --output    arch/x86/boot/built-in-32.S
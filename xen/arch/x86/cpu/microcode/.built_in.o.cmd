@@ -0,0 +1 @@
+cmd_arch/x86/cpu/microcode/built_in.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o arch/x86/cpu/microcode/built_in.o arch/x86/cpu/microcode/amd.o arch/x86/cpu/microcode/core.o arch/x86/cpu/microcode/intel.o
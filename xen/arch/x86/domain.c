@@ -2417,6 +2417,8 @@ int domain_relinquish_resources(struct domain *d)
             if ( ret )
                 return ret;
 
+            mem_sharing_fork_teardown(d);
+
             /*
              * If the domain is forked, decrement the parent's pause count
              * and release the domain.
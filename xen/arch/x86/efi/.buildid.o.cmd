@@ -0,0 +1 @@
+cmd_arch/x86/efi/buildid.o := objcopy -I ihex -O binary arch/x86/efi/buildid.ihex arch/x86/efi/buildid.o
@@ -0,0 +1 @@
+../../../common/efi/pe.c
\ No newline at end of file
@@ -31,6 +31,7 @@
 #include <xen/lib.h>
 #include <xen/errno.h>
 #include <xen/nospec.h>
+#include <xen/perfc.h>
 #include <xen/sched.h>
 #include <xen/softirq.h>
 #include <xen/irq.h>
@@ -122,6 +123,27 @@ void vmsi_deliver_pirq(struct domain *d, const struct hvm_pirq_dpci *pirq_dpci)
 
     ASSERT(pirq_dpci->flags & HVM_IRQ_DPCI_GUEST_MSI);
 
+    /*
+     * A fixed, physical destination other than broadcast can only match a
+     * single vCPU, which pt_irq_create_bind() already looked up.  Deliver
+     * to it directly, rather than matching the destination against every
+     * vCPU of the domain.
+     */
+    if ( delivery_mode == dest_Fixed && !dest_mode && dest != 0xff &&
+         pirq_dpci->gmsi.dest_vcpu_id >= 0 )
+    {
+        struct vlapic *target =
+            vcpu_vlapic(d->vcpu[pirq_dpci->gmsi.dest_vcpu_id]);
+
+        if ( vlapic_enabled(target) &&
+             vlapic_match_dest(target, NULL, 0, dest, dest_mode) )
+        {
+            perfc_incr(vmsi_pirq_direct);
+            vmsi_inj_irq(target, vector, trig_mode, delivery_mode);
+            return;
+        }
+    }
+
     vmsi_deliver(d, vector, dest, dest_mode, delivery_mode, trig_mode);
 }
 
@@ -0,0 +1 @@
+cmd_arch/x86/hvm/vmx/built_in.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o arch/x86/hvm/vmx/built_in.o arch/x86/hvm/vmx/intr.o arch/x86/hvm/vmx/realmode.o arch/x86/hvm/vmx/vmcs.o arch/x86/hvm/vmx/vmx.o arch/x86/hvm/vmx/vvmx.o arch/x86/hvm/vmx/entry.o
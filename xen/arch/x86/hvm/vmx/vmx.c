@@ -143,8 +143,15 @@ static void vmx_pi_switch_to(struct vcpu *v)
     struct pi_desc *pi_desc = &v->arch.hvm.vmx.pi_desc;
     unsigned int dest = cpu_physical_id(v->processor);
 
-    write_atomic(&pi_desc->ndst,
-                 x2apic_enabled ? dest : MASK_INSR(dest, PI_xAPIC_NDST_MASK));
+    if ( !x2apic_enabled )
+        dest = MASK_INSR(dest, PI_xAPIC_NDST_MASK);
+
+    /*
+     * Only write NDST when the vCPU moved: the descriptor's cache line is
+     * shared with the IOMMU posting interrupts to it.
+     */
+    if ( pi_desc->ndst != dest )
+        write_atomic(&pi_desc->ndst, dest);
 
     pi_clear_sn(pi_desc);
 }
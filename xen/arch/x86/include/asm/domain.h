@@ -183,6 +183,10 @@ struct log_dirty_domain {
     unsigned long  fault_count;
     unsigned long  dirty_count;
 
+    /* dirty pfn ring shared with the toolstack, if set up */
+    struct log_dirty_ring *ring;
+    unsigned int   ring_frames;
+
     /* functions which are paging mode specific */
     const struct log_dirty_ops {
         int        (*enable  )(struct domain *d);
@@ -27,6 +27,16 @@ struct mem_sharing_domain
      * to resume the search.
      */
     unsigned long next_shared_gfn_to_relinquish;
+
+    /*
+     * Forks: gfns which were given a page since the fork was created or
+     * last reset, so that resetting the fork's memory only needs to
+     * revisit those.  Once the log overflowed, the reset walks the fork's
+     * page list instead.
+     */
+    unsigned long *dirty_gfns;
+    unsigned int nr_dirty_gfns, max_dirty_gfns;
+    bool dirty_overflow;
 };
 #endif
 
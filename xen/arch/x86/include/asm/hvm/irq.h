@@ -148,6 +148,9 @@ struct hvm_irq_dpci {
     uint8_t link_cnt[NR_LINK];
 };
 
+/* Buckets of interrupt latency: <1us, <2us, <4us, ... <64us, >=64us. */
+#define HVM_DPCI_LATENCY_BUCKETS 8
+
 /* Machine IRQ to guest device/intx mapping. */
 struct hvm_pirq_dpci {
     uint32_t flags;
@@ -158,6 +161,9 @@ struct hvm_pirq_dpci {
     struct domain *dom;
     struct hvm_gmsi_info gmsi;
     struct list_head softirq_list;
+    s_time_t raised;            /* when the softirq was last raised */
+    /* Latency from raising the softirq to delivery to the guest. */
+    unsigned long latency[HVM_DPCI_LATENCY_BUCKETS];
 };
 
 void pt_pirq_init(struct domain *d, struct hvm_pirq_dpci *dpci);
@@ -167,13 +173,22 @@ int pt_pirq_iterate(struct domain *d,
                               struct hvm_pirq_dpci *dpci, void *arg),
                     void *arg);
 
+struct msi_desc;
+struct pirq;
+
 #ifdef CONFIG_HVM
 bool pt_pirq_softirq_active(struct hvm_pirq_dpci *pirq_dpci);
+void pt_pirq_dump_latency(const struct domain *d, const struct pirq *pirq,
+                          const struct msi_desc *msi_desc);
 #else
 static inline bool pt_pirq_softirq_active(struct hvm_pirq_dpci *pirq_dpci)
 {
     return false;
 }
+
+static inline void pt_pirq_dump_latency(const struct domain *d,
+                                        const struct pirq *pirq,
+                                        const struct msi_desc *msi_desc) {}
 #endif
 
 /* Modify state of a PCI INTx wire. */
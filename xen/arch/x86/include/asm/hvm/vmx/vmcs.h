@@ -42,6 +42,8 @@ struct ept_data {
     };
     /* Set of PCPUs needing an INVEPT before a VMENTER. */
     cpumask_var_t invalidate;
+    /* A/D bits kept enabled for the pager's access sampling. */
+    bool access_sampling;
 };
 
 #define _VMX_DOMAIN_PML_ENABLED    0
@@ -68,6 +68,7 @@ typedef enum {
 #define EPTE_IGMT_SHIFT         6
 #define EPTE_RWX_MASK           0x7
 #define EPTE_FLAG_MASK          0x7f
+#define EPTE_A_SHIFT            8
 
 #define PI_xAPIC_NDST_MASK      0xFF00
 
@@ -75,6 +75,9 @@ int mem_sharing_fork_page(struct domain *d, gfn_t gfn,
 
 int mem_sharing_fork_reset(struct domain *d, bool reset_state,
                            bool reset_memory);
+void mem_sharing_fork_teardown(struct domain *d);
+void mem_sharing_fork_page_added(struct domain *d, gfn_t gfn,
+                                 unsigned int order);
 
 /*
  * If called by a foreign domain, possible errors are
@@ -145,6 +148,12 @@ static inline int mem_sharing_fork_reset(struct domain *d, bool reset_state,
     return -EOPNOTSUPP;
 }
 
+static inline void mem_sharing_fork_page_added(struct domain *d, gfn_t gfn,
+                                               unsigned int order)
+{
+    ASSERT_UNREACHABLE();
+}
+
 #endif
 
 #endif /* __MEM_SHARING_H__ */
@@ -15,6 +15,7 @@
 #define _XEN_ASM_X86_P2M_H
 
 #include <xen/paging.h>
+#include <xen/timer.h>
 #include <xen/mem_access.h>
 #include <asm/mem_sharing.h>
 #include <asm/page.h>    /* for pagetable_t */
@@ -253,9 +254,15 @@ struct p2m_domain {
                                     bool *sve);
     int                (*recalc)(struct p2m_domain *p2m,
                                  unsigned long gfn);
+    int                (*coalesce)(struct p2m_domain *p2m,
+                                   gfn_t gfn, unsigned int order);
     void               (*enable_hardware_log_dirty)(struct p2m_domain *p2m);
     void               (*disable_hardware_log_dirty)(struct p2m_domain *p2m);
     void               (*flush_hardware_cached_dirty)(struct p2m_domain *p2m);
+    int                (*test_and_clear_accessed)(struct p2m_domain *p2m,
+                                                  unsigned long gfn,
+                                                  unsigned int nr,
+                                                  unsigned long *bitmap);
     void               (*change_entry_type_global)(struct p2m_domain *p2m,
                                                    p2m_type_t ot,
                                                    p2m_type_t nt);
@@ -300,6 +307,16 @@ struct p2m_domain {
     /* Highest guest frame that's ever been mapped in the p2m */
     unsigned long max_mapped_pfn;
 
+    /*
+     * Host p2m: background pass re-coalescing superpages over [next_gfn,
+     * end_gfn), see p2m_recoalesce().  Protected by the p2m lock.
+     */
+    struct {
+        struct timer  timer;
+        unsigned long next_gfn;
+        unsigned long end_gfn;
+    } recoalesce;
+
     /*
      * Alternate p2m's only: range of gfn's for which underlying
      * mfn may have duplicate mappings
@@ -337,6 +354,18 @@ struct p2m_domain {
             unsigned long list[NR_POD_MRP_ENTRIES];
             unsigned int idx;
         } mrp;
+
+        /*
+         * Background reclaim of zeroed pages, ahead of the cache running
+         * dry, and statistics about reclaim and emergency sweeps.
+         */
+        struct timer     reclaim_timer;
+        unsigned long    reclaim_found;  /* Pages found in current pass */
+        unsigned long    reclaimed_bg,   /* Pages reclaimed in background */
+                         reclaimed_sweep, /* Pages reclaimed by sweeps    */
+                         sweeps;         /* # of emergency sweeps         */
+        s_time_t         sweep_time,     /* Time spent in sweeps          */
+                         sweep_max;      /* Longest sweep                 */
         mm_lock_t        lock;         /* Locking of private pod structs,   *
                                         * not relying on the p2m lock.      */
     } pod;
@@ -641,6 +670,13 @@ void p2m_disable_hardware_log_dirty(struct domain *d);
 /* Flush hardware cached dirty GFNs */
 void p2m_flush_hardware_cached_dirty(struct domain *d);
 
+/*
+ * Harvest and clear the hardware accessed state of nr gfns starting at gfn.
+ * Bit i of bitmap is set if gfn + i was accessed since the previous call.
+ */
+int p2m_test_and_clear_accessed(struct domain *d, gfn_t gfn, unsigned int nr,
+                                unsigned long *bitmap);
+
 #else
 
 static inline void p2m_flush_hardware_cached_dirty(struct domain *d) {}
@@ -665,6 +701,17 @@ int p2m_finish_type_change(struct domain *d,
                            gfn_t first_gfn,
                            unsigned long max_nr);
 
+/*
+ * Queue a range of gfns (start ... end-1) for superpage re-coalescing, after
+ * log-dirty tracking of the range stopped.
+ */
+#ifdef CONFIG_HVM
+void p2m_recoalesce(struct domain *d, unsigned long start, unsigned long end);
+#else
+static inline void p2m_recoalesce(struct domain *d, unsigned long start,
+                                  unsigned long end) {}
+#endif
+
 static inline bool p2m_is_global_logdirty(const struct domain *d)
 {
 #ifdef CONFIG_HVM
@@ -153,6 +153,11 @@ void paging_mark_pfn_dirty(struct domain *d, pfn_t pfn);
  * This is called from inside paging code, with the paging lock held. */
 bool paging_mfn_is_dirty(const struct domain *d, mfn_t gmfn);
 
+/* dirty pfn ring frames, for XENMEM_acquire_resource */
+unsigned int paging_dirty_ring_frames(const struct domain *d);
+int paging_dirty_ring_acquire(struct domain *d, unsigned int frame,
+                              unsigned int nr_frames, xen_pfn_t mfn_list[]);
+
 /*
  * Log-dirty radix tree indexing:
  *   All tree nodes are PAGE_SIZE bytes, mapped on-demand.
@@ -191,6 +196,16 @@ static inline void paging_log_dirty_init(struct domain *d,
 static inline void paging_mark_dirty(struct domain *d, mfn_t gmfn) {}
 static inline void paging_mark_pfn_dirty(struct domain *d, pfn_t pfn) {}
 static inline bool paging_mfn_is_dirty(struct domain *d, mfn_t gmfn) { return false; }
+static inline unsigned int paging_dirty_ring_frames(const struct domain *d)
+{
+    return 0;
+}
+static inline int paging_dirty_ring_acquire(
+    struct domain *d, unsigned int frame, unsigned int nr_frames,
+    xen_pfn_t mfn_list[])
+{
+    return -EOPNOTSUPP;
+}
 
 #endif /* PG_log_dirty */
 
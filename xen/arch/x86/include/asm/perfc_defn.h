@@ -127,6 +127,21 @@ PERFCOUNTER(pauseloop_exits, "vmexits from Pause-Loop Detection")
 
 PERFCOUNTER(iommu_pt_shatters,    "IOMMU page table shatters")
 PERFCOUNTER(iommu_pt_coalesces,   "IOMMU page table coalesces")
+PERFCOUNTER(iommu_irte_unchanged, "IOMMU IRTE re-writes elided")
+
+#ifdef CONFIG_HVM
+PERFCOUNTER(vmsi_pirq_direct,     "vMSI pass-through direct deliveries")
+#endif
+
+#ifdef CONFIG_HVM
+PERFCOUNTER(p2m_recoalesced_2m,   "p2m 2M superpages re-coalesced")
+PERFCOUNTER(p2m_recoalesced_1g,   "p2m 1G superpages re-coalesced")
+#endif
+
+#ifdef CONFIG_MEM_SHARING
+PERFCOUNTER(mem_sharing_fork_reset_logged, "fork resets from the dirty log")
+PERFCOUNTER(mem_sharing_fork_reset_walked, "fork resets walking page list")
+#endif
 
 PERFCOUNTER(buslock, "Bus Locks Detected")
 PERFCOUNTER(vmnotify_crash, "domain crashes by Notify VM Exit")
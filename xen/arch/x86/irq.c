@@ -2559,6 +2559,14 @@ static void cf_check dump_irqs(unsigned char key)
                        "-M?"[masked], info->masked ? 'M' : '-',
                        i < action->nr_guests ? ',' : '\n');
             }
+
+            for ( i = 0; i < action->nr_guests; i++ )
+            {
+                d = action->guest[i];
+                info = pirq_info(d, domain_irq_to_pirq(d, irq));
+                if ( is_hvm_domain(d) && info )
+                    pt_pirq_dump_latency(d, info, desc->msi_desc);
+            }
         }
         else if ( desc->action )
             printk("%ps()\n", desc->action->handler);
@@ -0,0 +1 @@
+cmd_arch/x86/mm/hap/built_in.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o arch/x86/mm/hap/built_in.o arch/x86/mm/hap/hap.o arch/x86/mm/hap/guest_walk_2.o arch/x86/mm/hap/guest_walk_3.o arch/x86/mm/hap/guest_walk_4.o arch/x86/mm/hap/nested_hap.o arch/x86/mm/hap/nested_ept.o
@@ -95,8 +95,11 @@ int hap_track_dirty_vram(struct domain *d,
             domain_unpause(d);
 
             if ( oend > ostart )
+            {
                 p2m_change_type_range(d, ostart, oend,
                                       p2m_ram_logdirty, p2m_ram_rw);
+                p2m_recoalesce(d, ostart, oend);
+            }
 
             /*
              * Switch vram to log dirty mode, either by setting l1e entries of
@@ -148,8 +151,11 @@ int hap_track_dirty_vram(struct domain *d,
         paging_unlock(d);
 
         if ( nr_frames )
+        {
             p2m_change_type_range(d, begin_pfn, begin_pfn + nr_frames,
                                   p2m_ram_logdirty, p2m_ram_rw);
+            p2m_recoalesce(d, begin_pfn, begin_pfn + nr_frames);
+        }
     }
 out:
     vfree(dirty_bitmap);
@@ -210,6 +216,10 @@ static int cf_check hap_disable_log_dirty(struct domain *d)
      * normal mode, or via hardware-assisted log-dirty.
      */
     p2m_change_entry_type_global(d, p2m_ram_logdirty, p2m_ram_rw);
+
+    /* Merge back the superpages which tracking shattered. */
+    p2m_recoalesce(d, 0, p2m_get_hostp2m(d)->max_mapped_pfn + 1);
+
     return 0;
 }
 
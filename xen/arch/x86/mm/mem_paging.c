@@ -9,6 +9,7 @@
 
 
 #include <asm/p2m.h>
+#include <asm/mem_sharing.h>
 #include <xen/guest_access.h>
 #include <xen/vm_event.h>
 #include <xsm/xsm.h>
@@ -404,6 +405,9 @@ static int prepare(struct domain *d, gfn_t gfn,
 
         if ( !page_extant )
             atomic_dec(&d->paged_pages);
+
+        if ( mem_sharing_is_fork(d) )
+            mem_sharing_fork_page_added(d, gfn, PAGE_ORDER_4K);
     }
 
  out:
@@ -423,6 +427,83 @@ static int prepare(struct domain *d, gfn_t gfn,
     return ret;
 }
 
+/*
+ * sample - Harvest the accessed state of a range of guest pages
+ * @d: guest domain
+ * @gfn: first guest page of the range
+ * @nr: number of guest pages
+ * @bitmap: buffer receiving one bit per guest page
+ *
+ * sample() lets the pager tell the guest's working set apart from idle
+ * memory before choosing pages to evict.
+ */
+static int sample(struct domain *d, gfn_t gfn, unsigned int nr,
+                  XEN_GUEST_HANDLE_64(uint8) bitmap)
+{
+    unsigned long *bits;
+    int ret;
+
+    if ( !nr || nr > XENMEM_paging_sample_max ||
+         gfn_x(gfn) + nr < gfn_x(gfn) )
+        return -EINVAL;
+
+    bits = xzalloc_array(unsigned long, BITS_TO_LONGS(nr));
+    if ( !bits )
+        return -ENOMEM;
+
+    ret = p2m_test_and_clear_accessed(d, gfn, nr, bits);
+    if ( !ret && copy_to_guest(bitmap, (uint8_t *)bits, DIV_ROUND_UP(nr, 8)) )
+        ret = -EFAULT;
+
+    xfree(bits);
+
+    return ret;
+}
+
+/*
+ * batch - Nominate or evict a list of guest pages
+ * @d: guest domain
+ * @op: XENMEM_paging_op_nominate_batch or XENMEM_paging_op_evict_batch
+ * @nr: number of guest pages
+ * @gfns: list of guest pages
+ * @bitmap: buffer receiving one bit per guest page
+ *
+ * batch() saves the pager a hypercall per page.  Pages which can't be
+ * nominated or evicted are skipped, just like the pager skips them when
+ * acting on single pages.
+ */
+static int batch(struct domain *d, unsigned int op, unsigned int nr,
+                 XEN_GUEST_HANDLE_64(const_uint64) gfns,
+                 XEN_GUEST_HANDLE_64(uint8) bitmap)
+{
+    uint8_t done[XENMEM_paging_batch_max / 8] = {};
+    unsigned int i;
+    uint64_t gfn;
+    int ret;
+
+    if ( !nr || nr > XENMEM_paging_batch_max )
+        return -EINVAL;
+
+    for ( i = 0; i < nr; i++ )
+    {
+        if ( copy_from_guest_offset(&gfn, gfns, i, 1) )
+            return -EFAULT;
+
+        if ( op == XENMEM_paging_op_nominate_batch )
+            ret = nominate(d, _gfn(gfn));
+        else
+            ret = evict(d, _gfn(gfn));
+
+        if ( !ret )
+            done[i / 8] |= 1U << (i % 8);
+    }
+
+    if ( copy_to_guest(bitmap, done, DIV_ROUND_UP(nr, 8)) )
+        return -EFAULT;
+
+    return 0;
+}
+
 int mem_paging_memop(XEN_GUEST_HANDLE_PARAM(xen_mem_paging_op_t) arg)
 {
     int rc;
@@ -433,6 +514,9 @@ int mem_paging_memop(XEN_GUEST_HANDLE_PARAM(xen_mem_paging_op_t) arg)
     if ( copy_from_guest(&mpo, arg, 1) )
         return -EFAULT;
 
+    if ( mpo.pad )
+        return -EINVAL;
+
     rc = rcu_lock_live_remote_domain_by_id(mpo.domain, &d);
     if ( rc )
         return rc;
@@ -461,6 +545,15 @@ int mem_paging_memop(XEN_GUEST_HANDLE_PARAM(xen_mem_paging_op_t) arg)
             copyback = 1;
         break;
 
+    case XENMEM_paging_op_sample:
+        rc = sample(d, _gfn(mpo.gfn), mpo.nr, mpo.bitmap);
+        break;
+
+    case XENMEM_paging_op_nominate_batch:
+    case XENMEM_paging_op_evict_batch:
+        rc = batch(d, mpo.op, mpo.nr, mpo.gfns, mpo.bitmap);
+        break;
+
     default:
         rc = -ENOSYS;
         break;
@@ -14,6 +14,7 @@
 #include <xen/spinlock.h>
 #include <xen/rwlock.h>
 #include <xen/mm.h>
+#include <xen/perfc.h>
 #include <xen/grant_table.h>
 #include <xen/sched.h>
 #include <xen/rcupdate.h>
@@ -1235,6 +1236,85 @@ err_out:
 }
 
 
+/*
+ * Log a gfn of a fork as having been given a private page since the last
+ * reset, see fork_reset_memory().  Failing to grow the log only costs the
+ * next reset a walk of the fork's page list.
+ */
+static void fork_log_dirty(struct domain *d, unsigned long gfn)
+{
+    struct mem_sharing_domain *msd = &d->arch.hvm.mem_sharing;
+    struct p2m_domain *p2m = p2m_get_hostp2m(d);
+
+    p2m_lock(p2m);
+
+    if ( msd->dirty_overflow )
+        goto out;
+
+    if ( msd->nr_dirty_gfns == msd->max_dirty_gfns )
+    {
+        unsigned int max = min(max(msd->max_dirty_gfns * 2, 512U),
+                               d->max_pages);
+        unsigned long *gfns = NULL;
+
+        if ( max > msd->max_dirty_gfns )
+            gfns = xrealloc_array(msd->dirty_gfns, max);
+        if ( !gfns )
+        {
+            msd->dirty_overflow = true;
+            goto out;
+        }
+
+        msd->dirty_gfns = gfns;
+        msd->max_dirty_gfns = max;
+    }
+
+    msd->dirty_gfns[msd->nr_dirty_gfns++] = gfn;
+
+ out:
+    p2m_unlock(p2m);
+}
+
+/*
+ * Log pages added to a fork's p2m other than by forking or unsharing, eg.
+ * by the guest populating its physmap or exchanging memory.  Superpages
+ * aren't logged: they only come from populating, and the reset walks the
+ * page list instead.
+ */
+void mem_sharing_fork_page_added(struct domain *d, gfn_t gfn,
+                                 unsigned int order)
+{
+    struct mem_sharing_domain *msd = &d->arch.hvm.mem_sharing;
+    struct p2m_domain *p2m = p2m_get_hostp2m(d);
+
+    if ( order == PAGE_ORDER_4K )
+    {
+        fork_log_dirty(d, gfn_x(gfn));
+        return;
+    }
+
+    p2m_lock(p2m);
+    msd->dirty_overflow = true;
+    p2m_unlock(p2m);
+}
+
+/* Start a new dirty log, for a fork freshly created or reset. */
+static void fork_clear_dirty(struct domain *d)
+{
+    struct mem_sharing_domain *msd = &d->arch.hvm.mem_sharing;
+
+    msd->nr_dirty_gfns = 0;
+    msd->dirty_overflow = false;
+}
+
+void mem_sharing_fork_teardown(struct domain *d)
+{
+    struct mem_sharing_domain *msd = &d->arch.hvm.mem_sharing;
+
+    XFREE(msd->dirty_gfns);
+    msd->nr_dirty_gfns = msd->max_dirty_gfns = 0;
+}
+
 /*
  * A note on the rationale for unshare error handling:
  *  1. Unshare can only fail with ENOMEM. Any other error conditions BUG_ON()'s
@@ -1371,6 +1451,9 @@ int __mem_sharing_unshare_page(struct domain *d,
     /* Update m2p entry */
     set_gpfn_from_mfn(mfn_x(page_to_mfn(page)), gfn);
 
+    if ( mem_sharing_is_fork(d) )
+        fork_log_dirty(d, gfn);
+
     /*
      * Now that the gfn<->mfn map is properly established,
      * marking dirty is feasible
@@ -1499,6 +1582,148 @@ static int range_share(struct domain *d, struct domain *cd,
     return rc;
 }
 
+/*
+ * Compare the contents of two pages nominated for sharing.  The outcome is
+ * only advisory, as the guests may unshare the pages again, but then their
+ * handles change and share_pages() fails.
+ */
+static bool pages_match(struct domain *d, gfn_t gfn,
+                        struct domain *cd, gfn_t cgfn)
+{
+    struct page_info *page, *cpage;
+    const void *va, *cva;
+    p2m_type_t t;
+    mfn_t mfn, cmfn;
+    bool match = false;
+
+    mfn = get_gfn_query_unlocked(d, gfn_x(gfn), &t);
+    if ( !mfn_valid(mfn) || !p2m_is_shared(t) )
+        return false;
+    cmfn = get_gfn_query_unlocked(cd, gfn_x(cgfn), &t);
+    if ( !mfn_valid(cmfn) || !p2m_is_shared(t) )
+        return false;
+    if ( mfn_eq(mfn, cmfn) )
+        return true;
+
+    page = mfn_to_page(mfn);
+    cpage = mfn_to_page(cmfn);
+    if ( !get_page(page, dom_cow) )
+        return false;
+    if ( get_page(cpage, dom_cow) )
+    {
+        va = map_domain_page(mfn);
+        cva = map_domain_page(cmfn);
+        match = !memcmp(va, cva, PAGE_SIZE);
+        unmap_domain_page(cva);
+        unmap_domain_page(va);
+        put_page(cpage);
+    }
+    put_page(page);
+
+    return match;
+}
+
+/*
+ * Share arbitrary pairs of gfns, as found to be duplicates by a scanner
+ * hashing the domains' memory.  Unlike for range_share() the domains needn't
+ * be paused: the pages' contents get compared once both are nominated, as
+ * they may have changed since they were hashed.
+ */
+static int share_batch(struct domain *d, struct domain *cd,
+                       struct mem_sharing_op_batch *batch)
+{
+    unsigned int i = batch->opaque;
+    uint8_t bits = 0;
+    int rc;
+
+    while ( i < batch->nr )
+    {
+        uint64_t sgfn, cgfn;
+        shr_handle_t sh, ch;
+
+        if ( copy_from_guest_offset(&sgfn, batch->source_gfns, i, 1) ||
+             copy_from_guest_offset(&cgfn, batch->client_gfns, i, 1) )
+            return -EFAULT;
+
+        rc = nominate_page(d, _gfn(sgfn), 0, false, &sh);
+        if ( !rc )
+            rc = nominate_page(cd, _gfn(cgfn), 0, false, &ch);
+        if ( !rc && !pages_match(d, _gfn(sgfn), cd, _gfn(cgfn)) )
+            rc = -EILSEQ;
+        if ( !rc )
+            rc = share_pages(d, _gfn(sgfn), sh, cd, _gfn(cgfn), ch);
+        if ( !rc )
+            bits |= 1U << (i & 7);
+
+        if ( !(++i & 7) || i == batch->nr || rc == -ENOMEM )
+        {
+            if ( copy_to_guest_offset(batch->bitmap, (i - 1) / 8, &bits, 1) )
+                return -EFAULT;
+            bits = 0;
+        }
+
+        /*
+         * Individual pages may legitimately be unsharable, and we just want
+         * to skip over those: only running out of memory fails the batch.
+         */
+        if ( rc == -ENOMEM )
+            return rc;
+
+        /* Check for continuation at the end of a bitmap byte. */
+        if ( i < batch->nr && !(i & 7) && hypercall_preempt_check() )
+        {
+            batch->opaque = i;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Report the type of gfns of a domain.  This only queries the p2m, so
+ * that a scanner can tell which gfns it can map without populating PoD
+ * entries, paging pages back in or populating a fork from its parent.
+ */
+static int query_batch(struct domain *d, struct mem_sharing_op_query *query)
+{
+    unsigned int i = query->opaque;
+
+    while ( i < query->nr )
+    {
+        uint64_t gfn;
+        uint8_t type;
+        p2m_type_t t;
+        mfn_t mfn;
+
+        if ( copy_from_guest_offset(&gfn, query->gfns, i, 1) )
+            return -EFAULT;
+
+        mfn = get_gfn_query_unlocked(d, gfn, &t);
+        if ( p2m_is_shared(t) )
+            type = XENMEM_SHARING_GFN_SHARED;
+        else if ( p2m_is_pod(t) )
+            type = XENMEM_SHARING_GFN_POD;
+        else if ( p2m_is_paging(t) )
+            type = XENMEM_SHARING_GFN_PAGED;
+        else if ( p2m_is_ram(t) && mfn_valid(mfn) )
+            type = XENMEM_SHARING_GFN_RAM;
+        else
+            type = XENMEM_SHARING_GFN_OTHER;
+
+        if ( copy_to_guest_offset(query->types, i, &type, 1) )
+            return -EFAULT;
+
+        if ( ++i < query->nr && !(i & 0xff) && hypercall_preempt_check() )
+        {
+            query->opaque = i;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
 static inline int mem_sharing_control(struct domain *d, bool enable,
                                       uint16_t flags)
 {
@@ -1601,8 +1826,12 @@ int mem_sharing_fork_page(struct domain *d, gfn_t gfn, bool unsharing)
 
     put_gfn(parent, gfn_l);
 
-    return p2m->set_entry(p2m, gfn, new_mfn, PAGE_ORDER_4K, p2m_ram_rw,
-                          p2m->default_access, -1);
+    rc = p2m->set_entry(p2m, gfn, new_mfn, PAGE_ORDER_4K, p2m_ram_rw,
+                        p2m->default_access, -1);
+    if ( !rc )
+        fork_log_dirty(d, gfn_l);
+
+    return rc;
 }
 
 static int bring_up_vcpus(struct domain *cd, struct domain *d)
@@ -1709,6 +1938,16 @@ static int copy_vcpu_settings(struct domain *cd, const struct domain *d)
         if ( !d_vcpu || !cd_vcpu )
             continue;
 
+        /*
+         * The parent's context has no record for a vCPU which is down, so a
+         * vCPU the fork brought up since can't be reset by loading it: take
+         * it back down instead.
+         */
+        if ( test_bit(_VPF_down, &d_vcpu->pause_flags) &&
+             !test_bit(_VPF_down, &cd_vcpu->pause_flags) &&
+             (ret = vcpu_reset(cd_vcpu)) )
+            return ret;
+
         /*
          * Map the vcpu_info page and the (physically registered) runstate and
          * time info areas.
@@ -1811,6 +2050,8 @@ static int copy_special_pages(struct domain *cd, struct domain *d)
                                 p2m_ram_rw, p2m->default_access, -1);
             if ( rc )
                 return rc;
+
+            fork_log_dirty(cd, value);
         }
 
         copy_domain_page(new_mfn, old_mfn);
@@ -1888,6 +2129,7 @@ static int fork(struct domain *cd, struct domain *d)
         *cd->arch.cpu_policy = *d->arch.cpu_policy;
         cd->vmtrace_size = d->vmtrace_size;
         cd->parent = d;
+        fork_clear_dirty(cd);
     }
 
     /* This is preemptible so it's the first to get done */
@@ -1911,70 +2153,112 @@ static int fork(struct domain *cd, struct domain *d)
 }
 
 /*
- * The fork reset operation is intended to be used on short-lived forks only.
- * There is no hypercall continuation operation implemented for this reason.
- * For forks that obtain a larger memory footprint it is likely going to be
- * more performant to create a new fork instead of resetting an existing one.
+ * Drop a page of a fork which was copied from the parent, so that it gets
+ * re-populated from the parent on next access.  Only regular pages with no
+ * extra reference held to them qualify, which p2m_is_sharable() alone
+ * doesn't tell as it doesn't check the page's reference count: check
+ * whether the page is convertible to the shared type using nominate_page()
+ * instead.  Pages which are already shared (ie. a share handle is returned)
+ * are left alone too.
+ */
+static void fork_reset_page(struct domain *d, struct page_info *page,
+                            gfn_t gfn)
+{
+    struct p2m_domain *p2m = p2m_get_hostp2m(d);
+    shr_handle_t sh;
+    int rc;
+
+    if ( nominate_page(d, gfn, 0, true, &sh) || sh )
+        return;
+
+    /* forked memory is 4k, not splitting large pages so this must work */
+    rc = p2m->set_entry(p2m, gfn, INVALID_MFN, PAGE_ORDER_4K,
+                        p2m_invalid, p2m_access_rwx, -1);
+    ASSERT(!rc);
+
+    put_page_alloc_ref(page);
+    put_page_and_type(page);
+}
+
+/*
+ * Resetting a fork's memory only revisits the gfns which were given a
+ * private page since the last reset, as logged by fork_log_dirty(), making
+ * the cost proportional to what the fork wrote rather than to its size.
+ * Every page entering the fork's p2m gets logged: by forking or unsharing,
+ * and through mem_sharing_fork_page_added() for p2m_add_page(), PoD and
+ * paging.  Pages leaving it need no entry, as the reset would only drop
+ * them.  The log having overflowed falls back to walking the fork's whole
+ * page list.
  *
- * TODO: In case this hypercall would become useful on forks with larger memory
- * footprints the hypercall continuation should be implemented (or if this
- * feature needs to be become "stable").
+ * There is no hypercall continuation operation implemented, the reset being
+ * intended for forks which get reset regularly, and so don't accumulate a
+ * large amount of private memory.
  */
-int mem_sharing_fork_reset(struct domain *d, bool reset_state,
-                           bool reset_memory)
+static void fork_reset_memory(struct domain *d)
 {
-    int rc = 0;
-    struct domain *pd = d->parent;
+    struct mem_sharing_domain *msd = &d->arch.hvm.mem_sharing;
     struct p2m_domain *p2m = p2m_get_hostp2m(d);
     struct page_info *page, *tmp;
+    unsigned int i;
 
-    ASSERT(reset_state || reset_memory);
+    p2m_lock(p2m);
 
-    domain_pause(d);
+    if ( !msd->dirty_overflow )
+    {
+        for ( i = 0; i < msd->nr_dirty_gfns; i++ )
+        {
+            gfn_t gfn = _gfn(msd->dirty_gfns[i]);
+            p2m_access_t a;
+            p2m_type_t t;
+            mfn_t mfn;
 
-    if ( !reset_memory )
-        goto state;
+            mfn = p2m->get_entry(p2m, gfn, &t, &a, 0, NULL, NULL);
+            if ( !mfn_valid(mfn) || !p2m_is_ram(t) )
+                continue;
 
-    /* need recursive lock because we will free pages */
-    rspin_lock(&d->page_alloc_lock);
-    page_list_for_each_safe(page, tmp, &d->page_list)
+            page = mfn_to_page(mfn);
+            if ( page_get_owner(page) == d )
+                fork_reset_page(d, page, gfn);
+        }
+
+        perfc_incr(mem_sharing_fork_reset_logged);
+    }
+    else
     {
-        shr_handle_t sh;
-        mfn_t mfn = page_to_mfn(page);
-        gfn_t gfn = mfn_to_gfn(d, mfn);
+        /* need recursive lock because we will free pages */
+        rspin_lock(&d->page_alloc_lock);
+        page_list_for_each_safe(page, tmp, &d->page_list)
+            fork_reset_page(d, page, mfn_to_gfn(d, page_to_mfn(page)));
+        rspin_unlock(&d->page_alloc_lock);
 
-        /*
-         * We only want to remove pages from the fork here that were copied
-         * from the parent but could be potentially re-populated using memory
-         * sharing after the reset. These pages all must be regular pages with
-         * no extra reference held to them, thus should be possible to make
-         * them sharable. Unfortunately p2m_is_sharable check is not sufficient
-         * to test this as it doesn't check the page's reference count. We thus
-         * check whether the page is convertable to the shared type using
-         * nominate_page. In case the page is already shared (ie. a share
-         * handle is returned) then we don't remove it.
-         */
-        if ( (rc = nominate_page(d, gfn, 0, true, &sh)) || sh )
-            continue;
+        perfc_incr(mem_sharing_fork_reset_walked);
+    }
 
-        /* forked memory is 4k, not splitting large pages so this must work */
-        rc = p2m->set_entry(p2m, gfn, INVALID_MFN, PAGE_ORDER_4K,
-                            p2m_invalid, p2m_access_rwx, -1);
-        ASSERT(!rc);
+    fork_clear_dirty(d);
 
-        put_page_alloc_ref(page);
-        put_page_and_type(page);
-    }
-    rspin_unlock(&d->page_alloc_lock);
+    p2m_unlock(p2m);
+}
+
+int mem_sharing_fork_reset(struct domain *d, bool reset_state,
+                           bool reset_memory)
+{
+    int rc = 0;
+    struct domain *pd = d->parent;
+
+    ASSERT(reset_state || reset_memory);
+
+    domain_pause(d);
+
+    if ( reset_memory )
+        fork_reset_memory(d);
 
- state:
     if ( reset_state )
     {
         rc = copy_settings(d, pd);
         if ( rc == -ERESTART )
             /*
-             * Translate to -EAGAIN, see TODO comment at top of function about
-             * hypercall continuations.
+             * Translate to -EAGAIN, see the comment ahead of
+             * fork_reset_memory() about hypercall continuations.
              */
             rc = -EAGAIN;
     }
@@ -2005,7 +2289,9 @@ int mem_sharing_memop(XEN_GUEST_HANDLE_PARAM(xen_mem_sharing_op_t) arg)
     if ( rc )
         goto out;
 
-    if ( !mem_sharing_enabled(d) &&
+    /* Querying gfn types leaves sharing disabled. */
+    if ( mso.op != XENMEM_sharing_op_query_batch &&
+         !mem_sharing_enabled(d) &&
          (rc = mem_sharing_control(d, true, 0)) )
         goto out;
 
@@ -2231,6 +2517,79 @@ int mem_sharing_memop(XEN_GUEST_HANDLE_PARAM(xen_mem_sharing_op_t) arg)
     }
     break;
 
+    case XENMEM_sharing_op_share_batch:
+    {
+        struct domain *cd;
+
+        rc = -EINVAL;
+        if ( mso.u.batch._pad[0] || mso.u.batch._pad[1] ||
+             mso.u.batch._pad[2] || (mso.u.batch.opaque & 7) ||
+             mso.u.batch.opaque > mso.u.batch.nr )
+            goto out;
+
+        rc = rcu_lock_live_remote_domain_by_id(mso.u.batch.client_domain,
+                                               &cd);
+        if ( rc )
+            goto out;
+
+        rc = xsm_mem_sharing_op(XSM_DM_PRIV, d, cd,
+                                XENMEM_sharing_op_share);
+        if ( rc )
+        {
+            rcu_unlock_domain(cd);
+            goto out;
+        }
+
+        if ( !mem_sharing_enabled(cd) )
+        {
+            rcu_unlock_domain(cd);
+            rc = -EINVAL;
+            goto out;
+        }
+
+        rc = share_batch(d, cd, &mso.u.batch);
+        rcu_unlock_domain(cd);
+
+        if ( rc > 0 )
+        {
+            if ( __copy_to_guest(arg, &mso, 1) )
+                rc = -EFAULT;
+            else
+                rc = hypercall_create_continuation(__HYPERVISOR_memory_op,
+                                                   "lh", XENMEM_sharing_op,
+                                                   arg);
+        }
+        else
+            mso.u.batch.opaque = 0;
+    }
+    break;
+
+    case XENMEM_sharing_op_query_batch:
+        rc = -EINVAL;
+        if ( memchr_inv(mso.u.query._pad, 0, sizeof(mso.u.query._pad)) ||
+             mso.u.query.opaque > mso.u.query.nr )
+            goto out;
+
+        rc = -EOPNOTSUPP;
+        if ( !is_hvm_domain(d) )
+            goto out;
+
+        mso.u.query.enabled = mem_sharing_enabled(d);
+        rc = query_batch(d, &mso.u.query);
+
+        if ( rc > 0 )
+        {
+            if ( __copy_to_guest(arg, &mso, 1) )
+                rc = -EFAULT;
+            else
+                rc = hypercall_create_continuation(__HYPERVISOR_memory_op,
+                                                   "lh", XENMEM_sharing_op,
+                                                   arg);
+        }
+        else
+            mso.u.query.opaque = 0;
+        break;
+
     case XENMEM_sharing_op_debug_gfn:
         rc = debug_gfn(d, _gfn(mso.u.debug.u.gfn));
         break;
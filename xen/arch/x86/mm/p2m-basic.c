@@ -89,7 +89,14 @@ static int p2m_init_hostp2m(struct domain *d)
     rc = p2m_init_logdirty(p2m);
 
     if ( !rc )
+    {
+        if ( is_hvm_domain(d) )
+        {
+            p2m_init_recoalesce(p2m);
+            p2m_pod_init_reclaim(p2m);
+        }
         d->arch.p2m = p2m;
+    }
     else
         p2m_free_one(p2m);
 
@@ -103,6 +110,11 @@ static void p2m_teardown_hostp2m(struct domain *d)
 
     if ( p2m )
     {
+        if ( is_hvm_domain(d) )
+        {
+            p2m_free_recoalesce(p2m);
+            p2m_pod_free_reclaim(p2m);
+        }
         p2m_free_one(p2m);
         d->arch.p2m = NULL;
     }
@@ -1116,6 +1116,85 @@ static mfn_t cf_check ept_get_entry(
     return mfn;
 }
 
+/*
+ * Replace the table mapping the naturally aligned range of the given order
+ * (2M or 1G) at gfn by a superpage, if all its entries are leaves of the
+ * same RAM type and access mapping contiguous frames, and the range has a
+ * uniform memory type.  Pending type changes are taken into account, as
+ * ept_get_entry() does.  Returns 1 if the range got promoted, 0 if not, or
+ * -errno.
+ */
+static int cf_check ept_coalesce(struct p2m_domain *p2m, gfn_t gfn_,
+                                 unsigned int order)
+{
+    unsigned long gfn = gfn_x(gfn_), gfn_remainder = gfn;
+    unsigned int level = order / EPT_TABLE_ORDER, i;
+    unsigned int shift = (level - 1) * EPT_TABLE_ORDER;
+    ept_entry_t *table, e0 = { .epte = 0 };
+    p2m_type_t t0 = p2m_invalid;
+    bool recalc = false, ipat;
+    int rc = 0;
+
+    ASSERT(p2m_locked_by_me(p2m));
+    ASSERT(order == PAGE_ORDER_2M || order == PAGE_ORDER_1G);
+
+    if ( (gfn & ((1UL << order) - 1)) || gfn > p2m->max_mapped_pfn )
+        return 0;
+
+    table = map_domain_page(pagetable_get_mfn(p2m_get_pagetable(p2m)));
+
+    /* Walk down to the table below the entry covering the range. */
+    for ( i = p2m->ept.wl; i >= level; i-- )
+    {
+        if ( table[gfn_remainder >> (i * EPT_TABLE_ORDER)].recalc )
+            recalc = true;
+        if ( ept_next_level(p2m, true, &table, &gfn_remainder, i) !=
+             GUEST_TABLE_NORMAL_PAGE )
+            goto out;
+    }
+
+    for ( i = 0; i < EPT_PAGETABLE_ENTRIES; i++ )
+    {
+        const ept_entry_t *e = &table[i];
+        p2m_type_t t;
+
+        if ( !is_epte_present(e) || (level > 1 && !is_epte_superpage(e)) )
+            goto out;
+
+        t = p2m_recalc_type(recalc || e->recalc, e->sa_p2mt, p2m,
+                            gfn + ((unsigned long)i << shift));
+
+        if ( !i )
+        {
+            if ( (t != p2m_ram_rw && t != p2m_ram_ro) ||
+                 (e->mfn & ((1UL << order) - 1)) )
+                goto out;
+            e0 = *e;
+            t0 = t;
+        }
+        else if ( t != t0 || e->access != e0.access ||
+                  e->suppress_ve != e0.suppress_ve ||
+                  e->mfn != e0.mfn + ((unsigned long)i << shift) )
+            goto out;
+    }
+
+    /* A mixed memory type would have ept_handle_misconfig() split it again. */
+    if ( epte_get_entry_emt(p2m->domain, gfn_, _mfn(e0.mfn), order, &ipat,
+                            t0) < 0 )
+        goto out;
+
+    unmap_domain_page(table);
+
+    rc = ept_set_entry(p2m, gfn_, _mfn(e0.mfn), order, t0, e0.access,
+                       e0.suppress_ve);
+
+    return rc ?: 1;
+
+ out:
+    unmap_domain_page(table);
+    return rc;
+}
+
 void ept_walk_table(struct domain *d, unsigned long gfn)
 {
     struct p2m_domain *p2m = p2m_get_hostp2m(d);
@@ -1342,8 +1421,8 @@ static void ept_disable_pml(struct p2m_domain *p2m)
 
     vmx_domain_disable_pml(p2m->domain);
 
-    /* Disable EPT A/D bit */
-    ept_set_ad_sync(p2m->domain, false);
+    /* Disable EPT A/D bit, unless the pager still samples accessed state */
+    ept_set_ad_sync(p2m->domain, p2m->ept.access_sampling);
     vmx_domain_update_eptp(p2m->domain);
 }
 
@@ -1373,6 +1452,92 @@ static void cf_check ept_flush_pml_buffers(struct p2m_domain *p2m)
     vmx_domain_flush_pml_buffers(p2m->domain);
 }
 
+/*
+ * Report and clear the accessed bits of the leaf entries mapping
+ * [gfn, gfn + nr).  A/D bits get enabled on first use and stay enabled for
+ * the lifetime of the domain.  A superpage reports all of its gfns as
+ * accessed.
+ */
+static int cf_check ept_test_and_clear_accessed(
+    struct p2m_domain *p2m, unsigned long gfn, unsigned int nr,
+    unsigned long *bitmap)
+{
+    struct domain *d = p2m->domain;
+    struct ept_data *ept = &p2m->ept;
+    unsigned long start = gfn, end = gfn + nr;
+    bool flush = false;
+
+    if ( unlikely(altp2m_active(d)) )
+        return -EOPNOTSUPP;
+
+    if ( unlikely(!ept->access_sampling) )
+    {
+        domain_pause(d);
+        p2m_lock(p2m);
+        if ( !ept->access_sampling )
+        {
+            ept->access_sampling = true;
+            ept_set_ad_sync(d, true);
+            vmx_domain_update_eptp(d);
+        }
+        p2m_unlock(p2m);
+        domain_unpause(d);
+    }
+
+    p2m_lock(p2m);
+
+    end = min(end, p2m->max_mapped_pfn + 1);
+
+    while ( gfn < end )
+    {
+        ept_entry_t *table =
+            map_domain_page(pagetable_get_mfn(p2m_get_pagetable(p2m)));
+        unsigned long gfn_remainder = gfn, next;
+        unsigned int i, index;
+        int ret = GUEST_TABLE_NORMAL_PAGE;
+
+        for ( i = ept->wl; i > 0; i-- )
+        {
+            ret = ept_next_level(p2m, true, &table, &gfn_remainder, i);
+            if ( ret != GUEST_TABLE_NORMAL_PAGE )
+                break;
+        }
+
+        next = min((gfn | ((1UL << (i * EPT_TABLE_ORDER)) - 1)) + 1, end);
+        index = gfn_remainder >> (i * EPT_TABLE_ORDER);
+
+        if ( ret == GUEST_TABLE_SUPER_PAGE )
+        {
+            if ( test_and_clear_bit(EPTE_A_SHIFT, &table[index].epte) )
+            {
+                bitmap_set(bitmap, gfn - start, next - gfn);
+                flush = true;
+            }
+        }
+        else if ( ret == GUEST_TABLE_NORMAL_PAGE )
+        {
+            for ( ; gfn < next; gfn++, index++ )
+                if ( is_epte_present(&table[index]) &&
+                     test_and_clear_bit(EPTE_A_SHIFT, &table[index].epte) )
+                {
+                    __set_bit(gfn - start, bitmap);
+                    flush = true;
+                }
+        }
+
+        unmap_domain_page(table);
+        gfn = next;
+    }
+
+    /* Clear cached translations, so that further accesses set A again. */
+    if ( flush )
+        ept_sync_domain(p2m);
+
+    p2m_unlock(p2m);
+
+    return 0;
+}
+
 int ept_p2m_init(struct p2m_domain *p2m)
 {
     struct ept_data *ept = &p2m->ept;
@@ -1380,6 +1545,7 @@ int ept_p2m_init(struct p2m_domain *p2m)
     p2m->set_entry = ept_set_entry;
     p2m->get_entry = ept_get_entry;
     p2m->recalc = resolve_misconfig;
+    p2m->coalesce = ept_coalesce;
     p2m->change_entry_type_global = ept_change_entry_type_global;
     p2m->change_entry_type_range = ept_change_entry_type_range;
     p2m->memory_type_changed = ept_memory_type_changed;
@@ -1401,6 +1567,9 @@ int ept_p2m_init(struct p2m_domain *p2m)
         p2m->flush_hardware_cached_dirty = ept_flush_pml_buffers;
     }
 
+    if ( cpu_has_vmx_ept_ad )
+        p2m->test_and_clear_accessed = ept_test_and_clear_accessed;
+
     if ( !zalloc_cpumask_var(&ept->invalidate) )
         return -ENOMEM;
 
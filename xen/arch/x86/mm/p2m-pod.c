@@ -14,6 +14,7 @@
 #include <xen/sched.h>
 #include <xen/trace.h>
 #include <asm/hvm/nestedhvm.h>
+#include <asm/mem_sharing.h>
 #include <asm/page.h>
 #include <asm/paging.h>
 #include <asm/p2m.h>
@@ -23,6 +24,8 @@
 
 #define superpage_aligned(_x)  (((_x)&(SUPERPAGE_PAGES-1))==0)
 
+static void pod_reclaim_kick(struct p2m_domain *p2m);
+
 /* Enforce lock ordering when grabbing the "external" page_alloc lock */
 static always_inline void lock_page_alloc(struct p2m_domain *p2m)
 {
@@ -343,6 +346,8 @@ p2m_pod_set_mem_target(struct domain *d, unsigned long target)
     else
         ret = p2m_pod_set_cache_target(p2m, pod_target, 1/*preemptible*/);
 
+    pod_reclaim_kick(p2m);
+
 out:
     pod_unlock(p2m);
 
@@ -702,9 +707,33 @@ void p2m_pod_dump_data(struct domain *d)
 
     printk("    PoD entries=%ld cachesize=%ld\n",
            p2m->pod.entry_count, p2m->pod.count);
+    printk("    PoD background reclaimed=%lu\n", p2m->pod.reclaimed_bg);
+    printk("    PoD sweeps=%lu reclaimed=%lu stall avg=%"PRI_stime"us max=%"PRI_stime"us\n",
+           p2m->pod.sweeps, p2m->pod.reclaimed_sweep,
+           p2m->pod.sweeps ? p2m->pod.sweep_time / p2m->pod.sweeps / 1000 : 0,
+           p2m->pod.sweep_max / 1000);
 }
 
 
+/*
+ * Check a page for being all zeroes.  Vector registers aren't available to
+ * Xen, so OR a cache line's worth of words together per iteration instead,
+ * leaving a single branch per line rather than one per word.
+ */
+static bool pod_page_is_zero(const unsigned long *p)
+{
+    unsigned int i;
+
+    BUILD_BUG_ON((PAGE_SIZE / sizeof(*p)) % 8);
+
+    for ( i = 0; i < PAGE_SIZE / sizeof(*p); i += 8 )
+        if ( p[i] | p[i + 1] | p[i + 2] | p[i + 3] |
+             p[i + 4] | p[i + 5] | p[i + 6] | p[i + 7] )
+            return false;
+
+    return true;
+}
+
 /*
  * Search for all-zero superpages to be reclaimed as superpages for the
  * PoD cache. Must be called w/ pod lock held, must lock the superpage
@@ -829,12 +858,8 @@ p2m_pod_zero_check_superpage(struct p2m_domain *p2m, gfn_t gfn)
     {
         map = map_domain_page(mfn_add(mfn0, i));
 
-        for ( j = 0; j < (PAGE_SIZE / sizeof(*map)); j++ )
-            if ( *(map+j) != 0 )
-            {
-                reset = 1;
-                break;
-            }
+        if ( !pod_page_is_zero(map) )
+            reset = 1;
 
         unmap_domain_page(map);
 
@@ -979,12 +1004,12 @@ p2m_pod_zero_check(struct p2m_domain *p2m, const gfn_t *gfns, unsigned int count
     /* Now check each page for real */
     for ( i = 0; i < count; i++ )
     {
+        bool zero;
+
         if ( !map[i] )
             continue;
 
-        for ( j = 0; j < (PAGE_SIZE / sizeof(*map[i])); j++ )
-            if ( *(map[i] + j) != 0 )
-                break;
+        zero = pod_page_is_zero(map[i]);
 
         unmap_domain_page(map[i]);
 
@@ -994,7 +1019,7 @@ p2m_pod_zero_check(struct p2m_domain *p2m, const gfn_t *gfns, unsigned int count
          * See comment in p2m_pod_zero_check_superpage() re gnttab
          * check timing.
          */
-        if ( j < (PAGE_SIZE / sizeof(*map[i])) )
+        if ( !zero )
         {
             /*
              * If the previous p2m_set_entry call succeeded, this one shouldn't
@@ -1046,9 +1071,10 @@ p2m_pod_emergency_sweep(struct p2m_domain *p2m)
 {
     gfn_t gfns[POD_SWEEP_STRIDE];
     unsigned long i, j = 0, start, limit;
+    long count = p2m->pod.count;
+    s_time_t t0 = NOW(), elapsed;
     p2m_type_t t;
 
-
     if ( gfn_eq(p2m->pod.reclaim_single, _gfn(0)) )
         p2m->pod.reclaim_single = p2m->pod.max_guest;
 
@@ -1094,6 +1120,150 @@ p2m_pod_emergency_sweep(struct p2m_domain *p2m)
     p2m_unlock(p2m);
     p2m->pod.reclaim_single = _gfn(i ? i - 1 : i);
 
+    /* The faulting vCPU stalls for the duration of the sweep. */
+    elapsed = NOW() - t0;
+    p2m->pod.sweeps++;
+    p2m->pod.sweep_time += elapsed;
+    p2m->pod.sweep_max = max(p2m->pod.sweep_max, elapsed);
+    p2m->pod.reclaimed_sweep += p2m->pod.count - count;
+}
+
+/*
+ * Background reclaim.
+ *
+ * Rather than leaving it to p2m_pod_emergency_sweep() to find zeroed pages
+ * once the cache has run dry, with the faulting vCPU stalled meanwhile, a
+ * timer scans the p2m ahead of demand while the cache is short of the
+ * outstanding PoD entries and below POD_RECLAIM_LOW pages.  It shares its
+ * position with the sweep, checks no more gfns per tick than the cache is
+ * short of (within POD_SWEEP_STRIDE and POD_RECLAIM_SCAN), and only holds
+ * the p2m and PoD locks for a batch of POD_SWEEP_STRIDE pages at a time.
+ * Superpage mappings are checked as a whole rather than getting shattered,
+ * and holes are skipped over.  A pass over the whole p2m finding nothing
+ * backs the scan off.  The timer follows the domain's first vCPU around, so
+ * that the work is charged to a pCPU the domain runs on rather than to a
+ * single pCPU for all domains.
+ */
+#define POD_RECLAIM_LOW      1024
+#define POD_RECLAIM_SCAN     512
+#define POD_RECLAIM_INTERVAL MILLISECS(10)
+#define POD_RECLAIM_BACKOFF  SECONDS(1)
+
+static bool pod_reclaim_needed(const struct p2m_domain *p2m)
+{
+    return p2m->pod.count < min(p2m->pod.entry_count, POD_RECLAIM_LOW + 0L);
+}
+
+static void pod_reclaim_arm(struct p2m_domain *p2m, s_time_t timeout)
+{
+    const struct vcpu *v = p2m->domain->vcpu ? p2m->domain->vcpu[0] : NULL;
+
+    if ( v )
+        migrate_timer(&p2m->pod.reclaim_timer, v->processor);
+    set_timer(&p2m->pod.reclaim_timer, NOW() + timeout);
+}
+
+static void pod_reclaim_kick(struct p2m_domain *p2m)
+{
+    if ( p2m_is_hostp2m(p2m) && pod_reclaim_needed(p2m) &&
+         !timer_is_active(&p2m->pod.reclaim_timer) )
+        pod_reclaim_arm(p2m, POD_RECLAIM_INTERVAL);
+}
+
+static void cf_check pod_reclaim_timer_fn(void *data)
+{
+    struct p2m_domain *p2m = data;
+    unsigned int scanned = 0, budget = POD_RECLAIM_SCAN;
+    s_time_t next = POD_RECLAIM_INTERVAL;
+
+    while ( scanned < budget )
+    {
+        gfn_t gfns[POD_SWEEP_STRIDE];
+        unsigned long gfn;
+        unsigned int j = 0;
+        long count;
+
+        p2m_lock(p2m);
+        pod_lock(p2m);
+
+        if ( p2m->domain->is_dying || !pod_reclaim_needed(p2m) )
+        {
+            pod_unlock(p2m);
+            p2m_unlock(p2m);
+            return;
+        }
+
+        /* Scale the work to how far short of the low watermark we are. */
+        if ( !scanned )
+        {
+            long shortfall = min(p2m->pod.entry_count, POD_RECLAIM_LOW + 0L) -
+                             p2m->pod.count;
+
+            budget = max(shortfall, POD_SWEEP_STRIDE + 0L);
+            budget = min(budget, POD_RECLAIM_SCAN + 0U);
+        }
+
+        if ( gfn_eq(p2m->pod.reclaim_single, _gfn(0)) )
+            p2m->pod.reclaim_single = p2m->pod.max_guest;
+        gfn = gfn_x(p2m->pod.reclaim_single);
+        count = p2m->pod.count;
+
+        while ( gfn && j < POD_SWEEP_STRIDE && scanned < budget )
+        {
+            unsigned int order;
+            p2m_access_t a;
+            p2m_type_t t;
+
+            (void)p2m->get_entry(p2m, _gfn(gfn), &t, &a, 0, &order, NULL);
+            scanned++;
+
+            if ( !p2m_is_ram(t) )
+                gfn &= ~((1UL << order) - 1);
+            else if ( order )
+            {
+                gfn &= ~(SUPERPAGE_PAGES - 1UL);
+                p2m_pod_zero_check_superpage(p2m, _gfn(gfn));
+            }
+            else
+                gfns[j++] = _gfn(gfn);
+
+            if ( gfn )
+                gfn--;
+        }
+
+        if ( j )
+            p2m_pod_zero_check(p2m, gfns, j);
+
+        p2m->pod.reclaim_single = _gfn(gfn);
+        p2m->pod.reclaimed_bg += p2m->pod.count - count;
+        p2m->pod.reclaim_found += p2m->pod.count - count;
+
+        if ( !gfn )
+        {
+            /* A whole pass without finding anything: back off. */
+            if ( !p2m->pod.reclaim_found )
+                next = POD_RECLAIM_BACKOFF;
+            p2m->pod.reclaim_found = 0;
+        }
+
+        pod_unlock(p2m);
+        p2m_unlock(p2m);
+
+        if ( next != POD_RECLAIM_INTERVAL )
+            break;
+    }
+
+    pod_reclaim_arm(p2m, next);
+}
+
+void p2m_pod_init_reclaim(struct p2m_domain *p2m)
+{
+    init_timer(&p2m->pod.reclaim_timer, pod_reclaim_timer_fn, p2m, 0);
+}
+
+void p2m_pod_free_reclaim(struct p2m_domain *p2m)
+{
+    kill_timer(&p2m->pod.reclaim_timer);
 }
 
 static void pod_eager_reclaim(struct p2m_domain *p2m)
@@ -1245,6 +1415,7 @@ p2m_pod_demand_populate(struct p2m_domain *p2m, gfn_t gfn,
     BUG_ON(p2m->pod.entry_count < 0);
 
     pod_eager_record(p2m, gfn_aligned, order);
+    pod_reclaim_kick(p2m);
 
     if ( tb_init_done )
     {
@@ -1262,6 +1433,10 @@ p2m_pod_demand_populate(struct p2m_domain *p2m, gfn_t gfn,
     }
 
     pod_unlock_and_flush(p2m);
+
+    if ( mem_sharing_is_fork(d) )
+        mem_sharing_fork_page_added(d, gfn_aligned, order);
+
     return true;
 
 out_of_memory:
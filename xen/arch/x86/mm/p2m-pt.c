@@ -931,6 +931,88 @@ pod_retry_l1:
     return (p2m_is_valid(*t) || p2m_is_any_ram(*t)) ? mfn : INVALID_MFN;
 }
 
+/*
+ * Replace the table mapping the naturally aligned range of the given order
+ * (2M or 1G) at gfn by a superpage, if all its entries are leaves of the
+ * same RAM type mapping contiguous frames.  Pending type changes are taken
+ * into account, as p2m_pt_get_entry() does.  Returns 1 if the range got
+ * promoted, 0 if not, or -errno.
+ */
+static int cf_check p2m_pt_coalesce(struct p2m_domain *p2m, gfn_t gfn_,
+                                    unsigned int order)
+{
+    unsigned long gfn = gfn_x(gfn_);
+    unsigned int level = order / PAGETABLE_ORDER, i;
+    unsigned int shift = (level - 1) * PAGETABLE_ORDER;
+    mfn_t mfn = pagetable_get_mfn(p2m_get_pagetable(p2m)), mfn0 = INVALID_MFN;
+    p2m_type_t t0 = p2m_invalid;
+    l1_pgentry_t *table;
+    bool recalc = false;
+    int rc;
+
+    ASSERT(p2m_locked_by_me(p2m));
+    ASSERT(order == PAGE_ORDER_2M || order == PAGE_ORDER_1G);
+
+    if ( (gfn & ((1UL << order) - 1)) || gfn > p2m->max_mapped_pfn )
+        return 0;
+
+    /* Walk down to the table below the entry covering the range. */
+    for ( i = 4; i > level; i-- )
+    {
+        l1_pgentry_t e;
+
+        table = map_domain_page(mfn);
+        e = table[(gfn >> ((i - 1) * PAGETABLE_ORDER)) &
+                  (L1_PAGETABLE_ENTRIES - 1)];
+        unmap_domain_page(table);
+
+        if ( !(l1e_get_flags(e) & _PAGE_PRESENT) ||
+             (l1e_get_flags(e) & _PAGE_PSE) )
+            return 0;
+        if ( needs_recalc(l1, e) )
+            recalc = true;
+        mfn = l1e_get_mfn(e);
+    }
+
+    table = map_domain_page(mfn);
+
+    for ( i = 0; i < L1_PAGETABLE_ENTRIES; i++ )
+    {
+        unsigned int flags = l1e_get_flags(table[i]);
+        p2m_type_t t;
+
+        if ( !(flags & _PAGE_PRESENT) || (level > 1 && !(flags & _PAGE_PSE)) )
+            break;
+
+        t = p2m_recalc_type(recalc || _needs_recalc(flags),
+                            p2m_flags_to_type(flags), p2m,
+                            gfn + ((unsigned long)i << shift));
+
+        if ( !i )
+        {
+            mfn0 = l1e_get_mfn(table[0]);
+            if ( (t != p2m_ram_rw && t != p2m_ram_ro) ||
+                 (mfn_x(mfn0) & ((1UL << order) - 1)) )
+                break;
+            t0 = t;
+        }
+        else if ( t != t0 ||
+                  !mfn_eq(l1e_get_mfn(table[i]),
+                          mfn_add(mfn0, (unsigned long)i << shift)) )
+            break;
+    }
+
+    unmap_domain_page(table);
+
+    if ( i < L1_PAGETABLE_ENTRIES )
+        return 0;
+
+    rc = p2m_pt_set_entry(p2m, gfn_, mfn0, order, t0, p2m->default_access,
+                          -1);
+
+    return rc ?: 1;
+}
+
 static void cf_check p2m_pt_change_entry_type_global(
     struct p2m_domain *p2m, p2m_type_t ot, p2m_type_t nt)
 {
@@ -1167,6 +1249,7 @@ void p2m_pt_init(struct p2m_domain *p2m)
     p2m->set_entry = p2m_pt_set_entry;
     p2m->get_entry = p2m_pt_get_entry;
     p2m->recalc = do_recalc;
+    p2m->coalesce = p2m_pt_coalesce;
     p2m->change_entry_type_global = p2m_pt_change_entry_type_global;
     p2m->change_entry_type_range = p2m_pt_change_entry_type_range;
 
@@ -18,6 +18,7 @@
 #include <xen/grant_table.h>
 #include <xen/ioreq.h>
 #include <xen/param.h>
+#include <xen/perfc.h>
 #include <public/vm_event.h>
 #include <asm/domain.h>
 #include <asm/page.h>
@@ -77,6 +78,121 @@ int p2m_is_logdirty_range(struct p2m_domain *p2m, unsigned long start,
     return 0;
 }
 
+/*
+ * Superpage re-coalescing.
+ *
+ * Log-dirty tracking shatters superpage mappings as pages get written, and
+ * nothing merges them back once tracking stops.  p2m_recoalesce() queues a
+ * range for a background pass, which has the page table code replace each
+ * table mapping a 2M, and then 1G, range uniformly and contiguously by a
+ * single superpage.  The pass runs off a timer, a batch at a time, and
+ * stops while global log-dirty tracking is active: disabling it restarts
+ * the pass.  The timer follows the domain's first vCPU, so that each
+ * domain's pass runs on a pCPU the domain uses rather than all on one.
+ */
+#define RECOALESCE_BATCH 64 /* 2M ranges */
+#define RECOALESCE_DELAY MILLISECS(10)
+
+static void recoalesce_arm(struct p2m_domain *p2m)
+{
+    const struct vcpu *v = p2m->domain->vcpu ? p2m->domain->vcpu[0] : NULL;
+
+    if ( v )
+        migrate_timer(&p2m->recoalesce.timer, v->processor);
+    set_timer(&p2m->recoalesce.timer, NOW() + RECOALESCE_DELAY);
+}
+
+static bool recoalesce_range(struct p2m_domain *p2m, unsigned long gfn,
+                             unsigned int order)
+{
+    if ( rangeset_overlaps_range(p2m->logdirty_ranges, gfn,
+                                 gfn + (1UL << order) - 1) )
+        return false;
+
+    return p2m->coalesce(p2m, _gfn(gfn), order) > 0;
+}
+
+static void cf_check recoalesce_timer_fn(void *data)
+{
+    struct p2m_domain *p2m = data;
+    unsigned int n;
+
+    if ( p2m->domain->is_dying )
+        return;
+
+    for ( n = 0; n < RECOALESCE_BATCH; n++ )
+    {
+        unsigned long gfn;
+
+        p2m_lock(p2m);
+
+        gfn = p2m->recoalesce.next_gfn;
+        if ( gfn >= p2m->recoalesce.end_gfn || p2m->global_logdirty )
+        {
+            p2m->recoalesce.next_gfn = p2m->recoalesce.end_gfn = 0;
+            p2m_unlock(p2m);
+            return;
+        }
+
+        if ( recoalesce_range(p2m, gfn, PAGE_ORDER_2M) )
+            perfc_incr(p2m_recoalesced_2m);
+
+        gfn += 1UL << PAGE_ORDER_2M;
+        if ( hap_has_1gb && !(gfn & ((1UL << PAGE_ORDER_1G) - 1)) &&
+             recoalesce_range(p2m, gfn - (1UL << PAGE_ORDER_1G),
+                              PAGE_ORDER_1G) )
+            perfc_incr(p2m_recoalesced_1g);
+
+        p2m->recoalesce.next_gfn = gfn;
+
+        p2m_unlock(p2m);
+    }
+
+    recoalesce_arm(p2m);
+}
+
+void p2m_init_recoalesce(struct p2m_domain *p2m)
+{
+    init_timer(&p2m->recoalesce.timer, recoalesce_timer_fn, p2m, 0);
+}
+
+void p2m_free_recoalesce(struct p2m_domain *p2m)
+{
+    kill_timer(&p2m->recoalesce.timer);
+}
+
+void p2m_recoalesce(struct domain *d, unsigned long start, unsigned long end)
+{
+    struct p2m_domain *p2m = p2m_get_hostp2m(d);
+    unsigned long align = 1UL << (hap_has_1gb ? PAGE_ORDER_1G
+                                              : PAGE_ORDER_2M);
+
+    if ( !hap_enabled(d) || !hap_has_2mb || !p2m->coalesce )
+        return;
+
+    p2m_lock(p2m);
+
+    start &= ~(align - 1);
+    end = ROUNDUP(min(end, p2m->max_mapped_pfn + 1), align);
+    if ( start >= end )
+    {
+        p2m_unlock(p2m);
+        return;
+    }
+
+    if ( p2m->recoalesce.next_gfn < p2m->recoalesce.end_gfn )
+    {
+        start = min(start, p2m->recoalesce.next_gfn);
+        end = max(end, p2m->recoalesce.end_gfn);
+    }
+    p2m->recoalesce.next_gfn = start;
+    p2m->recoalesce.end_gfn = end;
+
+    p2m_unlock(p2m);
+
+    recoalesce_arm(p2m);
+}
+
 static void change_entry_type_global(struct p2m_domain *p2m,
                                      p2m_type_t ot, p2m_type_t nt)
 {
@@ -249,6 +365,17 @@ void p2m_flush_hardware_cached_dirty(struct domain *d)
     }
 }
 
+int p2m_test_and_clear_accessed(struct domain *d, gfn_t gfn, unsigned int nr,
+                                unsigned long *bitmap)
+{
+    struct p2m_domain *p2m = p2m_get_hostp2m(d);
+
+    if ( !p2m->test_and_clear_accessed )
+        return -EOPNOTSUPP;
+
+    return p2m->test_and_clear_accessed(p2m, gfn_x(gfn), nr, bitmap);
+}
+
 /*
  * Force a synchronous P2M TLB flush if a deferred flush is pending.
  *
@@ -741,6 +868,9 @@ p2m_add_page(struct domain *d, gfn_t gfn, mfn_t mfn,
                 set_gpfn_from_mfn(mfn_x(mfn_add(mfn, i)),
                                   gfn_x(gfn_add(gfn, i)));
         }
+
+        if ( mem_sharing_is_fork(d) )
+            mem_sharing_fork_page_added(d, gfn, page_order);
     }
     else
     {
@@ -762,6 +892,9 @@ p2m_add_page(struct domain *d, gfn_t gfn, mfn_t mfn,
             {
                 set_gpfn_from_mfn(mfn_x(omfn), gfn_x(gfn) + i);
                 paging_mark_pfn_dirty(d, _pfn(gfn_x(gfn) + i));
+                if ( mem_sharing_is_fork(d) )
+                    mem_sharing_fork_page_added(d, gfn_add(gfn, i),
+                                                PAGE_ORDER_4K);
             }
             else if ( p2m_is_ram(ot) && !p2m_is_paged(ot) )
             {
@@ -1050,6 +1183,15 @@ static int set_typed_p2m_entry(struct domain *d, unsigned long gfn_l,
         gfn_unlock(p2m, gfn, order);
         return cur_order + 1;
     }
+    if ( order > PAGE_ORDER_2M && p2m_is_ram(ot) )
+    {
+        /*
+         * Limit the iteration count when zapping M2P entries below, by making
+         * the caller replace RAM backed 1G ranges in 2M chunks.
+         */
+        gfn_unlock(p2m, gfn, order);
+        return PAGE_ORDER_2M + 1;
+    }
     if ( p2m_is_special(ot) )
     {
         /* Special-case (almost) identical mappings. */
@@ -1658,12 +1800,12 @@ static unsigned int mmio_order(const struct domain *d,
          (start_fn & ((1UL << PAGE_ORDER_2M) - 1)) || !(nr >> PAGE_ORDER_2M) )
         return PAGE_ORDER_4K;
 
-    if ( 0 /*
-            * Don't use 1Gb pages, to limit the iteration count in
-            * set_typed_p2m_entry() when it needs to zap M2P entries
-            * for a RAM range.
-            */ &&
-         !(start_fn & ((1UL << PAGE_ORDER_1G) - 1)) && (nr >> PAGE_ORDER_1G) &&
+    /*
+     * 1Gb pages are fine to use here, set_typed_p2m_entry() will request a
+     * smaller order when replacing a RAM range, in order to limit the
+     * iteration count when zapping M2P entries.
+     */
+    if ( !(start_fn & ((1UL << PAGE_ORDER_1G) - 1)) && (nr >> PAGE_ORDER_1G) &&
          hap_has_1gb )
         return PAGE_ORDER_1G;
 
@@ -10,13 +10,19 @@ struct p2m_domain *p2m_init_one(struct domain *d);
 void p2m_free_one(struct p2m_domain *p2m);
 
 void p2m_pod_init(struct p2m_domain *p2m);
+void p2m_pod_init_reclaim(struct p2m_domain *p2m);
+void p2m_pod_free_reclaim(struct p2m_domain *p2m);
 
 #ifdef CONFIG_HVM
 int p2m_init_logdirty(struct p2m_domain *p2m);
 void p2m_free_logdirty(struct p2m_domain *p2m);
+void p2m_init_recoalesce(struct p2m_domain *p2m);
+void p2m_free_recoalesce(struct p2m_domain *p2m);
 #else
 static inline int p2m_init_logdirty(struct p2m_domain *p2m) { return 0; }
 static inline void p2m_free_logdirty(struct p2m_domain *p2m) {}
+static inline void p2m_init_recoalesce(struct p2m_domain *p2m) {}
+static inline void p2m_free_recoalesce(struct p2m_domain *p2m) {}
 #endif
 
 int p2m_init_altp2m(struct domain *d);
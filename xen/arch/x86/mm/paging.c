@@ -17,6 +17,7 @@
 #include <asm/event.h>
 #include <asm/hvm/nestedhvm.h>
 #include <xen/numa.h>
+#include <xen/vmap.h>
 #include <xsm/xsm.h>
 #include <public/sched.h> /* SHUTDOWN_suspend */
 
@@ -248,6 +249,194 @@ static int paging_log_dirty_disable(struct domain *d, bool resuming)
     return ret;
 }
 
+/*
+ * Dirty pfn ring: frames of the domain, owned by Xen, which the toolstack
+ * maps via XENMEM_acquire_resource.  Each pfn whose log-dirty bit gets set
+ * is appended, see struct xen_domctl_dirty_ring.  Protected by the paging
+ * lock; prod and overflow are private copies of what gets published, as
+ * the consumer can write to the header.
+ */
+struct log_dirty_ring {
+    struct xen_domctl_dirty_ring *hdr;
+    uint64_t *pfns;
+    uint32_t prod;
+    uint32_t mask;
+    bool overflow;
+    unsigned int nr_frames;
+    mfn_t mfns[];
+};
+
+static void log_dirty_ring_free(struct log_dirty_ring *r)
+{
+    unsigned int i;
+
+    if ( r->hdr )
+        vunmap(r->hdr);
+
+    for ( i = 0; i < r->nr_frames; i++ )
+    {
+        struct page_info *pg = mfn_to_page(r->mfns[i]);
+
+        put_page_alloc_ref(pg);
+        put_page_and_type(pg);
+    }
+
+    xfree(r);
+}
+
+static int log_dirty_ring_setup(struct domain *d, uint64_t pages)
+{
+    struct log_dirty_ring *r;
+    unsigned int i, nr;
+
+    if ( !pages )
+    {
+        domain_pause(d);
+        paging_lock(d);
+        r = d->arch.paging.log_dirty.ring;
+        d->arch.paging.log_dirty.ring = NULL;
+        d->arch.paging.log_dirty.ring_frames = 0;
+        paging_unlock(d);
+        domain_unpause(d);
+
+        if ( !r )
+            return -ENOENT;
+
+        log_dirty_ring_free(r);
+        return 0;
+    }
+
+    /*
+     * The ring pages are owned by the domain, as vmtrace buffers are.  A PV
+     * guest could map them by MFN and tamper with the ring.
+     */
+    if ( !is_hvm_domain(d) )
+        return -EOPNOTSUPP;
+
+    if ( pages > XEN_DOMCTL_DIRTY_RING_MAX_PAGES || (pages & (pages - 1)) )
+        return -EINVAL;
+
+    nr = pages + 1;
+    r = xzalloc_flex_struct(struct log_dirty_ring, mfns, nr);
+    if ( !r )
+        return -ENOMEM;
+
+    for ( i = 0; i < nr; i++ )
+    {
+        struct page_info *pg = alloc_domheap_page(d, MEMF_no_refcount);
+
+        if ( !pg )
+            goto nomem;
+
+        /*
+         * As for vmtrace buffers, failure here means something fishy is
+         * going on.  Leak the page rather than freeing it.
+         */
+        if ( unlikely(!get_page_and_type(pg, d, PGT_writable_page)) )
+            goto nomem;
+
+        r->mfns[r->nr_frames++] = page_to_mfn(pg);
+    }
+
+    r->hdr = vmap(r->mfns, nr);
+    if ( !r->hdr )
+        goto nomem;
+
+    memset(r->hdr, 0, nr * PAGE_SIZE);
+    r->pfns = (void *)r->hdr + PAGE_SIZE;
+    r->mask = pages * (PAGE_SIZE / sizeof(*r->pfns)) - 1;
+
+    domain_pause(d);
+    paging_lock(d);
+
+    if ( d->arch.paging.log_dirty.ring )
+    {
+        paging_unlock(d);
+        domain_unpause(d);
+        log_dirty_ring_free(r);
+        return -EEXIST;
+    }
+
+    /*
+     * Bits already set in the bitmap have no ring entry.  Make the first
+     * round fall back to the bitmap.
+     */
+    r->overflow = paging_mode_log_dirty(d);
+    r->hdr->overflow = r->overflow;
+
+    d->arch.paging.log_dirty.ring = r;
+    d->arch.paging.log_dirty.ring_frames = nr;
+
+    paging_unlock(d);
+    domain_unpause(d);
+
+    return 0;
+
+ nomem:
+    log_dirty_ring_free(r);
+    return -ENOMEM;
+}
+
+static void log_dirty_ring_put(struct log_dirty_ring *r, pfn_t pfn)
+{
+    if ( r->overflow )
+        return;
+
+    if ( r->prod - read_atomic(&r->hdr->cons) > r->mask )
+    {
+        r->overflow = true;
+        write_atomic(&r->hdr->overflow, 1);
+        return;
+    }
+
+    r->pfns[r->prod & r->mask] = pfn_x(pfn);
+    smp_wmb();
+    write_atomic(&r->hdr->prod, ++r->prod);
+}
+
+/*
+ * Start a new round on CLEAN.  Called with the domain paused and the
+ * paging lock held.
+ */
+static int log_dirty_ring_clean(struct log_dirty_ring *r, bool ring_only)
+{
+    if ( r->overflow && ring_only )
+        return -ENOBUFS;
+
+    r->overflow = false;
+    write_atomic(&r->hdr->overflow, 0);
+    write_atomic(&r->hdr->round_end, r->prod);
+
+    return 0;
+}
+
+unsigned int paging_dirty_ring_frames(const struct domain *d)
+{
+    return ACCESS_ONCE(d->arch.paging.log_dirty.ring_frames);
+}
+
+int paging_dirty_ring_acquire(struct domain *d, unsigned int frame,
+                              unsigned int nr_frames, xen_pfn_t mfn_list[])
+{
+    const struct log_dirty_ring *r;
+    unsigned int i;
+    int rc = -EINVAL;
+
+    paging_lock(d);
+
+    r = d->arch.paging.log_dirty.ring;
+    if ( r && frame + nr_frames <= r->nr_frames )
+    {
+        for ( i = 0; i < nr_frames; i++ )
+            mfn_list[i] = mfn_x(r->mfns[frame + i]);
+        rc = nr_frames;
+    }
+
+    paging_unlock(d);
+
+    return rc;
+}
+
 /* Mark a page as dirty, with taking guest pfn as parameter */
 void paging_mark_pfn_dirty(struct domain *d, pfn_t pfn)
 {
@@ -319,6 +508,8 @@ void paging_mark_pfn_dirty(struct domain *d, pfn_t pfn)
                      "d%d: marked mfn %" PRI_mfn " (pfn %" PRI_pfn ")\n",
                      d->domain_id, mfn_x(mfn), pfn_x(pfn));
         d->arch.paging.log_dirty.dirty_count++;
+        if ( d->arch.paging.log_dirty.ring )
+            log_dirty_ring_put(d->arch.paging.log_dirty.ring, pfn);
     }
 
 out:
@@ -438,6 +629,19 @@ static int paging_log_dirty_op(struct domain *d,
 
     clean = (sc->op == XEN_DOMCTL_SHADOW_OP_CLEAN);
 
+    if ( !d->arch.paging.preempt.dom && clean )
+    {
+        struct log_dirty_ring *r = d->arch.paging.log_dirty.ring;
+
+        if ( r )
+            rv = log_dirty_ring_clean(
+                     r, sc->mode & XEN_DOMCTL_SHADOW_LOGDIRTY_RING);
+        else if ( sc->mode & XEN_DOMCTL_SHADOW_LOGDIRTY_RING )
+            rv = -ENOENT;
+        if ( rv )
+            goto out;
+    }
+
     PAGING_DEBUG(LOGDIRTY, "log-dirty %s: dom %u faults=%lu dirty=%lu\n",
                  (clean) ? "clean" : "peek",
                  d->domain_id,
@@ -736,10 +940,18 @@ int paging_domctl(struct domain *d, struct xen_domctl_shadow_op *sc,
         break;
 
     case XEN_DOMCTL_SHADOW_OP_CLEAN:
+        if ( sc->mode & ~(XEN_DOMCTL_SHADOW_LOGDIRTY_FINAL |
+                          XEN_DOMCTL_SHADOW_LOGDIRTY_RING) )
+            return -EINVAL;
+        return paging_log_dirty_op(d, sc, resuming);
+
     case XEN_DOMCTL_SHADOW_OP_PEEK:
         if ( sc->mode & ~XEN_DOMCTL_SHADOW_LOGDIRTY_FINAL )
             return -EINVAL;
         return paging_log_dirty_op(d, sc, resuming);
+
+    case XEN_DOMCTL_SHADOW_OP_DIRTY_RING:
+        return log_dirty_ring_setup(d, sc->pages);
     }
 
     /* Here, dispatch domctl to the appropriate paging code */
@@ -819,6 +1031,19 @@ int paging_teardown(struct domain *d)
     rc = paging_free_log_dirty_bitmap(d, 0);
     if ( rc == -ERESTART )
         return rc;
+
+    if ( d->arch.paging.log_dirty.ring )
+    {
+        struct log_dirty_ring *r;
+
+        paging_lock(d);
+        r = d->arch.paging.log_dirty.ring;
+        d->arch.paging.log_dirty.ring = NULL;
+        d->arch.paging.log_dirty.ring_frames = 0;
+        paging_unlock(d);
+
+        log_dirty_ring_free(r);
+    }
 #endif
 
     /* Move populate-on-demand cache back to domain_list for destruction */
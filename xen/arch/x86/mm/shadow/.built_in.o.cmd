@@ -0,0 +1 @@
+cmd_arch/x86/mm/shadow/built_in.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o arch/x86/mm/shadow/built_in.o arch/x86/mm/shadow/common.o arch/x86/mm/shadow/set.o arch/x86/mm/shadow/hvm.o arch/x86/mm/shadow/guest_2.o arch/x86/mm/shadow/guest_3.o arch/x86/mm/shadow/guest_4.o arch/x86/mm/shadow/pv.o
@@ -0,0 +1 @@
+cmd_arch/x86/x86_64/built_in.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o arch/x86/x86_64/built_in.o arch/x86/x86_64/traps.o arch/x86/x86_64/machine_kexec.o arch/x86/x86_64/pci.o arch/x86/x86_64/acpi_mmcfg.o arch/x86/x86_64/mmconf-fam10h.o arch/x86/x86_64/mmconfig_64.o arch/x86/x86_64/mmconfig-shared.o arch/x86/x86_64/domain.o arch/x86/x86_64/cpu_idle.o arch/x86/x86_64/cpufreq.o arch/x86/x86_64/entry.o arch/x86/x86_64/kexec_reloc.o
@@ -0,0 +1,940 @@
+	.file	"asm-offsets.c"
+	.text
+#APP
+	.include "arch/x86/include/asm/asm-macros.h"
+	.equ X86_FEATURE_FPU, 0*32+ 0
+	.equ X86_FEATURE_VME, 0*32+ 1
+	.equ X86_FEATURE_DE, 0*32+ 2
+	.equ X86_FEATURE_PSE, 0*32+ 3
+	.equ X86_FEATURE_TSC, 0*32+ 4
+	.equ X86_FEATURE_MSR, 0*32+ 5
+	.equ X86_FEATURE_PAE, 0*32+ 6
+	.equ X86_FEATURE_MCE, 0*32+ 7
+	.equ X86_FEATURE_CX8, 0*32+ 8
+	.equ X86_FEATURE_APIC, 0*32+ 9
+	.equ X86_FEATURE_SEP, 0*32+11
+	.equ X86_FEATURE_MTRR, 0*32+12
+	.equ X86_FEATURE_PGE, 0*32+13
+	.equ X86_FEATURE_MCA, 0*32+14
+	.equ X86_FEATURE_CMOV, 0*32+15
+	.equ X86_FEATURE_PAT, 0*32+16
+	.equ X86_FEATURE_PSE36, 0*32+17
+	.equ X86_FEATURE_CLFLUSH, 0*32+19
+	.equ X86_FEATURE_DS, 0*32+21
+	.equ X86_FEATURE_ACPI, 0*32+22
+	.equ X86_FEATURE_MMX, 0*32+23
+	.equ X86_FEATURE_FXSR, 0*32+24
+	.equ X86_FEATURE_SSE, 0*32+25
+	.equ X86_FEATURE_SSE2, 0*32+26
+	.equ X86_FEATURE_SS, 0*32+27
+	.equ X86_FEATURE_HTT, 0*32+28
+	.equ X86_FEATURE_TM1, 0*32+29
+	.equ X86_FEATURE_PBE, 0*32+31
+	.equ X86_FEATURE_SSE3, 1*32+ 0
+	.equ X86_FEATURE_PCLMULQDQ, 1*32+ 1
+	.equ X86_FEATURE_DTES64, 1*32+ 2
+	.equ X86_FEATURE_MONITOR, 1*32+ 3
+	.equ X86_FEATURE_DSCPL, 1*32+ 4
+	.equ X86_FEATURE_VMX, 1*32+ 5
+	.equ X86_FEATURE_SMX, 1*32+ 6
+	.equ X86_FEATURE_EIST, 1*32+ 7
+	.equ X86_FEATURE_TM2, 1*32+ 8
+	.equ X86_FEATURE_SSSE3, 1*32+ 9
+	.equ X86_FEATURE_SDBG, 1*32+11
+	.equ X86_FEATURE_FMA, 1*32+12
+	.equ X86_FEATURE_CX16, 1*32+13
+	.equ X86_FEATURE_XTPR, 1*32+14
+	.equ X86_FEATURE_PDCM, 1*32+15
+	.equ X86_FEATURE_PCID, 1*32+17
+	.equ X86_FEATURE_DCA, 1*32+18
+	.equ X86_FEATURE_SSE4_1, 1*32+19
+	.equ X86_FEATURE_SSE4_2, 1*32+20
+	.equ X86_FEATURE_X2APIC, 1*32+21
+	.equ X86_FEATURE_MOVBE, 1*32+22
+	.equ X86_FEATURE_POPCNT, 1*32+23
+	.equ X86_FEATURE_TSC_DEADLINE, 1*32+24
+	.equ X86_FEATURE_AESNI, 1*32+25
+	.equ X86_FEATURE_XSAVE, 1*32+26
+	.equ X86_FEATURE_OSXSAVE, 1*32+27
+	.equ X86_FEATURE_AVX, 1*32+28
+	.equ X86_FEATURE_F16C, 1*32+29
+	.equ X86_FEATURE_RDRAND, 1*32+30
+	.equ X86_FEATURE_HYPERVISOR, 1*32+31
+	.equ X86_FEATURE_SYSCALL, 2*32+11
+	.equ X86_FEATURE_NX, 2*32+20
+	.equ X86_FEATURE_MMXEXT, 2*32+22
+	.equ X86_FEATURE_FFXSR, 2*32+25
+	.equ X86_FEATURE_PAGE1GB, 2*32+26
+	.equ X86_FEATURE_RDTSCP, 2*32+27
+	.equ X86_FEATURE_LM, 2*32+29
+	.equ X86_FEATURE_3DNOWEXT, 2*32+30
+	.equ X86_FEATURE_3DNOW, 2*32+31
+	.equ X86_FEATURE_LAHF_LM, 3*32+ 0
+	.equ X86_FEATURE_CMP_LEGACY, 3*32+ 1
+	.equ X86_FEATURE_SVM, 3*32+ 2
+	.equ X86_FEATURE_EXTAPIC, 3*32+ 3
+	.equ X86_FEATURE_CR8_LEGACY, 3*32+ 4
+	.equ X86_FEATURE_ABM, 3*32+ 5
+	.equ X86_FEATURE_SSE4A, 3*32+ 6
+	.equ X86_FEATURE_MISALIGNSSE, 3*32+ 7
+	.equ X86_FEATURE_3DNOWPREFETCH, 3*32+ 8
+	.equ X86_FEATURE_OSVW, 3*32+ 9
+	.equ X86_FEATURE_IBS, 3*32+10
+	.equ X86_FEATURE_XOP, 3*32+11
+	.equ X86_FEATURE_SKINIT, 3*32+12
+	.equ X86_FEATURE_WDT, 3*32+13
+	.equ X86_FEATURE_LWP, 3*32+15
+	.equ X86_FEATURE_FMA4, 3*32+16
+	.equ X86_FEATURE_NODEID_MSR, 3*32+19
+	.equ X86_FEATURE_TBM, 3*32+21
+	.equ X86_FEATURE_TOPOEXT, 3*32+22
+	.equ X86_FEATURE_DBEXT, 3*32+26
+	.equ X86_FEATURE_MONITORX, 3*32+29
+	.equ X86_FEATURE_ADDR_MSK_EXT, 3*32+30
+	.equ X86_FEATURE_XSAVEOPT, 4*32+ 0
+	.equ X86_FEATURE_XSAVEC, 4*32+ 1
+	.equ X86_FEATURE_XGETBV1, 4*32+ 2
+	.equ X86_FEATURE_XSAVES, 4*32+ 3
+	.equ X86_FEATURE_XFD, 4*32+ 4
+	.equ X86_FEATURE_FSGSBASE, 5*32+ 0
+	.equ X86_FEATURE_TSC_ADJUST, 5*32+ 1
+	.equ X86_FEATURE_SGX, 5*32+ 2
+	.equ X86_FEATURE_BMI1, 5*32+ 3
+	.equ X86_FEATURE_HLE, 5*32+ 4
+	.equ X86_FEATURE_AVX2, 5*32+ 5
+	.equ X86_FEATURE_FDP_EXCP_ONLY, 5*32+ 6
+	.equ X86_FEATURE_SMEP, 5*32+ 7
+	.equ X86_FEATURE_BMI2, 5*32+ 8
+	.equ X86_FEATURE_ERMS, 5*32+ 9
+	.equ X86_FEATURE_INVPCID, 5*32+10
+	.equ X86_FEATURE_RTM, 5*32+11
+	.equ X86_FEATURE_PQM, 5*32+12
+	.equ X86_FEATURE_NO_FPU_SEL, 5*32+13
+	.equ X86_FEATURE_MPX, 5*32+14
+	.equ X86_FEATURE_PQE, 5*32+15
+	.equ X86_FEATURE_AVX512F, 5*32+16
+	.equ X86_FEATURE_AVX512DQ, 5*32+17
+	.equ X86_FEATURE_RDSEED, 5*32+18
+	.equ X86_FEATURE_ADX, 5*32+19
+	.equ X86_FEATURE_SMAP, 5*32+20
+	.equ X86_FEATURE_AVX512_IFMA, 5*32+21
+	.equ X86_FEATURE_CLFLUSHOPT, 5*32+23
+	.equ X86_FEATURE_CLWB, 5*32+24
+	.equ X86_FEATURE_PROC_TRACE, 5*32+25
+	.equ X86_FEATURE_AVX512PF, 5*32+26
+	.equ X86_FEATURE_AVX512ER, 5*32+27
+	.equ X86_FEATURE_AVX512CD, 5*32+28
+	.equ X86_FEATURE_SHA, 5*32+29
+	.equ X86_FEATURE_AVX512BW, 5*32+30
+	.equ X86_FEATURE_AVX512VL, 5*32+31
+	.equ X86_FEATURE_PREFETCHWT1, 6*32+ 0
+	.equ X86_FEATURE_AVX512_VBMI, 6*32+ 1
+	.equ X86_FEATURE_UMIP, 6*32+ 2
+	.equ X86_FEATURE_PKU, 6*32+ 3
+	.equ X86_FEATURE_OSPKE, 6*32+ 4
+	.equ X86_FEATURE_WAITPKG, 6*32+ 5
+	.equ X86_FEATURE_AVX512_VBMI2, 6*32+ 6
+	.equ X86_FEATURE_CET_SS, 6*32+ 7
+	.equ X86_FEATURE_GFNI, 6*32+ 8
+	.equ X86_FEATURE_VAES, 6*32+ 9
+	.equ X86_FEATURE_VPCLMULQDQ, 6*32+10
+	.equ X86_FEATURE_AVX512_VNNI, 6*32+11
+	.equ X86_FEATURE_AVX512_BITALG, 6*32+12
+	.equ X86_FEATURE_TME, 6*32+13
+	.equ X86_FEATURE_AVX512_VPOPCNTDQ, 6*32+14
+	.equ X86_FEATURE_LA57, 6*32+16
+	.equ X86_FEATURE_RDPID, 6*32+22
+	.equ X86_FEATURE_BLD, 6*32+24
+	.equ X86_FEATURE_CLDEMOTE, 6*32+25
+	.equ X86_FEATURE_MOVDIRI, 6*32+27
+	.equ X86_FEATURE_MOVDIR64B, 6*32+28
+	.equ X86_FEATURE_ENQCMD, 6*32+29
+	.equ X86_FEATURE_SGX_LC, 6*32+30
+	.equ X86_FEATURE_PKS, 6*32+31
+	.equ X86_FEATURE_HW_PSTATE, 7*32+ 7
+	.equ X86_FEATURE_ITSC, 7*32+ 8
+	.equ X86_FEATURE_CPB, 7*32+ 9
+	.equ X86_FEATURE_EFRO, 7*32+10
+	.equ X86_FEATURE_CLZERO, 8*32+ 0
+	.equ X86_FEATURE_RSTR_FP_ERR_PTRS, 8*32+ 2
+	.equ X86_FEATURE_WBNOINVD, 8*32+ 9
+	.equ X86_FEATURE_IBPB, 8*32+12
+	.equ X86_FEATURE_IBRS, 8*32+14
+	.equ X86_FEATURE_AMD_STIBP, 8*32+15
+	.equ X86_FEATURE_IBRS_ALWAYS, 8*32+16
+	.equ X86_FEATURE_STIBP_ALWAYS, 8*32+17
+	.equ X86_FEATURE_IBRS_FAST, 8*32+18
+	.equ X86_FEATURE_IBRS_SAME_MODE, 8*32+19
+	.equ X86_FEATURE_NO_LMSL, 8*32+20
+	.equ X86_FEATURE_AMD_PPIN, 8*32+23
+	.equ X86_FEATURE_AMD_SSBD, 8*32+24
+	.equ X86_FEATURE_VIRT_SSBD, 8*32+25
+	.equ X86_FEATURE_SSB_NO, 8*32+26
+	.equ X86_FEATURE_CPPC, 8*32+27
+	.equ X86_FEATURE_PSFD, 8*32+28
+	.equ X86_FEATURE_BTC_NO, 8*32+29
+	.equ X86_FEATURE_IBPB_RET, 8*32+30
+	.equ X86_FEATURE_SGX_KEYS, 9*32+ 1
+	.equ X86_FEATURE_AVX512_4VNNIW, 9*32+ 2
+	.equ X86_FEATURE_AVX512_4FMAPS, 9*32+ 3
+	.equ X86_FEATURE_FSRM, 9*32+ 4
+	.equ X86_FEATURE_UINTR, 9*32+ 5
+	.equ X86_FEATURE_AVX512_VP2INTERSECT, 9*32+8
+	.equ X86_FEATURE_SRBDS_CTRL, 9*32+ 9
+	.equ X86_FEATURE_MD_CLEAR, 9*32+10
+	.equ X86_FEATURE_RTM_ALWAYS_ABORT, 9*32+11
+	.equ X86_FEATURE_TSX_FORCE_ABORT, 9*32+13
+	.equ X86_FEATURE_SERIALIZE, 9*32+14
+	.equ X86_FEATURE_HYBRID, 9*32+15
+	.equ X86_FEATURE_TSXLDTRK, 9*32+16
+	.equ X86_FEATURE_PCONFIG, 9*32+18
+	.equ X86_FEATURE_ARCH_LBR, 9*32+19
+	.equ X86_FEATURE_CET_IBT, 9*32+20
+	.equ X86_FEATURE_AMX_BF16, 9*32+22
+	.equ X86_FEATURE_AVX512_FP16, 9*32+23
+	.equ X86_FEATURE_AMX_TILE, 9*32+24
+	.equ X86_FEATURE_AMX_INT8, 9*32+25
+	.equ X86_FEATURE_IBRSB, 9*32+26
+	.equ X86_FEATURE_STIBP, 9*32+27
+	.equ X86_FEATURE_L1D_FLUSH, 9*32+28
+	.equ X86_FEATURE_ARCH_CAPS, 9*32+29
+	.equ X86_FEATURE_CORE_CAPS, 9*32+30
+	.equ X86_FEATURE_SSBD, 9*32+31
+	.equ X86_FEATURE_SHA512, 10*32+ 0
+	.equ X86_FEATURE_SM3, 10*32+ 1
+	.equ X86_FEATURE_SM4, 10*32+ 2
+	.equ X86_FEATURE_AVX_VNNI, 10*32+ 4
+	.equ X86_FEATURE_AVX512_BF16, 10*32+ 5
+	.equ X86_FEATURE_LASS, 10*32+ 6
+	.equ X86_FEATURE_CMPCCXADD, 10*32+ 7
+	.equ X86_FEATURE_ARCH_PERF_MON, 10*32+8
+	.equ X86_FEATURE_FZRM, 10*32+10
+	.equ X86_FEATURE_FSRS, 10*32+11
+	.equ X86_FEATURE_FSRCS, 10*32+12
+	.equ X86_FEATURE_WRMSRNS, 10*32+19
+	.equ X86_FEATURE_AMX_FP16, 10*32+21
+	.equ X86_FEATURE_AVX_IFMA, 10*32+23
+	.equ X86_FEATURE_LAM, 10*32+26
+	.equ X86_FEATURE_MSRLIST, 10*32+27
+	.equ X86_FEATURE_NO_INVD, 10*32+30
+	.equ X86_FEATURE_NO_NEST_BP, 11*32+ 0
+	.equ X86_FEATURE_FS_GS_NS, 11*32+ 1
+	.equ X86_FEATURE_LFENCE_DISPATCH, 11*32+ 2
+	.equ X86_FEATURE_NSCB, 11*32+ 6
+	.equ X86_FEATURE_AUTO_IBRS, 11*32+ 8
+	.equ X86_FEATURE_AMD_FSRS, 11*32+10
+	.equ X86_FEATURE_AMD_FSRC, 11*32+11
+	.equ X86_FEATURE_CPUID_USER_DIS, 11*32+17
+	.equ X86_FEATURE_EPSF, 11*32+18
+	.equ X86_FEATURE_FSRSC, 11*32+19
+	.equ X86_FEATURE_AMD_PREFETCHI, 11*32+20
+	.equ X86_FEATURE_SBPB, 11*32+27
+	.equ X86_FEATURE_IBPB_BRTYPE, 11*32+28
+	.equ X86_FEATURE_SRSO_NO, 11*32+29
+	.equ X86_FEATURE_SRSO_US_NO, 11*32+30
+	.equ X86_FEATURE_SRSO_MSR_FIX, 11*32+31
+	.equ X86_FEATURE_INTEL_PPIN, 12*32+ 0
+	.equ X86_FEATURE_INTEL_PSFD, 13*32+ 0
+	.equ X86_FEATURE_IPRED_CTRL, 13*32+ 1
+	.equ X86_FEATURE_RRSBA_CTRL, 13*32+ 2
+	.equ X86_FEATURE_DDP_CTRL, 13*32+ 3
+	.equ X86_FEATURE_BHI_CTRL, 13*32+ 4
+	.equ X86_FEATURE_MCDT_NO, 13*32+ 5
+	.equ X86_FEATURE_UC_LOCK_DIS, 13*32+ 6
+	.equ X86_FEATURE_AVX_VNNI_INT8, 15*32+ 4
+	.equ X86_FEATURE_AVX_NE_CONVERT, 15*32+ 5
+	.equ X86_FEATURE_AMX_COMPLEX, 15*32+ 8
+	.equ X86_FEATURE_AVX_VNNI_INT16, 15*32+10
+	.equ X86_FEATURE_PREFETCHI, 15*32+14
+	.equ X86_FEATURE_UIRET_UIF, 15*32+17
+	.equ X86_FEATURE_CET_SSS, 15*32+18
+	.equ X86_FEATURE_SLSM, 15*32+24
+	.equ X86_FEATURE_RDCL_NO, 16*32+ 0
+	.equ X86_FEATURE_EIBRS, 16*32+ 1
+	.equ X86_FEATURE_RSBA, 16*32+ 2
+	.equ X86_FEATURE_SKIP_L1DFL, 16*32+ 3
+	.equ X86_FEATURE_INTEL_SSB_NO, 16*32+ 4
+	.equ X86_FEATURE_MDS_NO, 16*32+ 5
+	.equ X86_FEATURE_IF_PSCHANGE_MC_NO, 16*32+ 6
+	.equ X86_FEATURE_TSX_CTRL, 16*32+ 7
+	.equ X86_FEATURE_TAA_NO, 16*32+ 8
+	.equ X86_FEATURE_MCU_CTRL, 16*32+ 9
+	.equ X86_FEATURE_MISC_PKG_CTRL, 16*32+10
+	.equ X86_FEATURE_ENERGY_FILTERING, 16*32+11
+	.equ X86_FEATURE_DOITM, 16*32+12
+	.equ X86_FEATURE_SBDR_SSDP_NO, 16*32+13
+	.equ X86_FEATURE_FBSDP_NO, 16*32+14
+	.equ X86_FEATURE_PSDP_NO, 16*32+15
+	.equ X86_FEATURE_MCU_EXT, 16*32+16
+	.equ X86_FEATURE_FB_CLEAR, 16*32+17
+	.equ X86_FEATURE_FB_CLEAR_CTRL, 16*32+18
+	.equ X86_FEATURE_RRSBA, 16*32+19
+	.equ X86_FEATURE_BHI_NO, 16*32+20
+	.equ X86_FEATURE_XAPIC_STATUS, 16*32+21
+	.equ X86_FEATURE_OVRCLK_STATUS, 16*32+23
+	.equ X86_FEATURE_PBRSB_NO, 16*32+24
+	.equ X86_FEATURE_GDS_CTRL, 16*32+25
+	.equ X86_FEATURE_GDS_NO, 16*32+26
+	.equ X86_FEATURE_RFDS_NO, 16*32+27
+	.equ X86_FEATURE_RFDS_CLEAR, 16*32+28
+	.equ X86_FEATURE_IGN_UMONITOR, 16*32+29
+	.equ X86_FEATURE_MON_UMON_MITG, 16*32+30
+	.equ X86_FEATURE_CONSTANT_TSC, (18 * 32 + (0))
+	.equ X86_FEATURE_NONSTOP_TSC, (18 * 32 + (1))
+	.equ X86_FEATURE_ARAT, (18 * 32 + (2))
+	.equ X86_FEATURE_ARCH_PERFMON, (18 * 32 + (3))
+	.equ X86_FEATURE_TSC_RELIABLE, (18 * 32 + (4))
+	.equ X86_FEATURE_XTOPOLOGY, (18 * 32 + (5))
+	.equ X86_FEATURE_CPUID_FAULTING, (18 * 32 + (6))
+	.equ X86_FEATURE_CLFLUSH_MONITOR, (18 * 32 + (7))
+	.equ X86_FEATURE_APERFMPERF, (18 * 32 + (8))
+	.equ X86_FEATURE_MFENCE_RDTSC, (18 * 32 + (9))
+	.equ X86_FEATURE_XEN_SMEP, (18 * 32 + (10))
+	.equ X86_FEATURE_XEN_SMAP, (18 * 32 + (11))
+	.equ X86_FEATURE_SC_NO_LOCK_HARDEN, (18 * 32 + (12))
+	.equ X86_FEATURE_IND_THUNK_LFENCE, (18 * 32 + (13))
+	.equ X86_FEATURE_IND_THUNK_JMP, (18 * 32 + (14))
+	.equ X86_FEATURE_SC_NO_BRANCH_HARDEN, (18 * 32 + (15))
+	.equ X86_FEATURE_SC_MSR_PV, (18 * 32 + (16))
+	.equ X86_FEATURE_SC_MSR_HVM, (18 * 32 + (17))
+	.equ X86_FEATURE_SC_RSB_PV, (18 * 32 + (18))
+	.equ X86_FEATURE_SC_RSB_HVM, (18 * 32 + (19))
+	.equ X86_FEATURE_XEN_SELFSNOOP, (18 * 32 + (20))
+	.equ X86_FEATURE_SC_MSR_IDLE, (18 * 32 + (21))
+	.equ X86_FEATURE_XEN_LBR, (18 * 32 + (22))
+	.equ X86_FEATURE_SC_DIV, (18 * 32 + (23))
+	.equ X86_FEATURE_SC_RSB_IDLE, (18 * 32 + (24))
+	.equ X86_FEATURE_SC_VERW_IDLE, (18 * 32 + (25))
+	.equ X86_FEATURE_XEN_SHSTK, (18 * 32 + (26))
+	.equ X86_FEATURE_XEN_IBT, (18 * 32 + (27))
+	.equ X86_FEATURE_IBPB_ENTRY_PV, (18 * 32 + (28))
+	.equ X86_FEATURE_IBPB_ENTRY_HVM, (18 * 32 + (29))
+	.equ CONFIG_INDIRECT_THUNK, 1
+#NO_APP
+	.section	.text.__dummy__,"ax",@progbits
+	.globl	__dummy__
+	.hidden	__dummy__
+	.type	__dummy__, @function
+__dummy__:
+#APP
+# 33 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_r15 $0 /* offsetof(struct cpu_user_regs, r15) */<=="
+# 0 "" 2
+# 34 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_r14 $8 /* offsetof(struct cpu_user_regs, r14) */<=="
+# 0 "" 2
+# 35 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_r13 $16 /* offsetof(struct cpu_user_regs, r13) */<=="
+# 0 "" 2
+# 36 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_r12 $24 /* offsetof(struct cpu_user_regs, r12) */<=="
+# 0 "" 2
+# 37 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_rbp $32 /* offsetof(struct cpu_user_regs, rbp) */<=="
+# 0 "" 2
+# 38 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_rbx $40 /* offsetof(struct cpu_user_regs, rbx) */<=="
+# 0 "" 2
+# 39 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_r11 $48 /* offsetof(struct cpu_user_regs, r11) */<=="
+# 0 "" 2
+# 40 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_r10 $56 /* offsetof(struct cpu_user_regs, r10) */<=="
+# 0 "" 2
+# 41 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_r9 $64 /* offsetof(struct cpu_user_regs, r9) */<=="
+# 0 "" 2
+# 42 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_r8 $72 /* offsetof(struct cpu_user_regs, r8) */<=="
+# 0 "" 2
+# 43 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_rax $80 /* offsetof(struct cpu_user_regs, rax) */<=="
+# 0 "" 2
+# 44 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_rcx $88 /* offsetof(struct cpu_user_regs, rcx) */<=="
+# 0 "" 2
+# 45 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_rdx $96 /* offsetof(struct cpu_user_regs, rdx) */<=="
+# 0 "" 2
+# 46 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_rsi $104 /* offsetof(struct cpu_user_regs, rsi) */<=="
+# 0 "" 2
+# 47 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_rdi $112 /* offsetof(struct cpu_user_regs, rdi) */<=="
+# 0 "" 2
+# 48 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_error_code $120 /* offsetof(struct cpu_user_regs, error_code) */<=="
+# 0 "" 2
+# 49 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_entry_vector $124 /* offsetof(struct cpu_user_regs, entry_vector) */<=="
+# 0 "" 2
+# 50 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_rip $128 /* offsetof(struct cpu_user_regs, rip) */<=="
+# 0 "" 2
+# 51 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_cs $136 /* offsetof(struct cpu_user_regs, cs) */<=="
+# 0 "" 2
+# 52 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_eflags $144 /* offsetof(struct cpu_user_regs, rflags) */<=="
+# 0 "" 2
+# 53 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_rsp $152 /* offsetof(struct cpu_user_regs, rsp) */<=="
+# 0 "" 2
+# 54 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_ss $160 /* offsetof(struct cpu_user_regs, ss) */<=="
+# 0 "" 2
+# 55 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define UREGS_kernel_sizeof $168 /* offsetof(struct cpu_user_regs, es) */<=="
+# 0 "" 2
+# 56 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 66 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define EFRAME_entry_vector $4 /* offsetof(struct cpu_user_regs, entry_vector) - offsetof(struct cpu_user_regs, error_code) */<=="
+# 0 "" 2
+# 67 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define EFRAME_rip $8 /* offsetof(struct cpu_user_regs, rip) - offsetof(struct cpu_user_regs, error_code) */<=="
+# 0 "" 2
+# 68 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define EFRAME_cs $16 /* offsetof(struct cpu_user_regs, cs) - offsetof(struct cpu_user_regs, error_code) */<=="
+# 0 "" 2
+# 69 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define EFRAME_eflags $24 /* offsetof(struct cpu_user_regs, eflags) - offsetof(struct cpu_user_regs, error_code) */<=="
+# 0 "" 2
+# 75 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define EFRAME_shadow_scf $28 /* offsetof(struct cpu_user_regs, eflags) - offsetof(struct cpu_user_regs, error_code) +4 */<=="
+# 0 "" 2
+# 76 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define EFRAME_shadow_sel $30 /* offsetof(struct cpu_user_regs, eflags) - offsetof(struct cpu_user_regs, error_code) +6 */<=="
+# 0 "" 2
+# 78 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define EFRAME_rsp $32 /* offsetof(struct cpu_user_regs, rsp) - offsetof(struct cpu_user_regs, error_code) */<=="
+# 0 "" 2
+# 79 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 83 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_processor $4 /* offsetof(struct vcpu, processor) */<=="
+# 0 "" 2
+# 84 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_domain $24 /* offsetof(struct vcpu, domain) */<=="
+# 0 "" 2
+# 85 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_vcpu_info $16 /* offsetof(struct vcpu, vcpu_info_area.map) */<=="
+# 0 "" 2
+# 86 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_trap_bounce $1520 /* offsetof(struct vcpu, arch.pv.trap_bounce) */<=="
+# 0 "" 2
+# 87 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_thread_flags $944 /* offsetof(struct vcpu, arch.flags) */<=="
+# 0 "" 2
+# 88 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_event_addr $1448 /* offsetof(struct vcpu, arch.pv.event_callback_eip) */<=="
+# 0 "" 2
+# 89 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_event_sel $1464 /* offsetof(struct vcpu, arch.pv.event_callback_cs) */<=="
+# 0 "" 2
+# 90 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_syscall_addr $1464 /* offsetof(struct vcpu, arch.pv.syscall_callback_eip) */<=="
+# 0 "" 2
+# 91 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_syscall32_addr $1472 /* offsetof(struct vcpu, arch.pv.syscall32_callback_eip) */<=="
+# 0 "" 2
+# 92 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_syscall32_sel $1488 /* offsetof(struct vcpu, arch.pv.syscall32_callback_cs) */<=="
+# 0 "" 2
+# 93 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_syscall32_disables_events $1492 /* offsetof(struct vcpu, arch.pv.syscall32_disables_events) */<=="
+# 0 "" 2
+# 95 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_sysenter_addr $1480 /* offsetof(struct vcpu, arch.pv.sysenter_callback_eip) */<=="
+# 0 "" 2
+# 96 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_sysenter_sel $1490 /* offsetof(struct vcpu, arch.pv.sysenter_callback_cs) */<=="
+# 0 "" 2
+# 97 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_sysenter_disables_events $1493 /* offsetof(struct vcpu, arch.pv.sysenter_disables_events) */<=="
+# 0 "" 2
+# 99 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_trap_ctxt $1232 /* offsetof(struct vcpu, arch.pv.trap_ctxt) */<=="
+# 0 "" 2
+# 100 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_kernel_sp $1376 /* offsetof(struct vcpu, arch.pv.kernel_sp) */<=="
+# 0 "" 2
+# 101 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_kernel_ss $1368 /* offsetof(struct vcpu, arch.pv.kernel_ss) */<=="
+# 0 "" 2
+# 102 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_iopl $1548 /* offsetof(struct vcpu, arch.pv.iopl) */<=="
+# 0 "" 2
+# 103 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_guest_context_flags $1224 /* offsetof(struct vcpu, arch.pv.vgc_flags) */<=="
+# 0 "" 2
+# 104 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_cr3 $2792 /* offsetof(struct vcpu, arch.cr3) */<=="
+# 0 "" 2
+# 105 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_arch_msrs $3368 /* offsetof(struct vcpu, arch.msrs) */<=="
+# 0 "" 2
+# 106 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_nmi_pending $1024 /* offsetof(struct vcpu, arch.async_exception_state[(1)-1].pending) */<=="
+# 0 "" 2
+# 107 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_mce_pending $1026 /* offsetof(struct vcpu, arch.async_exception_state[(2)-1].pending) */<=="
+# 0 "" 2
+# 108 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_nmi_old_mask $1025 /* offsetof(struct vcpu, arch.async_exception_state[(1)-1].old_mask) */<=="
+# 0 "" 2
+# 109 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_mce_old_mask $1027 /* offsetof(struct vcpu, arch.async_exception_state[(2)-1].old_mask) */<=="
+# 0 "" 2
+# 110 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_async_exception_mask $1028 /* offsetof(struct vcpu, arch.async_exception_mask) */<=="
+# 0 "" 2
+# 111 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_TRAP_NMI $1 /* VCPU_TRAP_NMI */<=="
+# 0 "" 2
+# 112 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_TRAP_MCE $2 /* VCPU_TRAP_MCE */<=="
+# 0 "" 2
+# 113 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define _VGCF_syscall_disables_events $4 /* _VGCF_syscall_disables_events */<=="
+# 0 "" 2
+# 114 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 117 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_svm_vmcb_pa $1544 /* offsetof(struct vcpu, arch.hvm.svm.vmcb_pa) */<=="
+# 0 "" 2
+# 118 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_svm_vmcb $1536 /* offsetof(struct vcpu, arch.hvm.svm.vmcb) */<=="
+# 0 "" 2
+# 119 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 121 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_vmx_launched $1588 /* offsetof(struct vcpu, arch.hvm.vmx.launched) */<=="
+# 0 "" 2
+# 122 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_vmx_realmode $1866 /* offsetof(struct vcpu, arch.hvm.vmx.vmx_realmode) */<=="
+# 0 "" 2
+# 123 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_vmx_emulate $1867 /* offsetof(struct vcpu, arch.hvm.vmx.vmx_emulate) */<=="
+# 0 "" 2
+# 124 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_vm86_seg_mask $1870 /* offsetof(struct vcpu, arch.hvm.vmx.vm86_segment_mask) */<=="
+# 0 "" 2
+# 125 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_hvm_guest_cr2 $1104 /* offsetof(struct vcpu, arch.hvm.guest_cr[2]) */<=="
+# 0 "" 2
+# 126 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 128 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_nhvm_guestmode $2088 /* offsetof(struct vcpu, arch.hvm.nvcpu.nv_guestmode) */<=="
+# 0 "" 2
+# 129 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_nhvm_p2m $2304 /* offsetof(struct vcpu, arch.hvm.nvcpu.nv_p2m) */<=="
+# 0 "" 2
+# 130 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPU_nsvm_hap_enabled $2260 /* offsetof(struct vcpu, arch.hvm.nvcpu.u.nsvm.ns_hap_enabled) */<=="
+# 0 "" 2
+# 131 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 144 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPUINFO_upcall_pending $0 /* offsetof(struct vcpu_info, evtchn_upcall_pending) */<=="
+# 0 "" 2
+# 145 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPUINFO_upcall_mask $1 /* offsetof(struct vcpu_info, evtchn_upcall_mask) */<=="
+# 0 "" 2
+# 146 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 149 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_guest_cpu_user_regs $0 /* offsetof(struct cpu_info, guest_cpu_user_regs) */<=="
+# 0 "" 2
+# 150 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_error_code $120 /* offsetof(struct cpu_info, guest_cpu_user_regs.error_code) */<=="
+# 0 "" 2
+# 151 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_rip $128 /* offsetof(struct cpu_info, guest_cpu_user_regs.rip) */<=="
+# 0 "" 2
+# 152 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_processor_id $200 /* offsetof(struct cpu_info, processor_id) */<=="
+# 0 "" 2
+# 153 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_verw_sel $204 /* offsetof(struct cpu_info, verw_sel) */<=="
+# 0 "" 2
+# 154 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_current_vcpu $208 /* offsetof(struct cpu_info, current_vcpu) */<=="
+# 0 "" 2
+# 155 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_per_cpu_offset $216 /* offsetof(struct cpu_info, per_cpu_offset) */<=="
+# 0 "" 2
+# 156 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_cr4 $224 /* offsetof(struct cpu_info, cr4) */<=="
+# 0 "" 2
+# 157 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_xen_cr3 $232 /* offsetof(struct cpu_info, xen_cr3) */<=="
+# 0 "" 2
+# 158 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_pv_cr3 $240 /* offsetof(struct cpu_info, pv_cr3) */<=="
+# 0 "" 2
+# 159 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_shadow_spec_ctrl $248 /* offsetof(struct cpu_info, shadow_spec_ctrl) */<=="
+# 0 "" 2
+# 160 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_xen_spec_ctrl $252 /* offsetof(struct cpu_info, xen_spec_ctrl) */<=="
+# 0 "" 2
+# 161 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_last_spec_ctrl $256 /* offsetof(struct cpu_info, last_spec_ctrl) */<=="
+# 0 "" 2
+# 162 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_scf $260 /* offsetof(struct cpu_info, scf) */<=="
+# 0 "" 2
+# 163 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_root_pgt_changed $261 /* offsetof(struct cpu_info, root_pgt_changed) */<=="
+# 0 "" 2
+# 164 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_use_pv_cr3 $262 /* offsetof(struct cpu_info, use_pv_cr3) */<=="
+# 0 "" 2
+# 165 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_sizeof $264 /* sizeof(struct cpu_info) */<=="
+# 0 "" 2
+# 166 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 169 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define TRAPINFO_eip $8 /* offsetof(struct trap_info, address) */<=="
+# 0 "" 2
+# 170 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define TRAPINFO_cs $2 /* offsetof(struct trap_info, cs) */<=="
+# 0 "" 2
+# 171 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define TRAPINFO_flags $1 /* offsetof(struct trap_info, flags) */<=="
+# 0 "" 2
+# 172 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define TRAPINFO_sizeof $16 /* sizeof(struct trap_info) */<=="
+# 0 "" 2
+# 173 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 175 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define TRAPBOUNCE_error_code $0 /* offsetof(struct trap_bounce, error_code) */<=="
+# 0 "" 2
+# 176 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define TRAPBOUNCE_flags $4 /* offsetof(struct trap_bounce, flags) */<=="
+# 0 "" 2
+# 177 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define TRAPBOUNCE_cs $6 /* offsetof(struct trap_bounce, cs) */<=="
+# 0 "" 2
+# 178 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define TRAPBOUNCE_eip $8 /* offsetof(struct trap_bounce, eip) */<=="
+# 0 "" 2
+# 179 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 182 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define VCPUMSR_spec_ctrl_raw $0 /* offsetof(struct vcpu_msrs, spec_ctrl.raw) */<=="
+# 0 "" 2
+# 183 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 186 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define ASM_PERFC_exceptions $0 /* PERFC_exceptions */<=="
+# 0 "" 2
+# 187 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 190 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define IRQSTAT_shift $7 /* ilog2(sizeof(irq_cpustat_t)) */<=="
+# 0 "" 2
+# 191 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define IRQSTAT_softirq_pending $0 /* offsetof(irq_cpustat_t, __softirq_pending) */<=="
+# 0 "" 2
+# 192 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 194 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define CPUINFO_features $12 /* offsetof(struct cpuinfo_x86, x86_capability) */<=="
+# 0 "" 2
+# 195 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 197 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define MB_flags $0 /* offsetof(multiboot_info_t, flags) */<=="
+# 0 "" 2
+# 198 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define MB_cmdline $16 /* offsetof(multiboot_info_t, cmdline) */<=="
+# 0 "" 2
+# 199 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define MB_mem_lower $4 /* offsetof(multiboot_info_t, mem_lower) */<=="
+# 0 "" 2
+# 200 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 202 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define MB2_fixed_sizeof $8 /* sizeof(multiboot2_fixed_t) */<=="
+# 0 "" 2
+# 203 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define MB2_fixed_total_size $0 /* offsetof(multiboot2_fixed_t, total_size) */<=="
+# 0 "" 2
+# 204 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define MB2_tag_type $0 /* offsetof(multiboot2_tag_t, type) */<=="
+# 0 "" 2
+# 205 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define MB2_tag_size $4 /* offsetof(multiboot2_tag_t, size) */<=="
+# 0 "" 2
+# 206 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define MB2_load_base_addr $8 /* offsetof(multiboot2_tag_load_base_addr_t, load_base_addr) */<=="
+# 0 "" 2
+# 207 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define MB2_mem_lower $8 /* offsetof(multiboot2_tag_basic_meminfo_t, mem_lower) */<=="
+# 0 "" 2
+# 208 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define MB2_efi64_st $8 /* offsetof(multiboot2_tag_efi64_t, pointer) */<=="
+# 0 "" 2
+# 209 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define MB2_efi64_ih $8 /* offsetof(multiboot2_tag_efi64_ih_t, pointer) */<=="
+# 0 "" 2
+# 210 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define MB2_tag_string $8 /* offsetof(multiboot2_tag_string_t, string) */<=="
+# 0 "" 2
+# 211 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 213 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define DOMAIN_vm_assist $640 /* offsetof(struct domain, vm_assist) */<=="
+# 0 "" 2
+# 214 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+# 217 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_cursor_pos $0 /* offsetof(struct boot_video_info, orig_x) */<=="
+# 0 "" 2
+# 218 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_video_mode $2 /* offsetof(struct boot_video_info, orig_video_mode) */<=="
+# 0 "" 2
+# 219 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_video_cols $3 /* offsetof(struct boot_video_info, orig_video_cols) */<=="
+# 0 "" 2
+# 220 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_video_lines $4 /* offsetof(struct boot_video_info, orig_video_lines) */<=="
+# 0 "" 2
+# 221 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_have_vga $5 /* offsetof(struct boot_video_info, orig_video_isVGA) */<=="
+# 0 "" 2
+# 222 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_font_points $6 /* offsetof(struct boot_video_info, orig_video_points) */<=="
+# 0 "" 2
+# 223 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_capabilities $8 /* offsetof(struct boot_video_info, capabilities) */<=="
+# 0 "" 2
+# 224 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_lfb_linelength $12 /* offsetof(struct boot_video_info, lfb_linelength) */<=="
+# 0 "" 2
+# 225 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_lfb_width $14 /* offsetof(struct boot_video_info, lfb_width) */<=="
+# 0 "" 2
+# 226 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_lfb_height $16 /* offsetof(struct boot_video_info, lfb_height) */<=="
+# 0 "" 2
+# 227 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_lfb_depth $18 /* offsetof(struct boot_video_info, lfb_depth) */<=="
+# 0 "" 2
+# 228 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_lfb_base $20 /* offsetof(struct boot_video_info, lfb_base) */<=="
+# 0 "" 2
+# 229 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_lfb_size $24 /* offsetof(struct boot_video_info, lfb_size) */<=="
+# 0 "" 2
+# 230 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_lfb_colors $28 /* offsetof(struct boot_video_info, colors) */<=="
+# 0 "" 2
+# 231 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_vesapm_seg $36 /* offsetof(struct boot_video_info, vesapm.seg) */<=="
+# 0 "" 2
+# 232 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_vesapm_off $38 /* offsetof(struct boot_video_info, vesapm.off) */<=="
+# 0 "" 2
+# 233 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_vesa_attrib $40 /* offsetof(struct boot_video_info, vesa_attrib) */<=="
+# 0 "" 2
+# 234 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==>#define BVI_size $44 /* sizeof(struct boot_video_info) */<=="
+# 0 "" 2
+# 235 "arch/x86/x86_64/asm-offsets.c" 1
+	
+.ascii"==><=="
+# 0 "" 2
+#NO_APP
+	ret
+	.size	__dummy__, .-__dummy__
+	.ident	"GCC: (Debian 12.2.0-14+deb12u1) 12.2.0"
+	.section	.note.GNU-stack,"",@progbits
+	.section	.note.gnu.property,"a"
+	.align 8
+	.long	1f - 0f
+	.long	4f - 1f
+	.long	5
+0:
+	.string	"GNU"
+1:
+	.align 8
+	.long	0xc0000002
+	.long	3f - 2f
+2:
+	.long	0x1
+3:
+	.align 8
+4:
@@ -66,10 +66,18 @@ CHECK_evtchn_init_control;
 CHECK_evtchn_reset;
 #undef xen_evtchn_reset
 
+#define xen_evtchn_set_moderation evtchn_set_moderation
+CHECK_evtchn_set_moderation;
+#undef xen_evtchn_set_moderation
+
 #define xen_evtchn_set_priority evtchn_set_priority
 CHECK_evtchn_set_priority;
 #undef xen_evtchn_set_priority
 
+#define xen_evtchn_send_multi evtchn_send_multi
+CHECK_evtchn_send_multi;
+#undef xen_evtchn_send_multi
+
 #define xen_mmu_update mmu_update
 CHECK_mmu_update;
 #undef xen_mmu_update
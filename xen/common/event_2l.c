@@ -36,7 +36,7 @@ static void cf_check evtchn_2l_set_pending(
          !guest_test_and_set_bit(d, port / BITS_PER_EVTCHN_WORD(d),
                                  &vcpu_info(v, evtchn_pending_sel)) )
     {
-        vcpu_mark_events_pending(v);
+        evtchn_mark_pending(v);
     }
 
     evtchn_check_pollers(d, port);
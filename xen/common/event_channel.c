@@ -27,6 +27,7 @@
 #include <xen/hypercall.h>
 #include <xen/keyhandler.h>
 #include <xen/sections.h>
+#include <xen/timer.h>
 
 #include <asm/current.h>
 
@@ -40,6 +41,32 @@
 
 #define consumer_is_xen(e) (!!(e)->xen_consumer)
 
+/*
+ * Upcalls raised while processing EVTCHNOP_send_multi are recorded here and
+ * only delivered once all the ports in the batch have been made pending, so
+ * that each target vCPU is notified at most once.
+ */
+struct evtchn_batch {
+    bool active;
+    unsigned int nr;
+    struct vcpu *vcpus[EVTCHN_SEND_MULTI_MAX];
+};
+static DEFINE_PER_CPU(struct evtchn_batch, evtchn_batch);
+
+/* Per-port moderation state, see EVTCHNOP_set_moderation. */
+struct evtchn_moderation {
+    spinlock_t lock;
+    struct timer timer;
+    struct domain *d;
+    evtchn_port_t port;
+    s_time_t interval;      /* Minimum time between deliveries, 0 if off. */
+    unsigned int count;     /* Deliver once this many events are held. */
+    unsigned int held;      /* Events held since the last delivery. */
+    s_time_t last;          /* Time of the last delivery. */
+    unsigned long delivered;
+    unsigned long suppressed;
+};
+
 /*
  * Lock an event channel exclusively. This is allowed only when the channel is
  * free or unbound either when taking or when releasing the lock, as any
@@ -279,11 +306,48 @@ static void check_free_port(struct domain *d, evtchn_port_t port)
         write_atomic(&d->active_evtchns, d->active_evtchns - 1);
 }
 
+static void evtchn_moderation_free(struct domain *d, struct evtchn *chn)
+{
+    unsigned int idx = chn->moderation - 1;
+    struct evtchn_moderation *mod = d->evtchn_moderation[idx];
+
+    /*
+     * The timer handler only try-locks the channel, which is locked for
+     * writing by our caller, so it can't block waiting for us.
+     */
+    kill_timer(&mod->timer);
+
+    chn->moderation = 0;
+    d->evtchn_moderation[idx] = NULL;
+    xfree(mod);
+}
+
+/*
+ * Forget about the events held and the time of the last delivery on a port
+ * whose remote end has gone away, keeping the settings for a new binding.
+ */
+static void evtchn_moderation_reset(struct domain *d, struct evtchn *chn)
+{
+    struct evtchn_moderation *mod = d->evtchn_moderation[chn->moderation - 1];
+    unsigned long flags;
+
+    stop_timer(&mod->timer);
+
+    spin_lock_irqsave(&mod->lock, flags);
+    mod->held = 0;
+    mod->last = 0;
+    spin_unlock_irqrestore(&mod->lock, flags);
+}
+
 void evtchn_free(struct domain *d, struct evtchn *chn)
 {
     /* Clear pending event to avoid unexpected behavior on re-bind. */
     evtchn_port_clear_pending(d, chn);
 
+    /* Events held by moderation are dropped together with the binding. */
+    if ( chn->moderation )
+        evtchn_moderation_free(d, chn);
+
     if ( consumer_is_xen(chn) )
     {
         write_atomic(&d->xen_evtchns, d->xen_evtchns - 1);
@@ -815,6 +879,9 @@ int evtchn_close(struct domain *d1, int port1, bool guest)
         chn2->state = ECS_UNBOUND;
         chn2->u.unbound.remote_domid = d1->domain_id;
 
+        if ( chn2->moderation )
+            evtchn_moderation_reset(d2, chn2);
+
         double_evtchn_unlock(chn1, chn2);
 
         goto out;
@@ -899,6 +966,75 @@ out:
     return ret;
 }
 
+void evtchn_mark_pending(struct vcpu *v)
+{
+    struct evtchn_batch *batch = &this_cpu(evtchn_batch);
+    unsigned int i;
+
+    /* Events raised from interrupt context are never part of a batch. */
+    if ( likely(!batch->active) || in_irq() )
+    {
+        vcpu_mark_events_pending(v);
+        return;
+    }
+
+    for ( i = 0; i < batch->nr; i++ )
+        if ( batch->vcpus[i] == v )
+        {
+            perfc_incr(evtchn_multi_coalesced);
+            return;
+        }
+
+    /*
+     * Each port sent normally adds at most one vCPU to the batch, but Xen
+     * consumers may raise further events: deliver those right away should
+     * the batch be full.
+     */
+    if ( batch->nr < ARRAY_SIZE(batch->vcpus) )
+        batch->vcpus[batch->nr++] = v;
+    else
+        vcpu_mark_events_pending(v);
+}
+
+static int evtchn_send_multi(struct domain *ld,
+                             struct evtchn_send_multi *send_multi)
+{
+    struct evtchn_batch *batch = &this_cpu(evtchn_batch);
+    unsigned int i;
+    int rc = 0;
+
+    if ( send_multi->nr_ports > ARRAY_SIZE(send_multi->ports) )
+        return -EINVAL;
+
+    /*
+     * Remote domains (and their vCPUs) must not go away before the deferred
+     * upcalls have been delivered.
+     */
+    rcu_read_lock(&domlist_read_lock);
+
+    ASSERT(!batch->active);
+    batch->active = true;
+    batch->nr = 0;
+
+    for ( i = 0; i < send_multi->nr_ports; i++ )
+    {
+        rc = evtchn_send(ld, send_multi->ports[i]);
+        if ( rc )
+            break;
+    }
+    send_multi->nr_sent = i;
+    perfc_add(evtchn_multi_ports, i);
+
+    batch->active = false;
+
+    for ( i = 0; i < batch->nr; i++ )
+        vcpu_mark_events_pending(batch->vcpus[i]);
+
+    rcu_read_unlock(&domlist_read_lock);
+
+    return rc;
+}
+
 bool evtchn_virq_enabled(const struct vcpu *v, unsigned int virq)
 {
     if ( !v )
@@ -1328,6 +1464,165 @@ int evtchn_reset(struct domain *d, bool resuming)
     return rc;
 }
 
+bool evtchn_moderation_hold(struct domain *d, struct evtchn *evtchn)
+{
+    struct evtchn_moderation *mod;
+    unsigned long flags;
+    s_time_t now;
+    bool hold = false;
+
+    /* Pairs with the smp_wmb() in evtchn_set_moderation(). */
+    smp_rmb();
+    mod = d->evtchn_moderation[evtchn->moderation - 1];
+
+    spin_lock_irqsave(&mod->lock, flags);
+
+    if ( !mod->interval )
+        goto out;
+
+    now = NOW();
+    if ( now - mod->last >= mod->interval ||
+         (mod->count && mod->held + 1 >= mod->count) )
+    {
+        /* Deliver now, together with any events held. */
+        mod->held = 0;
+        mod->last = now;
+        mod->delivered++;
+        perfc_incr(evtchn_mod_delivered);
+        goto out;
+    }
+
+    if ( !mod->held++ )
+        set_timer(&mod->timer, mod->last + mod->interval);
+    mod->suppressed++;
+    perfc_incr(evtchn_mod_suppressed);
+    hold = true;
+
+ out:
+    spin_unlock_irqrestore(&mod->lock, flags);
+
+    return hold;
+}
+
+static void cf_check evtchn_moderation_timer(void *data)
+{
+    struct evtchn_moderation *mod = data;
+    struct domain *d = mod->d;
+    struct evtchn *chn = evtchn_from_port(d, mod->port);
+    unsigned long flags;
+    bool deliver;
+
+    if ( !evtchn_read_trylock(chn) )
+    {
+        /* The channel is being (re)bound or closed, retry shortly. */
+        set_timer(&mod->timer, NOW() + MICROSECS(10));
+        return;
+    }
+
+    spin_lock_irqsave(&mod->lock, flags);
+    deliver = mod->held;
+    if ( deliver )
+    {
+        mod->held = 0;
+        mod->last = NOW();
+        mod->delivered++;
+        perfc_incr(evtchn_mod_delivered);
+    }
+    spin_unlock_irqrestore(&mod->lock, flags);
+
+    /*
+     * The events held were accounted for above, so mark the port pending
+     * without going through the moderation check again.  Concurrent senders
+     * keep being moderated against the delivery time just recorded.
+     */
+    if ( deliver && evtchn_usable(chn) )
+        d->evtchn_port_ops->set_pending(d->vcpu[chn->notify_vcpu_id], chn);
+
+    evtchn_read_unlock(chn);
+}
+
+static int evtchn_set_moderation(const struct evtchn_set_moderation *set)
+{
+    struct domain *d = current->domain;
+    struct evtchn *chn;
+    struct evtchn_moderation *mod = NULL;
+    unsigned long flags;
+    unsigned int idx;
+    int rc = 0;
+
+    if ( set->count && !set->interval_us )
+        return -EINVAL;
+
+    write_lock(&d->event_lock);
+
+    chn = _evtchn_from_port(d, set->port);
+    if ( !chn || chn->state == ECS_FREE || consumer_is_xen(chn) )
+    {
+        rc = -EINVAL;
+        goto out;
+    }
+
+    if ( !chn->moderation )
+    {
+        if ( !set->interval_us )
+            goto out;
+
+        if ( !d->evtchn_moderation )
+        {
+            d->evtchn_moderation =
+                xzalloc_array(struct evtchn_moderation *,
+                              EVTCHN_MODERATION_MAX);
+            if ( !d->evtchn_moderation )
+            {
+                rc = -ENOMEM;
+                goto out;
+            }
+        }
+
+        for ( idx = 0; idx < EVTCHN_MODERATION_MAX; idx++ )
+            if ( !d->evtchn_moderation[idx] )
+                break;
+        if ( idx == EVTCHN_MODERATION_MAX )
+        {
+            rc = -ENOSPC;
+            goto out;
+        }
+
+        mod = xzalloc(struct evtchn_moderation);
+        if ( !mod )
+        {
+            rc = -ENOMEM;
+            goto out;
+        }
+
+        spin_lock_init(&mod->lock);
+        init_timer(&mod->timer, evtchn_moderation_timer, mod,
+                   smp_processor_id());
+        mod->d = d;
+        mod->port = set->port;
+
+        d->evtchn_moderation[idx] = mod;
+        /* Publish the state before the channel starts using it. */
+        smp_wmb();
+        write_atomic(&chn->moderation, idx + 1);
+    }
+    else
+        mod = d->evtchn_moderation[chn->moderation - 1];
+
+    spin_lock_irqsave(&mod->lock, flags);
+    mod->interval = MICROSECS(set->interval_us);
+    mod->count = set->count;
+    /* Flush anything held under the previous settings. */
+    if ( mod->held )
+        set_timer(&mod->timer, NOW());
+    spin_unlock_irqrestore(&mod->lock, flags);
+
+ out:
+    write_unlock(&d->event_lock);
+
+    return rc;
+}
+
 static int evtchn_set_priority(const struct evtchn_set_priority *set_priority)
 {
     struct domain *d = current->domain;
@@ -1423,6 +1718,16 @@ long do_event_channel_op(int cmd, XEN_GUEST_HANDLE_PARAM(void) arg)
         break;
     }
 
+    case EVTCHNOP_send_multi: {
+        struct evtchn_send_multi send_multi;
+        if ( copy_from_guest(&send_multi, arg, 1) != 0 )
+            return -EFAULT;
+        rc = evtchn_send_multi(current->domain, &send_multi);
+        if ( __copy_to_guest(arg, &send_multi, 1) )
+            rc = -EFAULT;
+        break;
+    }
+
     case EVTCHNOP_status: {
         struct evtchn_status status;
         if ( copy_from_guest(&status, arg, 1) != 0 )
@@ -1491,6 +1796,14 @@ long do_event_channel_op(int cmd, XEN_GUEST_HANDLE_PARAM(void) arg)
         break;
     }
 
+    case EVTCHNOP_set_moderation: {
+        struct evtchn_set_moderation set_moderation;
+        if ( copy_from_guest(&set_moderation, arg, 1) != 0 )
+            return -EFAULT;
+        rc = evtchn_set_moderation(&set_moderation);
+        break;
+    }
+
     case EVTCHNOP_set_priority: {
         struct evtchn_set_priority set_priority;
         if ( copy_from_guest(&set_priority, arg, 1) != 0 )
@@ -1700,6 +2013,8 @@ void evtchn_destroy_final(struct domain *d)
     }
     free_evtchn_bucket(d, d->evtchn);
 
+    XFREE(d->evtchn_moderation);
+
 #if MAX_VIRT_CPUS > BITS_PER_LONG
     xfree(d->poll_mask);
     d->poll_mask = NULL;
@@ -1773,6 +2088,16 @@ static void domain_dump_evtchn_info(struct domain *d)
             break;
         }
 
+        if ( chn->moderation )
+        {
+            const struct evtchn_moderation *mod =
+                d->evtchn_moderation[chn->moderation - 1];
+
+            printk(" M=%"PRI_stime"us/%u d=%lu s=%lu",
+                   mod->interval / MICROSECS(1), mod->count,
+                   mod->delivered, mod->suppressed);
+        }
+
         ssid = xsm_show_security_evtchn(d, chn);
         if (ssid) {
             printk(" Z=%s\n", ssid);
@@ -39,6 +39,12 @@ static inline void evtchn_port_print_state(struct domain *d,
     d->evtchn_port_ops->print_state(d, evtchn);
 }
 
+/*
+ * Notify a vCPU of events having become pending, possibly deferring the
+ * notification to the end of the EVTCHNOP_send_multi batch being processed.
+ */
+void evtchn_mark_pending(struct vcpu *v);
+
 /* 2-level */
 
 void evtchn_2l_init(struct domain *d);
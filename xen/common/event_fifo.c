@@ -312,7 +312,7 @@ static void cf_check evtchn_fifo_set_pending(
     if ( !linked &&
          !guest_test_and_set_bit(d, q->priority,
                                  &v->evtchn_fifo->control_block->ready) )
-        vcpu_mark_events_pending(v);
+        evtchn_mark_pending(v);
 
     if ( check_pollers )
         evtchn_check_pollers(d, port);
@@ -1686,6 +1686,8 @@ gnttab_unmap_grant_ref(
         c = min(count, (unsigned int)GNTTAB_UNMAP_BATCH_SIZE);
         partial_done = 0;
 
+        iommu_flush_batch_begin();
+
         for ( i = 0; i < c; i++ )
         {
             if ( unlikely(__copy_from_guest(&op, uop, 1)) )
@@ -1697,6 +1699,7 @@ gnttab_unmap_grant_ref(
             guest_handle_add_offset(uop, 1);
         }
 
+        iommu_flush_batch_end();
         gnttab_flush_tlb(current->domain);
 
         for ( i = 0; i < partial_done; i++ )
@@ -1712,6 +1715,7 @@ gnttab_unmap_grant_ref(
     return 0;
 
 fault:
+    iommu_flush_batch_end();
     gnttab_flush_tlb(current->domain);
 
     for ( i = 0; i < partial_done; i++ )
@@ -1751,6 +1755,8 @@ gnttab_unmap_and_replace(
         c = min(count, (unsigned int)GNTTAB_UNMAP_BATCH_SIZE);
         partial_done = 0;
 
+        iommu_flush_batch_begin();
+
         for ( i = 0; i < c; i++ )
         {
             if ( unlikely(__copy_from_guest(&op, uop, 1)) )
@@ -1762,6 +1768,7 @@ gnttab_unmap_and_replace(
             guest_handle_add_offset(uop, 1);
         }
 
+        iommu_flush_batch_end();
         gnttab_flush_tlb(current->domain);
 
         for ( i = 0; i < partial_done; i++ )
@@ -1777,6 +1784,7 @@ gnttab_unmap_and_replace(
     return 0;
 
 fault:
+    iommu_flush_batch_end();
     gnttab_flush_tlb(current->domain);
 
     for ( i = 0; i < partial_done; i++ )
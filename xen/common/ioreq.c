@@ -26,6 +26,7 @@
 #include <xen/paging.h>
 #include <xen/sched.h>
 #include <xen/trace.h>
+#include <xen/vmap.h>
 
 #include <asm/guest_atomics.h>
 #include <asm/ioreq.h>
@@ -323,10 +324,92 @@ static void ioreq_server_free_mfn(struct ioreq_server *s, bool buf)
     put_page_and_type(page);
 }
 
+static void ioreq_server_free_posted(struct ioreq_server *s)
+{
+    struct ioreq_posted_ring *ring = &s->posted;
+    unsigned int i;
+
+    if ( ring->slot )
+        vunmap(ring->slot);
+    if ( ring->ctrl )
+        unmap_domain_page_global(ring->ctrl);
+
+    for ( i = 0; i < ring->nr_pages; i++ )
+    {
+        put_page_alloc_ref(ring->pages[i]);
+        put_page_and_type(ring->pages[i]);
+    }
+
+    XFREE(ring->pages);
+    ring->nr_pages = 0;
+    ring->ctrl = NULL;
+    ring->slot = NULL;
+    ring->nr_slots = 0;
+}
+
+static int ioreq_server_alloc_posted(struct ioreq_server *s,
+                                     unsigned int nr_frames)
+{
+    struct ioreq_posted_ring *ring = &s->posted;
+    unsigned int i;
+    mfn_t *mfns;
+    int rc = -ENOMEM;
+
+    ASSERT(!ring->pages);
+
+    /* One control page followed by nr_frames slot pages. */
+    ring->pages = xzalloc_array(struct page_info *, nr_frames + 1);
+    mfns = xmalloc_array(mfn_t, nr_frames);
+    if ( !ring->pages || !mfns )
+        goto fail;
+
+    for ( i = 0; i <= nr_frames; i++ )
+    {
+        struct page_info *page = alloc_domheap_page(s->target,
+                                                    MEMF_no_refcount);
+
+        if ( !page )
+            goto fail;
+
+        if ( !get_page_and_type(page, s->target, PGT_writable_page) )
+        {
+            /* See ioreq_server_alloc_mfn(). */
+            domain_crash(s->emulator);
+            rc = -ENODATA;
+            goto fail;
+        }
+
+        ring->pages[ring->nr_pages++] = page;
+        if ( i )
+            mfns[i - 1] = page_to_mfn(page);
+    }
+
+    ring->ctrl = __map_domain_page_global(ring->pages[0]);
+    ring->slot = vmap(mfns, nr_frames);
+    if ( !ring->ctrl || !ring->slot )
+        goto fail;
+
+    xfree(mfns);
+
+    clear_page(ring->ctrl);
+    memset(ring->slot, 0, nr_frames * PAGE_SIZE);
+
+    ring->nr_slots = nr_frames * POSTED_IOREQ_SLOTS_PER_PAGE;
+    ring->ctrl->nr_slots = ring->nr_slots;
+
+    return 0;
+
+ fail:
+    xfree(mfns);
+    ioreq_server_free_posted(s);
+
+    return rc;
+}
+
 bool is_ioreq_server_page(struct domain *d, const struct page_info *page)
 {
     const struct ioreq_server *s;
-    unsigned int id;
+    unsigned int id, i;
     bool found = false;
 
     rspin_lock(&d->ioreq_server.lock);
@@ -338,6 +421,13 @@ bool is_ioreq_server_page(struct domain *d, const struct page_info *page)
             found = true;
             break;
         }
+
+        for ( i = 0; i < s->posted.nr_pages; i++ )
+            if ( s->posted.pages[i] == page )
+                found = true;
+
+        if ( found )
+            break;
     }
 
     rspin_unlock(&d->ioreq_server.lock);
@@ -509,6 +599,7 @@ static int ioreq_server_alloc_rangesets(struct ioreq_server *s,
         case XEN_DMOP_IO_RANGE_PORT:   type = " port";   break;
         case XEN_DMOP_IO_RANGE_MEMORY: type = " memory"; break;
         case XEN_DMOP_IO_RANGE_PCI:    type = " pci";    break;
+        case XEN_DMOP_IO_RANGE_POSTED: type = " posted"; break;
         default:                       type = "";        break;
         }
 
@@ -634,6 +725,7 @@ static void ioreq_server_deinit(struct ioreq_server *s)
      */
     arch_ioreq_server_unmap_pages(s);
     ioreq_server_free_pages(s);
+    ioreq_server_free_posted(s);
 
     ioreq_server_free_rangesets(s);
 
@@ -830,6 +922,17 @@ int ioreq_server_get_frame(struct domain *d, ioservid_t id,
 
     default:
         rc = -EINVAL;
+        if ( idx < XENMEM_resource_ioreq_server_frame_posted(0) )
+            break;
+
+        idx -= XENMEM_resource_ioreq_server_frame_posted(0);
+
+        rc = -ENOENT;
+        if ( idx >= s->posted.nr_pages )
+            break;
+
+        *mfn = page_to_mfn(s->posted.pages[idx]);
+        rc = 0;
         break;
     }
 
@@ -867,6 +970,7 @@ static int ioreq_server_map_io_range(struct domain *d, ioservid_t id,
     case XEN_DMOP_IO_RANGE_PORT:
     case XEN_DMOP_IO_RANGE_MEMORY:
     case XEN_DMOP_IO_RANGE_PCI:
+    case XEN_DMOP_IO_RANGE_POSTED:
         r = s->range[type];
         break;
 
@@ -883,6 +987,15 @@ static int ioreq_server_map_io_range(struct domain *d, ioservid_t id,
     if ( rangeset_overlaps_range(r, start, end) )
         goto out;
 
+    /* Posted ranges are MMIO ranges too, so the two must not overlap. */
+    if ( (type == XEN_DMOP_IO_RANGE_MEMORY &&
+          rangeset_overlaps_range(s->range[XEN_DMOP_IO_RANGE_POSTED],
+                                  start, end)) ||
+         (type == XEN_DMOP_IO_RANGE_POSTED &&
+          rangeset_overlaps_range(s->range[XEN_DMOP_IO_RANGE_MEMORY],
+                                  start, end)) )
+        goto out;
+
     rc = rangeset_add_range(r, start, end);
 
  out:
@@ -919,6 +1032,7 @@ static int ioreq_server_unmap_io_range(struct domain *d, ioservid_t id,
     case XEN_DMOP_IO_RANGE_PORT:
     case XEN_DMOP_IO_RANGE_MEMORY:
     case XEN_DMOP_IO_RANGE_PCI:
+    case XEN_DMOP_IO_RANGE_POSTED:
         r = s->range[type];
         break;
 
@@ -986,6 +1100,49 @@ int ioreq_server_map_mem_type(struct domain *d, ioservid_t id,
     return rc;
 }
 
+static int ioreq_server_set_posted_ring(struct domain *d, ioservid_t id,
+                                        unsigned int nr_frames)
+{
+    struct ioreq_server *s;
+    int rc;
+
+    if ( !nr_frames || nr_frames > XEN_DMOP_POSTED_RING_MAX_FRAMES ||
+         (nr_frames & (nr_frames - 1)) )
+        return -EINVAL;
+
+    rspin_lock(&d->ioreq_server.lock);
+
+    s = get_ioreq_server(d, id);
+
+    rc = -ENOENT;
+    if ( !s )
+        goto out;
+
+    rc = -EPERM;
+    if ( s->emulator != current->domain )
+        goto out;
+
+    /* Posted writes are signalled on the buffered ioreq event channel. */
+    rc = -EOPNOTSUPP;
+    if ( !HANDLE_BUFIOREQ(s) )
+        goto out;
+
+    rc = -EBUSY;
+    if ( s->enabled )
+        goto out;
+
+    rc = -EEXIST;
+    if ( s->posted.pages )
+        goto out;
+
+    rc = ioreq_server_alloc_posted(s, nr_frames);
+
+ out:
+    rspin_unlock(&d->ioreq_server.lock);
+
+    return rc;
+}
+
 static int ioreq_server_set_state(struct domain *d, ioservid_t id,
                                   bool enabled)
 {
@@ -1133,7 +1290,9 @@ struct ioreq_server *ioreq_server_select(struct domain *d,
             start = ioreq_mmio_first_byte(p);
             end = ioreq_mmio_last_byte(p);
 
-            if ( rangeset_contains_range(r, start, end) )
+            if ( rangeset_contains_range(r, start, end) ||
+                 rangeset_contains_range(s->range[XEN_DMOP_IO_RANGE_POSTED],
+                                         start, end) )
                 return s;
 
             break;
@@ -1246,6 +1405,71 @@ static int ioreq_send_buffered(struct ioreq_server *s, ioreq_t *p)
     return IOREQ_STATUS_HANDLED;
 }
 
+static bool ioreq_is_posted(const struct ioreq_server *s, const ioreq_t *p)
+{
+    if ( !s->posted.ctrl || p->type != IOREQ_TYPE_COPY ||
+         p->dir != IOREQ_WRITE || p->data_is_ptr || p->count != 1 )
+        return false;
+
+    return rangeset_contains_range(s->range[XEN_DMOP_IO_RANGE_POSTED],
+                                   p->addr, p->addr + p->size - 1);
+}
+
+static int ioreq_send_posted(struct ioreq_server *s, const ioreq_t *p)
+{
+    struct ioreq_posted_ring *ring = &s->posted;
+    posted_iopage_t *pg = ring->ctrl;
+    posted_ioreq_t *slot;
+    uint32_t wp;
+
+    spin_lock(&s->bufioreq_lock);
+
+    /* Private copy of the write pointer: the emulator may scribble on pg. */
+    wp = ring->write_pointer;
+
+    if ( (wp - ACCESS_ONCE(pg->read_pointer)) >= ring->nr_slots )
+    {
+        /*
+         * The ring is full: send the write through the synchronous path.
+         * The emulator drains the ring before servicing it, so ordering with
+         * respect to the writes already queued is retained.
+         */
+        spin_unlock(&s->bufioreq_lock);
+        perfc_incr(ioreq_posted_full);
+        return IOREQ_STATUS_UNHANDLED;
+    }
+
+    slot = &ring->slot[wp & (ring->nr_slots - 1)];
+    slot->addr = p->addr;
+    slot->data = p->data;
+    slot->size = p->size;
+
+    /* Make the slot visible /before/ write_pointer. */
+    smp_wmb();
+    ring->write_pointer = ++wp;
+    write_atomic(&pg->write_pointer, wp);
+
+    /*
+     * Order the write_pointer update against the read_pointer check below,
+     * pairing with the emulator updating read_pointer and then re-checking
+     * write_pointer.  Only notify if the emulator had caught up, i.e. it may
+     * be waiting for an event; otherwise it will pick this write up as part
+     * of the batch it is already processing.
+     */
+    smp_mb();
+    if ( ACCESS_ONCE(pg->read_pointer) == wp - 1 )
+    {
+        notify_via_xen_event_channel(s->target, s->bufioreq_evtchn);
+        perfc_incr(ioreq_posted_notify);
+    }
+
+    spin_unlock(&s->bufioreq_lock);
+
+    perfc_incr(ioreq_posted);
+
+    return IOREQ_STATUS_HANDLED;
+}
+
 int ioreq_send(struct ioreq_server *s, ioreq_t *proto_p,
                bool buffered)
 {
@@ -1259,6 +1483,10 @@ int ioreq_send(struct ioreq_server *s, ioreq_t *proto_p,
     if ( buffered )
         return ioreq_send_buffered(s, proto_p);
 
+    if ( ioreq_is_posted(s, proto_p) &&
+         ioreq_send_posted(s, proto_p) == IOREQ_STATUS_HANDLED )
+        return IOREQ_STATUS_HANDLED;
+
     if ( unlikely(!vcpu_start_shutdown_deferral(curr)) )
     {
         vio->suspended = true;
@@ -1420,6 +1648,19 @@ int ioreq_server_dm_op(struct xen_dm_op *op, struct domain *d, bool *const_op)
         break;
     }
 
+    case XEN_DMOP_set_ioreq_server_posted_ring:
+    {
+        const struct xen_dm_op_set_ioreq_server_posted_ring *data =
+            &op->u.set_ioreq_server_posted_ring;
+
+        rc = -EINVAL;
+        if ( data->pad )
+            break;
+
+        rc = ioreq_server_set_posted_ring(d, data->id, data->nr_frames);
+        break;
+    }
+
     case XEN_DMOP_destroy_ioreq_server:
     {
         const struct xen_dm_op_destroy_ioreq_server *data =
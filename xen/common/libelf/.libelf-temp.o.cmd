@@ -0,0 +1 @@
+cmd_common/libelf/libelf-temp.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o common/libelf/libelf-temp.o common/libelf/libelf-tools.o common/libelf/libelf-loader.o common/libelf/libelf-dominfo.o --start-group  --end-group
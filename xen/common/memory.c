@@ -1128,7 +1128,11 @@ static unsigned int ioreq_server_max_frames(const struct domain *d)
 
 #ifdef CONFIG_IOREQ_SERVER
     if ( is_hvm_domain(d) )
-        /* One frame for the buf-ioreq ring, and one frame per 128 vcpus. */
+        /*
+         * One frame for the buf-ioreq ring, and one frame per 128 vcpus.  The
+         * posted write ring's frames live at their own index range, see
+         * XENMEM_resource_ioreq_server_frame_posted(), outside of this size.
+         */
         nr = 1 + DIV_ROUND_UP(d->max_vcpus * sizeof(struct ioreq), PAGE_SIZE);
 #endif
 
@@ -1156,6 +1160,11 @@ static unsigned int resource_max_frames(const struct domain *d,
     case XENMEM_resource_vmtrace_buf:
         return d->vmtrace_size >> PAGE_SHIFT;
 
+#ifdef CONFIG_X86
+    case XENMEM_resource_dirty_ring:
+        return id ? 0 : paging_dirty_ring_frames(d);
+#endif
+
     default:
         return 0;
     }
@@ -1239,6 +1248,11 @@ static int _acquire_resource(
     case XENMEM_resource_vmtrace_buf:
         return acquire_vmtrace_buf(d, id, frame, nr_frames, mfn_list);
 
+#ifdef CONFIG_X86
+    case XENMEM_resource_dirty_ring:
+        return paging_dirty_ring_acquire(d, frame, nr_frames, mfn_list);
+#endif
+
     default:
         ASSERT_UNREACHABLE();
         return -EOPNOTSUPP;
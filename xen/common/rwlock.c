@@ -26,6 +26,7 @@ static inline void rspin_until_writer_unlock(rwlock_t *lock, u32 cnts)
 void queue_read_lock_slowpath(rwlock_t *lock)
 {
     u32 cnts;
+    s_time_t wait = lock_contention_enter();
 
     /*
      * Readers come here when they cannot get the lock without waiting.
@@ -59,6 +60,7 @@ void queue_read_lock_slowpath(rwlock_t *lock)
     spin_unlock(&lock->lock);
 
     lock_enter(&lock->lock.debug);
+    lock_contention_exit(lock, __builtin_return_address(0), wait);
 }
 
 /*
@@ -68,6 +70,7 @@ void queue_read_lock_slowpath(rwlock_t *lock)
 void queue_write_lock_slowpath(rwlock_t *lock)
 {
     u32 cnts;
+    s_time_t wait = lock_contention_enter();
 
     /*
      * Put the writer into the wait queue.
@@ -112,6 +115,7 @@ void queue_write_lock_slowpath(rwlock_t *lock)
     spin_unlock(&lock->lock);
 
     lock_enter(&lock->lock.debug);
+    lock_contention_exit(lock, __builtin_return_address(0), wait);
 }
 
 
@@ -4,11 +4,13 @@
 #include <xen/notifier.h>
 #include <xen/param.h>
 #include <xen/smp.h>
+#include <xen/symbols.h>
 #include <xen/time.h>
 #include <xen/sections.h>
 #include <xen/spinlock.h>
 #include <xen/guest_access.h>
 #include <xen/preempt.h>
+#include <xen/xvmalloc.h>
 #include <public/sysctl.h>
 #include <asm/processor.h>
 #include <asm/atomic.h>
@@ -295,6 +297,261 @@ void spin_debug_disable(void)
 
 #endif
 
+#ifdef CONFIG_LOCK_CONTENTION_PROFILE
+
+/*
+ * Sampled contention profiling.  One in lock_contention_rate contended
+ * acquisitions is timed and accounted to its (lock, call site) pair in a
+ * fixed size open addressed table.  Uncontended acquisitions never get
+ * here, and with sampling disabled the slow path only tests the rate.
+ */
+#define LOCK_CONTENTION_SITES   2048
+#define LOCK_CONTENTION_PROBES  16
+
+struct lock_contention_site {
+    uint64_t key;                           /* 0: unused */
+    const void *lock;
+    const void *caller;
+    uint64_t samples;
+    uint64_t wait_time;
+    uint64_t max_wait;
+    uint64_t hist[LOCKPROF_HIST_BUCKETS];
+};
+
+static unsigned int __read_mostly lock_contention_rate;
+integer_param("lock-contention", lock_contention_rate);
+
+static struct lock_contention_site *lock_contention_sites;
+static uint64_t lock_contention_dropped;
+static s_time_t lock_contention_start;
+static DEFINE_SPINLOCK(lock_contention_lock);
+
+static DEFINE_PER_CPU(unsigned int, lock_contention_count);
+static DEFINE_PER_CPU(unsigned int, lock_contention_nest);
+
+static bool lock_contention_sample(void)
+{
+    unsigned int rate = ACCESS_ONCE(lock_contention_rate);
+    unsigned int *count;
+
+    if ( likely(!rate) || this_cpu(lock_contention_nest) )
+        return false;
+
+    count = &this_cpu(lock_contention_count);
+    if ( ++*count < rate )
+        return false;
+
+    *count = 0;
+
+    return true;
+}
+
+static uint64_t lock_contention_key(const void *lock, const void *caller)
+{
+    uint64_t key = (unsigned long)lock * 0x9e3779b97f4a7c15ULL;
+
+    key ^= (unsigned long)caller;
+    key ^= key >> 29;
+
+    return key ?: 1;
+}
+
+static void lock_contention_record(const void *lock, const void *caller,
+                                   s_time_t wait)
+{
+    struct lock_contention_site *sites = ACCESS_ONCE(lock_contention_sites);
+    struct lock_contention_site *site;
+    uint64_t key = lock_contention_key(lock, caller);
+    uint64_t max, prev;
+    unsigned int i, idx;
+
+    if ( !sites )
+        return;
+
+    if ( wait < 0 )
+        wait = 0;
+
+    for ( i = 0, idx = key; i < LOCK_CONTENTION_PROBES; i++, idx++ )
+    {
+        site = &sites[idx & (LOCK_CONTENTION_SITES - 1)];
+
+        prev = ACCESS_ONCE(site->key);
+        if ( !prev )
+        {
+            prev = cmpxchg(&site->key, 0, key);
+            if ( !prev )
+            {
+                site->lock = lock;
+                site->caller = caller;
+                break;
+            }
+        }
+        if ( prev == key )
+            break;
+    }
+
+    if ( i == LOCK_CONTENTION_PROBES )
+    {
+        arch_fetch_and_add(&lock_contention_dropped, 1);
+        return;
+    }
+
+    arch_fetch_and_add(&site->samples, 1);
+    arch_fetch_and_add(&site->wait_time, wait);
+    arch_fetch_and_add(&site->hist[min(fls64(wait >> 7),
+                                       LOCKPROF_HIST_BUCKETS - 1U)], 1);
+
+    for ( max = ACCESS_ONCE(site->max_wait); wait > max; max = prev )
+    {
+        prev = cmpxchg(&site->max_wait, max, wait);
+        if ( prev == max )
+            break;
+    }
+}
+
+s_time_t lock_contention_enter(void)
+{
+    s_time_t start = lock_contention_sample() ? NOW() : 0;
+
+    this_cpu(lock_contention_nest)++;
+
+    return start;
+}
+
+void lock_contention_exit(const void *lock, const void *caller,
+                          s_time_t start)
+{
+    this_cpu(lock_contention_nest)--;
+
+    if ( start )
+        lock_contention_record(lock, caller, NOW() - start);
+}
+
+static int lock_contention_alloc(void)
+{
+    struct lock_contention_site *sites;
+
+    if ( lock_contention_sites )
+        return 0;
+
+    sites = xvzalloc_array(struct lock_contention_site,
+                           LOCK_CONTENTION_SITES);
+    if ( !sites )
+        return -ENOMEM;
+
+    lock_contention_start = NOW();
+    smp_wmb();
+    lock_contention_sites = sites;
+
+    return 0;
+}
+
+static int __init cf_check lock_contention_init(void)
+{
+    if ( lock_contention_rate && lock_contention_alloc() )
+    {
+        printk(XENLOG_WARNING
+               "Failed to allocate lock contention table, sampling disabled\n");
+        lock_contention_rate = 0;
+    }
+
+    return 0;
+}
+__initcall(lock_contention_init);
+
+static int lock_contention_control(struct xen_sysctl_lockprof_op *pc)
+{
+    struct xen_sysctl_lockprof_site elem;
+    const struct lock_contention_site *site;
+    unsigned long size, offset;
+    const char *name;
+    char namebuf[KSYM_NAME_LEN + 1];
+    unsigned int i;
+    int rc = 0;
+
+    spin_lock(&lock_contention_lock);
+
+    switch ( pc->cmd )
+    {
+    case XEN_SYSCTL_LOCKPROF_contention_set:
+        if ( pc->sample_rate && (rc = lock_contention_alloc()) != 0 )
+            break;
+        this_cpu(lock_contention_count) = 0;
+        write_atomic(&lock_contention_rate, pc->sample_rate);
+        break;
+
+    case XEN_SYSCTL_LOCKPROF_contention_reset:
+        /* Samples taken while resetting may be lost or partially kept. */
+        if ( lock_contention_sites )
+            memset(lock_contention_sites, 0,
+                   LOCK_CONTENTION_SITES * sizeof(*lock_contention_sites));
+        lock_contention_dropped = 0;
+        lock_contention_start = NOW();
+        break;
+
+    case XEN_SYSCTL_LOCKPROF_contention_query:
+        pc->nr_elem = 0;
+        pc->sample_rate = lock_contention_rate;
+        pc->dropped = lock_contention_dropped;
+        pc->time = lock_contention_sites ? NOW() - lock_contention_start : 0;
+
+        for ( i = 0; lock_contention_sites && i < LOCK_CONTENTION_SITES; i++ )
+        {
+            site = &lock_contention_sites[i];
+            if ( !ACCESS_ONCE(site->key) || !ACCESS_ONCE(site->caller) )
+                continue;
+
+            if ( pc->nr_elem < pc->max_elem )
+            {
+                memset(&elem, 0, sizeof(elem));
+                elem.lock_addr = (unsigned long)site->lock;
+                elem.caller_addr = (unsigned long)site->caller;
+                name = symbols_lookup(elem.caller_addr, &size, &offset,
+                                      namebuf);
+                if ( name )
+                    snprintf(elem.caller, sizeof(elem.caller), "%s+%#lx",
+                             name, offset);
+                elem.samples = site->samples;
+                elem.wait_time = site->wait_time;
+                elem.max_wait = site->max_wait;
+                memcpy(elem.hist, site->hist, sizeof(elem.hist));
+                if ( copy_to_guest_offset(pc->sites, pc->nr_elem, &elem, 1) )
+                {
+                    rc = -EFAULT;
+                    break;
+                }
+            }
+
+            pc->nr_elem++;
+        }
+        break;
+
+    default:
+        rc = -EINVAL;
+        break;
+    }
+
+    spin_unlock(&lock_contention_lock);
+
+    return rc;
+}
+
+#define LOCK_CONTENTION_VAR(var)      s_time_t var = 0
+#define LOCK_CONTENTION_BLOCK(var)                                           \
+    if ( !(var) )                                                            \
+        (var) = lock_contention_sample() ? NOW() : -1
+#define LOCK_CONTENTION_GOT(var, l)                                          \
+    if ( unlikely((var) > 0) )                                               \
+        lock_contention_record(l, __builtin_return_address(0), NOW() - (var))
+
+#else
+
+#define LOCK_CONTENTION_VAR(var)      s_time_t var __maybe_unused
+#define LOCK_CONTENTION_BLOCK(var)
+#define LOCK_CONTENTION_GOT(var, l)
+
+#endif
+
 static always_inline spinlock_tickets_t observe_lock(spinlock_tickets_t *t)
 {
     spinlock_tickets_t v;
@@ -316,6 +573,7 @@ static void always_inline spin_lock_common(spinlock_tickets_t *t,
                                            void (*cb)(void *data), void *data)
 {
     spinlock_tickets_t tickets = SPINLOCK_TICKET_INC;
+    LOCK_CONTENTION_VAR(wait);
     LOCK_PROFILE_VAR(block, 0);
 
     check_lock(debug, false);
@@ -324,6 +582,7 @@ static void always_inline spin_lock_common(spinlock_tickets_t *t,
     while ( tickets.tail != observe_head(t) )
     {
         LOCK_PROFILE_BLOCK(block);
+        LOCK_CONTENTION_BLOCK(wait);
         if ( cb )
             cb(data);
         arch_lock_relax();
@@ -331,6 +590,7 @@ static void always_inline spin_lock_common(spinlock_tickets_t *t,
     arch_lock_acquire_barrier();
     got_lock(debug);
     LOCK_PROFILE_GOT(block);
+    LOCK_CONTENTION_GOT(wait, t);
 }
 
 void _spin_lock(spinlock_t *lock)
@@ -348,7 +608,8 @@ void _spin_lock_irq(spinlock_t *lock)
 {
     ASSERT(local_irq_is_enabled());
     local_irq_disable();
-    _spin_lock(lock);
+    spin_lock_common(&lock->tickets, &lock->debug, LOCK_PROFILE_PAR, NULL,
+                     NULL);
 }
 
 unsigned long _spin_lock_irqsave(spinlock_t *lock)
@@ -356,7 +617,8 @@ unsigned long _spin_lock_irqsave(spinlock_t *lock)
     unsigned long flags;
 
     local_irq_save(flags);
-    _spin_lock(lock);
+    spin_lock_common(&lock->tickets, &lock->debug, LOCK_PROFILE_PAR, NULL,
+                     NULL);
     return flags;
 }
 
@@ -507,7 +769,7 @@ bool _rspin_trylock(rspinlock_t *lock)
     return true;
 }
 
-void _rspin_lock(rspinlock_t *lock)
+static void always_inline rspin_lock_common(rspinlock_t *lock)
 {
     unsigned int cpu = smp_processor_id();
 
@@ -523,12 +785,17 @@ void _rspin_lock(rspinlock_t *lock)
     lock->recurse_cnt++;
 }
 
+void _rspin_lock(rspinlock_t *lock)
+{
+    rspin_lock_common(lock);
+}
+
 unsigned long _rspin_lock_irqsave(rspinlock_t *lock)
 {
     unsigned long flags;
 
     local_irq_save(flags);
-    _rspin_lock(lock);
+    rspin_lock_common(lock);
 
     return flags;
 }
@@ -573,7 +840,8 @@ void _nrspin_lock_irq(rspinlock_t *lock)
 {
     ASSERT(local_irq_is_enabled());
     local_irq_disable();
-    _nrspin_lock(lock);
+    spin_lock_common(&lock->tickets, &lock->debug, LOCK_PROFILE_PAR, NULL,
+                     NULL);
 }
 
 void _nrspin_unlock_irq(rspinlock_t *lock)
@@ -587,7 +855,8 @@ unsigned long _nrspin_lock_irqsave(rspinlock_t *lock)
     unsigned long flags;
 
     local_irq_save(flags);
-    _nrspin_lock(lock);
+    spin_lock_common(&lock->tickets, &lock->debug, LOCK_PROFILE_PAR, NULL,
+                     NULL);
 
     return flags;
 }
@@ -721,35 +990,6 @@ static void cf_check spinlock_profile_ucopy_elem(struct lock_profile *data,
         p->pc->nr_elem++;
 }
 
-/* Dom0 control of lock profiling */
-int spinlock_profile_control(struct xen_sysctl_lockprof_op *pc)
-{
-    int rc = 0;
-    spinlock_profile_ucopy_t par;
-
-    switch ( pc->cmd )
-    {
-    case XEN_SYSCTL_LOCKPROF_reset:
-        spinlock_profile_reset('\0');
-        break;
-
-    case XEN_SYSCTL_LOCKPROF_query:
-        pc->nr_elem = 0;
-        par.rc = 0;
-        par.pc = pc;
-        spinlock_profile_iterate(spinlock_profile_ucopy_elem, &par);
-        pc->time = NOW() - lock_profile_start;
-        rc = par.rc;
-        break;
-
-    default:
-        rc = -EINVAL;
-        break;
-    }
-
-    return rc;
-}
-
 void _lock_profile_register_struct(
     int32_t type, struct lock_profile_qhead *qhead, int32_t idx)
 {
@@ -805,3 +1045,48 @@ static int __init cf_check lock_prof_init(void)
 __initcall(lock_prof_init);
 
 #endif /* CONFIG_DEBUG_LOCK_PROFILE */
+
+#if defined(CONFIG_DEBUG_LOCK_PROFILE) || defined(CONFIG_LOCK_CONTENTION_PROFILE)
+
+/* Dom0 control of lock profiling */
+int spinlock_profile_control(struct xen_sysctl_lockprof_op *pc)
+{
+    int rc = 0;
+#ifdef CONFIG_DEBUG_LOCK_PROFILE
+    spinlock_profile_ucopy_t par;
+#endif
+
+    switch ( pc->cmd )
+    {
+#ifdef CONFIG_DEBUG_LOCK_PROFILE
+    case XEN_SYSCTL_LOCKPROF_reset:
+        spinlock_profile_reset('\0');
+        break;
+
+    case XEN_SYSCTL_LOCKPROF_query:
+        pc->nr_elem = 0;
+        par.rc = 0;
+        par.pc = pc;
+        spinlock_profile_iterate(spinlock_profile_ucopy_elem, &par);
+        pc->time = NOW() - lock_profile_start;
+        rc = par.rc;
+        break;
+#endif
+
+#ifdef CONFIG_LOCK_CONTENTION_PROFILE
+    case XEN_SYSCTL_LOCKPROF_contention_set:
+    case XEN_SYSCTL_LOCKPROF_contention_query:
+    case XEN_SYSCTL_LOCKPROF_contention_reset:
+        rc = lock_contention_control(pc);
+        break;
+#endif
+
+    default:
+        rc = -EINVAL;
+        break;
+    }
+
+    return rc;
+}
+
+#endif
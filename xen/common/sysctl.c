@@ -119,7 +119,7 @@ long do_sysctl(XEN_GUEST_HANDLE_PARAM(xen_sysctl_t) u_sysctl)
         break;
 #endif
 
-#ifdef CONFIG_DEBUG_LOCK_PROFILE
+#if defined(CONFIG_DEBUG_LOCK_PROFILE) || defined(CONFIG_LOCK_CONTENTION_PROFILE)
     case XEN_SYSCTL_lockprof_op:
         ret = spinlock_profile_control(&op->u.lockprof_op);
         break;
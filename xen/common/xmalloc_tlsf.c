@@ -23,8 +23,12 @@
  * Adapted for Xen by Dan Magenheimer (dan.magenheimer@oracle.com)
  */
 
+#include <xen/cpu.h>
 #include <xen/irq.h>
+#include <xen/keyhandler.h>
 #include <xen/mm.h>
+#include <xen/param.h>
+#include <xen/percpu.h>
 #include <xen/pfn.h>
 #include <asm/time.h>
 #include <asm/page.h>
@@ -382,47 +386,21 @@ void xmem_pool_destroy(struct xmem_pool *pool)
     free_xenheap_pages(pool,pool_order);
 }
 
-void *xmem_pool_alloc(unsigned long size, struct xmem_pool *pool)
+/*
+ * Take a block of (rounded) size bytes from the pool's free lists, with the
+ * pool lock held.  Returns NULL if the pool needs to grow.
+ */
+static struct bhdr *pool_alloc_block(unsigned long size, struct xmem_pool *pool)
 {
-    struct bhdr *b, *b2, *next_b, *region;
+    struct bhdr *b, *b2, *next_b;
     int fl, sl;
     unsigned long tmp_size;
 
-    ASSERT_ALLOC_CONTEXT();
-
-    if ( size < MIN_BLOCK_SIZE )
-        size = MIN_BLOCK_SIZE;
-    else
-    {
-        tmp_size = ROUNDUP_SIZE(size);
-        /* Guard against overflow. */
-        if ( tmp_size < size )
-            return NULL;
-        size = tmp_size;
-    }
-
-    /* Rounding up the requested size and calculating fl and sl */
-
-    spin_lock(&pool->lock);
- retry_find:
     MAPPING_SEARCH(&size, &fl, &sl);
 
     /* Searching a free block */
     if ( !(b = FIND_SUITABLE_BLOCK(pool, &fl, &sl)) )
-    {
-        /* Not found */
-        if ( size > (pool->grow_size - 2 * BHDR_OVERHEAD) )
-            goto out_locked;
-        if ( pool->max_size && (pool->num_regions * pool->grow_size
-                                > pool->max_size) )
-            goto out_locked;
-        spin_unlock(&pool->lock);
-        if ( (region = pool->get_mem(pool->grow_size)) == NULL )
-            goto out;
-        spin_lock(&pool->lock);
-        ADD_REGION(region, pool->grow_size, pool);
-        goto retry_find;
-    }
+        return NULL;
     EXTRACT_BLOCK_HDR(b, pool, fl, sl);
 
     /*-- found: */
@@ -452,6 +430,49 @@ void *xmem_pool_alloc(unsigned long size, struct xmem_pool *pool)
 
     pool->used_size += (b->size & BLOCK_SIZE_MASK) + BHDR_OVERHEAD;
 
+    return b;
+}
+
+static unsigned long pool_alloc_size(unsigned long size)
+{
+    unsigned long tmp_size;
+
+    if ( size < MIN_BLOCK_SIZE )
+        return MIN_BLOCK_SIZE;
+
+    tmp_size = ROUNDUP_SIZE(size);
+    /* Guard against overflow. */
+    return tmp_size < size ? 0 : tmp_size;
+}
+
+void *xmem_pool_alloc(unsigned long size, struct xmem_pool *pool)
+{
+    struct bhdr *b, *region;
+    int fl, sl;
+
+    ASSERT_ALLOC_CONTEXT();
+
+    /* Rounding up the requested size and calculating fl and sl */
+    if ( !(size = pool_alloc_size(size)) )
+        return NULL;
+    MAPPING_SEARCH(&size, &fl, &sl);
+
+    spin_lock(&pool->lock);
+    while ( !(b = pool_alloc_block(size, pool)) )
+    {
+        /* Not found */
+        if ( size > (pool->grow_size - 2 * BHDR_OVERHEAD) )
+            goto out_locked;
+        if ( pool->max_size && (pool->num_regions * pool->grow_size
+                                > pool->max_size) )
+            goto out_locked;
+        spin_unlock(&pool->lock);
+        if ( (region = pool->get_mem(pool->grow_size)) == NULL )
+            goto out;
+        spin_lock(&pool->lock);
+        ADD_REGION(region, pool->grow_size, pool);
+    }
+
     spin_unlock(&pool->lock);
     return (void *)b->ptr.buffer;
 
@@ -463,19 +484,12 @@ void *xmem_pool_alloc(unsigned long size, struct xmem_pool *pool)
     return NULL;
 }
 
-void xmem_pool_free(void *ptr, struct xmem_pool *pool)
+/* Return a used block to the pool's free lists, with the pool lock held. */
+static void pool_free_block(struct bhdr *b, struct xmem_pool *pool)
 {
-    struct bhdr *b, *tmp_b;
+    struct bhdr *tmp_b;
     int fl = 0, sl = 0;
 
-    ASSERT_ALLOC_CONTEXT();
-
-    if ( unlikely(ptr == NULL) )
-        return;
-
-    b = (struct bhdr *)((char *) ptr - BHDR_OVERHEAD);
-
-    spin_lock(&pool->lock);
     b->size |= FREE_BLOCK;
     pool->used_size -= (b->size & BLOCK_SIZE_MASK) + BHDR_OVERHEAD;
     b->ptr.free_ptr = (struct free_ptr) { NULL, NULL};
@@ -504,14 +518,24 @@ void xmem_pool_free(void *ptr, struct xmem_pool *pool)
         pool->put_mem(b);
         pool->num_regions--;
         pool->used_size -= BHDR_OVERHEAD; /* sentinel block header */
-        goto out;
+        return;
     }
 
     INSERT_BLOCK(b, pool, fl, sl);
 
     tmp_b->size |= PREV_FREE;
     tmp_b->prev_hdr = b;
- out:
+}
+
+void xmem_pool_free(void *ptr, struct xmem_pool *pool)
+{
+    ASSERT_ALLOC_CONTEXT();
+
+    if ( unlikely(ptr == NULL) )
+        return;
+
+    spin_lock(&pool->lock);
+    pool_free_block((struct bhdr *)((char *)ptr - BHDR_OVERHEAD), pool);
     spin_unlock(&pool->lock);
 }
 
@@ -569,6 +593,279 @@ static void tlsf_init(void)
     BUG_ON(!xenpool);
 }
 
+/*
+ * Per-CPU caches of small xmalloc() blocks.
+ *
+ * Each CPU keeps up to 2 * XMALLOC_BATCH free blocks of every size class.
+ * The blocks remain used as far as the pool is concerned.  An empty cache
+ * is refilled, and a full one is trimmed, by XMALLOC_BATCH blocks at a
+ * time, taking the pool lock once per batch.  Trimmed batches are first
+ * put in a per-class depot, from where other CPUs refill, so that blocks
+ * allocated on one CPU and freed on another circulate without going back
+ * to the pool.  In the depot the blocks of a batch are linked through
+ * their first word, and batches through the second word of their first
+ * block.
+ */
+#define XMALLOC_BATCH       16
+#define XMALLOC_DEPOT_MAX   32      /* batches per class */
+
+static const unsigned short xmalloc_class_size[] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512,
+    768 /* upper bound of the last class */
+};
+#define XMALLOC_CLASSES     (ARRAY_SIZE(xmalloc_class_size) - 1)
+#define XMALLOC_CACHE_MAX   xmalloc_class_size[XMALLOC_CLASSES - 1]
+
+struct xmalloc_cache {
+    unsigned int count;
+    void *blocks[2 * XMALLOC_BATCH];
+
+    /* Statistics. */
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long frees;
+    unsigned long depot_gets;
+    unsigned long depot_puts;
+    unsigned long pool_batches;
+    unsigned long contended;
+};
+
+static DEFINE_PER_CPU(struct xmalloc_cache[XMALLOC_CLASSES], xmalloc_caches);
+
+static struct xmalloc_depot {
+    spinlock_t lock;
+    unsigned int nr;
+    void **batches;
+} xmalloc_depots[XMALLOC_CLASSES] = {
+    [0 ... XMALLOC_CLASSES - 1] = { .lock = SPIN_LOCK_UNLOCKED },
+};
+
+static bool __initdata opt_xmalloc_cache = !IS_ENABLED(CONFIG_XMEM_POOL_POISON);
+boolean_param("xmalloc-cache", opt_xmalloc_cache);
+
+static bool __read_mostly xmalloc_cache_enabled;
+
+static unsigned int xmalloc_class(unsigned long size)
+{
+    unsigned int cls = 0;
+
+    while ( xmalloc_class_size[cls] < size )
+        cls++;
+
+    return cls;
+}
+
+static void xmalloc_lock(spinlock_t *lock, struct xmalloc_cache *c)
+{
+    if ( !spin_trylock(lock) )
+    {
+        c->contended++;
+        spin_lock(lock);
+    }
+}
+
+static void xmalloc_cache_refill(struct xmalloc_cache *c, unsigned int cls)
+{
+    struct xmalloc_depot *d = &xmalloc_depots[cls];
+    struct bhdr *b;
+    void **batch = NULL;
+
+    if ( ACCESS_ONCE(d->nr) )
+    {
+        xmalloc_lock(&d->lock, c);
+        if ( (batch = d->batches) != NULL )
+        {
+            d->batches = batch[1];
+            d->nr--;
+        }
+        spin_unlock(&d->lock);
+    }
+
+    if ( batch )
+    {
+        c->depot_gets++;
+        for ( ; batch; batch = *batch )
+            c->blocks[c->count++] = batch;
+        ASSERT(c->count == XMALLOC_BATCH);
+        return;
+    }
+
+    c->pool_batches++;
+    xmalloc_lock(&xenpool->lock, c);
+    while ( c->count < XMALLOC_BATCH &&
+            (b = pool_alloc_block(xmalloc_class_size[cls], xenpool)) != NULL )
+        c->blocks[c->count++] = b->ptr.buffer;
+    spin_unlock(&xenpool->lock);
+}
+
+/* Move the n least recently freed blocks out of a CPU's cache. */
+static void xmalloc_cache_trim(struct xmalloc_cache *c, unsigned int cls,
+                               unsigned int n, bool to_depot)
+{
+    struct xmalloc_depot *d = &xmalloc_depots[cls];
+    unsigned int i;
+
+    ASSERT(n <= c->count);
+
+    if ( to_depot && n == XMALLOC_BATCH &&
+         ACCESS_ONCE(d->nr) < XMALLOC_DEPOT_MAX )
+    {
+        void **batch = c->blocks[0];
+
+        for ( i = 0; i < n; i++ )
+            *(void **)c->blocks[i] = i + 1 < n ? c->blocks[i + 1] : NULL;
+
+        xmalloc_lock(&d->lock, c);
+        batch[1] = d->batches;
+        d->batches = batch;
+        d->nr++;
+        spin_unlock(&d->lock);
+
+        c->depot_puts++;
+    }
+    else
+    {
+        c->pool_batches++;
+        xmalloc_lock(&xenpool->lock, c);
+        for ( i = 0; i < n; i++ )
+            pool_free_block(c->blocks[i] - BHDR_OVERHEAD, xenpool);
+        spin_unlock(&xenpool->lock);
+    }
+
+    c->count -= n;
+    memmove(c->blocks, c->blocks + n, c->count * sizeof(*c->blocks));
+}
+
+static void *xmalloc_cache_alloc(unsigned long size)
+{
+    unsigned int cls = xmalloc_class(size);
+    struct xmalloc_cache *c = &this_cpu(xmalloc_caches)[cls];
+
+    if ( likely(c->count) )
+    {
+        c->hits++;
+        return c->blocks[--c->count];
+    }
+
+    c->misses++;
+    xmalloc_cache_refill(c, cls);
+    if ( c->count )
+        return c->blocks[--c->count];
+
+    /* The pool needs to grow. */
+    return xmem_pool_alloc(xmalloc_class_size[cls], xenpool);
+}
+
+static bool xmalloc_cache_free(void *p)
+{
+    const struct bhdr *b = p - BHDR_OVERHEAD;
+    unsigned long size = b->size & BLOCK_SIZE_MASK;
+    unsigned int cls;
+    struct xmalloc_cache *c;
+
+    if ( size >= xmalloc_class_size[XMALLOC_CLASSES] )
+        return false;
+
+    /* The largest class the block can serve. */
+    cls = xmalloc_class(size + 1) - 1;
+    c = &this_cpu(xmalloc_caches)[cls];
+
+    if ( c->count == ARRAY_SIZE(c->blocks) )
+        xmalloc_cache_trim(c, cls, XMALLOC_BATCH, true);
+
+    c->frees++;
+    c->blocks[c->count++] = p;
+
+    return true;
+}
+
+static int cf_check cpu_xmalloc_callback(
+    struct notifier_block *nfb, unsigned long action, void *hcpu)
+{
+    unsigned int cpu = (unsigned long)hcpu, cls;
+    struct xmalloc_cache *c;
+
+    switch ( action )
+    {
+    case CPU_UP_CANCELED:
+    case CPU_DEAD:
+        for ( cls = 0; cls < XMALLOC_CLASSES; cls++ )
+        {
+            c = &per_cpu(xmalloc_caches, cpu)[cls];
+            if ( c->count )
+                xmalloc_cache_trim(c, cls, c->count, false);
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return NOTIFY_DONE;
+}
+
+static struct notifier_block cpu_xmalloc_nfb = {
+    .notifier_call = cpu_xmalloc_callback,
+};
+
+static void cf_check dump_xmalloc_caches(unsigned char key)
+{
+    unsigned int cpu, cls;
+
+    printk("xmalloc: pool used %lu of %lu bytes, per-CPU caches %s\n",
+           xenpool ? xmem_pool_get_used_size(xenpool) : 0,
+           xenpool ? xmem_pool_get_total_size(xenpool) : 0,
+           xmalloc_cache_enabled ? "enabled" : "disabled");
+    if ( !xmalloc_cache_enabled )
+        return;
+
+    printk("  size  cached      hits    misses  hit%%     frees  "
+           "depot get/put  pool  contended\n");
+    for ( cls = 0; cls < XMALLOC_CLASSES; cls++ )
+    {
+        unsigned long cached = 0, hits = 0, misses = 0, frees = 0;
+        unsigned long gets = 0, puts = 0, pool = 0, contended = 0;
+
+        for_each_online_cpu ( cpu )
+        {
+            const struct xmalloc_cache *c = &per_cpu(xmalloc_caches, cpu)[cls];
+
+            cached += c->count;
+            hits += c->hits;
+            misses += c->misses;
+            frees += c->frees;
+            gets += c->depot_gets;
+            puts += c->depot_puts;
+            pool += c->pool_batches;
+            contended += c->contended;
+        }
+
+        printk("  %4u %7lu %9lu %9lu %4lu %9lu %7lu/%-7lu %5lu %10lu\n",
+               xmalloc_class_size[cls],
+               cached + (unsigned long)xmalloc_depots[cls].nr * XMALLOC_BATCH,
+               hits, misses, hits + misses ? hits * 100 / (hits + misses) : 0,
+               frees, gets, puts, pool, contended);
+    }
+}
+
+static int __init cf_check xmalloc_cache_init(void)
+{
+    register_keyhandler('X', dump_xmalloc_caches, "dump xmalloc cache stats",
+                        1);
+
+    if ( !opt_xmalloc_cache )
+        return 0;
+
+    if ( !xenpool )
+        tlsf_init();
+
+    register_cpu_notifier(&cpu_xmalloc_nfb);
+    xmalloc_cache_enabled = true;
+
+    return 0;
+}
+presmp_initcall(xmalloc_cache_init);
+
 /*
  * xmalloc()
  */
@@ -625,7 +922,9 @@ void *_xmalloc(unsigned long size, unsigned long align)
     if ( !xenpool )
         tlsf_init();
 
-    if ( size < PAGE_SIZE )
+    if ( xmalloc_cache_enabled && size <= XMALLOC_CACHE_MAX )
+        p = xmalloc_cache_alloc(size);
+    else if ( size < PAGE_SIZE )
         p = xmem_pool_alloc(size, xenpool);
     if ( p == NULL )
         return xmalloc_whole_pages(size - align + MEM_ALIGN, align);
@@ -737,5 +1036,8 @@ void xfree(void *p)
     /* Strip alignment padding. */
     p = strip_padding(p);
 
+    if ( xmalloc_cache_enabled && xmalloc_cache_free(p) )
+        return;
+
     xmem_pool_free(p, xenpool);
 }
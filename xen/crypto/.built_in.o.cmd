@@ -0,0 +1 @@
+cmd_crypto/built_in.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o crypto/built_in.o crypto/rijndael.o crypto/vmac.o
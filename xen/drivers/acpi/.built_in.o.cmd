@@ -0,0 +1 @@
+cmd_drivers/acpi/built_in.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o drivers/acpi/built_in.o drivers/acpi/tables/built_in.o drivers/acpi/utilities/built_in.o drivers/acpi/apei/built_in.o drivers/acpi/numa.o drivers/acpi/osl.o drivers/acpi/pmstat.o drivers/acpi/hwregs.o drivers/acpi/reboot.o drivers/acpi/tables.init.o
@@ -0,0 +1 @@
+cmd_drivers/acpi/apei/built_in.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o drivers/acpi/apei/built_in.o drivers/acpi/apei/erst.o drivers/acpi/apei/hest.o drivers/acpi/apei/apei-base.o drivers/acpi/apei/apei-io.o
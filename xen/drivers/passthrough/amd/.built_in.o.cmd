@@ -0,0 +1 @@
+cmd_drivers/passthrough/amd/built_in.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o drivers/passthrough/amd/built_in.o drivers/passthrough/amd/iommu_init.o drivers/passthrough/amd/iommu_map.o drivers/passthrough/amd/pci_amd_iommu.o drivers/passthrough/amd/iommu_intr.o drivers/passthrough/amd/iommu_cmd.o drivers/passthrough/amd/iommu_detect.init.o drivers/passthrough/amd/iommu_acpi.init.o
@@ -94,6 +94,14 @@ struct amd_iommu {
 
     struct table_struct dev_table;
     struct ring_buffer cmd_buffer;
+    cpumask_t cmd_batch;     /* CPUs with commands yet to wait for */
+    struct {
+        unsigned long iotlb;     /* INVALIDATE_IOMMU_PAGES sent for flushes */
+        unsigned long deferred;  /* ... with the wait left to a batch */
+        unsigned long waits;     /* COMPLETION_WAITs sent */
+        s_time_t wait_time;      /* total and longest time spent waiting */
+        s_time_t wait_max;
+    } cmd_stats;
     struct ring_buffer event_log;
     struct ring_buffer ppr_log;
     unsigned long *domid_map;
@@ -238,6 +246,8 @@ void amd_iommu_flush_device(struct amd_iommu *iommu, uint16_t bdf,
                             domid_t domid);
 void amd_iommu_flush_intremap(struct amd_iommu *iommu, uint16_t bdf);
 void amd_iommu_flush_all_caches(struct amd_iommu *iommu);
+void cf_check amd_iommu_flush_batch_begin(void);
+int __must_check cf_check amd_iommu_flush_batch_end(void);
 
 /* find iommu for bdf */
 struct amd_iommu *find_iommu_for_device(int seg, int bdf);
@@ -260,6 +270,7 @@ int cf_check amd_iommu_msi_msg_update_ire(
     struct msi_desc *msi_desc, struct msi_msg *msg);
 int cf_check amd_setup_hpet_msi(struct msi_desc *msi_desc);
 void cf_check amd_iommu_dump_intremap_tables(unsigned char key);
+void cf_check amd_iommu_dump_info(unsigned char key);
 
 extern struct ioapic_sbdf {
     u16 bdf, seg;
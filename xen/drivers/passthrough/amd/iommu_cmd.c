@@ -23,6 +23,26 @@
 #define CMD_COMPLETION_INIT 0
 #define CMD_COMPLETION_DONE 1
 
+/* Max number of invalidations a CPU may have sent without a wait. */
+#define CMD_BATCH_MAX       16
+
+/* Nesting depth of flush batches, and invalidations sent within them. */
+static DEFINE_PER_CPU(unsigned int, cmd_batch_depth);
+static DEFINE_PER_CPU(unsigned int, cmd_batch_pending);
+
+/* Number of entries in the command buffer not yet fetched by the IOMMU. */
+static unsigned int cmd_buffer_used(const struct amd_iommu *iommu)
+{
+    uint32_t head = readl(iommu->mmio_base + IOMMU_CMD_BUFFER_HEAD_OFFSET) &
+                    IOMMU_RING_BUFFER_PTR_MASK;
+    uint32_t tail = ACCESS_ONCE(iommu->cmd_buffer.tail);
+
+    if ( tail < head )
+        tail += iommu->cmd_buffer.size;
+
+    return (tail - head) / sizeof(cmd_entry_t);
+}
+
 static void send_iommu_command(struct amd_iommu *iommu,
                                const uint32_t cmd[4])
 {
@@ -69,13 +89,17 @@ static void flush_command_buffer(struct amd_iommu *iommu,
         CMD_COMPLETION_DONE,
         0
     };
-    s_time_t start, timeout;
+    s_time_t start, timeout, elapsed;
     static unsigned int __read_mostly threshold = 1;
+    unsigned long flags;
 
     ACCESS_ONCE(*this_poll_slot) = CMD_COMPLETION_INIT;
 
     send_iommu_command(iommu, cmd);
 
+    /* This also covers whatever this CPU left to wait for in a batch. */
+    cpumask_clear_cpu(smp_processor_id(), &iommu->cmd_batch);
+
     start = NOW();
     timeout = start + (timeout_base ?: 100) * MILLISECS(threshold);
     while ( ACCESS_ONCE(*this_poll_slot) != CMD_COMPLETION_DONE )
@@ -92,12 +116,55 @@ static void flush_command_buffer(struct amd_iommu *iommu,
         cpu_relax();
     }
 
+    elapsed = NOW() - start;
+
     if ( !timeout )
         printk(XENLOG_WARNING
                "AMD IOMMU %pp: %scompletion wait took %lums\n",
                &PCI_SBDF(iommu->seg, iommu->bdf),
                timeout_base ? "iotlb " : "",
-               (NOW() - start) / 10000000);
+               elapsed / 10000000);
+
+    spin_lock_irqsave(&iommu->lock, flags);
+    iommu->cmd_stats.waits++;
+    iommu->cmd_stats.wait_time += elapsed;
+    if ( elapsed > iommu->cmd_stats.wait_max )
+        iommu->cmd_stats.wait_max = elapsed;
+    spin_unlock_irqrestore(&iommu->lock, flags);
+}
+
+/*
+ * Within a flush batch, page invalidations don't wait for their completion
+ * one by one.  Instead each IOMMU they were sent to gets a single
+ * COMPLETION_WAIT, as late as possible: when the outermost batch ends, once
+ * CMD_BATCH_MAX invalidations were sent without one, or once the command
+ * buffer is half full, so that the batch can't make others spin for a slot.
+ */
+void cf_check amd_iommu_flush_batch_begin(void)
+{
+    this_cpu(cmd_batch_depth)++;
+}
+
+static void flush_batch_sync(void)
+{
+    struct amd_iommu *iommu;
+    unsigned int cpu = smp_processor_id();
+
+    this_cpu(cmd_batch_pending) = 0;
+
+    for_each_amd_iommu ( iommu )
+        if ( cpumask_test_cpu(cpu, &iommu->cmd_batch) )
+            flush_command_buffer(iommu, 0);
+}
+
+int cf_check amd_iommu_flush_batch_end(void)
+{
+    ASSERT(this_cpu(cmd_batch_depth));
+
+    if ( !--this_cpu(cmd_batch_depth) && this_cpu(cmd_batch_pending) )
+        flush_batch_sync();
+
+    return 0;
 }
 
 /* Build low level iommu command messages */
@@ -332,14 +399,38 @@ static void _amd_iommu_flush_pages(struct domain *d,
 {
     struct amd_iommu *iommu;
     unsigned int dom_id = d->domain_id;
-
-    /* send INVALIDATE_IOMMU_PAGES command */
+    /*
+     * Device IOTLB invalidations have to follow completion of the IOMMU
+     * ones, so can't have the wait deferred.
+     */
+    bool defer = this_cpu(cmd_batch_depth) && !ats_enabled;
+    bool sync = false;
+
+    /*
+     * Send INVALIDATE_IOMMU_PAGES commands to all IOMMUs first, so they get
+     * processed in parallel, before waiting for any of them.
+     */
     for_each_amd_iommu ( iommu )
     {
+        unsigned long flags;
+
         invalidate_iommu_pages(iommu, daddr, dom_id, order);
-        flush_command_buffer(iommu, 0);
+
+        spin_lock_irqsave(&iommu->lock, flags);
+        cpumask_set_cpu(smp_processor_id(), &iommu->cmd_batch);
+        iommu->cmd_stats.iotlb++;
+        if ( defer )
+            iommu->cmd_stats.deferred++;
+        spin_unlock_irqrestore(&iommu->lock, flags);
+
+        if ( cmd_buffer_used(iommu) * 2 >=
+             iommu->cmd_buffer.size / sizeof(cmd_entry_t) )
+            sync = true;
     }
 
+    if ( !defer || sync || ++this_cpu(cmd_batch_pending) >= CMD_BATCH_MAX )
+        flush_batch_sync();
+
     if ( ats_enabled )
     {
         amd_iommu_flush_all_iotlbs(d, daddr, order);
@@ -389,3 +480,21 @@ void amd_iommu_flush_all_caches(struct amd_iommu *iommu)
     invalidate_iommu_all(iommu);
     flush_command_buffer(iommu, 0);
 }
+
+void cf_check amd_iommu_dump_info(unsigned char key)
+{
+    const struct amd_iommu *iommu;
+
+    for_each_amd_iommu ( iommu )
+        printk("AMD IOMMU %pp: %lu IOTLB invalidations (%lu batched),"
+               " %lu waits (avg %"PRI_stime"ns, max %"PRI_stime"ns)\n",
+               &PCI_SBDF(iommu->seg, iommu->bdf),
+               iommu->cmd_stats.iotlb, iommu->cmd_stats.deferred,
+               iommu->cmd_stats.waits,
+               iommu->cmd_stats.waits
+               ? iommu->cmd_stats.wait_time / iommu->cmd_stats.waits : 0,
+               iommu->cmd_stats.wait_max);
+
+    if ( iommu_intremap != iommu_intremap_off )
+        amd_iommu_dump_intremap_tables(key);
+}
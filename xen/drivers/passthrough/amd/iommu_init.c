@@ -1481,9 +1481,7 @@ int __init amd_iommu_init(bool xt)
             goto error_out;
     }
 
-    if ( iommu_intremap != iommu_intremap_off )
-        register_keyhandler('V', &amd_iommu_dump_intremap_tables,
-                            "dump IOMMU intremap tables", 0);
+    register_keyhandler('V', &amd_iommu_dump_info, "dump iommu info", 0);
 
     return 0;
 
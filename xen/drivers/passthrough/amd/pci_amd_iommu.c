@@ -778,6 +778,8 @@ static const struct iommu_ops __initconst_cf_clobber _iommu_ops = {
     .map_page = amd_iommu_map_page,
     .unmap_page = amd_iommu_unmap_page,
     .iotlb_flush = amd_iommu_flush_iotlb_pages,
+    .flush_batch_begin = amd_iommu_flush_batch_begin,
+    .flush_batch_end = amd_iommu_flush_batch_end,
     .reassign_device = reassign_device,
     .get_device_group_id = amd_iommu_group_id,
     .enable_x2apic = iov_enable_xt,
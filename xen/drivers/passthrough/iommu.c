@@ -18,6 +18,7 @@
 #include <xen/guest_access.h>
 #include <xen/event.h>
 #include <xen/param.h>
+#include <xen/perfc.h>
 #include <xen/softirq.h>
 #include <xen/keyhandler.h>
 #include <xsm/xsm.h>
@@ -65,6 +66,25 @@ bool __read_mostly iommu_debug;
 
 DEFINE_PER_CPU(bool, iommu_dont_flush_iotlb);
 
+/*
+ * Per-CPU state of a flush batch: its nesting depth, and the range of IOTLB
+ * entries which iommu_legacy_{,un}map() left to be flushed at its end.
+ */
+struct iommu_flush_batch {
+    unsigned int depth;
+    struct domain *d;
+    dfn_t dfn;
+    unsigned long page_count;
+    unsigned int flush_flags;
+};
+static DEFINE_PER_CPU(struct iommu_flush_batch, iommu_flush_batch);
+
+/*
+ * Disjoint ranges are only merged into one flush if they fall within the
+ * same aligned block of this order, i.e. a 2M superpage's worth of pages.
+ */
+#define IOMMU_FLUSH_MERGE_ORDER 9
+
 static int __init cf_check parse_iommu_param(const char *s)
 {
     const char *ss;
@@ -381,6 +401,63 @@ long iommu_map(struct domain *d, dfn_t dfn0, mfn_t mfn0,
     return rc;
 }
 
+static int iommu_flush_batch_flush(struct iommu_flush_batch *batch)
+{
+    int rc = iommu_iotlb_flush(batch->d, batch->dfn, batch->page_count,
+                               batch->flush_flags);
+
+    batch->d = NULL;
+    batch->page_count = 0;
+    batch->flush_flags = 0;
+
+    return rc;
+}
+
+/*
+ * Fold a flush into the pending range of the batch, provided the two are
+ * for the same domain and are adjacent, overlap, or are close enough to be
+ * covered by one flush of a small aligned block.  Otherwise flush what is
+ * pending, and start a new range.
+ */
+static int iommu_flush_batch_add(struct domain *d, dfn_t dfn,
+                                 unsigned long page_count,
+                                 unsigned int flush_flags)
+{
+    struct iommu_flush_batch *batch = &this_cpu(iommu_flush_batch);
+    int rc = 0;
+
+    if ( !page_count || !flush_flags )
+        return 0;
+
+    if ( batch->page_count )
+    {
+        unsigned long start = min(dfn_x(batch->dfn), dfn_x(dfn));
+        unsigned long end = max(dfn_x(batch->dfn) + batch->page_count,
+                                dfn_x(dfn) + page_count);
+
+        if ( batch->d == d &&
+             (end - start <= batch->page_count + page_count ||
+              !((start ^ (end - 1)) >> IOMMU_FLUSH_MERGE_ORDER)) )
+        {
+            batch->dfn = _dfn(start);
+            batch->page_count = end - start;
+            batch->flush_flags |= flush_flags;
+            perfc_incr(iommu_flush_merged);
+
+            return 0;
+        }
+
+        rc = iommu_flush_batch_flush(batch);
+    }
+
+    batch->d = d;
+    batch->dfn = dfn;
+    batch->page_count = page_count;
+    batch->flush_flags = flush_flags;
+
+    return rc;
+}
+
 int iommu_legacy_map(struct domain *d, dfn_t dfn, mfn_t mfn,
                      unsigned long page_count, unsigned int flags)
 {
@@ -390,7 +467,11 @@ int iommu_legacy_map(struct domain *d, dfn_t dfn, mfn_t mfn,
     ASSERT(!(flags & IOMMUF_preempt));
     rc = iommu_map(d, dfn, mfn, page_count, flags, &flush_flags);
 
-    if ( !this_cpu(iommu_dont_flush_iotlb) && !rc )
+    if ( this_cpu(iommu_dont_flush_iotlb) || rc )
+        ;
+    else if ( this_cpu(iommu_flush_batch).depth )
+        rc = iommu_flush_batch_add(d, dfn, page_count, flush_flags);
+    else
         rc = iommu_iotlb_flush(d, dfn, page_count, flush_flags);
 
     return rc;
@@ -458,12 +539,53 @@ int iommu_legacy_unmap(struct domain *d, dfn_t dfn, unsigned long page_count)
     unsigned int flush_flags = 0;
     int rc = iommu_unmap(d, dfn, page_count, 0, &flush_flags);
 
-    if ( !this_cpu(iommu_dont_flush_iotlb) && !rc )
+    if ( this_cpu(iommu_dont_flush_iotlb) || rc )
+        ;
+    else if ( this_cpu(iommu_flush_batch).depth )
+        rc = iommu_flush_batch_add(d, dfn, page_count, flush_flags);
+    else
         rc = iommu_iotlb_flush(d, dfn, page_count, flush_flags);
 
     return rc;
 }
 
+void iommu_flush_batch_begin(void)
+{
+    const struct iommu_ops *ops;
+
+    if ( !iommu_enabled )
+        return;
+
+    this_cpu(iommu_flush_batch).depth++;
+
+    ops = iommu_get_ops();
+    if ( ops->flush_batch_begin )
+        iommu_vcall(ops, flush_batch_begin);
+}
+
+void iommu_flush_batch_end(void)
+{
+    struct iommu_flush_batch *batch = &this_cpu(iommu_flush_batch);
+    const struct iommu_ops *ops;
+    int rc;
+
+    if ( !iommu_enabled )
+        return;
+
+    ASSERT(batch->depth);
+    if ( !--batch->depth && batch->page_count )
+        /* Failures are reported (and acted upon) by iommu_iotlb_flush(). */
+        iommu_flush_batch_flush(batch);
+
+    ops = iommu_get_ops();
+    if ( !ops->flush_batch_end )
+        return;
+
+    rc = iommu_call(ops, flush_batch_end);
+    if ( unlikely(rc) && printk_ratelimit() )
+        printk(XENLOG_ERR "IOMMU IOTLB flush batch failed: %d\n", rc);
+}
+
 int iommu_lookup_page(struct domain *d, dfn_t dfn, mfn_t *mfn,
                       unsigned int *flags)
 {
@@ -0,0 +1 @@
+cmd_drivers/passthrough/vtd/built_in.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o drivers/passthrough/vtd/built_in.o drivers/passthrough/vtd/x86/built_in.o drivers/passthrough/vtd/iommu.o drivers/passthrough/vtd/dmar.o drivers/passthrough/vtd/utils.o drivers/passthrough/vtd/qinval.o drivers/passthrough/vtd/intremap.o drivers/passthrough/vtd/quirks.o
@@ -39,6 +39,8 @@ void cf_check intel_iommu_disable_eim(void);
 
 int enable_qinval(struct vtd_iommu *iommu);
 void disable_qinval(struct vtd_iommu *iommu);
+void cf_check qinval_batch_begin(void);
+int __must_check cf_check qinval_batch_end(void);
 int enable_intremap(struct vtd_iommu *iommu, int eim);
 void disable_intremap(struct vtd_iommu *iommu);
 
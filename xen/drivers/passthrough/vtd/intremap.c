@@ -24,6 +24,7 @@
 #include <xen/list.h>
 #include <xen/pci.h>
 #include <xen/pci_regs.h>
+#include <xen/perfc.h>
 #include "iommu.h"
 #include "dmar.h"
 #include "vtd.h"
@@ -602,11 +603,22 @@ static int msi_msg_to_remap_entry(
     remap_rte->address_hi = 0;
     remap_rte->data = index - i;
 
-    update_irte(iommu, iremap_entry, &new_ire, msi_desc->irte_initialized);
-    msi_desc->irte_initialized = true;
+    /*
+     * Re-writing an unchanged entry, e.g. when the guest re-programs an MSI
+     * for the same (posted) destination, needs neither the update nor the
+     * synchronous invalidation of the interrupt entry cache.
+     */
+    if ( msi_desc->irte_initialized && iremap_entry->val == new_ire.val )
+        perfc_incr(iommu_irte_unchanged);
+    else
+    {
+        update_irte(iommu, iremap_entry, &new_ire,
+                    msi_desc->irte_initialized);
+        msi_desc->irte_initialized = true;
 
-    iommu_sync_cache(iremap_entry, sizeof(*iremap_entry));
-    iommu_flush_iec_index(iommu, 0, index);
+        iommu_sync_cache(iremap_entry, sizeof(*iremap_entry));
+        iommu_flush_iec_index(iommu, 0, index);
+    }
 
     unmap_vtd_domain_page(iremap_entries);
     spin_unlock_irqrestore(&iommu->intremap.lock, flags);
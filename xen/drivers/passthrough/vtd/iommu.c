@@ -739,7 +739,8 @@ static int __must_check cf_check iommu_flush_iotlb(struct domain *d, dfn_t dfn,
     struct vtd_iommu *iommu;
     bool flush_dev_iotlb;
     int iommu_domid;
-    int ret = 0;
+    unsigned int order = 0;
+    int ret = 0, rc;
 
     if ( flush_flags & IOMMU_FLUSHF_all )
     {
@@ -750,16 +751,30 @@ static int __must_check cf_check iommu_flush_iotlb(struct domain *d, dfn_t dfn,
     {
         ASSERT(page_count && !dfn_eq(dfn, INVALID_DFN));
         ASSERT(flush_flags);
+
+        /*
+         * Page selective invalidation covers naturally aligned blocks only.
+         * Use the smallest one covering the range, rather than resorting to
+         * a domain selective one for every range which isn't such a block.
+         * iommu_flush_iotlb_psi() still falls back to the latter for blocks
+         * larger than the hardware supports.
+         */
+        order = flsl(dfn_x(dfn) ^ (dfn_x(dfn) + page_count - 1));
+        dfn = _dfn(dfn_x(dfn) & ~((1UL << order) - 1));
     }
 
+    /*
+     * Queue the invalidations on all IOMMUs first, so they get processed in
+     * parallel, before waiting for any of them.
+     */
+    qinval_batch_begin();
+
     /*
      * No need pcideves_lock here because we have flush
      * when assign/deassign device
      */
     for_each_drhd_unit ( drhd )
     {
-        int rc;
-
         iommu = drhd->iommu;
 
         if ( !test_bit(iommu->index, hd->arch.vtd.iommu_bitmap) )
@@ -770,14 +785,12 @@ static int __must_check cf_check iommu_flush_iotlb(struct domain *d, dfn_t dfn,
         if ( iommu_domid == -1 )
             continue;
 
-        if ( !page_count || (page_count & (page_count - 1)) ||
-             dfn_eq(dfn, INVALID_DFN) || !IS_ALIGNED(dfn_x(dfn), page_count) )
+        if ( !page_count || dfn_eq(dfn, INVALID_DFN) )
             rc = iommu_flush_iotlb_dsi(iommu, iommu_domid,
                                        0, flush_dev_iotlb);
         else
             rc = iommu_flush_iotlb_psi(iommu, iommu_domid,
-                                       dfn_to_daddr(dfn),
-                                       get_order_from_pages(page_count),
+                                       dfn_to_daddr(dfn), order,
                                        !(flush_flags & IOMMU_FLUSHF_modified),
                                        flush_dev_iotlb);
 
@@ -787,6 +800,10 @@ static int __must_check cf_check iommu_flush_iotlb(struct domain *d, dfn_t dfn,
             ret = rc;
     }
 
+    rc = qinval_batch_end();
+    if ( !ret )
+        ret = rc;
+
     return ret;
 }
 
@@ -3252,6 +3269,8 @@ static const struct iommu_ops __initconst_cf_clobber vtd_ops = {
     .resume = vtd_resume,
     .crash_shutdown = vtd_crash_shutdown,
     .iotlb_flush = iommu_flush_iotlb,
+    .flush_batch_begin = qinval_batch_begin,
+    .flush_batch_end = qinval_batch_end,
     .get_reserved_device_memory = intel_iommu_get_reserved_device_memory,
     .dump_page_tables = vtd_dump_page_tables,
     .quiesce = vtd_quiesce,
@@ -488,6 +488,15 @@ struct vtd_iommu {
     struct acpi_drhd_unit *drhd;
 
     uint64_t qinval_maddr;   /* queue invalidation page machine address */
+    cpumask_t qinval_batch;  /* CPUs with invalidations yet to wait for */
+
+    struct {
+        unsigned long iotlb;     /* IOTLB invalidations queued */
+        unsigned long deferred;  /* ... with the wait left to a batch */
+        unsigned long waits;     /* wait descriptors queued */
+        s_time_t wait_time;      /* total and longest time spent waiting */
+        s_time_t wait_max;
+    } qinval_stats;
 
     struct {
         uint64_t maddr;   /* interrupt remap table machine address */
@@ -36,9 +36,16 @@
 #define QINVAL_STAT_INIT  0
 #define QINVAL_STAT_DONE  1
 
+/* Max number of IOTLB invalidations a CPU may have queued without a wait. */
+#define QINVAL_BATCH_MAX  16
+
 static unsigned int __read_mostly qi_pg_order;
 static unsigned int __read_mostly qi_entry_nr;
 
+/* Nesting depth of flush batches, and invalidations queued within them. */
+static DEFINE_PER_CPU(unsigned int, qi_batch_depth);
+static DEFINE_PER_CPU(unsigned int, qi_batch_pending);
+
 static int __must_check invalidate_sync(struct vtd_iommu *iommu);
 
 static void print_qi_regs(const struct vtd_iommu *iommu)
@@ -116,10 +123,9 @@ static int __must_check queue_invalidate_context_sync(struct vtd_iommu *iommu,
     return invalidate_sync(iommu);
 }
 
-static int __must_check queue_invalidate_iotlb_sync(struct vtd_iommu *iommu,
-                                                    u8 granu, u8 dr, u8 dw,
-                                                    u16 did, u8 am, u8 ih,
-                                                    u64 addr)
+static void queue_invalidate_iotlb(struct vtd_iommu *iommu,
+                                   u8 granu, u8 dr, u8 dw,
+                                   u16 did, u8 am, u8 ih, u64 addr)
 {
     unsigned long flags;
     unsigned int index;
@@ -143,11 +149,10 @@ static int __must_check queue_invalidate_iotlb_sync(struct vtd_iommu *iommu,
     qinval_entry->q.iotlb_inv_dsc.hi.addr = addr >> PAGE_SHIFT_4K;
 
     qinval_update_qtail(iommu, index);
+    iommu->qinval_stats.iotlb++;
     spin_unlock_irqrestore(&iommu->register_lock, flags);
 
     unmap_vtd_domain_page(qinval_entry);
-
-    return invalidate_sync(iommu);
 }
 
 static int __must_check queue_invalidate_wait(struct vtd_iommu *iommu,
@@ -174,6 +179,9 @@ static int __must_check queue_invalidate_wait(struct vtd_iommu *iommu,
     qinval_entry->q.inv_wait_dsc.hi.saddr = virt_to_maddr(this_poll_slot);
 
     qinval_update_qtail(iommu, index);
+    iommu->qinval_stats.waits++;
+    /* This also covers whatever this CPU left to wait for in a batch. */
+    cpumask_clear_cpu(smp_processor_id(), &iommu->qinval_batch);
     spin_unlock_irqrestore(&iommu->register_lock, flags);
 
     unmap_vtd_domain_page(qinval_entry);
@@ -182,7 +190,7 @@ static int __must_check queue_invalidate_wait(struct vtd_iommu *iommu,
     if ( sw )
     {
         static unsigned int __read_mostly threshold = 1;
-        s_time_t start = NOW();
+        s_time_t start = NOW(), elapsed;
         s_time_t timeout = start + (flush_dev_iotlb
                                     ? iommu_dev_iotlb_timeout
                                     : 100) * MILLISECS(threshold);
@@ -201,11 +209,19 @@ static int __must_check queue_invalidate_wait(struct vtd_iommu *iommu,
             cpu_relax();
         }
 
+        elapsed = NOW() - start;
+
         if ( !timeout )
             printk(XENLOG_WARNING VTDPREFIX
                    " IOMMU#%u: QI%s wait descriptor took %lums\n",
                    iommu->index, flush_dev_iotlb ? " dev" : "",
-                   (NOW() - start) / 10000000);
+                   elapsed / 10000000);
+
+        spin_lock_irqsave(&iommu->register_lock, flags);
+        iommu->qinval_stats.wait_time += elapsed;
+        if ( elapsed > iommu->qinval_stats.wait_max )
+            iommu->qinval_stats.wait_max = elapsed;
+        spin_unlock_irqrestore(&iommu->register_lock, flags);
 
         return 0;
     }
@@ -220,6 +236,54 @@ static int __must_check invalidate_sync(struct vtd_iommu *iommu)
     return queue_invalidate_wait(iommu, 0, 1, 1, 0);
 }
 
+/*
+ * Within a flush batch, IOTLB invalidations don't wait for their completion
+ * one by one.  Instead each IOMMU they were queued on gets a single wait
+ * descriptor, as late as possible: when the outermost batch ends, or once
+ * QINVAL_BATCH_MAX invalidations were queued without one.
+ */
+void cf_check qinval_batch_begin(void)
+{
+    this_cpu(qi_batch_depth)++;
+}
+
+static int __must_check qinval_batch_sync(void)
+{
+    const struct acpi_drhd_unit *drhd;
+    unsigned int cpu = smp_processor_id();
+    int rc = 0;
+
+    if ( !this_cpu(qi_batch_pending) )
+        return 0;
+
+    this_cpu(qi_batch_pending) = 0;
+
+    for_each_drhd_unit ( drhd )
+    {
+        struct vtd_iommu *iommu = drhd->iommu;
+        int ret;
+
+        if ( !cpumask_test_cpu(cpu, &iommu->qinval_batch) )
+            continue;
+
+        ret = invalidate_sync(iommu);
+        if ( !rc )
+            rc = ret;
+    }
+
+    return rc;
+}
+
+int cf_check qinval_batch_end(void)
+{
+    ASSERT(this_cpu(qi_batch_depth));
+
+    if ( --this_cpu(qi_batch_depth) )
+        return 0;
+
+    return qinval_batch_sync();
+}
+
 static int __must_check dev_invalidate_sync(struct vtd_iommu *iommu,
                                             struct pci_dev *pdev, u16 did)
 {
@@ -374,9 +438,31 @@ static int __must_check cf_check flush_iotlb_qi(
     if (cap_read_drain(iommu->cap))
         dr = 1;
     /* Need to conside the ih bit later */
-    rc = queue_invalidate_iotlb_sync(iommu,
-                                     type >> DMA_TLB_FLUSH_GRANU_OFFSET,
-                                     dr, dw, did, size_order, 0, addr);
+    queue_invalidate_iotlb(iommu, type >> DMA_TLB_FLUSH_GRANU_OFFSET,
+                           dr, dw, did, size_order, 0, addr);
+
+    /*
+     * Device-TLB invalidations have to follow completion of the IOTLB one,
+     * and the IGD errata workarounds only cover the flush up to the caller
+     * returning, so neither can have the wait deferred.
+     */
+    if ( this_cpu(qi_batch_depth) && !flush_dev_iotlb &&
+         !is_igd_drhd(iommu->drhd) )
+    {
+        unsigned long flags;
+
+        spin_lock_irqsave(&iommu->register_lock, flags);
+        cpumask_set_cpu(smp_processor_id(), &iommu->qinval_batch);
+        iommu->qinval_stats.deferred++;
+        spin_unlock_irqrestore(&iommu->register_lock, flags);
+
+        if ( ++this_cpu(qi_batch_pending) < QINVAL_BATCH_MAX )
+            return 0;
+
+        rc = qinval_batch_sync();
+    }
+    else
+        rc = invalidate_sync(iommu);
     if ( !ret )
         ret = rc;
 
@@ -412,10 +498,19 @@ int enable_qinval(struct vtd_iommu *iommu)
              * can be one such pair of requests pending per CPU.  One extra
              * entry is needed as the ring is considered full when there's
              * only one entry left.
+             *
+             * Flush batches can have up to QINVAL_BATCH_MAX invalidations
+             * pending per CPU ahead of their wait.  Size the ring for these
+             * as well as far as possible; when full, queueing merely waits
+             * for the hardware to process older entries.
              */
             BUILD_BUG_ON(CONFIG_NR_CPUS * 2 >= QINVAL_MAX_ENTRY_NR);
-            qi_pg_order = get_order_from_bytes((num_present_cpus() * 2 + 1) *
-                                               sizeof(struct qinval_entry));
+            qi_pg_order = get_order_from_bytes(
+                (num_present_cpus() * (QINVAL_BATCH_MAX + 1) + 1) *
+                sizeof(struct qinval_entry));
+            qi_pg_order = min(qi_pg_order,
+                              get_order_from_bytes(QINVAL_MAX_ENTRY_NR *
+                                                   sizeof(struct qinval_entry)));
             qi_entry_nr = (PAGE_SIZE << qi_pg_order) /
                           sizeof(struct qinval_entry);
 
@@ -175,6 +175,15 @@ void cf_check vtd_dump_iommu_info(unsigned char key)
             ecap_queued_inval(iommu->ecap) ? "" : "not ",
            (status & DMA_GSTS_QIES) ? " and enabled" : "" );
 
+        if ( iommu->qinval_maddr )
+            printk("  QI: %lu IOTLB invalidations (%lu batched), %lu waits"
+                   " (avg %"PRI_stime"ns, max %"PRI_stime"ns)\n",
+                   iommu->qinval_stats.iotlb, iommu->qinval_stats.deferred,
+                   iommu->qinval_stats.waits,
+                   iommu->qinval_stats.waits
+                   ? iommu->qinval_stats.wait_time / iommu->qinval_stats.waits
+                   : 0,
+                   iommu->qinval_stats.wait_max);
 
         printk("  Interrupt Remapping: %ssupported%s.\n",
             ecap_intr_remap(iommu->ecap) ? "" : "not ",
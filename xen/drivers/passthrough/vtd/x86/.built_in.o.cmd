@@ -0,0 +1 @@
+cmd_drivers/passthrough/vtd/x86/built_in.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o drivers/passthrough/vtd/x86/built_in.o drivers/passthrough/vtd/x86/ats.o drivers/passthrough/vtd/x86/vtd.o
@@ -77,6 +77,7 @@ static void raise_softirq_for(struct hvm_pirq_dpci *pirq_dpci)
     if ( test_and_set_bit(STATE_SCHED, &pirq_dpci->state) )
         return;
 
+    pirq_dpci->raised = NOW();
     get_knownalive_domain(pirq_dpci->dom);
 
     local_irq_save(flags);
@@ -721,6 +722,35 @@ void pt_pirq_init(struct domain *d, struct hvm_pirq_dpci *dpci)
     dpci->gmsi.dest_vcpu_id = -1;
 }
 
+static void pt_pirq_record_latency(struct hvm_pirq_dpci *pirq_dpci)
+{
+    unsigned long us = (NOW() - pirq_dpci->raised) / MICROSECS(1);
+
+    pirq_dpci->latency[min_t(unsigned int, flsl(us),
+                             HVM_DPCI_LATENCY_BUCKETS - 1)]++;
+}
+
+void pt_pirq_dump_latency(const struct domain *d, const struct pirq *pirq,
+                          const struct msi_desc *msi_desc)
+{
+    const struct hvm_pirq_dpci *pirq_dpci = &pirq->arch.hvm.dpci;
+    unsigned int i;
+    unsigned long total = 0;
+
+    for ( i = 0; i < HVM_DPCI_LATENCY_BUCKETS; i++ )
+        total += pirq_dpci->latency[i];
+    if ( !total )
+        return;
+
+    printk("      d%d:%d", d->domain_id, pirq->pirq);
+    if ( msi_desc && msi_desc->dev )
+        printk(" %pp", &msi_desc->dev->sbdf);
+    printk(" latency:");
+    for ( i = 0; i < HVM_DPCI_LATENCY_BUCKETS - 1; i++ )
+        printk(" <%uus:%lu", 1U << i, pirq_dpci->latency[i]);
+    printk(" >=%uus:%lu\n", 1U << (i - 1), pirq_dpci->latency[i]);
+}
+
 bool pt_pirq_cleanup_check(struct hvm_pirq_dpci *dpci)
 {
     if ( !dpci->flags && !pt_pirq_softirq_active(dpci) )
@@ -844,6 +874,8 @@ static void hvm_dirq_assist(struct domain *d, struct hvm_pirq_dpci *pirq_dpci)
         struct pirq *pirq = dpci_pirq(pirq_dpci);
         const struct dev_intx_gsi_link *digl;
 
+        pt_pirq_record_latency(pirq_dpci);
+
         if ( hvm_domain_use_pirq(d, pirq) )
         {
             send_guest_pirq(d, pirq);
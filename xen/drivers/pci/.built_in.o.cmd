@@ -0,0 +1 @@
+cmd_drivers/pci/built_in.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o drivers/pci/built_in.o drivers/pci/pci.o drivers/pci/physdev.o
@@ -0,0 +1 @@
+cmd_drivers/vpci/built_in.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o drivers/vpci/built_in.o drivers/vpci/vpci.o drivers/vpci/header.o drivers/vpci/rebar.o drivers/vpci/msi.o drivers/vpci/msix.o
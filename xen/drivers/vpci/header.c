@@ -46,8 +46,20 @@ static int cf_check map_range(
     unsigned long start_gfn = PFN_DOWN(map->bar->guest_addr);
     /* Physical start address of the BAR. */
     unsigned long start_mfn = PFN_DOWN(map->bar->addr);
+    /* First guest frame of the range processed by this invocation. */
+    unsigned long first = s;
     int rc;
 
+#ifdef CONFIG_HAS_PASSTHROUGH
+    /*
+     * Don't flush the IOMMU TLB for each (super)page installed or removed,
+     * instead issue a single flush for the whole range processed before
+     * returning, be it because of completion, error or preemption.
+     */
+    if ( is_iommu_enabled(map->d) )
+        this_cpu(iommu_dont_flush_iotlb) = true;
+#endif
+
     for ( ; ; )
     {
         unsigned long size = e - s + 1;
@@ -64,7 +76,8 @@ static int cf_check map_range(
             printk(XENLOG_G_WARNING
                    "%pd denied access to MMIO range [%#lx, %#lx]\n",
                    map->d, map_mfn, m_end);
-            return -EPERM;
+            rc = -EPERM;
+            break;
         }
 
         rc = xsm_iomem_mapping(XSM_HOOK, map->d, map_mfn, m_end, map->map);
@@ -73,7 +86,7 @@ static int cf_check map_range(
             printk(XENLOG_G_WARNING
                    "%pd XSM denied access to MMIO range [%#lx, %#lx]: %d\n",
                    map->d, map_mfn, m_end, rc);
-            return rc;
+            break;
         }
 
         /*
@@ -90,6 +103,7 @@ static int cf_check map_range(
         if ( rc == 0 )
         {
             *c += size;
+            s += size;
             break;
         }
         if ( rc < 0 )
@@ -104,8 +118,37 @@ static int cf_check map_range(
         *c += rc;
         s += rc;
         if ( general_preempt_check() )
-                return -ERESTART;
+        {
+            rc = -ERESTART;
+            break;
+        }
+    }
+
+    perfc_add(vpci_bar_pages, s - first);
+
+#ifdef CONFIG_HAS_PASSTHROUGH
+    if ( is_iommu_enabled(map->d) )
+    {
+        int ret;
+
+        this_cpu(iommu_dont_flush_iotlb) = false;
+
+        /*
+         * Ranges being {un}mapped by vPCI are either unpopulated or belong to
+         * the BAR being toggled, so a single flush covering the processed
+         * range is enough.  On error the pages processed so far still need
+         * flushing, as the p2m has been modified.
+         */
+        ret = iommu_iotlb_flush(map->d, _dfn(first), s - first,
+                                map->map ? IOMMU_FLUSHF_added |
+                                           IOMMU_FLUSHF_modified
+                                         : IOMMU_FLUSHF_modified);
+        if ( s != first )
+            perfc_incr(vpci_bar_iotlb_flush);
+        if ( unlikely(ret) && (!rc || rc == -ERESTART) )
+            rc = ret;
     }
+#endif
 
     return rc;
 }
@@ -173,6 +216,22 @@ static void modify_decoding(const struct pci_dev *pdev, uint16_t cmd,
         ASSERT_UNREACHABLE();
 }
 
+/*
+ * Account the time elapsed since the guest toggled the memory decoding bit
+ * (or the ROM enable bit), in power of 2 microsecond buckets.
+ */
+static void account_toggle(const struct vcpu *v)
+{
+#ifdef CONFIG_PERF_COUNTERS
+    s_time_t us = (NOW() - v->vpci.start) / MICROSECS(1);
+
+    perfc_incra(vpci_cmd_write_time,
+                min_t(unsigned int, us > 0 ? flsl(us) : 0,
+                      PERFC_LAST_vpci_cmd_write_time -
+                      PERFC_vpci_cmd_write_time));
+#endif
+}
+
 bool vpci_process_pending(struct vcpu *v)
 {
     struct pci_dev *pdev = v->vpci.pdev;
@@ -227,6 +286,7 @@ bool vpci_process_pending(struct vcpu *v)
                      rangeset_purge(header->bars[i].mem);
 
             v->vpci.pdev = NULL;
+            account_toggle(v);
 
             read_unlock(&v->domain->pci_lock);
 
@@ -242,6 +302,8 @@ bool vpci_process_pending(struct vcpu *v)
     modify_decoding(pdev, v->vpci.cmd, v->vpci.rom_only);
     spin_unlock(&pdev->vpci->lock);
 
+    account_toggle(v);
+
     read_unlock(&v->domain->pci_lock);
 
     return false;
@@ -297,6 +359,9 @@ static void defer_map(struct domain *d, struct pci_dev *pdev,
     curr->vpci.pdev = pdev;
     curr->vpci.cmd = cmd;
     curr->vpci.rom_only = rom_only;
+#ifdef CONFIG_PERF_COUNTERS
+    curr->vpci.start = NOW();
+#endif
     /*
      * Raise a scheduler softirq in order to prevent the guest from resuming
      * execution with pending mapping operations, to trigger the invocation
@@ -541,6 +606,8 @@ static void cf_check cmd_write(
      * handled above and by the rsvdp_mask.
      */
     if ( header->bars_mapped != !!(cmd & PCI_COMMAND_MEMORY) )
+    {
+        perfc_incr(vpci_cmd_writes);
         /*
          * Ignore the error. No memory has been added or removed from the p2m
          * (because the actual p2m changes are deferred in defer_map) and the
@@ -548,6 +615,7 @@ static void cf_check cmd_write(
          * hoping the guest will realize and try again.
          */
         modify_bars(pdev, cmd, false);
+    }
     else
         pci_conf_write16(pdev->sbdf, reg, cmd);
 }
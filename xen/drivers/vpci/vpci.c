@@ -28,7 +28,6 @@ struct vpci_register {
     unsigned int size;
     unsigned int offset;
     void *private;
-    struct list_head node;
     uint32_t ro_mask;
     uint32_t rw1c_mask;
     uint32_t rsvdp_mask;
@@ -99,15 +98,12 @@ void vpci_deassign_device(struct pci_dev *pdev)
 #endif
 
     spin_lock(&pdev->vpci->lock);
-    while ( !list_empty(&pdev->vpci->handlers) )
-    {
-        struct vpci_register *r = list_first_entry(&pdev->vpci->handlers,
-                                                   struct vpci_register,
-                                                   node);
-
-        list_del(&r->node);
-        xfree(r);
-    }
+    for ( i = 0; i < pdev->vpci->nr_regs; i++ )
+        xfree(pdev->vpci->regs[i]);
+    XFREE(pdev->vpci->regs);
+    XFREE(pdev->vpci->reg_index);
+    pdev->vpci->nr_regs = 0;
+    pdev->vpci->reg_index_size = 0;
     spin_unlock(&pdev->vpci->lock);
     if ( pdev->vpci->msix )
     {
@@ -149,7 +145,6 @@ int vpci_assign_device(struct pci_dev *pdev)
     if ( !pdev->vpci )
         return -ENOMEM;
 
-    INIT_LIST_HEAD(&pdev->vpci->handlers);
     spin_lock_init(&pdev->vpci->lock);
 
 #ifdef CONFIG_HAS_VPCI_GUEST_SUPPORT
@@ -203,19 +198,65 @@ static const struct pci_dev *translate_virtual_device(const struct domain *d,
     return NULL;
 }
 
-static int vpci_register_cmp(const struct vpci_register *r1,
-                             const struct vpci_register *r2)
+/*
+ * Return the position in vpci->regs of the first register that ends past
+ * 'offset', or vpci->nr_regs if there's none.  Registers never overlap, so
+ * all the registers an access can touch are found by walking forward from
+ * the returned position.
+ */
+static unsigned int vpci_find_register(const struct vpci *vpci,
+                                       unsigned int offset)
 {
-    /* Return 0 if registers overlap. */
-    if ( r1->offset < r2->offset + r2->size &&
-         r2->offset < r1->offset + r1->size )
-        return 0;
-    if ( r1->offset < r2->offset )
-        return -1;
-    if ( r1->offset > r2->offset )
-        return 1;
+    unsigned int pos;
+
+    if ( offset / 4 >= vpci->reg_index_size )
+        return vpci->nr_regs;
+
+    /* Skip registers in the same dword that end before 'offset'. */
+    for ( pos = vpci->reg_index[offset / 4]; pos < vpci->nr_regs; pos++ )
+        if ( vpci->regs[pos]->offset + vpci->regs[pos]->size > offset )
+            break;
+
+    return pos;
+}
+
+/*
+ * Rebuild the per-dword index into vpci->regs.  reg_index[i] holds the
+ * position of the first register ending past offset i * 4, and the index
+ * only covers dwords up to the last one containing a register, so accesses
+ * past it need no lookup at all.  The index never shrinks its allocation,
+ * hence only growing it can fail.
+ */
+static int vpci_update_index(struct vpci *vpci)
+{
+    unsigned int size = 0, dword, pos = 0;
+
+    if ( vpci->nr_regs )
+    {
+        const struct vpci_register *last = vpci->regs[vpci->nr_regs - 1];
+
+        size = (last->offset + last->size - 1) / 4 + 1;
+    }
+
+    if ( size > vpci->reg_index_size )
+    {
+        uint16_t *index = xrealloc_array(vpci->reg_index, size);
+
+        if ( !index )
+            return -ENOMEM;
+
+        vpci->reg_index = index;
+    }
+
+    for ( dword = 0; dword < size; dword++ )
+    {
+        while ( vpci->regs[pos]->offset + vpci->regs[pos]->size <= dword * 4 )
+            pos++;
+        vpci->reg_index[dword] = pos;
+    }
+
+    vpci->reg_index_size = size;
 
-    ASSERT_UNREACHABLE();
     return 0;
 }
 
@@ -267,8 +308,9 @@ int vpci_add_register_mask(struct vpci *vpci, vpci_read_t *read_handler,
                            uint32_t rw1c_mask, uint32_t rsvdp_mask,
                            uint32_t rsvdz_mask)
 {
-    struct list_head *prev;
-    struct vpci_register *r;
+    struct vpci_register *r, **regs;
+    unsigned int pos;
+    int rc;
 
     /* Some sanity checks. */
     if ( (size != 1 && size != 2 && size != 4) ||
@@ -299,57 +341,73 @@ int vpci_add_register_mask(struct vpci *vpci, vpci_read_t *read_handler,
 
     spin_lock(&vpci->lock);
 
-    /* The list of handlers must be kept sorted at all times. */
-    list_for_each ( prev, &vpci->handlers )
-    {
-        const struct vpci_register *this =
-            list_entry(prev, const struct vpci_register, node);
-        int cmp = vpci_register_cmp(r, this);
+    /* The array of handlers must be kept sorted at all times. */
+    pos = vpci_find_register(vpci, offset);
+    rc = -EEXIST;
+    if ( pos < vpci->nr_regs && vpci->regs[pos]->offset < offset + size )
+        goto fail;
 
-        if ( cmp < 0 )
-            break;
-        if ( cmp == 0 )
-        {
-            spin_unlock(&vpci->lock);
-            xfree(r);
-            return -EEXIST;
-        }
+    rc = -ENOMEM;
+    regs = xrealloc_array(vpci->regs, vpci->nr_regs + 1);
+    if ( !regs )
+        goto fail;
+    vpci->regs = regs;
+
+    memmove(&regs[pos + 1], &regs[pos],
+            (vpci->nr_regs - pos) * sizeof(*regs));
+    regs[pos] = r;
+    vpci->nr_regs++;
+
+    rc = vpci_update_index(vpci);
+    if ( rc )
+    {
+        vpci->nr_regs--;
+        memmove(&regs[pos], &regs[pos + 1],
+                (vpci->nr_regs - pos) * sizeof(*regs));
+        goto fail;
     }
 
-    list_add_tail(&r->node, prev);
     spin_unlock(&vpci->lock);
 
     return 0;
+
+ fail:
+    spin_unlock(&vpci->lock);
+    xfree(r);
+
+    return rc;
 }
 
 int vpci_remove_register(struct vpci *vpci, unsigned int offset,
                          unsigned int size)
 {
-    const struct vpci_register r = { .offset = offset, .size = size };
     struct vpci_register *rm;
+    unsigned int pos;
+    int rc;
 
     spin_lock(&vpci->lock);
-    list_for_each_entry ( rm, &vpci->handlers, node )
-    {
-        int cmp = vpci_register_cmp(&r, rm);
 
-        /*
-         * NB: do not use a switch so that we can use break to
-         * get out of the list loop earlier if required.
-         */
-        if ( !cmp && rm->offset == offset && rm->size == size )
-        {
-            list_del(&rm->node);
-            spin_unlock(&vpci->lock);
-            xfree(rm);
-            return 0;
-        }
-        if ( cmp <= 0 )
-            break;
+    pos = vpci_find_register(vpci, offset);
+    if ( pos >= vpci->nr_regs || vpci->regs[pos]->offset != offset ||
+         vpci->regs[pos]->size != size )
+    {
+        spin_unlock(&vpci->lock);
+        return -ENOENT;
     }
+
+    rm = vpci->regs[pos];
+    vpci->nr_regs--;
+    memmove(&vpci->regs[pos], &vpci->regs[pos + 1],
+            (vpci->nr_regs - pos) * sizeof(*vpci->regs));
+
+    /* The index can only shrink, which doesn't require allocating memory. */
+    rc = vpci_update_index(vpci);
+    ASSERT(!rc);
+
     spin_unlock(&vpci->lock);
+    xfree(rm);
 
-    return -ENOENT;
+    return 0;
 }
 
 /* Wrappers for performing reads/writes to the underlying hardware. */
@@ -465,9 +523,9 @@ uint32_t vpci_read(pci_sbdf_t sbdf, unsigned int reg, unsigned int size)
 {
     struct domain *d = current->domain;
     const struct pci_dev *pdev;
-    const struct vpci_register *r;
-    unsigned int data_offset = 0;
-    uint32_t data = ~(uint32_t)0;
+    struct vpci *vpci;
+    unsigned int i;
+    uint32_t data = ~(uint32_t)0, emulated = 0;
 
     if ( !size )
     {
@@ -497,60 +555,44 @@ uint32_t vpci_read(pci_sbdf_t sbdf, unsigned int reg, unsigned int size)
         return vpci_read_hw(sbdf, reg, size);
     }
 
-    spin_lock(&pdev->vpci->lock);
+    vpci = pdev->vpci;
+    spin_lock(&vpci->lock);
 
-    /* Read from the hardware or the emulated register handlers. */
-    list_for_each_entry ( r, &pdev->vpci->handlers, node )
+    /* Read from the emulated register handlers. */
+    for ( i = vpci_find_register(vpci, reg); i < vpci->nr_regs; i++ )
     {
-        const struct vpci_register emu = {
-            .offset = reg + data_offset,
-            .size = size - data_offset
-        };
-        int cmp = vpci_register_cmp(&emu, r);
+        const struct vpci_register *r = vpci->regs[i];
+        unsigned int start = max(reg, r->offset), read_size;
         uint32_t val;
-        unsigned int read_size;
 
-        if ( cmp < 0 )
+        if ( r->offset >= reg + size )
             break;
-        if ( cmp > 0 )
-            continue;
-
-        if ( emu.offset < r->offset )
-        {
-            /* Heading gap, read partial content from hardware. */
-            read_size = r->offset - emu.offset;
-            val = vpci_read_hw(sbdf, emu.offset, read_size);
-            data = merge_result(data, val, read_size, data_offset);
-            data_offset += read_size;
-        }
 
         val = r->read(pdev, r->offset, r->private);
         val &= ~(r->rsvdp_mask | r->rsvdz_mask);
 
         /* Check if the read is in the middle of a register. */
-        if ( r->offset < emu.offset )
-            val >>= (emu.offset - r->offset) * 8;
+        val >>= (start - r->offset) * 8;
 
         /* Find the intersection size between the two sets. */
-        read_size = min(emu.offset + emu.size, r->offset + r->size) -
-                    max(emu.offset, r->offset);
-        /* Merge the emulated data into the native read value. */
-        data = merge_result(data, val, read_size, data_offset);
-        data_offset += read_size;
-        if ( data_offset == size )
-            break;
-        ASSERT(data_offset < size);
+        read_size = min(reg + size, r->offset + r->size) - start;
+        /* Merge the emulated data into the result. */
+        data = merge_result(data, val, read_size, start - reg);
+        emulated = merge_result(emulated, ~0U, read_size, start - reg);
     }
-    spin_unlock(&pdev->vpci->lock);
+    spin_unlock(&vpci->lock);
     read_unlock(&d->pci_lock);
 
-    if ( data_offset < size )
+    if ( emulated != (0xffffffffU >> (32 - 8 * size)) )
     {
-        /* Tailing gap, read the remaining. */
-        uint32_t tmp_data = vpci_read_hw(sbdf, reg + data_offset,
-                                         size - data_offset);
+        /*
+         * Fill the gaps with the native value.  Rather than issuing one
+         * hardware access per gap, do a single read of the whole (aligned)
+         * range and only keep the bytes not provided by the handlers.
+         */
+        uint32_t hw = vpci_read_hw(sbdf, reg, size);
 
-        data = merge_result(data, tmp_data, size - data_offset, data_offset);
+        data = (data & emulated) | (hw & ~emulated);
     }
 
     return data & (0xffffffffU >> (32 - 8 * size));
@@ -587,8 +629,8 @@ void vpci_write(pci_sbdf_t sbdf, unsigned int reg, unsigned int size,
 {
     struct domain *d = current->domain;
     const struct pci_dev *pdev;
-    const struct vpci_register *r;
-    unsigned int data_offset = 0;
+    struct vpci *vpci;
+    unsigned int i, data_offset = 0;
 
     if ( !size )
     {
@@ -627,42 +669,36 @@ void vpci_write(pci_sbdf_t sbdf, unsigned int reg, unsigned int size,
         return;
     }
 
-    spin_lock(&pdev->vpci->lock);
+    vpci = pdev->vpci;
+    spin_lock(&vpci->lock);
 
     /* Write the value to the hardware or emulated registers. */
-    list_for_each_entry ( r, &pdev->vpci->handlers, node )
+    for ( i = vpci_find_register(vpci, reg); i < vpci->nr_regs; i++ )
     {
-        const struct vpci_register emu = {
-            .offset = reg + data_offset,
-            .size = size - data_offset
-        };
-        int cmp = vpci_register_cmp(&emu, r);
+        const struct vpci_register *r = vpci->regs[i];
         unsigned int write_size;
 
-        if ( cmp < 0 )
+        if ( r->offset >= reg + size )
             break;
-        if ( cmp > 0 )
-            continue;
 
-        if ( emu.offset < r->offset )
+        if ( reg + data_offset < r->offset )
         {
             /* Heading gap, write partial content to hardware. */
-            vpci_write_hw(sbdf, emu.offset, r->offset - emu.offset,
+            vpci_write_hw(sbdf, reg + data_offset,
+                          r->offset - reg - data_offset,
                           data >> (data_offset * 8));
-            data_offset += r->offset - emu.offset;
+            data_offset = r->offset - reg;
         }
 
         /* Find the intersection size between the two sets. */
-        write_size = min(emu.offset + emu.size, r->offset + r->size) -
-                     max(emu.offset, r->offset);
+        write_size = min(reg + size, r->offset + r->size) -
+                     (reg + data_offset);
         vpci_write_helper(pdev, r, write_size, reg + data_offset - r->offset,
                           data >> (data_offset * 8));
         data_offset += write_size;
-        if ( data_offset == size )
-            break;
-        ASSERT(data_offset < size);
+        ASSERT(data_offset <= size);
     }
-    spin_unlock(&pdev->vpci->lock);
+    spin_unlock(&vpci->lock);
     write_unlock(&d->pci_lock);
 
     if ( data_offset < size )
@@ -0,0 +1 @@
+cmd_include/headers++.chk := 	rm -f include/headers++.chk.new; if ! g++ -v >/dev/null 2>&1; then touch include/headers++.chk.new; exit 0; fi; get_prereq() { case $$1 in                                             include/public/io/9pfs.h) echo " -include cstring";;                         include/public/io/pvcalls.h) echo " -include cstring";;                                                   *) ;; esac; }; for i in include/public/argo.h include/public/bootfdt.h include/public/callback.h include/public/device_tree_defs.h include/public/domctl.h include/public/elfnote.h include/public/errno.h include/public/event_channel.h include/public/features.h include/public/grant_table.h include/public/hvm/dm_op.h include/public/hvm/e820.h include/public/hvm/hvm_info_table.h include/public/hvm/hvm_op.h include/public/hvm/hvm_vcpu.h include/public/hvm/hvm_xs_strings.h include/public/hvm/ioreq.h include/public/hvm/params.h include/public/hvm/pvdrivers.h include/public/hvm/save.h include/public/hypfs.h include/public/io/9pfs.h include/public/io/blkif.h include/public/io/cameraif.h include/public/io/console.h include/public/io/displif.h include/public/io/fbif.h include/public/io/fsif.h include/public/io/kbdif.h include/public/io/libxenvchan.h include/public/io/netif.h include/public/io/pciif.h include/public/io/protocols.h include/public/io/pvcalls.h include/public/io/ring.h include/public/io/sndif.h include/public/io/tpmif.h include/public/io/usbif.h include/public/io/vscsiif.h include/public/io/xenbus.h include/public/io/xs_wire.h include/public/kexec.h include/public/memory.h include/public/nmi.h include/public/physdev.h include/public/platform.h include/public/pmu.h include/public/sched.h include/public/sysctl.h include/public/tmem.h include/public/trace.h include/public/vcpu.h include/public/version.h include/public/vm_event.h include/public/xen-compat.h include/public/xen.h include/public/xencomm.h include/public/xenoprof.h include/public/xsm/flask_op.h; do echo "$(pound)include "\"$$i\" | g++ -x c++ -std=gnu++98 -Wall -Werror -D__XEN_TOOLS__ -include stdint.h -include ./include/public/xen.h $$(get_prereq $$i) -S -o /dev/null - || exit $$?; echo $$i >> include/headers++.chk.new; done; mv include/headers++.chk.new include/headers++.chk
@@ -0,0 +1 @@
+cmd_include/compat/callback.c := /root/.pyenv/shims/python3 ./tools/compat-build-source.py ./include/xlat.lst <include/public/callback.h >include/compat/callback.c.new; mv -f include/compat/callback.c.new include/compat/callback.c
@@ -0,0 +1 @@
+cmd_include/compat/elfnote.h := /root/.pyenv/shims/python3 ./tools/compat-build-header.py <include/compat/elfnote.i compat/elfnote.h >>include/compat/elfnote.h.new; mv -f include/compat/elfnote.h.new include/compat/elfnote.h
@@ -0,0 +1 @@
+cmd_include/compat/features.h := /root/.pyenv/shims/python3 ./tools/compat-build-header.py <include/compat/features.i compat/features.h >>include/compat/features.h.new; mv -f include/compat/features.h.new include/compat/features.h
@@ -0,0 +1 @@
+cmd_include/compat/grant_table.h := /root/.pyenv/shims/python3 ./tools/compat-build-header.py <include/compat/grant_table.i compat/grant_table.h >>include/compat/grant_table.h.new; mv -f include/compat/grant_table.h.new include/compat/grant_table.h
@@ -0,0 +1 @@
+cmd_include/compat/hypfs.h := /root/.pyenv/shims/python3 ./tools/compat-build-header.py <include/compat/hypfs.i compat/hypfs.h >>include/compat/hypfs.h.new; mv -f include/compat/hypfs.h.new include/compat/hypfs.h
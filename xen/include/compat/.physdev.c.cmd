@@ -0,0 +1 @@
+cmd_include/compat/physdev.c := /root/.pyenv/shims/python3 ./tools/compat-build-source.py ./include/xlat.lst <include/public/physdev.h >include/compat/physdev.c.new; mv -f include/compat/physdev.c.new include/compat/physdev.c
@@ -0,0 +1 @@
+cmd_include/compat/platform.h := /root/.pyenv/shims/python3 ./tools/compat-build-header.py <include/compat/platform.i compat/platform.h >>include/compat/platform.h.new; mv -f include/compat/platform.h.new include/compat/platform.h
@@ -0,0 +1 @@
+cmd_include/compat/pmu.c := /root/.pyenv/shims/python3 ./tools/compat-build-source.py ./include/xlat.lst <include/public/pmu.h >include/compat/pmu.c.new; mv -f include/compat/pmu.c.new include/compat/pmu.c
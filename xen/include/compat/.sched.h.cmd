@@ -0,0 +1 @@
+cmd_include/compat/sched.h := /root/.pyenv/shims/python3 ./tools/compat-build-header.py <include/compat/sched.i compat/sched.h >>include/compat/sched.h.new; mv -f include/compat/sched.h.new include/compat/sched.h
@@ -0,0 +1 @@
+cmd_include/compat/trace.c := /root/.pyenv/shims/python3 ./tools/compat-build-source.py ./include/xlat.lst <include/public/trace.h >include/compat/trace.c.new; mv -f include/compat/trace.c.new include/compat/trace.c
@@ -0,0 +1 @@
+cmd_include/compat/vcpu.c := /root/.pyenv/shims/python3 ./tools/compat-build-source.py ./include/xlat.lst <include/public/vcpu.h >include/compat/vcpu.c.new; mv -f include/compat/vcpu.c.new include/compat/vcpu.c
@@ -0,0 +1 @@
+cmd_include/compat/version.c := /root/.pyenv/shims/python3 ./tools/compat-build-source.py ./include/xlat.lst <include/public/version.h >include/compat/version.c.new; mv -f include/compat/version.c.new include/compat/version.c
@@ -0,0 +1 @@
+cmd_include/compat/xlat.h := cat include/compat/.xlat/xen.h include/compat/.xlat/arch-x86/pmu.h include/compat/.xlat/arch-x86/xen-x86_32.h include/compat/.xlat/arch-x86/xen-mca.h include/compat/.xlat/arch-x86/xen.h include/compat/.xlat/event_channel.h include/compat/.xlat/grant_table.h include/compat/.xlat/hvm/dm_op.h include/compat/.xlat/hvm/hvm_op.h include/compat/.xlat/hvm/hvm_vcpu.h include/compat/.xlat/hypfs.h include/compat/.xlat/kexec.h include/compat/.xlat/memory.h include/compat/.xlat/physdev.h include/compat/.xlat/platform.h include/compat/.xlat/pmu.h include/compat/.xlat/sched.h include/compat/.xlat/trace.h include/compat/.xlat/vcpu.h include/compat/.xlat/version.h >include/compat/xlat.h.new; mv -f include/compat/xlat.h.new include/compat/xlat.h
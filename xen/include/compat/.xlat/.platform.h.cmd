@@ -0,0 +1 @@
+cmd_include/compat/.xlat/platform.h := /root/.pyenv/shims/python3 ./tools/compat-xlat-header.py include/compat/platform.h include/compat/.xlat/platform.lst > include/compat/.xlat/platform.h.new; mv -f include/compat/.xlat/platform.h.new include/compat/.xlat/platform.h
@@ -0,0 +1 @@
+cmd_include/compat/.xlat/sched.h := /root/.pyenv/shims/python3 ./tools/compat-xlat-header.py include/compat/sched.h include/compat/.xlat/sched.lst > include/compat/.xlat/sched.h.new; mv -f include/compat/.xlat/sched.h.new include/compat/.xlat/sched.h
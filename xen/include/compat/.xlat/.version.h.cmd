@@ -0,0 +1 @@
+cmd_include/compat/.xlat/version.h := /root/.pyenv/shims/python3 ./tools/compat-xlat-header.py include/compat/version.h include/compat/.xlat/version.lst > include/compat/.xlat/version.h.new; mv -f include/compat/.xlat/version.h.new include/compat/.xlat/version.h
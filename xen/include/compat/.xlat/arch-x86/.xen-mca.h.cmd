@@ -0,0 +1 @@
+cmd_include/compat/.xlat/arch-x86/xen-mca.h := /root/.pyenv/shims/python3 ./tools/compat-xlat-header.py include/compat/arch-x86/xen-mca.h include/compat/.xlat/arch-x86/xen-mca.lst > include/compat/.xlat/arch-x86/xen-mca.h.new; mv -f include/compat/.xlat/arch-x86/xen-mca.h.new include/compat/.xlat/arch-x86/xen-mca.h
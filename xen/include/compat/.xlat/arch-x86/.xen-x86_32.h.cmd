@@ -0,0 +1 @@
+cmd_include/compat/.xlat/arch-x86/xen-x86_32.h := /root/.pyenv/shims/python3 ./tools/compat-xlat-header.py include/compat/arch-x86/xen-x86_32.h include/compat/.xlat/arch-x86/xen-x86_32.lst > include/compat/.xlat/arch-x86/xen-x86_32.h.new; mv -f include/compat/.xlat/arch-x86/xen-x86_32.h.new include/compat/.xlat/arch-x86/xen-x86_32.h
@@ -0,0 +1 @@
+cmd_include/compat/.xlat/arch-x86/xen.h := /root/.pyenv/shims/python3 ./tools/compat-xlat-header.py include/compat/arch-x86/xen.h include/compat/.xlat/arch-x86/xen.lst > include/compat/.xlat/arch-x86/xen.h.new; mv -f include/compat/.xlat/arch-x86/xen.h.new include/compat/.xlat/arch-x86/xen.h
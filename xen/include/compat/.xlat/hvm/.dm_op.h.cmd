@@ -0,0 +1 @@
+cmd_include/compat/.xlat/hvm/dm_op.h := /root/.pyenv/shims/python3 ./tools/compat-xlat-header.py include/compat/hvm/dm_op.h include/compat/.xlat/hvm/dm_op.lst > include/compat/.xlat/hvm/dm_op.h.new; mv -f include/compat/.xlat/hvm/dm_op.h.new include/compat/.xlat/hvm/dm_op.h
@@ -0,0 +1 @@
+cmd_include/compat/.xlat/hvm/hvm_vcpu.h := /root/.pyenv/shims/python3 ./tools/compat-xlat-header.py include/compat/hvm/hvm_vcpu.h include/compat/.xlat/hvm/hvm_vcpu.lst > include/compat/.xlat/hvm/hvm_vcpu.h.new; mv -f include/compat/.xlat/hvm/hvm_vcpu.h.new include/compat/.xlat/hvm/hvm_vcpu.h
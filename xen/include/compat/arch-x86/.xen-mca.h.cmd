@@ -0,0 +1 @@
+cmd_include/compat/arch-x86/xen-mca.h := /root/.pyenv/shims/python3 ./tools/compat-build-header.py <include/compat/arch-x86/xen-mca.i compat/arch-x86/xen-mca.h >>include/compat/arch-x86/xen-mca.h.new; mv -f include/compat/arch-x86/xen-mca.h.new include/compat/arch-x86/xen-mca.h
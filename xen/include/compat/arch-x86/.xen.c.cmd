@@ -0,0 +1 @@
+cmd_include/compat/arch-x86/xen.c := /root/.pyenv/shims/python3 ./tools/compat-build-source.py ./include/xlat.lst <include/public/arch-x86/xen.h >include/compat/arch-x86/xen.c.new; mv -f include/compat/arch-x86/xen.c.new include/compat/arch-x86/xen.c
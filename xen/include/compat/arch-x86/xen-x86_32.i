@@ -0,0 +1,47 @@
+# 0 "include/compat/arch-x86/xen-x86_32.c"
+# 1 "/root/repo/xen//"
+# 0 "<built-in>"
+# 0 "<command-line>"
+# 1 "./include/public/xen-compat.h" 1
+# 0 "<command-line>" 2
+# 1 "include/compat/arch-x86/xen-x86_32.c"
+# 87 "include/compat/arch-x86/xen-x86_32.c"
+typedef int64_T __attribute__((aligned(4))) int64_compat_T;
+typedef uint64_T __attribute__((aligned(4))) uint64_compat_T;
+# 117 "include/compat/arch-x86/xen-x86_32.c"
+struct cpu_user_regs {
+    __DECL_REG_LO8(b);
+    __DECL_REG_LO8(c);
+    __DECL_REG_LO8(d);
+    __DECL_REG_LO16(si);
+    __DECL_REG_LO16(di);
+    __DECL_REG_LO16(bp);
+    __DECL_REG_LO8(a);
+    uint16_t error_code;
+    uint16_t entry_vector;
+    __DECL_REG_LO16(ip);
+    uint16_t cs;
+    uint8_t saved_upcall_mask;
+    uint8_t _pad0;
+    __DECL_REG_LO16(flags);
+    __DECL_REG_LO16(sp);
+    uint16_t ss, _pad1;
+    uint16_t es, _pad2;
+    uint16_t ds, _pad3;
+    uint16_t fs, _pad4;
+    uint16_t gs, _pad5;
+};
+typedef struct cpu_user_regs cpu_user_regs_t;
+DEFINE_COMPAT_HANDLE(cpu_user_regs_t);
+# 153 "include/compat/arch-x86/xen-x86_32.c"
+struct arch_vcpu_info {
+    unsigned long cr2;
+    unsigned long pad[5];
+};
+typedef struct arch_vcpu_info arch_vcpu_info_t;
+
+struct xen_callback {
+    unsigned long cs;
+    unsigned long eip;
+};
+typedef struct xen_callback xen_callback_t;
@@ -0,0 +1,5 @@
+#ifndef _COMPAT_ARCH_X86_32_H
+#define _COMPAT_ARCH_X86_32_H
+#include <xen/compat.h>
+#include "arch-x86/xen.h"
+#endif /* _COMPAT_ARCH_X86_32_H */
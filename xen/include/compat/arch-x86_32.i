@@ -0,0 +1,9 @@
+# 0 "include/compat/arch-x86_32.c"
+# 1 "/root/repo/xen//"
+# 0 "<built-in>"
+# 0 "<command-line>"
+# 1 "./include/public/xen-compat.h" 1
+# 0 "<command-line>" 2
+# 1 "include/compat/arch-x86_32.c"
+# 10 "include/compat/arch-x86_32.c"
+__InClUdE__ "arch-x86/xen.h"
@@ -0,0 +1,239 @@
+# 0 "include/compat/grant_table.c"
+# 1 "/root/repo/xen//"
+# 0 "<built-in>"
+# 0 "<command-line>"
+# 1 "./include/public/xen-compat.h" 1
+# 0 "<command-line>" 2
+# 1 "include/compat/grant_table.c"
+# 14 "include/compat/grant_table.c"
+__InClUdE__ "xen.h"
+# 97 "include/compat/grant_table.c"
+typedef uint32_t grant_ref_t;
+# 115 "include/compat/grant_table.c"
+struct grant_entry_v1 {
+
+    uint16_t flags;
+
+    domid_t domid;
+
+
+
+
+
+
+    uint32_t frame;
+};
+typedef struct @KeeP@grant_entry_v1 grant_entry_v1_t;
+# 209 "include/compat/grant_table.c"
+struct grant_entry_header {
+    uint16_t flags;
+    domid_t domid;
+};
+typedef struct @KeeP@grant_entry_header grant_entry_header_t;
+
+
+
+
+union grant_entry_v2 {
+    grant_entry_header_t hdr;
+# 230 "include/compat/grant_table.c"
+    struct {
+        grant_entry_header_t hdr;
+        uint32_t pad0;
+        uint64_t frame;
+    } full_page;
+
+
+
+
+
+
+    struct {
+        grant_entry_header_t hdr;
+        uint16_t page_off;
+        uint16_t length;
+        uint64_t frame;
+    } sub_page;
+# 257 "include/compat/grant_table.c"
+    struct {
+        grant_entry_header_t hdr;
+        domid_t trans_domid;
+        uint16_t pad0;
+        grant_ref_t gref;
+    } transitive;
+
+    uint32_t __spacer[4];
+};
+typedef union @KeeP@grant_entry_v2 grant_entry_v2_t;
+
+typedef uint16_t grant_status_t;
+# 307 "include/compat/grant_table.c"
+typedef uint32_t grant_handle_t;
+# 326 "include/compat/grant_table.c"
+struct gnttab_map_grant_ref {
+
+    uint64_t host_addr;
+    uint32_t flags;
+    grant_ref_t ref;
+    domid_t dom;
+
+    int16_t status;
+    grant_handle_t handle;
+    uint64_t dev_bus_addr;
+};
+typedef struct @KeeP@gnttab_map_grant_ref gnttab_map_grant_ref_t;
+DEFINE_COMPAT_HANDLE(gnttab_map_grant_ref_t);
+# 351 "include/compat/grant_table.c"
+struct gnttab_unmap_grant_ref {
+
+    uint64_t host_addr;
+    uint64_t dev_bus_addr;
+    grant_handle_t handle;
+
+    int16_t status;
+};
+typedef struct @KeeP@gnttab_unmap_grant_ref gnttab_unmap_grant_ref_t;
+DEFINE_COMPAT_HANDLE(gnttab_unmap_grant_ref_t);
+# 371 "include/compat/grant_table.c"
+struct gnttab_setup_table {
+
+    domid_t dom;
+    uint32_t nr_frames;
+
+    int16_t status;
+
+
+
+    COMPAT_HANDLE(xen_pfn_t) frame_list;
+
+};
+typedef struct gnttab_setup_table gnttab_setup_table_t;
+DEFINE_COMPAT_HANDLE(gnttab_setup_table_t);
+
+
+
+
+
+struct gnttab_dump_table {
+
+    domid_t dom;
+
+    int16_t status;
+};
+typedef struct @KeeP@gnttab_dump_table gnttab_dump_table_t;
+DEFINE_COMPAT_HANDLE(gnttab_dump_table_t);
+# 408 "include/compat/grant_table.c"
+struct gnttab_transfer {
+
+    xen_pfn_t mfn;
+    domid_t domid;
+    grant_ref_t ref;
+
+    int16_t status;
+};
+typedef struct gnttab_transfer gnttab_transfer_t;
+DEFINE_COMPAT_HANDLE(gnttab_transfer_t);
+# 443 "include/compat/grant_table.c"
+struct gnttab_copy {
+
+    struct gnttab_copy_ptr {
+        union {
+            grant_ref_t ref;
+            xen_pfn_t gmfn;
+        } u;
+        domid_t domid;
+        uint16_t offset;
+    } source, dest;
+    uint16_t len;
+    uint16_t flags;
+
+    int16_t status;
+};
+typedef struct gnttab_copy gnttab_copy_t;
+DEFINE_COMPAT_HANDLE(gnttab_copy_t);
+# 468 "include/compat/grant_table.c"
+struct gnttab_query_size {
+
+    domid_t dom;
+
+    uint32_t nr_frames;
+    uint32_t max_nr_frames;
+    int16_t status;
+};
+typedef struct @KeeP@gnttab_query_size gnttab_query_size_t;
+DEFINE_COMPAT_HANDLE(gnttab_query_size_t);
+# 490 "include/compat/grant_table.c"
+struct gnttab_unmap_and_replace {
+
+    uint64_t host_addr;
+    uint64_t new_addr;
+    grant_handle_t handle;
+
+    int16_t status;
+};
+typedef struct @KeeP@gnttab_unmap_and_replace gnttab_unmap_and_replace_t;
+DEFINE_COMPAT_HANDLE(gnttab_unmap_and_replace_t);
+# 508 "include/compat/grant_table.c"
+struct gnttab_set_version {
+
+    uint32_t version;
+};
+typedef struct @KeeP@gnttab_set_version gnttab_set_version_t;
+DEFINE_COMPAT_HANDLE(gnttab_set_version_t);
+# 528 "include/compat/grant_table.c"
+struct gnttab_get_status_frames {
+
+    uint32_t nr_frames;
+    domid_t dom;
+
+    int16_t status;
+    COMPAT_HANDLE(uint64_t) frame_list;
+};
+typedef struct gnttab_get_status_frames gnttab_get_status_frames_t;
+DEFINE_COMPAT_HANDLE(gnttab_get_status_frames_t);
+
+
+
+
+
+struct gnttab_get_version {
+
+    domid_t dom;
+    uint16_t pad;
+
+    uint32_t version;
+};
+typedef struct @KeeP@gnttab_get_version gnttab_get_version_t;
+DEFINE_COMPAT_HANDLE(gnttab_get_version_t);
+
+
+
+
+struct gnttab_swap_grant_ref {
+
+    grant_ref_t ref_a;
+    grant_ref_t ref_b;
+
+    int16_t status;
+};
+typedef struct @KeeP@gnttab_swap_grant_ref gnttab_swap_grant_ref_t;
+DEFINE_COMPAT_HANDLE(gnttab_swap_grant_ref_t);
+
+
+
+
+
+struct gnttab_cache_flush {
+    union {
+        uint64_t dev_bus_addr;
+        grant_ref_t ref;
+    } a;
+    uint16_t offset;
+    uint16_t length;
+
+
+
+    uint32_t op;
+};
+typedef struct @KeeP@gnttab_cache_flush gnttab_cache_flush_t;
+DEFINE_COMPAT_HANDLE(gnttab_cache_flush_t);
@@ -0,0 +1 @@
+cmd_include/compat/hvm/dm_op.h := /root/.pyenv/shims/python3 ./tools/compat-build-header.py <include/compat/hvm/dm_op.i compat/hvm/dm_op.h >>include/compat/hvm/dm_op.h.new; mv -f include/compat/hvm/dm_op.h.new include/compat/hvm/dm_op.h
@@ -0,0 +1 @@
+cmd_include/compat/hvm/hvm_vcpu.h := /root/.pyenv/shims/python3 ./tools/compat-build-header.py <include/compat/hvm/hvm_vcpu.i compat/hvm/hvm_vcpu.h >>include/compat/hvm/hvm_vcpu.h.new; mv -f include/compat/hvm/hvm_vcpu.h.new include/compat/hvm/hvm_vcpu.h
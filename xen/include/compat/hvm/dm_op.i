@@ -0,0 +1,296 @@
+# 0 "include/compat/hvm/dm_op.c"
+# 1 "/root/repo/xen//"
+# 0 "<built-in>"
+# 0 "<command-line>"
+# 1 "./include/public/xen-compat.h" 1
+# 0 "<command-line>" 2
+# 1 "include/compat/hvm/dm_op.c"
+# 10 "include/compat/hvm/dm_op.c"
+__InClUdE__ "../xen.h"
+__InClUdE__ "../event_channel.h"
+# 36 "include/compat/hvm/dm_op.c"
+typedef uint16_t ioservid_t;
+# 50 "include/compat/hvm/dm_op.c"
+struct xen_dm_op_create_ioreq_server {
+
+    uint8_t handle_bufioreq;
+    uint8_t pad[3];
+
+    ioservid_t id;
+};
+typedef struct @KeeP@xen_dm_op_create_ioreq_server xen_dm_op_create_ioreq_server_t;
+# 81 "include/compat/hvm/dm_op.c"
+struct xen_dm_op_get_ioreq_server_info {
+
+    ioservid_t id;
+
+    uint16_t flags;
+
+
+
+
+
+    evtchn_port_t bufioreq_port;
+
+    uint64_t ioreq_gfn;
+
+    uint64_t bufioreq_gfn;
+};
+typedef struct @KeeP@xen_dm_op_get_ioreq_server_info xen_dm_op_get_ioreq_server_info_t;
+# 128 "include/compat/hvm/dm_op.c"
+struct xen_dm_op_ioreq_server_range {
+
+    ioservid_t id;
+    uint16_t pad;
+
+    uint32_t type;
+
+
+
+
+
+    uint64_t start, end;
+};
+typedef struct @KeeP@xen_dm_op_ioreq_server_range xen_dm_op_ioreq_server_range_t;
+# 160 "include/compat/hvm/dm_op.c"
+struct xen_dm_op_set_ioreq_server_state {
+
+    ioservid_t id;
+
+    uint8_t enabled;
+    uint8_t pad;
+};
+typedef struct @KeeP@xen_dm_op_set_ioreq_server_state xen_dm_op_set_ioreq_server_state_t;
+# 176 "include/compat/hvm/dm_op.c"
+struct xen_dm_op_destroy_ioreq_server {
+
+    ioservid_t id;
+    uint16_t pad;
+};
+typedef struct @KeeP@xen_dm_op_destroy_ioreq_server xen_dm_op_destroy_ioreq_server_t;
+# 192 "include/compat/hvm/dm_op.c"
+struct xen_dm_op_track_dirty_vram {
+
+    uint32_t nr;
+    uint32_t pad;
+
+    uint64_t first_pfn;
+};
+typedef struct @KeeP@xen_dm_op_track_dirty_vram xen_dm_op_track_dirty_vram_t;
+
+
+
+
+
+
+
+struct xen_dm_op_set_pci_intx_level {
+
+    uint16_t domain;
+    uint8_t bus, device, intx;
+
+    uint8_t level;
+};
+typedef struct @KeeP@xen_dm_op_set_pci_intx_level xen_dm_op_set_pci_intx_level_t;
+
+
+
+
+
+
+
+struct xen_dm_op_set_isa_irq_level {
+
+    uint8_t isa_irq;
+
+    uint8_t level;
+};
+typedef struct @KeeP@xen_dm_op_set_isa_irq_level xen_dm_op_set_isa_irq_level_t;
+
+
+
+
+
+
+struct xen_dm_op_set_pci_link_route {
+
+    uint8_t link;
+
+    uint8_t isa_irq;
+};
+typedef struct @KeeP@xen_dm_op_set_pci_link_route xen_dm_op_set_pci_link_route_t;
+# 256 "include/compat/hvm/dm_op.c"
+struct xen_dm_op_modified_memory {
+
+
+
+
+    uint32_t nr_extents;
+
+    uint32_t opaque;
+};
+typedef struct @KeeP@xen_dm_op_modified_memory xen_dm_op_modified_memory_t;
+
+struct xen_dm_op_modified_memory_extent {
+
+    uint32_t nr;
+    uint32_t pad;
+
+    uint64_t first_pfn;
+};
+# 286 "include/compat/hvm/dm_op.c"
+struct xen_dm_op_set_mem_type {
+
+    uint32_t nr;
+
+    uint16_t mem_type;
+    uint16_t pad;
+
+    uint64_t first_pfn;
+};
+typedef struct @KeeP@xen_dm_op_set_mem_type xen_dm_op_set_mem_type_t;
+# 306 "include/compat/hvm/dm_op.c"
+struct xen_dm_op_inject_event {
+
+    uint32_t vcpuid;
+
+    uint8_t vector;
+
+    uint8_t type;
+# 321 "include/compat/hvm/dm_op.c"
+    uint8_t insn_len;
+    uint8_t pad0;
+
+    uint32_t error_code;
+    uint32_t pad1;
+
+    uint64_t cr2;
+};
+typedef struct @KeeP@xen_dm_op_inject_event xen_dm_op_inject_event_t;
+
+
+
+
+
+
+struct xen_dm_op_inject_msi {
+
+    uint32_t data;
+    uint32_t pad;
+
+    uint64_t addr;
+};
+typedef struct @KeeP@xen_dm_op_inject_msi xen_dm_op_inject_msi_t;
+# 357 "include/compat/hvm/dm_op.c"
+struct xen_dm_op_map_mem_type_to_ioreq_server {
+    ioservid_t id;
+    uint16_t type;
+    uint32_t flags;
+
+
+
+
+
+
+    uint64_t opaque;
+
+};
+typedef struct @KeeP@xen_dm_op_map_mem_type_to_ioreq_server xen_dm_op_map_mem_type_to_ioreq_server_t;
+
+
+
+
+
+
+
+struct xen_dm_op_remote_shutdown {
+    uint32_t reason;
+
+};
+typedef struct @KeeP@xen_dm_op_remote_shutdown xen_dm_op_remote_shutdown_t;
+# 391 "include/compat/hvm/dm_op.c"
+struct xen_dm_op_relocate_memory {
+
+
+    uint32_t size;
+    uint32_t pad;
+
+    uint64_t src_gfn;
+
+    uint64_t dst_gfn;
+};
+typedef struct @KeeP@xen_dm_op_relocate_memory xen_dm_op_relocate_memory_t;
+
+
+
+
+
+
+
+struct xen_dm_op_pin_memory_cacheattr {
+    uint64_t start;
+    uint64_t end;
+# 420 "include/compat/hvm/dm_op.c"
+    uint32_t type;
+    uint32_t pad;
+};
+typedef struct @KeeP@xen_dm_op_pin_memory_cacheattr xen_dm_op_pin_memory_cacheattr_t;
+# 432 "include/compat/hvm/dm_op.c"
+struct xen_dm_op_set_irq_level {
+    uint32_t irq;
+
+    uint8_t level;
+    uint8_t pad[3];
+};
+typedef struct xen_dm_op_set_irq_level xen_dm_op_set_irq_level_t;
+# 450 "include/compat/hvm/dm_op.c"
+struct xen_dm_op_nr_vcpus {
+    uint32_t vcpus;
+};
+typedef struct @KeeP@xen_dm_op_nr_vcpus xen_dm_op_nr_vcpus_t;
+# 470 "include/compat/hvm/dm_op.c"
+struct xen_dm_op_set_ioreq_server_posted_ring {
+
+    ioservid_t id;
+    uint16_t pad;
+
+    uint32_t nr_frames;
+};
+typedef struct @KeeP@xen_dm_op_set_ioreq_server_posted_ring xen_dm_op_set_ioreq_server_posted_ring_t;
+
+
+
+struct xen_dm_op {
+    uint32_t op;
+    uint32_t pad;
+    union {
+        xen_dm_op_create_ioreq_server_t create_ioreq_server;
+        xen_dm_op_get_ioreq_server_info_t get_ioreq_server_info;
+        xen_dm_op_ioreq_server_range_t map_io_range_to_ioreq_server;
+        xen_dm_op_ioreq_server_range_t unmap_io_range_from_ioreq_server;
+        xen_dm_op_set_ioreq_server_state_t set_ioreq_server_state;
+        xen_dm_op_destroy_ioreq_server_t destroy_ioreq_server;
+        xen_dm_op_track_dirty_vram_t track_dirty_vram;
+        xen_dm_op_set_pci_intx_level_t set_pci_intx_level;
+        xen_dm_op_set_isa_irq_level_t set_isa_irq_level;
+        xen_dm_op_set_irq_level_t set_irq_level;
+        xen_dm_op_set_pci_link_route_t set_pci_link_route;
+        xen_dm_op_modified_memory_t modified_memory;
+        xen_dm_op_set_mem_type_t set_mem_type;
+        xen_dm_op_inject_event_t inject_event;
+        xen_dm_op_inject_msi_t inject_msi;
+        xen_dm_op_map_mem_type_to_ioreq_server_t map_mem_type_to_ioreq_server;
+        xen_dm_op_remote_shutdown_t remote_shutdown;
+        xen_dm_op_relocate_memory_t relocate_memory;
+        xen_dm_op_pin_memory_cacheattr_t pin_memory_cacheattr;
+        xen_dm_op_nr_vcpus_t nr_vcpus;
+        xen_dm_op_set_ioreq_server_posted_ring_t set_ioreq_server_posted_ring;
+    } u;
+};
+
+struct xen_dm_op_buf {
+    COMPAT_HANDLE(void) h;
+    xen_ulong_t size;
+};
+typedef struct xen_dm_op_buf xen_dm_op_buf_t;
+DEFINE_COMPAT_HANDLE(xen_dm_op_buf_t);
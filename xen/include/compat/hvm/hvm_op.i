@@ -0,0 +1,197 @@
+# 0 "include/compat/hvm/hvm_op.c"
+# 1 "/root/repo/xen//"
+# 0 "<built-in>"
+# 0 "<command-line>"
+# 1 "./include/public/xen-compat.h" 1
+# 0 "<command-line>" 2
+# 1 "include/compat/hvm/hvm_op.c"
+# 9 "include/compat/hvm/hvm_op.c"
+__InClUdE__ "../xen.h"
+__InClUdE__ "../trace.h"
+__InClUdE__ "../event_channel.h"
+
+
+
+
+struct xen_hvm_param {
+    domid_t domid;
+    uint16_t pad;
+    uint32_t index;
+    uint64_t value;
+};
+typedef struct xen_hvm_param xen_hvm_param_t;
+DEFINE_COMPAT_HANDLE(xen_hvm_param_t);
+
+struct xen_hvm_altp2m_suppress_ve {
+    uint16_t view;
+    uint8_t suppress_ve;
+    uint8_t pad1;
+    uint32_t pad2;
+    uint64_t gfn;
+};
+
+struct xen_hvm_altp2m_suppress_ve_multi {
+    uint16_t view;
+    uint8_t suppress_ve;
+    uint8_t pad1;
+    int32_t first_error;
+    uint64_t first_gfn;
+    uint64_t last_gfn;
+    uint64_t first_error_gfn;
+};
+# 118 "include/compat/hvm/hvm_op.c"
+struct xen_hvm_pagetable_dying {
+
+    domid_t domid;
+    uint16_t pad[3];
+
+    uint64_t gpa;
+};
+typedef struct xen_hvm_pagetable_dying xen_hvm_pagetable_dying_t;
+DEFINE_COMPAT_HANDLE(xen_hvm_pagetable_dying_t);
+
+
+
+struct xen_hvm_get_time {
+    uint64_t now;
+};
+typedef struct xen_hvm_get_time xen_hvm_get_time_t;
+DEFINE_COMPAT_HANDLE(xen_hvm_get_time_t);
+
+
+struct xen_hvm_xentrace {
+    uint16_t event, extra_bytes;
+    uint8_t extra[TRACE_EXTRA_MAX * sizeof(uint32_t)];
+};
+typedef struct xen_hvm_xentrace xen_hvm_xentrace_t;
+DEFINE_COMPAT_HANDLE(xen_hvm_xentrace_t);
+# 157 "include/compat/hvm/hvm_op.c"
+struct xen_hvm_get_mem_type {
+
+    domid_t domid;
+
+    uint16_t mem_type;
+    uint16_t pad[2];
+
+    uint64_t pfn;
+};
+typedef struct xen_hvm_get_mem_type xen_hvm_get_mem_type_t;
+DEFINE_COMPAT_HANDLE(xen_hvm_get_mem_type_t);
+# 197 "include/compat/hvm/hvm_op.c"
+struct xen_hvm_evtchn_upcall_vector {
+    uint32_t vcpu;
+    uint8_t vector;
+};
+typedef struct xen_hvm_evtchn_upcall_vector xen_hvm_evtchn_upcall_vector_t;
+DEFINE_COMPAT_HANDLE(xen_hvm_evtchn_upcall_vector_t);
+# 213 "include/compat/hvm/hvm_op.c"
+struct xen_hvm_altp2m_domain_state {
+
+    uint8_t state;
+};
+typedef struct xen_hvm_altp2m_domain_state xen_hvm_altp2m_domain_state_t;
+DEFINE_COMPAT_HANDLE(xen_hvm_altp2m_domain_state_t);
+
+struct xen_hvm_altp2m_vcpu_enable_notify {
+    uint32_t vcpu_id;
+    uint32_t pad;
+
+    uint64_t gfn;
+};
+typedef struct xen_hvm_altp2m_vcpu_enable_notify xen_hvm_altp2m_vcpu_enable_notify_t;
+DEFINE_COMPAT_HANDLE(xen_hvm_altp2m_vcpu_enable_notify_t);
+
+struct xen_hvm_altp2m_vcpu_disable_notify {
+    uint32_t vcpu_id;
+};
+typedef struct xen_hvm_altp2m_vcpu_disable_notify xen_hvm_altp2m_vcpu_disable_notify_t;
+DEFINE_COMPAT_HANDLE(xen_hvm_altp2m_vcpu_disable_notify_t);
+
+struct xen_hvm_altp2m_view {
+
+    uint16_t view;
+    uint16_t hvmmem_default_access;
+};
+typedef struct xen_hvm_altp2m_view xen_hvm_altp2m_view_t;
+DEFINE_COMPAT_HANDLE(xen_hvm_altp2m_view_t);
+# 257 "include/compat/hvm/hvm_op.c"
+struct xen_hvm_altp2m_mem_access {
+
+    uint16_t view;
+
+    uint16_t access;
+    uint32_t pad;
+
+    uint64_t gfn;
+};
+typedef struct xen_hvm_altp2m_mem_access xen_hvm_altp2m_mem_access_t;
+DEFINE_COMPAT_HANDLE(xen_hvm_altp2m_mem_access_t);
+
+struct xen_hvm_altp2m_set_mem_access_multi {
+
+    uint16_t view;
+    uint16_t pad;
+
+    uint32_t nr;
+
+
+
+
+    uint64_t opaque;
+
+    COMPAT_HANDLE(const_uint64) pfn_list;
+
+    COMPAT_HANDLE(const_uint8) access_list;
+};
+
+struct xen_hvm_altp2m_change_gfn {
+
+    uint16_t view;
+    uint16_t pad1;
+    uint32_t pad2;
+
+    uint64_t old_gfn;
+
+    uint64_t new_gfn;
+};
+typedef struct xen_hvm_altp2m_change_gfn xen_hvm_altp2m_change_gfn_t;
+DEFINE_COMPAT_HANDLE(xen_hvm_altp2m_change_gfn_t);
+
+struct xen_hvm_altp2m_get_vcpu_p2m_idx {
+    uint32_t vcpu_id;
+    uint16_t altp2m_idx;
+};
+
+struct xen_hvm_altp2m_set_visibility {
+    uint16_t altp2m_idx;
+    uint8_t visible;
+    uint8_t pad;
+};
+
+struct xen_hvm_altp2m_op {
+    uint32_t version;
+    uint32_t cmd;
+# 344 "include/compat/hvm/hvm_op.c"
+    domid_t domain;
+    uint16_t pad1;
+    uint32_t pad2;
+    union {
+        struct xen_hvm_altp2m_domain_state domain_state;
+        struct xen_hvm_altp2m_vcpu_enable_notify enable_notify;
+        struct xen_hvm_altp2m_view view;
+
+
+
+        struct xen_hvm_altp2m_mem_access mem_access;
+        struct xen_hvm_altp2m_change_gfn change_gfn;
+        struct xen_hvm_altp2m_set_mem_access_multi set_mem_access_multi;
+        struct xen_hvm_altp2m_suppress_ve suppress_ve;
+        struct xen_hvm_altp2m_suppress_ve_multi suppress_ve_multi;
+        struct xen_hvm_altp2m_vcpu_disable_notify disable_notify;
+        struct xen_hvm_altp2m_get_vcpu_p2m_idx get_vcpu_p2m_idx;
+        struct xen_hvm_altp2m_set_visibility set_visibility;
+        uint8_t pad[64];
+    } u;
+};
+typedef struct xen_hvm_altp2m_op xen_hvm_altp2m_op_t;
+DEFINE_COMPAT_HANDLE(xen_hvm_altp2m_op_t);
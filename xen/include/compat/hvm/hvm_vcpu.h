@@ -0,0 +1,78 @@
+#ifndef _COMPAT_HVM_HVM_VCPU_H
+#define _COMPAT_HVM_HVM_VCPU_H
+#include <xen/compat.h>
+#include <public/hvm/hvm_vcpu.h>
+#include "../xen.h"
+
+struct compat_vcpu_hvm_x86_32 {
+    uint32_t eax;
+    uint32_t ecx;
+    uint32_t edx;
+    uint32_t ebx;
+    uint32_t esp;
+    uint32_t ebp;
+    uint32_t esi;
+    uint32_t edi;
+    uint32_t eip;
+    uint32_t eflags;
+
+    uint32_t cr0;
+    uint32_t cr3;
+    uint32_t cr4;
+
+    uint32_t pad1;
+
+    uint64_compat_t efer;
+
+    uint32_t cs_base;
+    uint32_t ds_base;
+    uint32_t ss_base;
+    uint32_t es_base;
+    uint32_t tr_base;
+    uint32_t cs_limit;
+    uint32_t ds_limit;
+    uint32_t ss_limit;
+    uint32_t es_limit;
+    uint32_t tr_limit;
+    uint16_t cs_ar;
+    uint16_t ds_ar;
+    uint16_t ss_ar;
+    uint16_t es_ar;
+    uint16_t tr_ar;
+
+    uint16_t pad2[3];
+};
+typedef struct vcpu_hvm_x86_32 __attribute__((__aligned__(__alignof( struct compat_vcpu_hvm_x86_32)))) compat_vcpu_hvm_x86_32_t;
+struct compat_vcpu_hvm_x86_64 {
+    uint64_compat_t rax;
+    uint64_compat_t rcx;
+    uint64_compat_t rdx;
+    uint64_compat_t rbx;
+    uint64_compat_t rsp;
+    uint64_compat_t rbp;
+    uint64_compat_t rsi;
+    uint64_compat_t rdi;
+    uint64_compat_t rip;
+    uint64_compat_t rflags;
+
+    uint64_compat_t cr0;
+    uint64_compat_t cr3;
+    uint64_compat_t cr4;
+    uint64_compat_t efer;
+};
+typedef struct vcpu_hvm_x86_64 __attribute__((__aligned__(__alignof( struct compat_vcpu_hvm_x86_64)))) compat_vcpu_hvm_x86_64_t;
+
+struct compat_vcpu_hvm_context {
+
+    uint32_t mode;
+
+    uint32_t pad;
+
+    union {
+        compat_vcpu_hvm_x86_32_t x86_32;
+        compat_vcpu_hvm_x86_64_t x86_64;
+    } cpu_regs;
+};
+typedef struct vcpu_hvm_context __attribute__((__aligned__(__alignof( struct compat_vcpu_hvm_context)))) vcpu_hvm_context_compat_t;
+DEFINE_COMPAT_HANDLE(vcpu_hvm_context_compat_t);
+#endif /* _COMPAT_HVM_HVM_VCPU_H */
@@ -0,0 +1,12 @@
+#ifndef _COMPAT_NMI_H
+#define _COMPAT_NMI_H
+#include <xen/compat.h>
+#include <public/nmi.h>
+#include "xen.h"
+struct compat_nmi_callback {
+    unsigned int handler_address;
+    unsigned int pad;
+};
+typedef struct compat_nmi_callback compat_nmi_callback_t;
+DEFINE_COMPAT_HANDLE(compat_nmi_callback_t);
+#endif /* _COMPAT_NMI_H */
@@ -0,0 +1,49 @@
+# 0 "include/compat/pmu.c"
+# 1 "/root/repo/xen//"
+# 0 "<built-in>"
+# 0 "<command-line>"
+# 1 "./include/public/xen-compat.h" 1
+# 0 "<command-line>" 2
+# 1 "include/compat/pmu.c"
+# 9 "include/compat/pmu.c"
+__InClUdE__ "xen.h"
+
+__InClUdE__ "arch-x86/pmu.h"
+# 44 "include/compat/pmu.c"
+struct xen_pmu_params {
+
+    struct {
+        uint32_t maj;
+        uint32_t min;
+    } version;
+    uint64_t val;
+
+
+    uint32_t vcpu;
+    uint32_t pad;
+};
+typedef struct @KeeP@xen_pmu_params xen_pmu_params_t;
+DEFINE_COMPAT_HANDLE(xen_pmu_params_t);
+# 97 "include/compat/pmu.c"
+struct xen_pmu_data {
+
+    uint32_t vcpu_id;
+
+
+
+
+
+    uint32_t pcpu_id;
+
+
+
+
+
+
+    domid_t domain_id;
+
+    uint8_t pad[6];
+
+
+    xen_pmu_arch_t pmu;
+};
@@ -0,0 +1,74 @@
+# 0 "include/compat/vcpu.c"
+# 1 "/root/repo/xen//"
+# 0 "<built-in>"
+# 0 "<command-line>"
+# 1 "./include/public/xen-compat.h" 1
+# 0 "<command-line>" 2
+# 1 "include/compat/vcpu.c"
+# 13 "include/compat/vcpu.c"
+__InClUdE__ "xen.h"
+# 64 "include/compat/vcpu.c"
+struct vcpu_runstate_info {
+
+    int state;
+
+    uint64_t state_entry_time;
+# 79 "include/compat/vcpu.c"
+    uint64_t time[4];
+};
+typedef struct vcpu_runstate_info vcpu_runstate_info_t;
+DEFINE_COMPAT_HANDLE(vcpu_runstate_info_t);
+# 118 "include/compat/vcpu.c"
+struct vcpu_register_runstate_memory_area {
+    union {
+        COMPAT_HANDLE(vcpu_runstate_info_t) h;
+        struct vcpu_runstate_info *v;
+        uint64_t p;
+    } addr;
+};
+typedef struct vcpu_register_runstate_memory_area vcpu_register_runstate_memory_area_t;
+DEFINE_COMPAT_HANDLE(vcpu_register_runstate_memory_area_t);
+# 135 "include/compat/vcpu.c"
+struct vcpu_set_periodic_timer {
+    uint64_t period_ns;
+};
+typedef struct @KeeP@vcpu_set_periodic_timer vcpu_set_periodic_timer_t;
+DEFINE_COMPAT_HANDLE(vcpu_set_periodic_timer_t);
+
+
+
+
+
+
+
+struct vcpu_set_singleshot_timer {
+    uint64_t timeout_abs_ns;
+    uint32_t flags;
+};
+typedef struct vcpu_set_singleshot_timer vcpu_set_singleshot_timer_t;
+DEFINE_COMPAT_HANDLE(vcpu_set_singleshot_timer_t);
+# 172 "include/compat/vcpu.c"
+struct vcpu_register_vcpu_info {
+    uint64_t mfn;
+    uint32_t offset;
+    uint32_t rsvd;
+};
+typedef struct @KeeP@vcpu_register_vcpu_info vcpu_register_vcpu_info_t;
+DEFINE_COMPAT_HANDLE(vcpu_register_vcpu_info_t);
+# 190 "include/compat/vcpu.c"
+struct vcpu_get_physid {
+    uint64_t phys_id;
+};
+typedef struct @KeeP@vcpu_get_physid vcpu_get_physid_t;
+DEFINE_COMPAT_HANDLE(vcpu_get_physid_t);
+# 218 "include/compat/vcpu.c"
+DEFINE_COMPAT_HANDLE(vcpu_time_info_t);
+struct vcpu_register_time_memory_area {
+    union {
+        COMPAT_HANDLE(vcpu_time_info_t) h;
+        struct vcpu_time_info *v;
+        uint64_t p;
+    } addr;
+};
+typedef struct vcpu_register_time_memory_area vcpu_register_time_memory_area_t;
+DEFINE_COMPAT_HANDLE(vcpu_register_time_memory_area_t);
@@ -0,0 +1 @@
+/* SAF-9-safe empty header */
@@ -0,0 +1,45 @@
+deps_config := \
+	arch/x86/Kconfig.debug \
+	Kconfig.debug \
+	drivers/video/Kconfig \
+	drivers/pci/Kconfig \
+	drivers/passthrough/Kconfig \
+	drivers/cpufreq/Kconfig \
+	drivers/char/Kconfig \
+	drivers/acpi/Kconfig \
+	drivers/Kconfig \
+	common/sched/Kconfig \
+	common/Kconfig \
+	arch/x86/hvm/Kconfig \
+	arch/Kconfig \
+	arch/x86/Kconfig.cpu \
+	arch/x86/Kconfig \
+	scripts/Kconfig.include \
+	Kconfig
+
+include/config/auto.conf: \
+	$(deps_config)
+
+ifneq "$(SRCARCH)" "x86"
+include/config/auto.conf: FORCE
+endif
+ifneq "$(XEN_FULLVERSION)" "4.21-unstable"
+include/config/auto.conf: FORCE
+endif
+ifneq "$(CC)" "gcc"
+include/config/auto.conf: FORCE
+endif
+ifneq "$(LD)" "ld"
+include/config/auto.conf: FORCE
+endif
+ifneq "$(srctree)" "."
+include/config/auto.conf: FORCE
+endif
+ifneq "$(XEN_HAS_CHECKPOLICY)" "n"
+include/config/auto.conf: FORCE
+endif
+ifneq "$(XEN_HAS_BUILD_ID)" "y"
+include/config/auto.conf: FORCE
+endif
+
+$(deps_config): ;
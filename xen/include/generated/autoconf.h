@@ -0,0 +1,120 @@
+/*
+ *
+ * Automatically generated file; DO NOT EDIT.
+ * Xen/x86 4.21-unstable Configuration
+ *
+ */
+#define CONFIG_ARCH_SUPPORTS_INT128 1
+#define CONFIG_SPECULATIVE_HARDEN_LOCK 1
+#define CONFIG_HAS_ALTERNATIVE 1
+#define CONFIG_HAS_CC_CET_IBT 1
+#define CONFIG_COMPAT 1
+#define CONFIG_HVM_FEP 1
+#define CONFIG_SCRUB_DEBUG 1
+#define CONFIG_FAST_SYMBOL_LOOKUP 1
+#define CONFIG_HAS_AS_CET_SS 1
+#define CONFIG_HAS_DIT 1
+#define CONFIG_HAS_VPCI 1
+#define CONFIG_GCC_ASM_GOTO_OUTPUT_BROKEN 1
+#define CONFIG_SCHED_RTDS 1
+#define CONFIG_HYPFS_CONFIG 1
+#define CONFIG_X86 1
+#define CONFIG_HAS_VMAP 1
+#define CONFIG_ACPI 1
+#define CONFIG_FUNCTION_ALIGNMENT 16
+#define CONFIG_PV 1
+#define CONFIG_NR_NUMA_NODES 64
+#define CONFIG_CORE_PARKING 1
+#define CONFIG_HAS_PCI_MSI 1
+#define CONFIG_ARCH_DEFCONFIG "arch/x86/configs/x86_64_defconfig"
+#define CONFIG_MEM_PAGING 1
+#define CONFIG_XEN_ALIGN_DEFAULT 1
+#define CONFIG_DEBUG_LOCK_PROFILE 1
+#define CONFIG_PERF_COUNTERS 1
+#define CONFIG_ALTP2M 1
+#define CONFIG_X86_PSR 1
+#define CONFIG_EVTCHN_FIFO 1
+#define CONFIG_TBOOT 1
+#define CONFIG_X2APIC_MIXED 1
+#define CONFIG_SCHED_NULL 1
+#define CONFIG_HAS_PCI 1
+#define CONFIG_VIDEO 1
+#define CONFIG_HAS_SCHED_GRANULARITY 1
+#define CONFIG_HAS_EHCI 1
+#define CONFIG_UNSUPPORTED 1
+#define CONFIG_PERF_ARRAYS 1
+#define CONFIG_HAS_IOPORTS 1
+#define CONFIG_XMEM_POOL_POISON 1
+#define CONFIG_SCHED_CREDIT2_DEFAULT 1
+#define CONFIG_GENERIC_BUG_FRAME 1
+#define CONFIG_SCHED_CREDIT2 1
+#define CONFIG_SCHED_CREDIT 1
+#define CONFIG_KEXEC 1
+#define CONFIG_ENFORCE_UNIQUE_SYMBOLS 1
+#define CONFIG_ARCH_MAP_DOMAIN_PAGE 1
+#define CONFIG_CLANG_VERSION 0
+#define CONFIG_LD_IS_GNU 1
+#define CONFIG_IOMMU_QUARANTINE_BASIC 1
+#define CONFIG_AMD 1
+#define CONFIG_FRAME_POINTER 1
+#define CONFIG_INTEL_VMX 1
+#define CONFIG_NUMA 1
+#define CONFIG_SCHED_DEFAULT "credit2"
+#define CONFIG_MEM_ACCESS_ALWAYS_ON 1
+#define CONFIG_HVM 1
+#define CONFIG_SERIAL_TX_BUFSIZE 32768
+#define CONFIG_SPECULATIVE_HARDEN_ARRAY 1
+#define CONFIG_ARCH_VCPU_IOREQ_COMPLETION 1
+#define CONFIG_CC_HAS_INDIRECT_THUNK 1
+#define CONFIG_HAS_COMPAT 1
+#define CONFIG_SCHED_ARINC653 1
+#define CONFIG_HYPFS 1
+#define CONFIG_VERBOSE_DEBUG 1
+#define CONFIG_AMD_SVM 1
+#define CONFIG_CRYPTO 1
+#define CONFIG_CMDLINE ""
+#define CONFIG_GDBSX 1
+#define CONFIG_HAS_FAST_MULTIPLY 1
+#define CONFIG_INDIRECT_THUNK 1
+#define CONFIG_XEN_IBT 1
+#define CONFIG_LIVEPATCH 1
+#define CONFIG_X86_64 1
+#define CONFIG_SHADOW_PAGING 1
+#define CONFIG_HAS_CPUFREQ 1
+#define CONFIG_EXPERT 1
+#define CONFIG_HAS_PIRQ 1
+#define CONFIG_SPECULATIVE_HARDEN_GUEST_ACCESS 1
+#define CONFIG_SPECULATIVE_HARDEN_BRANCH 1
+#define CONFIG_DOM0_MEM ""
+#define CONFIG_CC_IS_GCC 1
+#define CONFIG_INTEL 1
+#define CONFIG_NR_CPUS 256
+#define CONFIG_HAS_KEXEC 1
+#define CONFIG_GRANT_TABLE 1
+#define CONFIG_AMD_IOMMU 1
+#define CONFIG_ALTERNATIVE_CALL 1
+#define CONFIG_VM_EVENT 1
+#define CONFIG_IOREQ_SERVER 1
+#define CONFIG_HAS_PASSTHROUGH 1
+#define CONFIG_FUNCTION_ALIGNMENT_16B 1
+#define CONFIG_HAS_EX_TABLE 1
+#define CONFIG_ARCH_PAGING_MEMPOOL 1
+#define CONFIG_GCC_VERSION 120200
+#define CONFIG_CC_SPLIT_SECTIONS 1
+#define CONFIG_LOCK_CONTENTION_PROFILE 1
+#define CONFIG_VGA 1
+#define CONFIG_INTEL_IOMMU 1
+#define CONFIG_HAS_UBSAN 1
+#define CONFIG_ACPI_NUMA 1
+#define CONFIG_HAS_NS16550 1
+#define CONFIG_TRACEBUFFER 1
+#define CONFIG_DEBUG_LOCKS 1
+#define CONFIG_DEBUG 1
+#define CONFIG_64BIT 1
+#define CONFIG_SELF_TESTS 1
+#define CONFIG_MEM_SHARING 1
+#define CONFIG_PV_LINEAR_PT 1
+#define CONFIG_ACPI_LEGACY_TABLES_LOOKUP 1
+#define CONFIG_NEEDS_LIBELF 1
+#define CONFIG_DEBUG_INFO 1
+#define CONFIG_XEN_SHSTK 1
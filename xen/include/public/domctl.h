@@ -32,7 +32,7 @@
  *
  * Last version bump: Xen 4.19
  */
-#define XEN_DOMCTL_INTERFACE_VERSION 0x00000017
+#define XEN_DOMCTL_INTERFACE_VERSION 0x00000018
 
 /*
  * NB. xen_domctl.domain is an IN/OUT parameter for this operation.
@@ -225,6 +225,13 @@ struct xen_domctl_getpageframeinfo3 {
 #define XEN_DOMCTL_SHADOW_OP_CLEAN       11
  /* Return the bitmap but do not modify internal copy. */
 #define XEN_DOMCTL_SHADOW_OP_PEEK        12
+ /*
+  * Set up (pages != 0) or tear down (pages == 0) the dirty pfn ring, see
+  * struct xen_domctl_dirty_ring.  pages is the number of ring frames, a
+  * power of two no larger than XEN_DOMCTL_DIRTY_RING_MAX_PAGES.  HVM
+  * domains only.
+  */
+#define XEN_DOMCTL_SHADOW_OP_DIRTY_RING  13
 
 /*
  * Memory allocation accessors.  These APIs are broken and will be removed.
@@ -271,6 +278,38 @@ struct xen_domctl_getpageframeinfo3 {
   * writably by the hypervisor in the dirty bitmap.
   */
 #define XEN_DOMCTL_SHADOW_LOGDIRTY_FINAL   (1 << 0)
+ /*
+  * CLEAN only: the caller consumes the dirty pfn ring instead of (or as
+  * well as) the bitmap.  Fails with -ENOBUFS, without cleaning anything, if
+  * pfns were dropped from the ring since the last CLEAN.  The caller then
+  * has to fall back to a CLEAN retrieving the bitmap.
+  */
+#define XEN_DOMCTL_SHADOW_LOGDIRTY_RING    (1 << 1)
+
+/*
+ * Dirty pfn ring, mapped with XENMEM_acquire_resource of type
+ * XENMEM_resource_dirty_ring.  Frame 0 holds this header, the following
+ * frames hold the ring proper: an array of uint64_t pfns.
+ *
+ * While log-dirty mode is enabled, Xen appends a pfn whenever its bit in
+ * the log-dirty bitmap gets set, so the ring holds each pfn at most once
+ * per round.  A CLEAN sets round_end to the value prod had when the bitmap
+ * was cleaned: entries from cons up to round_end are the pages dirtied in
+ * the round just ended.  The consumer advances cons past the entries it
+ * has processed.  All indexes are free running; entry i lives in slot
+ * (i & (nr_entries - 1)).
+ *
+ * When the ring is full, or log-dirty mode was already enabled when the
+ * ring was set up, Xen stops appending and sets overflow until the next
+ * CLEAN retrieving the bitmap.
+ */
+struct xen_domctl_dirty_ring {
+    uint32_t prod;       /* OUT: written by Xen. */
+    uint32_t cons;       /* IN: written by the consumer. */
+    uint32_t round_end;  /* OUT: prod at the last CLEAN. */
+    uint32_t overflow;   /* OUT: entries were dropped in this round. */
+};
+#define XEN_DOMCTL_DIRTY_RING_MAX_PAGES 4096
 
 struct xen_domctl_shadow_op_stats {
     uint32_t fault_count;
@@ -290,7 +329,11 @@ struct xen_domctl_shadow_op {
 
     /* OP_PEEK / OP_CLEAN */
     XEN_GUEST_HANDLE_64(uint8) dirty_bitmap;
-    uint64_aligned_t pages; /* Size of buffer. Updated with actual size. */
+    /*
+     * OP_PEEK / OP_CLEAN: Size of buffer. Updated with actual size.
+     * OP_DIRTY_RING: Number of ring frames.
+     */
+    uint64_aligned_t pages;
     struct xen_domctl_shadow_op_stats stats;
 };
 
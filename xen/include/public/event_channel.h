@@ -60,6 +60,8 @@
 #ifdef __XEN__
 #define EVTCHNOP_reset_cont      14
 #endif
+#define EVTCHNOP_send_multi      15
+#define EVTCHNOP_set_moderation  16
 /* ` } */
 
 typedef uint32_t evtchn_port_t;
@@ -298,6 +300,51 @@ struct evtchn_set_priority {
 };
 typedef struct evtchn_set_priority evtchn_set_priority_t;
 
+/*
+ * EVTCHNOP_send_multi: Send an event to the remote end of each of the
+ * channels whose local endpoints are listed in <ports>, as EVTCHNOP_send
+ * would do for each of them.
+ * NOTES:
+ *  1. Ports are processed in order, stopping at the first one that fails to
+ *     be sent, whose error is returned.  <nr_sent> is set to the number of
+ *     ports processed successfully in all cases.
+ *  2. Upcalls are coalesced: each vCPU is notified at most once per call,
+ *     after all the events targeting it have been made pending.
+ */
+#define EVTCHN_SEND_MULTI_MAX 64
+struct evtchn_send_multi {
+    /* IN parameters. */
+    uint32_t nr_ports;
+    /* OUT parameters. */
+    uint32_t nr_sent;
+    /* IN parameters. */
+    evtchn_port_t ports[EVTCHN_SEND_MULTI_MAX];
+};
+typedef struct evtchn_send_multi evtchn_send_multi_t;
+
+/*
+ * EVTCHNOP_set_moderation: Moderate the delivery of events on local <port>.
+ * An event arriving less than <interval_us> microseconds after the previous
+ * delivery is held back, and all events held are delivered as a single one
+ * once the interval has elapsed, or as soon as <count> events have been held
+ * if <count> is non-zero.
+ * NOTES:
+ *  1. An <interval_us> of zero disables moderation, delivering any event
+ *     being held.  A non-zero <count> requires a non-zero <interval_us>.
+ *  2. The setting is dropped when the port is closed.  Events held when the
+ *     remote end of an interdomain channel is closed are discarded.
+ *  3. Only EVTCHN_MODERATION_MAX ports may be moderated per domain at any one
+ *     time, -ENOSPC is returned past that.
+ */
+#define EVTCHN_MODERATION_MAX 64
+struct evtchn_set_moderation {
+    /* IN parameters. */
+    evtchn_port_t port;
+    uint32_t interval_us;
+    uint32_t count;
+};
+typedef struct evtchn_set_moderation evtchn_set_moderation_t;
+
 /*
  * ` enum neg_errnoval
  * ` HYPERVISOR_event_channel_op_compat(struct evtchn_op *op)
@@ -114,6 +114,13 @@ typedef struct xen_dm_op_get_ioreq_server_info xen_dm_op_get_ioreq_server_info_t
  *
  * NOTE: unless an emulation request falls entirely within a range mapped
  * by a secondary emulator, it will not be passed to that emulator.
+ *
+ * A range of type XEN_DMOP_IO_RANGE_POSTED is an MMIO range for which
+ * single (non-rep) writes may be queued on the posted write ring set up by
+ * XEN_DMOP_set_ioreq_server_posted_ring rather than being forwarded
+ * synchronously (see struct posted_iopage in ioreq.h).  Reads, and writes
+ * which cannot be posted, are forwarded as for XEN_DMOP_IO_RANGE_MEMORY.
+ * POSTED and MEMORY ranges of an IOREQ Server may not overlap.
  */
 #define XEN_DMOP_map_io_range_to_ioreq_server 3
 #define XEN_DMOP_unmap_io_range_from_ioreq_server 4
@@ -127,6 +134,7 @@ struct xen_dm_op_ioreq_server_range {
 # define XEN_DMOP_IO_RANGE_PORT   0 /* I/O port range */
 # define XEN_DMOP_IO_RANGE_MEMORY 1 /* MMIO range */
 # define XEN_DMOP_IO_RANGE_PCI    2 /* PCI segment/bus/dev/func range */
+# define XEN_DMOP_IO_RANGE_POSTED 3 /* MMIO range with posted writes */
     /* IN - inclusive start and end of range */
     uint64_aligned_t start, end;
 };
@@ -444,6 +452,32 @@ struct xen_dm_op_nr_vcpus {
 };
 typedef struct xen_dm_op_nr_vcpus xen_dm_op_nr_vcpus_t;
 
+/*
+ * XEN_DMOP_set_ioreq_server_posted_ring: Allocate the posted write ring of
+ *                                        IOREQ Server <id>.
+ *
+ * The ring consists of one control page followed by <nr_frames> slot
+ * pages, which must be a power of two no larger than
+ * XEN_DMOP_POSTED_RING_MAX_FRAMES.  The IOREQ Server must be handling
+ * buffered ioreqs, as posted writes are signalled on <bufioreq_port>, and
+ * must not yet be enabled.  The ring can be mapped using the
+ * XENMEM_acquire_resource memory op, with frame indices
+ * XENMEM_resource_ioreq_server_frame_posted(0) for the control page and
+ * XENMEM_resource_ioreq_server_frame_posted(1 .. nr_frames) for the slots.
+ */
+#define XEN_DMOP_set_ioreq_server_posted_ring 21
+
+struct xen_dm_op_set_ioreq_server_posted_ring {
+    /* IN - server id */
+    ioservid_t id;
+    uint16_t pad;
+    /* IN - number of slot pages */
+    uint32_t nr_frames;
+};
+typedef struct xen_dm_op_set_ioreq_server_posted_ring xen_dm_op_set_ioreq_server_posted_ring_t;
+
+#define XEN_DMOP_POSTED_RING_MAX_FRAMES 64
+
 struct xen_dm_op {
     uint32_t op;
     uint32_t pad;
@@ -468,6 +502,7 @@ struct xen_dm_op {
         xen_dm_op_relocate_memory_t relocate_memory;
         xen_dm_op_pin_memory_cacheattr_t pin_memory_cacheattr;
         xen_dm_op_nr_vcpus_t nr_vcpus;
+        xen_dm_op_set_ioreq_server_posted_ring_t set_ioreq_server_posted_ring;
     } u;
 };
 
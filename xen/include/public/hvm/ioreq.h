@@ -81,6 +81,47 @@ struct buffered_iopage {
 }; /* NB. Size of this structure must be no greater than one page. */
 typedef struct buffered_iopage buffered_iopage_t;
 
+/*
+ * Posted write ring.
+ *
+ * MMIO writes falling entirely within a range registered with type
+ * XEN_DMOP_IO_RANGE_POSTED are not sent as synchronous ioreqs.  Instead they
+ * are appended to a ring made of one control page (struct posted_iopage)
+ * followed by a power of two number of pages of struct posted_ioreq slots,
+ * and the guest vCPU continues without waiting for the emulator.
+ *
+ * Both pointers are free running and index the slot array modulo nr_slots.
+ * Xen only signals the buffered ioreq event channel when it finds the ring
+ * empty (read_pointer equal to the previous write_pointer) after publishing
+ * a write, so a burst of writes costs a single notification.  Hence, after
+ * updating read_pointer, an emulator must re-check write_pointer before
+ * waiting for the next notification.
+ *
+ * Writes are published in the order the guest issued them.  Any request
+ * which cannot be posted (e.g. reads, or writes arriving while the ring is
+ * full) is sent through the synchronous ioreq path, and an emulator must
+ * drain all posted writes before servicing a synchronous request from the
+ * same IOREQ Server.  This makes any read act as a barrier for previously
+ * posted writes.
+ */
+struct posted_ioreq {
+    uint64_t addr;      /* physical address */
+    uint64_t data;      /* data */
+    uint32_t size;      /* size in bytes */
+    uint32_t pad[3];
+};
+typedef struct posted_ioreq posted_ioreq_t;
+
+#define POSTED_IOREQ_SLOTS_PER_PAGE (4096 / sizeof(posted_ioreq_t))
+
+struct posted_iopage {
+    uint32_t read_pointer;  /* written by the emulator */
+    uint32_t write_pointer; /* written by Xen */
+    uint32_t nr_slots;      /* written by Xen, a power of two */
+    uint32_t pad;
+};
+typedef struct posted_iopage posted_iopage_t;
+
 /*
  * ACPI Control/Event register locations. Location is controlled by a
  * version number in HVM_PARAM_ACPI_IOPORTS_LOCATION.
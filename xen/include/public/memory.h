@@ -381,6 +381,23 @@ typedef struct xen_pod_target xen_pod_target_t;
 #define XENMEM_paging_op_nominate           0
 #define XENMEM_paging_op_evict              1
 #define XENMEM_paging_op_prep               2
+/*
+ * Report which of the nr gfns starting at gfn were accessed by the guest
+ * since the previous sample of them, and clear their accessed state.
+ * Returns -EOPNOTSUPP if the hardware can't track accesses.
+ */
+#define XENMEM_paging_op_sample             3
+
+#define XENMEM_paging_sample_max            (1U << 15)
+/*
+ * Nominate / evict each of the nr gfns listed in gfns.  gfns which can't be
+ * nominated / evicted right now are skipped, the others are reported in
+ * bitmap.
+ */
+#define XENMEM_paging_op_nominate_batch     4
+#define XENMEM_paging_op_evict_batch        5
+
+#define XENMEM_paging_batch_max             256
 
 struct xen_mem_paging_op {
     uint8_t     op;         /* XENMEM_paging_op_* */
@@ -390,6 +407,16 @@ struct xen_mem_paging_op {
     XEN_GUEST_HANDLE_64(const_uint8) buffer;
     /* IN:  gfn of page being operated on */
     uint64_aligned_t    gfn;
+    /* IN: (XENMEM_paging_op_sample, _*_batch) number of gfns */
+    uint32_t    nr;
+    uint32_t    pad;        /* Must be zero. */
+    /*
+     * OUT: (XENMEM_paging_op_sample) one bit per gfn, set if accessed
+     *      (XENMEM_paging_op_*_batch) one bit per gfn, set if done
+     */
+    XEN_GUEST_HANDLE_64(uint8) bitmap;
+    /* IN: (XENMEM_paging_op_*_batch) gfns to operate on */
+    XEN_GUEST_HANDLE_64(const_uint64) gfns;
 };
 typedef struct xen_mem_paging_op xen_mem_paging_op_t;
 DEFINE_XEN_GUEST_HANDLE(xen_mem_paging_op_t);
@@ -483,6 +510,8 @@ DEFINE_XEN_GUEST_HANDLE(xen_mem_access_op_t);
 #define XENMEM_sharing_op_range_share       8
 #define XENMEM_sharing_op_fork              9
 #define XENMEM_sharing_op_fork_reset        10
+#define XENMEM_sharing_op_share_batch       11
+#define XENMEM_sharing_op_query_batch       12
 
 #define XENMEM_SHARING_OP_S_HANDLE_INVALID  (-10)
 #define XENMEM_SHARING_OP_C_HANDLE_INVALID  (-9)
@@ -526,6 +555,40 @@ struct xen_mem_sharing_op {
             domid_t client_domain;           /* IN: the client domain id */
             uint16_t _pad[3];                /* Must be set to 0 */
         } range;
+        /*
+         * Share pairs of source and client gfns: both get nominated, and
+         * then shared if their contents are identical.  The domains needn't
+         * be paused.
+         */
+        struct mem_sharing_op_batch {         /* OP_SHARE_BATCH */
+            XEN_GUEST_HANDLE_64(const_uint64) source_gfns; /* IN */
+            XEN_GUEST_HANDLE_64(const_uint64) client_gfns; /* IN */
+            /* OUT: one bit per pair, set if the pages got shared */
+            XEN_GUEST_HANDLE_64(uint8) bitmap;
+            uint32_t nr;                     /* IN: number of pairs */
+            uint32_t opaque;                 /* Must be set to 0 */
+            domid_t client_domain;           /* IN: the client domain id */
+            uint16_t _pad[3];                /* Must be set to 0 */
+        } batch;
+        /*
+         * Report the p2m type of gfns without populating, paging in or
+         * unsharing them, eg. for a scanner to only map private RAM.
+         * Doesn't enable sharing on the domain.
+         */
+        struct mem_sharing_op_query {         /* OP_QUERY_BATCH */
+            XEN_GUEST_HANDLE_64(const_uint64) gfns;  /* IN */
+            /* OUT: one XENMEM_SHARING_GFN_* per gfn */
+            XEN_GUEST_HANDLE_64(uint8) types;
+            uint32_t nr;                     /* IN: number of gfns */
+            uint32_t opaque;                 /* Must be set to 0 */
+            uint8_t enabled;                 /* OUT: sharing is enabled */
+            uint8_t _pad[7];                 /* Must be set to 0 */
+        } query;
+#define XENMEM_SHARING_GFN_RAM      0 /* Private RAM */
+#define XENMEM_SHARING_GFN_SHARED   1
+#define XENMEM_SHARING_GFN_POD      2 /* Populate-on-demand */
+#define XENMEM_SHARING_GFN_PAGED    3 /* Paged out or being paged */
+#define XENMEM_SHARING_GFN_OTHER    4 /* Holes, MMIO, grants, ... */
         struct mem_sharing_op_debug {     /* OP_DEBUG_xxx */
             union {
                 uint64_aligned_t gfn;      /* IN: gfn to debug          */
@@ -627,6 +690,7 @@ struct xen_mem_acquire_resource {
 #define XENMEM_resource_ioreq_server 0
 #define XENMEM_resource_grant_table 1
 #define XENMEM_resource_vmtrace_buf 2
+#define XENMEM_resource_dirty_ring 3
 
     /*
      * IN - a type-specific resource identifier, which must be zero
@@ -673,6 +737,12 @@ struct xen_mem_acquire_resource {
 
 #define XENMEM_resource_ioreq_server_frame_bufioreq 0
 #define XENMEM_resource_ioreq_server_frame_ioreq(n) (1 + (n))
+/*
+ * The frames of the posted write ring (XEN_DMOP_set_ioreq_server_posted_ring)
+ * aren't included in the size reported for the resource: they are only
+ * reached by their explicit index.
+ */
+#define XENMEM_resource_ioreq_server_frame_posted(n) (0x10000 + (n))
 
     /*
      * IN/OUT - If the tools domain is PV then, upon return, frame_list
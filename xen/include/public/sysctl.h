@@ -28,7 +28,7 @@
  *
  * Last version bump: Xen 4.17
  */
-#define XEN_SYSCTL_INTERFACE_VERSION 0x00000015
+#define XEN_SYSCTL_INTERFACE_VERSION 0x00000016
 
 /*
  * Read console content from Xen buffer ring.
@@ -579,6 +579,9 @@ struct xen_sysctl_page_offline_op {
 /* Sub-operations: */
 #define XEN_SYSCTL_LOCKPROF_reset 1   /* Reset all profile data to zero. */
 #define XEN_SYSCTL_LOCKPROF_query 2   /* Get lock profile information. */
+#define XEN_SYSCTL_LOCKPROF_contention_set   3 /* Set contention sampling. */
+#define XEN_SYSCTL_LOCKPROF_contention_query 4 /* Get contended lock sites. */
+#define XEN_SYSCTL_LOCKPROF_contention_reset 5 /* Reset contention data. */
 /* Record-type: */
 #define LOCKPROF_TYPE_GLOBAL      0   /* global lock, idx meaningless */
 #define LOCKPROF_TYPE_PERDOM      1   /* per-domain lock, idx is domid */
@@ -594,15 +597,42 @@ struct xen_sysctl_lockprof_data {
 };
 typedef struct xen_sysctl_lockprof_data xen_sysctl_lockprof_data_t;
 DEFINE_XEN_GUEST_HANDLE(xen_sysctl_lockprof_data_t);
+/*
+ * Contention record for one (lock, call site) pair.  Only sampled contended
+ * acquisitions are accounted.  Histogram bucket 0 counts waits below 128ns,
+ * bucket i (i > 0) waits in [64ns << i, 128ns << i), the last bucket is
+ * open ended.
+ */
+#define LOCKPROF_HIST_BUCKETS     16
+struct xen_sysctl_lockprof_site {
+    char     caller[64];           /* symbol+offset of the call site */
+    uint64_aligned_t lock_addr;    /* hypervisor address of the lock */
+    uint64_aligned_t caller_addr;  /* hypervisor address of the call site */
+    uint64_aligned_t samples;      /* # of sampled contended acquisitions */
+    uint64_aligned_t wait_time;    /* nsecs waited in sampled acquisitions */
+    uint64_aligned_t max_wait;     /* longest sampled wait in nsecs */
+    uint64_aligned_t hist[LOCKPROF_HIST_BUCKETS];
+};
+typedef struct xen_sysctl_lockprof_site xen_sysctl_lockprof_site_t;
+DEFINE_XEN_GUEST_HANDLE(xen_sysctl_lockprof_site_t);
 struct xen_sysctl_lockprof_op {
     /* IN variables. */
     uint32_t       cmd;               /* XEN_SYSCTL_LOCKPROF_??? */
     uint32_t       max_elem;          /* size of output buffer */
     /* OUT variables (query only). */
     uint32_t       nr_elem;           /* number of elements available */
+    /*
+     * IN (contention_set) / OUT (contention_query): one in sample_rate
+     * contended acquisitions is sampled, 0 disables contention sampling.
+     */
+    uint32_t       sample_rate;
     uint64_aligned_t time;            /* nsecs of profile measurement */
     /* profile information (or NULL) */
     XEN_GUEST_HANDLE_64(xen_sysctl_lockprof_data_t) data;
+    /* OUT variables (contention_query only). */
+    uint64_aligned_t dropped;         /* samples lost to a full site table */
+    /* contention information (or NULL) */
+    XEN_GUEST_HANDLE_64(xen_sysctl_lockprof_site_t) sites;
 };
 
 /* XEN_SYSCTL_cputopoinfo */
@@ -0,0 +1,15 @@
+#define XEN_COMPILE_DATE	"Sun Oct 18 17:33:52 UTC 2026"
+#define XEN_COMPILE_TIME	"17:33:52"
+#define XEN_COMPILE_BY		""
+#define XEN_COMPILE_DOMAIN	""
+#define XEN_COMPILE_HOST	"vm"
+#define XEN_COMPILER		"gcc (Debian 12.2.0-14+deb12u1) 12.2.0"
+
+#define XEN_VERSION		4
+#define XEN_SUBVERSION		21
+#define XEN_VERSION_STRING	"4.21"
+#define XEN_EXTRAVERSION	"-unstable"
+
+#define XEN_CHANGESET		"Sun Oct 18 17:33:19 2026 +0000 git:c63f9d2-dirty"
+#define XEN_BANNER		\
+"Xen 4.21-unstable\n"
@@ -245,11 +245,19 @@ static inline void evtchn_port_init(struct domain *d, struct evtchn *evtchn)
         d->evtchn_port_ops->init(d, evtchn);
 }
 
+/* Moderation of event delivery, see EVTCHNOP_set_moderation. */
+bool evtchn_moderation_hold(struct domain *d, struct evtchn *evtchn);
+
+static inline bool evtchn_moderated(struct domain *d, struct evtchn *evtchn)
+{
+    return unlikely(evtchn->moderation) && evtchn_moderation_hold(d, evtchn);
+}
+
 static inline void evtchn_port_set_pending(struct domain *d,
                                            unsigned int vcpu_id,
                                            struct evtchn *evtchn)
 {
-    if ( evtchn_usable(evtchn) )
+    if ( evtchn_usable(evtchn) && !evtchn_moderated(d, evtchn) )
         d->evtchn_port_ops->set_pending(d->vcpu[vcpu_id], evtchn);
 }
 
@@ -352,6 +352,8 @@ struct iommu_ops {
     int __must_check (*iotlb_flush)(struct domain *d, dfn_t dfn,
                                     unsigned long page_count,
                                     unsigned int flush_flags);
+    void (*flush_batch_begin)(void);
+    int __must_check (*flush_batch_end)(void);
     int (*get_reserved_device_memory)(iommu_grdm_t *func, void *ctxt);
     void (*dump_page_tables)(struct domain *d);
 
@@ -481,6 +483,20 @@ void iommu_dev_iotlb_flush_timeout(struct domain *d, struct pci_dev *pdev);
  */
 DECLARE_PER_CPU(bool, iommu_dont_flush_iotlb);
 
+/*
+ * IOTLB flushes issued between iommu_flush_batch_begin() and the matching
+ * iommu_flush_batch_end() on the same CPU may return before the IOMMU has
+ * completed them.  They are only guaranteed to have completed once the
+ * (outermost) batch has ended, so pages unmapped inside a batch must not be
+ * freed or reused before then.  Batches may nest.
+ *
+ * Within a batch, iommu_legacy_{,un}map() additionally don't flush right
+ * away: the ranges they leave to flush are merged as far as possible, and
+ * flushed at the latest when the batch ends.
+ */
+void iommu_flush_batch_begin(void);
+void iommu_flush_batch_end(void);
+
 extern struct spinlock iommu_pt_cleanup_lock;
 extern struct page_list_head iommu_pt_cleanup_list;
 
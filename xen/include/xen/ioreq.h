@@ -36,7 +36,16 @@ struct ioreq_vcpu {
     bool             pending;
 };
 
-#define NR_IO_RANGE_TYPES (XEN_DMOP_IO_RANGE_PCI + 1)
+struct ioreq_posted_ring {
+    struct page_info **pages;
+    unsigned int     nr_pages;
+    posted_iopage_t  *ctrl;
+    posted_ioreq_t   *slot;
+    unsigned int     nr_slots;
+    uint32_t         write_pointer;
+};
+
+#define NR_IO_RANGE_TYPES (XEN_DMOP_IO_RANGE_POSTED + 1)
 #define MAX_NR_IO_RANGES  256
 
 struct ioreq_server {
@@ -49,9 +58,10 @@ struct ioreq_server {
     struct list_head       ioreq_vcpu_list;
     struct ioreq_page      bufioreq;
 
-    /* Lock to serialize access to buffered ioreq ring */
+    /* Lock to serialize access to buffered and posted ioreq rings */
     spinlock_t             bufioreq_lock;
     evtchn_port_t          bufioreq_evtchn;
+    struct ioreq_posted_ring posted;
     struct rangeset        *range[NR_IO_RANGE_TYPES];
     bool                   enabled;
     uint8_t                bufioreq_handling;
@@ -85,4 +85,26 @@ PERFCOUNTER(tickled_cpu_overridden, "csched2: tickled_cpu_overridden")
 
 PERFCOUNTER(need_flush_tlb_flush,   "PG_need_flush tlb flushes")
 
+PERFCOUNTER(evtchn_multi_ports,     "evtchn: send_multi ports")
+PERFCOUNTER(evtchn_multi_coalesced, "evtchn: send_multi upcalls coalesced")
+PERFCOUNTER(evtchn_mod_delivered,   "evtchn: moderated events delivered")
+PERFCOUNTER(evtchn_mod_suppressed,  "evtchn: moderated events suppressed")
+
+#ifdef CONFIG_IOREQ_SERVER
+PERFCOUNTER(ioreq_posted,           "ioreq: posted writes")
+PERFCOUNTER(ioreq_posted_notify,    "ioreq: posted write notifications")
+PERFCOUNTER(ioreq_posted_full,      "ioreq: posted ring full")
+#endif
+
+#ifdef CONFIG_HAS_PASSTHROUGH
+PERFCOUNTER(iommu_flush_merged,     "IOMMU flushes merged in batches")
+#endif
+
+#ifdef CONFIG_HAS_VPCI
+PERFCOUNTER(vpci_cmd_writes,        "vpci: memory decoding toggles")
+PERFCOUNTER(vpci_bar_pages,         "vpci: BAR pages {un}mapped")
+PERFCOUNTER(vpci_bar_iotlb_flush,   "vpci: BAR IOTLB flushes")
+PERFCOUNTER_ARRAY(vpci_cmd_write_time, "vpci: decoding toggle time (log2 us)", 24)
+#endif
+
 /*#endif*/ /* __XEN_PERFC_DEFN_H__ */
@@ -105,6 +105,7 @@ struct evtchn
     unsigned char old_state; /* State when taking lock in write mode. */
 #endif
     unsigned char xen_consumer:XEN_CONSUMER_BITS; /* Consumer in Xen if != 0 */
+    unsigned char moderation; /* Index + 1 in d->evtchn_moderation, or 0. */
     evtchn_port_t port;
     union {
         struct {
@@ -368,6 +369,7 @@ struct sched_unit {
 #define domain_unlock(d) rspin_unlock(&(d)->domain_lock)
 
 struct evtchn_port_ops;
+struct evtchn_moderation;
 
 #define MAX_NR_IOREQ_SERVERS 8
 
@@ -445,6 +447,8 @@ struct domain
     rwlock_t         event_lock;
     const struct evtchn_port_ops *evtchn_port_ops;
     struct evtchn_fifo_domain *evtchn_fifo;
+    /* Moderated ports, EVTCHN_MODERATION_MAX entries. */
+    struct evtchn_moderation **evtchn_moderation;
 
     struct grant_table *grant_table;
 
@@ -164,7 +164,6 @@ void _lock_profile_deregister_struct(int32_t type,
 #define lock_profile_deregister_struct(type, ptr)                             \
     _lock_profile_deregister_struct(type, &((ptr)->profile_head))
 
-extern int spinlock_profile_control(struct xen_sysctl_lockprof_op *pc);
 extern void cf_check spinlock_profile_printall(unsigned char key);
 extern void cf_check spinlock_profile_reset(unsigned char key);
 
@@ -191,6 +190,25 @@ struct lock_profile { };
 
 #endif
 
+#if defined(CONFIG_DEBUG_LOCK_PROFILE) || defined(CONFIG_LOCK_CONTENTION_PROFILE)
+struct xen_sysctl_lockprof_op;
+extern int spinlock_profile_control(struct xen_sysctl_lockprof_op *pc);
+#endif
+
+#ifdef CONFIG_LOCK_CONTENTION_PROFILE
+/*
+ * Bracket a contended acquisition not going through the spinlock slow path
+ * (e.g. rwlocks).  Inner spinlock contention is not sampled in between.
+ */
+s_time_t lock_contention_enter(void);
+void lock_contention_exit(const void *lock, const void *caller,
+                          s_time_t start);
+#else
+static inline s_time_t lock_contention_enter(void) { return 0; }
+static inline void lock_contention_exit(const void *lock, const void *caller,
+                                        s_time_t start) {}
+#endif
+
 typedef union {
     uint32_t head_tail;
     struct {
@@ -86,8 +86,12 @@ void cf_check vpci_hw_write16(
 bool __must_check vpci_process_pending(struct vcpu *v);
 
 struct vpci {
-    /* List of vPCI handlers for a device. */
-    struct list_head handlers;
+    /* vPCI handlers for a device, sorted by offset. */
+    struct vpci_register **regs;
+    unsigned int nr_regs;
+    /* Per-dword index into regs, see vpci_update_index(). */
+    uint16_t *reg_index;
+    unsigned int reg_index_size;
     spinlock_t lock;
 
 #ifdef __XEN__
@@ -197,6 +201,10 @@ struct vpci_vcpu {
     struct pci_dev *pdev;
     uint16_t cmd;
     bool rom_only : 1;
+#ifdef CONFIG_PERF_COUNTERS
+    /* Time at which the {un}mapping was requested. */
+    s_time_t start;
+#endif
 };
 
 #ifdef __XEN__
@@ -0,0 +1 @@
+cmd_tools/kconfig/lexer.lex.c := flex -otools/kconfig/lexer.lex.c -L tools/kconfig/lexer.l
@@ -0,0 +1 @@
+cmd_tools/kconfig/parser.tab.h := bison -o tools/kconfig/parser.tab.c --defines=tools/kconfig/parser.tab.h -t -l tools/kconfig/parser.y
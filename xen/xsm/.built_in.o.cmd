@@ -0,0 +1 @@
+cmd_xsm/built_in.o := ld    -melf_x86_64 --no-warn-rwx-segments -r -o xsm/built_in.o xsm/xsm_core.o